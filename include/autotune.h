@@ -0,0 +1,123 @@
+#ifndef AUTOTUNE_H
+#define AUTOTUNE_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "dyn_array.h"
+#include "processing_scheduling.h"
+
+/*
+    Auto-tuner notes!
+
+    Searches the parameters of the scheduling policies for the ones that serve a trace best.
+    A candidate is a policy plus its quantum (for the time sliced policies: RR, STRIDE,
+    LOTTERY and GROUP, and SRT on many CPUs), and with a topology in the base config also a
+    placement and a balance policy. Everything else (costs, topology, tenants, groups) comes
+    from the base config, so the candidates differ only in what is being tuned.
+
+    Searches:
+      AUTOTUNE_GRID     every policy with quanta doubling from quantum_min up to quantum_max
+                        (quantum_max itself included), times every placement and balance
+      AUTOTUNE_RANDOM   candidates distinct draws (fewer if the space is smaller), the
+                        quantum log-uniform in [quantum_min, quantum_max]
+      AUTOTUNE_HALVING  successive halving over the grid, or over candidates draws when that is
+                        set: every candidate first runs on the first min_pcbs PCBs of the trace,
+                        only the better half goes on to twice as many, and so on until the
+                        survivors (never fewer than finalists) replay the whole trace
+    Grid and random searches replay the whole trace for every candidate.
+
+    Each round of evaluations is spread across threads, one simulation per task; a
+    simulation is serial, so the results do not depend on the thread count.
+
+    Every evaluation measures the mean waiting time, the 99th percentile turnaround time
+    (nearest rank, from the completion times in the run's timeline) and the throughput in
+    PCBs per tick. The objective picks which of those ranks the candidates; the Pareto
+    front is the full replays no other full replay beats on all three (lower waiting, lower
+    p99, higher throughput) at once.
+*/
+
+    typedef enum
+    {
+        AUTOTUNE_GRID,
+        AUTOTUNE_RANDOM,
+        AUTOTUNE_HALVING
+    }
+    AutotuneSearch_t;
+
+    typedef enum
+    {
+        AUTOTUNE_MEAN_WAIT,             // lowest mean waiting time
+        AUTOTUNE_P99_TURNAROUND,        // lowest 99th percentile turnaround time
+        AUTOTUNE_THROUGHPUT             // most PCBs finished per tick
+    }
+    AutotuneObjective_t;
+
+    // The tuned parameters of one candidate
+    typedef struct
+    {
+        SchedulePolicy_t policy;
+        size_t quantum;                 // 0 for policies without a quantum
+        SchedulePlacement_t placement;  // only varied with a topology
+        ScheduleBalance_t balance;      // only varied with a topology
+    }
+    AutotuneParams_t;
+
+    // A candidate and what its last evaluation measured
+    typedef struct
+    {
+        AutotuneParams_t params;
+        double mean_wait;
+        double p99_turnaround;
+        double throughput;
+        size_t pcbs;                    // PCBs it was last evaluated on, the whole trace unless pruned
+        bool pareto;                    // on the Pareto front of the full replays
+    }
+    AutotuneResult_t;
+
+    typedef struct
+    {
+        const ScheduleConfig_t *base;   // everything not tuned; its policy, quantum and outputs are ignored
+        const SchedulePolicy_t *policies; // the policies to try
+        size_t policy_count;
+        size_t quantum_min;             // smallest quantum tried, at least 1
+        size_t quantum_max;             // largest quantum tried
+        AutotuneSearch_t search;
+        AutotuneObjective_t objective;
+        size_t candidates;              // draws of AUTOTUNE_RANDOM, and of AUTOTUNE_HALVING when not 0
+        size_t min_pcbs;                // PCBs of the first halving round
+        size_t finalists;               // candidates halving keeps for the full replay, at least 1
+        uint64_t seed;                  // seeds the random draws
+        size_t threads;                 // evaluations run at once, 0 for one per online CPU
+    }
+    AutotuneConfig_t;
+
+    // Fills in the defaults: a grid over RR with quanta 1 to 64, ranked by mean waiting time;
+    // 32 random draws, halving from 1000 PCBs down to 4 finalists, seed 1, one thread per CPU
+    // \param config the config to initialise
+    // \param base the settings shared by every candidate
+    void autotune_config_init(AutotuneConfig_t *config, const ScheduleConfig_t *base);
+
+    // Runs the search over a trace, which is left unchanged
+    // \param ready_queue a dyn_array of type ProcessControlBlock_t, the trace
+    // \param config what to search and how \ref AutotuneConfig_t
+    // \return a dyn_array of AutotuneResult_t, one per candidate: the full replays best first by
+    // the objective, then the pruned ones from the last round they reached; NULL on error
+    dyn_array_t *autotune_run(const dyn_array_t *ready_queue, const AutotuneConfig_t *config);
+
+    // \param objective the objective
+    // \param a a result
+    // \param b a result
+    // \return true if a scores better than b on the objective
+    bool autotune_better(AutotuneObjective_t objective, const AutotuneResult_t *a, const AutotuneResult_t *b);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
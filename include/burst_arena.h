@@ -0,0 +1,64 @@
+#ifndef BURST_ARENA_H
+#define BURST_ARENA_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+    Burst arena notes!
+
+    A burst arena holds the CPU/I/O phase lists of a whole trace in one shared buffer,
+    so a PCB's phases cost two integers of bookkeeping instead of a malloc each.
+    Entry i describes the PCB at index i of the ready queue.
+
+    A phase list alternates CPU and I/O and starts and ends with CPU:
+      {cpu, io, cpu, io, ..., cpu}
+    so it always has an odd number of phases. A single phase is a plain CPU-bound job.
+
+    File form (burst_arena_load): per PCB a uint32 phase count followed by that many
+    uint32 phase lengths, native endianness, until end of file.
+*/
+
+    typedef struct burst_arena BurstArena_t;
+
+    // Creates an empty arena
+    // \return the arena, NULL on error
+    BurstArena_t *burst_arena_create(void);
+
+    // Frees the arena and all phase lists
+    // \param arena the arena to destroy
+    void burst_arena_destroy(BurstArena_t *arena);
+
+    // Appends the phase list of the next PCB
+    // \param arena the arena
+    // \param phases alternating CPU and I/O lengths, starting and ending with CPU
+    // \param count number of phases (odd)
+    // \return true if function ran successful else false for an error
+    bool burst_arena_add(BurstArena_t *arena, const uint32_t *phases, size_t count);
+
+    // \param arena the arena
+    // \return the number of PCBs described, 0 on error
+    size_t burst_arena_size(const BurstArena_t *arena);
+
+    // Returns the phase list of a PCB. The pointer is invalidated by burst_arena_add
+    // \param arena the arena
+    // \param pid index of the PCB
+    // \param count receives the number of phases
+    // \return the phases, NULL on error
+    const uint32_t *burst_arena_phases(const BurstArena_t *arena, size_t pid, size_t *count);
+
+    // Reads an arena in the file form described above
+    // \param path the file to read
+    // \return the arena, NULL on error
+    BurstArena_t *burst_arena_load(const char *path);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -0,0 +1,83 @@
+#ifndef COEXEC_H
+#define COEXEC_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "processing_scheduling.h"
+
+/*
+    Coroutine executor notes!
+
+    Tasks are stackful coroutines (one ucontext and stack each) multiplexed on the thread
+    that calls coexec_run. Tasks report progress with coexec_tick; under RR and SRTF a task
+    that has used config->quantum ticks since it was dispatched yields back to the
+    executor, which then picks the next task with schedule_policy_key just like the
+    simulator. The descriptor's remaining_burst_time is the SRTF estimate and shrinks as
+    ticks are reported. FCFS, SJF and priority never preempt; a task only gives up the
+    CPU there by finishing or calling coexec_yield.
+
+    Every switch (task -> executor -> next task, including the pick) is timed, so the
+    average real switch cost can be compared with the zero cost the simulator assumes.
+
+    Executors are single threaded; coexec_tick, coexec_yield and coexec_spawn from inside a
+    task act on the executor running on the calling thread.
+*/
+
+    typedef struct coexec CoExecutor_t;
+
+    // A task body. Returning finishes the task
+    typedef void (*CoTaskFunc_t)(void *arg);
+
+    typedef struct
+    {
+        uint64_t completed;         // tasks that returned
+        uint64_t dispatches;        // times the executor resumed a task
+        uint64_t switches;          // timed task to task switches
+        uint64_t total_switch_ns;   // time spent in those switches
+    }
+    CoExecStats_t;
+
+    // Creates an executor
+    // \param config the dispatch policy and quantum (copied)
+    // \param stack_size bytes of stack per task (0 for 64 KiB)
+    // \return the executor, NULL on error
+    CoExecutor_t *coexec_create(const ScheduleConfig_t *config, size_t stack_size);
+
+    // Adds a task. May be called before coexec_run or from inside a running task
+    // \param executor the executor
+    // \param descriptor burst estimate and priority used by the policy
+    // \param func the task body
+    // \param arg passed to func
+    // \return true if the task was created
+    bool coexec_spawn(CoExecutor_t *executor, const ProcessControlBlock_t *descriptor, CoTaskFunc_t func, void *arg);
+
+    // Runs tasks until all of them have finished
+    // \param executor the executor
+    // \param stats optional, receives the executor's counters
+    // \return true if function ran successful else false for an error, including a task that
+    //         could not be queued again and was abandoned unfinished
+    bool coexec_run(CoExecutor_t *executor, CoExecStats_t *stats);
+
+    // Reports ticks of work done by the running task, yielding at quantum boundaries
+    // No-op outside a task
+    // \param ticks units of work just done
+    void coexec_tick(uint32_t ticks);
+
+    // Gives up the CPU and goes back in the ready queue. No-op outside a task
+    void coexec_yield(void);
+
+    // Frees the executor and any tasks that never ran
+    // \param executor the executor to destroy
+    void coexec_destroy(CoExecutor_t *executor);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -12,9 +12,12 @@
 #include <stdint.h>
 
 typedef struct dyn_array dyn_array_t;
-// Next version, push/pop_N_back/front for bulk loading
-// Erase_n
-// etc
+
+// Room for a dyn_array_t header outside the heap, see dyn_array_init
+typedef struct
+{
+    void *opaque[6];
+} dyn_array_storage_t;
 
 /*
     Destructor notes!
@@ -37,6 +40,7 @@ typedef struct dyn_array dyn_array_t;
 ///
 /// Creates a new dynamic array capable of holding at least capacity number of
 /// data_type_size-sized objects with optional destructor
+/// Small arrays (up to 512 bytes of objects) are a single allocation holding header and objects
 /// \param capacity Minimum capacity request (0 is fine if you have no opinion)
 /// \param data_type_size Size of the object type to be stored in bytes
 /// \param destruct_func Optional destructor to be applied on destruct operations (NULL to disable)
@@ -44,6 +48,32 @@ typedef struct dyn_array dyn_array_t;
 ///
 dyn_array_t *dyn_array_create(const size_t capacity, const size_t data_type_size, void (*destruct_func)(void *));
 
+///
+/// Initialises a dynamic array in caller-provided storage (a local variable, a struct member...)
+/// The first capacity objects go in buffer, so a small array needs no heap allocation at all;
+/// growing past it moves the contents to the heap transparently.
+/// storage and buffer must outlive the array, and the array must be torn down with dyn_array_deinit.
+/// The header points at buffer, so neither may be copied or moved while the array is in use,
+/// and buffer must be aligned for the stored type (only pointer alignment is assumed)
+/// \param storage where the array's header is kept
+/// \param buffer initial storage for capacity objects (NULL if capacity is 0)
+/// \param capacity number of objects buffer holds
+/// \param data_type_size Size of the object type to be stored in bytes
+/// \param destruct_func Optional destructor to be applied on destruct operations (NULL to disable)
+/// \return the dynamic array (living in storage), NULL on error
+///
+dyn_array_t *dyn_array_init(dyn_array_storage_t *const storage, void *const buffer, const size_t capacity,
+                            const size_t data_type_size, void (*destruct_func)(void *));
+
+///
+/// Declares name as a dyn_array_t * to an array of type with room for count objects in local storage
+/// ex: DYN_ARRAY_LOCAL(queue, ProcessControlBlock_t, 8); ... dyn_array_deinit(queue);
+///
+#define DYN_ARRAY_LOCAL(name, type, count)                                                            \
+    dyn_array_storage_t name##_storage;                                                               \
+    type name##_buffer[count];                                                                        \
+    dyn_array_t *name = dyn_array_init(&name##_storage, name##_buffer, (count), sizeof(type), NULL)
+
 ///
 /// Creates a new dynamic array from a given array
 /// (Given pointer can be freed after import, we copy the data)
@@ -71,6 +101,13 @@ const void *dyn_array_export(const dyn_array_t *const dyn_array);
 ///
 void dyn_array_destroy(dyn_array_t *const dyn_array);
 
+///
+/// Tears down an array made by dyn_array_init, applying the destructor to all remaining elements
+/// and freeing any heap storage it grew into. The storage and buffer can be reused afterwards
+/// \param dyn_array The dynamic array to tear down
+///
+void dyn_array_deinit(dyn_array_t *const dyn_array);
+
 
 
 
@@ -185,6 +222,77 @@ bool dyn_array_erase(dyn_array_t *const dyn_array, const size_t index);
 bool dyn_array_extract(dyn_array_t *const dyn_array, const size_t index, void *const object);
 
 
+///
+/// Copies count objects to the back of the array with a single reallocation and copy
+/// \param dyn_array the dynamic array
+/// \param objects the objects to append (may be NULL when count is 0)
+/// \param count number of objects (0 is a successful no-op)
+/// \return bool representing success of the operation
+///
+bool dyn_array_append_n(dyn_array_t *const dyn_array, const void *const objects, const size_t count);
+
+///
+/// Inserts count objects at the given index, moving any contents at index and beyond down count
+/// \param dyn_array the dynamic array
+/// \param index the position of the first inserted object
+/// \param objects the objects to insert (may be NULL when count is 0)
+/// \param count number of objects (0 is a successful no-op, as long as index is valid)
+/// \return bool representing success of the operation
+///
+bool dyn_array_insert_n(dyn_array_t *const dyn_array, const size_t index, const void *const objects,
+                        const size_t count);
+
+///
+/// Removes and optionally destructs count objects starting at index
+/// \param dyn_array the dynamic array
+/// \param index index of the first object to be erased
+/// \param count number of objects, index + count may not pass the end (0 is a successful no-op)
+/// \return bool representing success of the operation
+///
+bool dyn_array_erase_range(dyn_array_t *const dyn_array, const size_t index, const size_t count);
+
+///
+/// Removes count objects starting at index and places them at the desired location
+/// Does not destruct the objects since they are returned to the user
+/// \param dyn_array the dynamic array
+/// \param index index of the first object to extract
+/// \param count number of objects, index + count may not pass the end
+/// \param objects destination for the extracted objects, room for count of them
+/// \return bool representing success of the operation
+///
+bool dyn_array_extract_range(dyn_array_t *const dyn_array, const size_t index, const size_t count,
+                             void *const objects);
+
+///
+/// Grows the capacity to hold at least capacity objects so that many can be added without reallocation
+/// Never shrinks the array
+/// \param dyn_array the dynamic array
+/// \param capacity the number of objects to make room for
+/// \return bool representing success of the operation
+///
+bool dyn_array_reserve(dyn_array_t *const dyn_array, const size_t capacity);
+
+///
+/// Releases unused capacity so the array holds exactly its size (at least one object)
+/// Does nothing while the objects are still in inline storage (a small array's own allocation
+/// or the buffer given to dyn_array_init), which can't be given back on its own
+/// Pointers into the array may be invalidated
+/// \param dyn_array the dynamic array
+/// \return bool representing success of the operation (the array is unchanged on failure)
+///
+bool dyn_array_shrink_to_fit(dyn_array_t *const dyn_array);
+
+///
+/// Changes the size of the array
+/// Growing copies fill into each new object (zero fills if fill is NULL)
+/// Shrinking optionally destructs the objects past the new size
+/// \param dyn_array the dynamic array
+/// \param size the new number of objects
+/// \param fill the object to copy into new positions, NULL for zeroes
+/// \return bool representing success of the operation
+///
+bool dyn_array_resize(dyn_array_t *const dyn_array, const size_t size, const void *const fill);
+
 ///
 /// Removes and optionally destructs all array elements
 /// \param dyn_array the dynamic array
@@ -0,0 +1,281 @@
+#ifndef DYN_ARRAY_HPP
+#define DYN_ARRAY_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#include "dyn_array.h"
+
+/*
+    C++ layer notes!
+
+    dyn::dyn_array<T> owns a plain C dyn_array_t whose data_size is sizeof(T), so it can be
+    handed to any C function (get()) or built around one the C side created (adopt()).
+    The element size is a compile time constant and iteration is over raw T pointers,
+    so loops over it compile to plain pointer arithmetic the optimiser can unroll and
+    vectorise, instead of a dyn_array_at call, bounds check and size multiply per element.
+
+    Elements are moved around with memcpy/memmove by the C code, so T has to be trivially
+    copyable. Iterators, data() and references are invalidated by anything that grows
+    the array, same as the pointers from dyn_array_at.
+
+    Errors the C API reports as false/NULL are thrown as std::bad_alloc from constructors
+    and growth, and std::out_of_range from at().
+*/
+
+namespace dyn
+{
+
+template <typename T>
+class dyn_array
+{
+    static_assert(std::is_trivially_copyable<T>::value, "dyn_array elements are copied with memcpy");
+
+public:
+    typedef T value_type;
+    typedef T *iterator;
+    typedef const T *const_iterator;
+    typedef size_t size_type;
+
+    explicit dyn_array(size_t capacity = 0) : array_(::dyn_array_create(capacity, sizeof(T), NULL))
+    {
+        if (!array_)
+        {
+            throw std::bad_alloc();
+        }
+    }
+
+    dyn_array(const T *data, size_t count) : dyn_array(count)
+    {
+        append(data, count);
+    }
+
+    ~dyn_array()
+    {
+        ::dyn_array_destroy(array_);
+    }
+
+    dyn_array(const dyn_array &) = delete;
+    dyn_array &operator=(const dyn_array &) = delete;
+
+    dyn_array(dyn_array &&other) noexcept : array_(other.array_)
+    {
+        other.array_ = NULL;
+    }
+
+    dyn_array &operator=(dyn_array &&other) noexcept
+    {
+        if (this != &other)
+        {
+            ::dyn_array_destroy(array_);
+            array_ = other.array_;
+            other.array_ = NULL;
+        }
+        return *this;
+    }
+
+    // Takes ownership of a C array holding T-sized objects
+    static dyn_array adopt(::dyn_array_t *array)
+    {
+        if (!array || ::dyn_array_data_size(array) != sizeof(T))
+        {
+            throw std::invalid_argument("dyn_array::adopt: element size mismatch");
+        }
+        return dyn_array(array, adopt_tag());
+    }
+
+    // The C array, still owned by this object
+    ::dyn_array_t *get() const
+    {
+        return array_;
+    }
+
+    // Gives up ownership of the C array; this object is empty afterwards
+    ::dyn_array_t *release()
+    {
+        ::dyn_array_t *array = array_;
+        array_ = NULL;
+        return array;
+    }
+
+    size_t size() const
+    {
+        return ::dyn_array_size(array_);
+    }
+
+    size_t capacity() const
+    {
+        return ::dyn_array_capacity(array_);
+    }
+
+    bool empty() const
+    {
+        return ::dyn_array_empty(array_);
+    }
+
+    T *data()
+    {
+        return static_cast<T *>(::dyn_array_front(array_));
+    }
+
+    const T *data() const
+    {
+        return static_cast<const T *>(::dyn_array_front(array_));
+    }
+
+    iterator begin()
+    {
+        return data();
+    }
+
+    iterator end()
+    {
+        return data() + size();
+    }
+
+    const_iterator begin() const
+    {
+        return data();
+    }
+
+    const_iterator end() const
+    {
+        return data() + size();
+    }
+
+    // Unchecked access
+    T &operator[](size_t index)
+    {
+        return data()[index];
+    }
+
+    const T &operator[](size_t index) const
+    {
+        return data()[index];
+    }
+
+    // Checked access
+    T &at(size_t index)
+    {
+        void *element = ::dyn_array_at(array_, index);
+        if (!element)
+        {
+            throw std::out_of_range("dyn_array::at");
+        }
+        return *static_cast<T *>(element);
+    }
+
+    T &front()
+    {
+        return *data();
+    }
+
+    T &back()
+    {
+        return *static_cast<T *>(::dyn_array_back(array_));
+    }
+
+    void push_back(const T &value)
+    {
+        if (!::dyn_array_push_back(array_, &value))
+        {
+            throw std::bad_alloc();
+        }
+    }
+
+    template <typename... Args>
+    T &emplace_back(Args &&... args)
+    {
+        const T value(std::forward<Args>(args)...);
+        push_back(value);
+        return back();
+    }
+
+    void append(const T *values, size_t count)
+    {
+        if (!::dyn_array_append_n(array_, values, count))
+        {
+            throw std::bad_alloc();
+        }
+    }
+
+    void insert(size_t index, const T &value)
+    {
+        if (!::dyn_array_insert(array_, index, &value))
+        {
+            throw std::out_of_range("dyn_array::insert");
+        }
+    }
+
+    void pop_back()
+    {
+        ::dyn_array_pop_back(array_);
+    }
+
+    void erase(size_t index)
+    {
+        ::dyn_array_erase(array_, index);
+    }
+
+    // Erases count elements starting at index with a single move of the tail
+    void erase(size_t index, size_t count)
+    {
+        if (!::dyn_array_erase_range(array_, index, count))
+        {
+            throw std::out_of_range("dyn_array::erase");
+        }
+    }
+
+    void reserve(size_t capacity)
+    {
+        if (!::dyn_array_reserve(array_, capacity))
+        {
+            throw std::bad_alloc();
+        }
+    }
+
+    // New elements are value-initialised (zero filled)
+    void resize(size_t size)
+    {
+        if (!::dyn_array_resize(array_, size, NULL))
+        {
+            throw std::bad_alloc();
+        }
+    }
+
+    void shrink_to_fit()
+    {
+        ::dyn_array_shrink_to_fit(array_);
+    }
+
+    void clear()
+    {
+        ::dyn_array_clear(array_);
+    }
+
+    // Sorts with an inlinable comparator instead of qsort's function pointer
+    template <typename Compare>
+    void sort(Compare compare)
+    {
+        std::sort(begin(), end(), compare);
+    }
+
+private:
+    struct adopt_tag
+    {
+    };
+
+    dyn_array(::dyn_array_t *array, adopt_tag) : array_(array)
+    {
+    }
+
+    ::dyn_array_t *array_;
+};
+
+}
+
+#endif
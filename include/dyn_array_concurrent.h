@@ -0,0 +1,80 @@
+#ifndef DYN_ARRAY_CONCURRENT_H
+#define DYN_ARRAY_CONCURRENT_H
+
+#ifdef __cplusplus
+  extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stddef.h>
+
+typedef struct dyn_array_concurrent dyn_array_concurrent_t;
+
+/*
+    Concurrent notes!
+
+    An append-only dynamic array any number of threads can push to and read from at once.
+
+    Storage is a fixed table of segments that double in size (64, 128, 256, ... objects)
+    instead of one buffer that gets realloc'd, so an object never moves once written and
+    pointers from dyn_array_concurrent_at stay valid until the array is destroyed.
+
+    Pushing is lock-free: a fetch-and-add claims the index, the first thread to reach a new
+    segment installs it with a compare-and-swap (losers free theirs), the object is copied in
+    and then published with a release store. A reader that gets a published object's pointer
+    sees all of it. Indices below dyn_array_concurrent_size may still be in flight; at()
+    returns NULL for those until their push completes.
+
+    There is no erase or pop. destroy (and nothing else) must not race with other calls.
+*/
+
+///
+/// Creates a new concurrent array of data_type_size-sized objects
+/// \param data_type_size Size of the object type to be stored in bytes
+/// \return new concurrent array pointer, NULL on error
+///
+dyn_array_concurrent_t *dyn_array_concurrent_create(const size_t data_type_size);
+
+///
+/// Concurrent array destructor, must not race with any other call
+/// \param dyn_array The concurrent array to destruct
+///
+void dyn_array_concurrent_destroy(dyn_array_concurrent_t *const dyn_array);
+
+///
+/// Copies the given object to the back of the array, safe to call from any number of threads
+/// \param dyn_array the concurrent array
+/// \param object the object to insert
+/// \param index receives the index the object was stored at (NULL if not wanted)
+/// \return bool representing success of the operation
+///
+bool dyn_array_concurrent_push_back(dyn_array_concurrent_t *const dyn_array, const void *const object,
+                                    size_t *const index);
+
+///
+/// Returns a pointer to a published object. The pointer stays valid until the array is destroyed
+/// \param dyn_array the concurrent array
+/// \param index the index of the object to retrieve
+/// \return pointer to the requested object, NULL on error or if its push has not completed
+///
+void *dyn_array_concurrent_at(const dyn_array_concurrent_t *const dyn_array, const size_t index);
+
+///
+/// Returns the number of indices handed out so far, including pushes still in flight
+/// \param dyn_array the concurrent array
+/// \return the size of the array, 0 on error
+///
+size_t dyn_array_concurrent_size(const dyn_array_concurrent_t *const dyn_array);
+
+///
+/// Returns the size of the object stored in the array
+/// \param dyn_array the concurrent array
+/// \return the size of a stored object (bytes), 0 on error
+///
+size_t dyn_array_concurrent_data_size(const dyn_array_concurrent_t *const dyn_array);
+
+#ifdef __cplusplus
+  }
+#endif
+
+#endif
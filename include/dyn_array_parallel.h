@@ -0,0 +1,83 @@
+#ifndef DYN_ARRAY_PARALLEL_H
+#define DYN_ARRAY_PARALLEL_H
+
+#ifdef __cplusplus
+  extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "dyn_array.h"
+
+/*
+    Parallel notes!
+
+    The array is cut into fixed-size chunks of about DYN_PARALLEL_CHUNK_BYTES, rounded to a
+    multiple of 64 bytes, and worker threads claim chunks one at a time until none are left.
+    The array's data is not aligned to a cache line, so a chunk boundary can fall inside one
+    and the two chunks either side of it share that single line; no other line is shared.
+    The chunk boundaries only depend on the array's size and element size, never on the
+    thread count or on which thread ran what.
+
+    dyn_array_reduce folds each chunk into its own partial result, starting from the identity,
+    then combines the partials into the result in chunk order on the calling thread. The
+    order of every floating point operation is therefore fixed: the same array gives the same
+    bits with 1 thread or 64.
+
+    threads == 0 uses one thread per online CPU. The calling thread is one of the workers, and
+    if threads cannot be started the ones that did (or just the caller) do all the chunks.
+    The callbacks run concurrently, so they must only touch their own element/accumulator
+    and read arg.
+*/
+
+#ifndef DYN_PARALLEL_CHUNK_BYTES
+#define DYN_PARALLEL_CHUNK_BYTES ((size_t) 64 * 1024)
+#endif
+
+///
+/// Applies the given function to every object in the array, spread across threads
+/// \param dyn_array the dynamic array
+/// \param func the function to apply, called concurrently for different objects
+/// \param arg argument that will be passed to the function (as parameter 2)
+/// \param threads number of threads to use, 0 for one per online CPU
+/// \return bool representing success of operation (really just pointer and size checks)
+///
+bool dyn_array_parallel_for_each(dyn_array_t *const dyn_array, void (*const func)(void *const, void *), void *arg,
+                                 const size_t threads);
+
+///
+/// Applies the given function to every object in the array, claiming grain objects at a time.
+/// For objects that each stand for a lot of work (a whole simulation, a file block), where the
+/// default chunks of DYN_PARALLEL_CHUNK_BYTES would hand everything to one thread
+/// \param dyn_array the dynamic array
+/// \param func the function to apply, called concurrently for different objects
+/// \param arg argument that will be passed to the function (as parameter 2)
+/// \param threads number of threads to use, 0 for one per online CPU
+/// \param grain objects per chunk, 0 for the default chunking
+/// \return bool representing success of operation (really just pointer and size checks)
+///
+bool dyn_array_parallel_for_each_grain(dyn_array_t *const dyn_array, void (*const func)(void *const, void *),
+                                       void *arg, const size_t threads, const size_t grain);
+
+///
+/// Reduces the array to a single value, spread across threads with a deterministic combine order
+/// \param dyn_array the dynamic array
+/// \param result holds the identity value on entry and the reduced value on return
+/// \param result_size size of the result (and of every partial accumulator) in bytes
+/// \param fold folds one object (parameter 2) into an accumulator (parameter 1)
+/// \param combine merges a chunk's partial (parameter 2) into an accumulator (parameter 1)
+/// \param arg argument that will be passed to fold and combine (as parameter 3)
+/// \param threads number of threads to use, 0 for one per online CPU
+/// \return bool representing success of the operation (result is unchanged on failure)
+///
+bool dyn_array_reduce(const dyn_array_t *const dyn_array, void *const result, const size_t result_size,
+                      void (*const fold)(void *const, const void *const, void *),
+                      void (*const combine)(void *const, const void *const, void *), void *arg,
+                      const size_t threads);
+
+#ifdef __cplusplus
+  }
+#endif
+
+#endif
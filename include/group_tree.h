@@ -0,0 +1,109 @@
+#ifndef GROUP_TREE_H
+#define GROUP_TREE_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "dyn_array.h"
+
+/*
+    Group tree notes!
+
+    The cgroup-style hierarchy SCHEDULE_GROUP schedules over. Node 0 is the root; every
+    other node is named by its path from the root, components separated by '/', such as
+    "search/frontend". Each node has a weight (its share against its siblings, 0 counts
+    as 1) and a policy for picking among its children, which are its subgroups and the
+    PCBs tagged with it:
+      GROUP_FAIR  weighted fair: the child with the least virtual runtime (ticks run
+                  divided by weight) goes next
+      GROUP_RR    round robin: children take turns, one quantum each
+    Nodes named only as a path's ancestors are created with weight 1 and GROUP_FAIR.
+
+    Tree file form (group_tree_load), one node per line, '#' starts a comment:
+      <path> <weight> [fair|rr]
+    The root can be configured with the path "/".
+
+    Map file form (group_tree_load_map), one path per line, line i tagging the PCB at
+    index i of the ready queue; paths not in the tree are added to it.
+*/
+
+    typedef enum
+    {
+        GROUP_FAIR,
+        GROUP_RR
+    }
+    GroupPolicy_t;
+
+    typedef struct
+    {
+        uint32_t parent;            // the parent's id, UINT32_MAX for the root
+        uint32_t weight;            // share against the siblings
+        uint32_t depth;             // 0 for the root
+        GroupPolicy_t policy;       // how the node picks among its children
+    }
+    GroupNode_t;
+
+    typedef struct group_tree GroupTree_t;
+
+    // Creates a tree holding only the root
+    // \param root_policy how the root picks among its children
+    // \return the tree, NULL on error
+    GroupTree_t *group_tree_create(GroupPolicy_t root_policy);
+
+    // Frees the tree
+    // \param tree the tree to destroy
+    void group_tree_destroy(GroupTree_t *tree);
+
+    // Adds a node, or reconfigures it if the path is already there
+    // \param tree the tree
+    // \param path the node's path, "/" or "" for the root
+    // \param weight its share against its siblings
+    // \param policy how it picks among its children
+    // \param id receives its id, may be NULL
+    // \return true if function ran successful else false for an error
+    bool group_tree_add(GroupTree_t *tree, const char *path, uint32_t weight, GroupPolicy_t policy, uint32_t *id);
+
+    // Finds a node by path
+    // \param tree the tree
+    // \param path the node's path
+    // \param id receives its id
+    // \return true if the path is in the tree
+    bool group_tree_find(const GroupTree_t *tree, const char *path, uint32_t *id);
+
+    // Finds a node by path, adding it and any missing ancestors with the defaults if needed
+    // \param tree the tree
+    // \param path the node's path
+    // \param id receives its id
+    // \return true if function ran successful else false for an error
+    bool group_tree_intern(GroupTree_t *tree, const char *path, uint32_t *id);
+
+    // \param tree the tree
+    // \return the number of nodes, root included
+    size_t group_tree_size(const GroupTree_t *tree);
+
+    // \param tree the tree
+    // \param id the node
+    // \return the node, NULL if there is no such id
+    const GroupNode_t *group_tree_node(const GroupTree_t *tree, uint32_t id);
+
+    // Reads a tree in the file form described above
+    // \param path the file to read
+    // \return the tree (its root is GROUP_FAIR unless the file says otherwise), NULL on error
+    GroupTree_t *group_tree_load(const char *path);
+
+    // Reads a map file described above, interning its paths into the tree
+    // \param tree the tree the paths belong to
+    // \param path the file to read
+    // \return a dyn_array of uint32_t node ids, one per PCB, NULL on error
+    dyn_array_t *group_tree_load_map(GroupTree_t *tree, const char *path);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
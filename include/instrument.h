@@ -0,0 +1,87 @@
+#ifndef INSTRUMENT_H
+#define INSTRUMENT_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+    Instrumentation notes!
+
+    The counters and the trace hook are only compiled in when INSTRUMENT is defined
+    (configure with -DINSTRUMENT=ON). Without it every INSTRUMENT_* macro expands to
+    nothing, so the hot paths in dyn_array.c and process_scheduling.c cost exactly what
+    they did before.
+
+    Counters are thread local, so a run only sees the work done on its own thread.
+    Reset them before a run and snapshot them afterwards.
+
+    The trace writer is always available. When a trace is open, schedulers built with
+    INSTRUMENT append one Chrome trace "complete" event per slice a PCB ran for
+    (one tick is written as one microsecond). Load the file in chrome://tracing or Perfetto.
+    The writer is one per process and a lock keeps its events whole, but runs on several
+    threads at once write their slices into the same timeline, so trace one run at a time.
+*/
+
+    typedef struct
+    {
+        uint64_t context_switches;      // times the CPU changed from one PCB to another
+        uint64_t queue_ops;             // insertions and removals on scheduler queues
+        uint64_t memmove_bytes;         // bytes shifted by dyn_shift_insert/dyn_shift_remove
+        uint64_t reallocs;              // buffer reallocations in dyn_request_size_increase
+        uint64_t comparator_calls;      // scheduler comparisons (qsort comparators and selection scans)
+    }
+    InstrumentCounters_t;
+
+#ifdef INSTRUMENT
+
+#ifdef __cplusplus
+    extern thread_local InstrumentCounters_t instrument_counters;
+#else
+    extern _Thread_local InstrumentCounters_t instrument_counters;
+#endif
+
+#define INSTRUMENT_ADD(counter, n) (instrument_counters.counter += (uint64_t) (n))
+#define INSTRUMENT_SLICE(pid, start, length) instrument_trace_slice((pid), (start), (length))
+
+#else
+
+#define INSTRUMENT_ADD(counter, n) ((void) 0)
+#define INSTRUMENT_SLICE(pid, start, length) ((void) 0)
+
+#endif
+
+    // Tells whether the counters and trace hooks were compiled in
+    // \return true when built with INSTRUMENT
+    bool instrument_enabled(void);
+
+    // Zeroes the calling thread's counters
+    void instrument_reset(void);
+
+    // Copies the calling thread's counters
+    // \param counters destination for the snapshot (all zero when built without INSTRUMENT)
+    void instrument_snapshot(InstrumentCounters_t *counters);
+
+    // Opens a Chrome trace/Perfetto JSON file that later slices are written to
+    // Any trace that is already open is closed first
+    // \param path the file to create
+    // \return true if the file was opened
+    bool instrument_trace_open(const char *path);
+
+    // Records that pid ran from start for length ticks. No-op when no trace is open
+    // \param pid the PCB that ran
+    // \param start the tick it was dispatched at
+    // \param length how many ticks it ran for
+    void instrument_trace_slice(uint32_t pid, uint64_t start, uint64_t length);
+
+    // Finishes the JSON document and closes the trace file
+    void instrument_trace_close(void);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
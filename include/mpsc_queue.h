@@ -0,0 +1,48 @@
+#ifndef MPSC_QUEUE_H
+#define MPSC_QUEUE_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdbool.h>
+
+/*
+    Multi-producer single-consumer queue notes!
+
+    Any number of threads may push at once without taking a lock (one atomic exchange
+    per push). Only one thread at a time may pop; callers with several consumers must
+    serialise pops themselves (the runtime does so under its scheduler lock).
+
+    Items are plain pointers and come out in the order their pushes linearised.
+    A pop can briefly report empty while a producer is between its two steps;
+    the item shows up on a later pop.
+*/
+
+    typedef struct mpsc_queue MpscQueue_t;
+
+    // Creates an empty queue
+    // \return the queue, NULL on error
+    MpscQueue_t *mpsc_queue_create(void);
+
+    // Frees the queue and any nodes still in it (the items themselves are not touched)
+    // Must not race with push or pop
+    // \param queue the queue to destroy
+    void mpsc_queue_destroy(MpscQueue_t *queue);
+
+    // Appends an item. Safe to call from any number of threads
+    // \param queue the queue
+    // \param item the pointer to enqueue (NULL is not allowed)
+    // \return false if the queue or item was NULL or no node could be allocated
+    bool mpsc_queue_push(MpscQueue_t *queue, void *item);
+
+    // Removes the oldest item. Single consumer only
+    // \param queue the queue
+    // \return the item, NULL if the queue is (momentarily) empty
+    void *mpsc_queue_pop(MpscQueue_t *queue);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -0,0 +1,61 @@
+#ifndef MULTI_CPU_H
+#define MULTI_CPU_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdbool.h>
+
+#include "processing_scheduling.h"
+
+/*
+    Multi-CPU notes!
+
+    schedule_run hands runs with a topology to this engine. Every logical CPU of the
+    topology has its own run queue, ordered by schedule_policy_key like the executors'
+    queues. FCFS, SJF and P run a dispatched PCB to completion; RR and SRT run it for one
+    quantum and queue it again on the same CPU, SRT re-evaluating at quantum boundaries.
+
+    Arriving PCBs are queued on a CPU chosen by the config's placement, and stay there
+    unless the balance policy lets an idle CPU steal them (by default the least urgent of
+    the last 64 heap entries of the nearest CPU with a backlog, the busiest one among
+    equally near ones; that is the least urgent entry of any queue that short).
+
+    A CPU of speed s retires s / 1000 units of burst per tick (see topology.h), so a slice
+    of w units takes ceil(w * 1000 / s) ticks; a quantum is in ticks, whatever the speed.
+    SCHEDULE_PLACE_SPEED queues an arriving PCB where it is expected to finish first:
+    after the CPU's current slice and its queued burst, all run at the CPU's speed.
+    Speed also guides stealing: a thief faster than its victim takes the PCB with the most
+    burst left among the last 64 heap entries (the whole queue when it is short), which
+    gains the most from the faster core, and a slower thief only takes a PCB it would
+    finish before the victim could get through its queue.
+
+    A dispatch pays, on top of the cost model's switch and refill costs:
+      - when the PCB last ran elsewhere, migration_cost plus the topology's migration
+        cost for the distance it moved
+      - remote_percent more ticks when it runs off the socket its tenant was first queued on
+        (where its memory is), and smt_percent more when the CPU's SMT sibling is busy;
+        both are judged when the slice starts
+    Overheads count as waiting time, as on one CPU; stretched slices count as running.
+    total_run_time is when the last PCB finished; cpu_busy sums the ticks every CPU spent
+    running PCBs, stretch included. With core_classes the same is broken down per class.
+    A timeline gets every CPU's slices in dispatch order with no CPU attached, so slices
+    of different CPUs overlap in time; analysis refuses --timeline with --topology.
+
+    Burst arenas, deadlines, admission and shares are not modelled here and make the run
+    fail, as does a CPU queue or the event heap failing to grow mid-run.
+*/
+
+    // Runs config over every CPU of config->topology. Use schedule_run, which calls this
+    // \param ready queue a dyn_array of type ProcessControlBlock_t that contain be up to N elements
+    // \param result used for stat tracking \ref ScheduleResult_t
+    // \param config the algorithm and its options \ref ScheduleConfig_t, with a topology
+    // \return true if function ran successful else false for an error
+    bool multi_cpu_run(dyn_array_t *ready_queue, ScheduleResult_t *result, const ScheduleConfig_t *config);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
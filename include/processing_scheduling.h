@@ -9,7 +9,11 @@ extern "C"
 #include <stdbool.h>
 #include <stdint.h>
 
+#include "burst_arena.h"
 #include "dyn_array.h"
+#include "group_tree.h"
+#include "timeline.h"
+#include "topology.h"
 
     typedef struct 
     {
@@ -28,12 +32,220 @@ extern "C"
     } 
     ScheduleResult_t;
 
+    typedef enum
+    {
+        SCHEDULE_FCFS,                  // first come first served
+        SCHEDULE_SJF,                   // shortest job first (non-preemptive)
+        SCHEDULE_PRIORITY,              // lowest priority value first (non-preemptive)
+        SCHEDULE_RR,                    // round robin with config quantum
+        SCHEDULE_SRTF,                  // shortest remaining time first (preemptive)
+        SCHEDULE_EDF,                   // earliest deadline first (preemptive), deadlines from the config
+        SCHEDULE_STRIDE,                // stride scheduling, priority is the tickets, config quantum
+        SCHEDULE_LOTTERY,               // lottery scheduling, priority is the tickets, config quantum
+        SCHEDULE_GROUP                  // hierarchical group scheduling over the config's group tree, config quantum
+    }
+    SchedulePolicy_t;
+
+    // What switching the CPU between PCBs costs, in ticks. All zero (free switches) by default.
+    // A dispatch of a different PCB than the one that ran last pays switch_cost, plus a cache
+    // refill of refill_max * off / (off + refill_halflife) where off is how long the PCB has
+    // been off the CPU (PCBs that never ran pay the full refill_max).
+    typedef struct
+    {
+        uint32_t switch_cost;           // fixed cost of every context switch
+        uint32_t refill_max;            // cache refill penalty for a completely cold PCB
+        uint32_t refill_halflife;       // off-CPU ticks after which half of refill_max is paid
+        uint32_t migration_cost;        // extra cost when a PCB resumes on a different CPU (multi-CPU runs)
+    }
+    ScheduleCostModel_t;
+
+    // Extended results, filled in when ScheduleConfig_t::stats is set
+    typedef struct
+    {
+        uint64_t context_switches;      // dispatches of a different PCB than the one that ran last
+        uint64_t switch_overhead;       // ticks spent on switch_cost
+        uint64_t refill_overhead;       // ticks spent on cache refills
+        uint64_t migrations;            // resumptions on a different CPU
+        uint64_t migration_overhead;    // ticks spent on migration_cost
+        uint64_t cpu_busy;              // ticks the CPU spent running PCBs
+        uint64_t io_busy;               // device ticks spent on I/O phases (summed over devices)
+        uint64_t locality_overhead;     // ticks slices were stretched by remote memory and busy SMT siblings (multi-CPU runs)
+    }
+    ScheduleStats_t;
+
+    // Where a multi-CPU run queues a PCB when it arrives
+    typedef enum
+    {
+        SCHEDULE_PLACE_SPREAD,          // the least loaded CPU, preferring cores whose SMT siblings are idle
+        SCHEDULE_PLACE_PACK,            // the first idle CPU in id order, filling cores and sockets one at a time
+        SCHEDULE_PLACE_AFFINITY,        // like spread, but on the socket its tenant was first queued on unless that is overloaded
+        SCHEDULE_PLACE_SPEED            // the CPU expected to finish it soonest given its queued work and speed
+    }
+    SchedulePlacement_t;
+
+    // What an idle CPU of a multi-CPU run does when its own queue is empty
+    typedef enum
+    {
+        SCHEDULE_BALANCE_NONE,          // waits for work placed on it
+        SCHEDULE_BALANCE_STEAL,         // takes a queued PCB from the nearest CPU that has one
+        SCHEDULE_BALANCE_SOCKET         // the same, only from CPUs on its own socket
+    }
+    ScheduleBalance_t;
+
+    // A core class's part of a multi-CPU run, entry k of ScheduleConfig_t::core_classes for class k
+    typedef struct
+    {
+        uint32_t speed;                 // burst its CPUs retire per 1000 ticks
+        uint32_t cpus;                  // CPUs in the class
+        uint64_t busy;                  // ticks its CPUs spent running PCBs
+        uint64_t work;                  // burst its CPUs retired
+        uint64_t slices;                // slices its CPUs ran
+        uint64_t finished;              // PCBs whose last slice ran on the class
+        uint64_t turnaround;            // their turnaround times, summed
+    }
+    ScheduleCoreClass_t;
+
+    // Most tickets (priority) or group weight a stride or group run accepts
+    #define SCHEDULE_TICKETS_MAX (1u << 16)
+
+    // A PCB's real-time constraints, entry i of ScheduleConfig_t::deadlines for ready queue index i
+    typedef struct
+    {
+        uint32_t deadline;              // ticks after arrival it has to be done by, 0 for the period (none if aperiodic)
+        uint32_t period;                // ticks between releases of the task it belongs to, 0 if aperiodic
+    }
+    PcbDeadline_t;
+
+    // Buckets of ScheduleDeadlineStats_t::lateness
+    #define SCHEDULE_LATENESS_BUCKETS 33
+
+    // Deadline results, filled in when ScheduleConfig_t::deadline_stats is set
+    typedef struct
+    {
+        uint64_t jobs;                  // PCBs that had a deadline and ran
+        uint64_t misses;                // of those, the ones done after their deadline
+        uint64_t rejected;              // PCBs turned away by admission control, they never run
+        uint64_t max_lateness;          // most ticks any PCB finished past its deadline
+        uint64_t total_lateness;        // ticks past the deadline, summed over the misses
+        uint64_t lateness[SCHEDULE_LATENESS_BUCKETS]; // 0: on time, b: late by [2^(b-1), 2^b) ticks
+    }
+    ScheduleDeadlineStats_t;
+
+    // A tenant's CPU share, entry t of ScheduleConfig_t::shares for tenant id t
+    typedef struct
+    {
+        uint64_t pcbs;                  // PCBs the tenant owns
+        uint64_t tickets;               // their tickets, summed
+        uint64_t received;              // CPU ticks its PCBs ran for
+        double entitled;                // CPU ticks its tickets were owed while its PCBs were runnable
+    }
+    ScheduleShare_t;
+
+    typedef struct
+    {
+        SchedulePolicy_t policy;        // the algorithm to run
+        size_t quantum;                 // time slice for SCHEDULE_RR, SCHEDULE_STRIDE and SCHEDULE_LOTTERY
+        Timeline_t *timeline;           // optional, receives the Gantt chart of the run (NULL to disable)
+        ScheduleCostModel_t costs;      // dispatch costs charged by every policy
+        ScheduleStats_t *stats;         // optional, receives the extended results (NULL to disable)
+        const BurstArena_t *bursts;     // optional CPU/I/O phases, entry i for ready queue index i (NULL: CPU only)
+        size_t io_devices;              // I/O phases served at once, the rest queue FIFO (0: no limit)
+        const dyn_array_t *deadlines;   // optional PcbDeadline_t, entry i for ready queue index i (NULL: none)
+        bool admission;                 // turn away PCBs whose deadline the admitted load cannot guarantee
+        ScheduleDeadlineStats_t *deadline_stats; // optional, receives the deadline results (NULL to disable)
+        uint64_t seed;                  // seeds the draws of SCHEDULE_LOTTERY
+        const dyn_array_t *tenants;     // optional uint32_t tenant id, entry i for ready queue index i (NULL: one per PCB)
+        dyn_array_t *shares;            // optional, resized to one ScheduleShare_t per tenant id (NULL to disable)
+        const GroupTree_t *groups;      // the hierarchy SCHEDULE_GROUP runs over
+        const dyn_array_t *group_of;    // uint32_t group id, entry i for ready queue index i (SCHEDULE_GROUP)
+        const Topology_t *topology;     // optional, simulates every CPU of this machine (NULL: one virtual CPU)
+        SchedulePlacement_t placement;  // where a multi-CPU run queues arriving PCBs
+        ScheduleBalance_t balance;      // how idle CPUs of a multi-CPU run find work
+        dyn_array_t *core_classes;      // optional, resized to one ScheduleCoreClass_t per core class of a multi-CPU run (NULL to disable)
+    }
+    ScheduleConfig_t;
+
     // Reads the PCB burst time values from the binary file into ProcessControlBlock_t remaining_burst_time field
     // for N number of PCB burst time stored in the file.
     // \param input_file the file containing the PCB burst times
     // \return a populated dyn_array of ProcessControlBlocks if function ran successful else NULL for an error
     dyn_array_t *load_process_control_blocks(const char *input_file);
 
+    // Fills in the defaults for a policy: quantum 1 for round robin, no optional outputs
+    // Prefer this over brace initialisation so new options keep their defaults
+    // \param config the config to initialise
+    // \param policy the algorithm the config selects
+    void schedule_config_init(ScheduleConfig_t *config, SchedulePolicy_t policy);
+
+    // Looks up a policy by its command line name (FCFS, SJF, P, RR, SRT, EDF, STRIDE, LOTTERY, GROUP)
+    // \param name the name to look up
+    // \param policy receives the policy
+    // \return true if the name is known
+    bool schedule_policy_from_name(const char *name, SchedulePolicy_t *policy);
+
+    // \param policy the policy
+    // \return the command line name of the policy, NULL for an unknown policy
+    const char *schedule_policy_name(SchedulePolicy_t policy);
+
+    // The value a policy minimises when it picks what runs next, so executors outside the
+    // simulator order their queues the same way. FIFO policies (FCFS, RR) use sequence, and so
+    // do EDF, whose deadlines only the simulator's config carries, and the proportional share
+    // and group policies, whose passes, draws and trees only the simulator keeps
+    // \param policy the policy
+    // \param pcb the candidate's descriptor
+    // \param sequence the candidate's admission order
+    // \return the key, smaller runs first
+    uint64_t schedule_policy_key(SchedulePolicy_t policy, const ProcessControlBlock_t *pcb, uint64_t sequence);
+
+    // Runs the algorithm selected by config over the incoming ready_queue
+    // The named entry points below are shorthands for this with a default config
+    // With a burst arena, a PCB's remaining_burst_time is replaced by its first CPU phase and it
+    // blocks between CPU phases; waiting time then only counts time spent in the ready queue
+    // With deadlines, every policy reports misses and lateness. Admission control admits a PCB
+    // only while the densities (burst / deadline, the period for a periodic PCB without a deadline
+    // of its own) of the admitted PCBs whose deadlines have not passed sum to at most 1, which guarantees EDF meets every admitted deadline; turned away
+    // PCBs are left out of the averages
+    // Stride and lottery give each PCB max(priority, 1) tickets, so unlike SCHEDULE_PRIORITY a
+    // bigger value gets more CPU. Stride runs the smallest pass (kept in a heap) for a quantum
+    // and advances it by quantum / tickets; lottery draws a ready PCB with probability
+    // proportional to its tickets from a Fenwick tree. Both pick in O(log n). Passes advance in
+    // whole steps, so stride and group runs refuse tickets and weights above
+    // SCHEDULE_TICKETS_MAX, which keeps the rounding of any share under 0.4%
+    // Group scheduling walks the group tree from the root, each node picking among its runnable
+    // subgroups and PCBs by its own policy, and runs the PCB it reaches for a quantum; PCBs
+    // weigh max(priority, 1) against their siblings. Every node keeps its runnable children in
+    // a heap and counts the runnable PCBs below it, so a pick is O(depth * log fanout).
+    // With a topology, the run is simulated on every CPU of the machine as described in
+    // multi_cpu.h, for FCFS, SJF, P, RR and SRT
+    // With shares, every policy reports what each tenant received against what its tickets
+    // entitled it to: each tick of CPU is owed to the runnable PCBs in proportion to their tickets
+    // \param ready queue a dyn_array of type ProcessControlBlock_t that contain be up to N elements
+    // \param result used for stat tracking \ref ScheduleResult_t
+    // \param config the algorithm and its options \ref ScheduleConfig_t
+    // \return true if function ran successful else false for an error
+    bool schedule_run(dyn_array_t *ready_queue, ScheduleResult_t *result, const ScheduleConfig_t *config);
+
+    // Runs like schedule_run, but cuts the run into busy periods (stretches between idle CPU gaps)
+    // and simulates those on threads at once. The queue drains at every cut, so every policy
+    // schedules each period exactly as the serial run does and the merged totals are the same.
+    // Runs with switch costs or a burst arena, whose busy periods depend on the policy, go to
+    // schedule_run unchanged, as do the proportional share and group policies, multi-CPU runs and
+    // runs with shares, whose passes, draws, virtual runtimes, placements and entitlements carry
+    // over between periods
+    // \param ready queue a dyn_array of type ProcessControlBlock_t that contain be up to N elements
+    // \param result used for stat tracking \ref ScheduleResult_t
+    // \param config the algorithm and its options \ref ScheduleConfig_t
+    // \param threads number of threads to use, 0 for one per online CPU
+    // \return true if function ran successful else false for an error
+    bool schedule_run_parallel(dyn_array_t *ready_queue, ScheduleResult_t *result, const ScheduleConfig_t *config,
+                               size_t threads);
+
+    // Share accuracy of a run: the ticks tenants received away from their entitlement, as a
+    // fraction of all entitled ticks (0 is a perfectly proportional share)
+    // \param shares the ScheduleConfig_t::shares a run filled in
+    // \return sum |received - entitled| / sum entitled, 0 for an empty or invalid array
+    double schedule_share_error(const dyn_array_t *shares);
+
     // Runs the First Come First Served Process Scheduling algorithm over the incoming ready_queue
     // \param ready queue a dyn_array of type ProcessControlBlock_t that contain be up to N elements
     // \param result used for first come first served stat tracking \ref ScheduleResult_t
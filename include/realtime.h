@@ -0,0 +1,71 @@
+#ifndef REALTIME_H
+#define REALTIME_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "dyn_array.h"
+
+/*
+    Real-time notes!
+
+    Offline schedulability tests for sporadic task sets run by EDF on one CPU. A task
+    releases a job of wcet ticks at least period ticks apart, and every job has to be
+    done deadline ticks after its release (0 means the period, an implicit deadline).
+
+    The utilisation test sums wcet / period. A set above 1 can never be scheduled; at
+    or below 1 it is exact for implicit deadlines and only necessary otherwise.
+
+    The demand bound test is the processor demand criterion: the set is schedulable iff
+    for every absolute deadline t, the work of the jobs released and due inside [0, t]
+    is at most t. Only deadlines up to the shorter of the synchronous busy period and
+    the Baruah bound need checking. The deadlines are walked in order with a heap
+    holding each task's next one, so every step is O(log n) and the demand grows by
+    one wcet per step.
+
+    Deadline tables for ScheduleConfig_t are raw PcbDeadline_t records, one per PCB in
+    the same order as the PCB file. A PCB with a period stands for a sporadic task whose
+    jobs take its burst time, so a trace's periodic PCBs make a task set for the tests.
+*/
+
+    typedef struct
+    {
+        uint32_t wcet;          // worst case ticks per job
+        uint32_t deadline;      // ticks after release a job has to be done by, 0 for the period
+        uint32_t period;        // least ticks between releases, must not be 0
+    }
+    RealtimeTask_t;
+
+    // Sums the utilisations of the tasks
+    // \param tasks a dyn_array of RealtimeTask_t
+    // \param utilisation receives the sum of wcet / period, may be NULL
+    // \return true if the sum is at most 1, false if it is above or the input is invalid
+    bool realtime_utilisation_test(const dyn_array_t *tasks, double *utilisation);
+
+    // Runs the processor demand criterion on the tasks
+    // \param tasks a dyn_array of RealtimeTask_t
+    // \param schedulable receives whether EDF meets every deadline of the set
+    // \return true if the test ran, false for invalid input or a bound past 2^63 ticks
+    bool realtime_demand_bound_test(const dyn_array_t *tasks, bool *schedulable);
+
+    // Collects the task set a trace's periodic PCBs stand for, one task per PCB with a period
+    // \param pcbs a dyn_array of ProcessControlBlock_t, before it is run
+    // \param deadlines a dyn_array of PcbDeadline_t, entry i for PCB i
+    // \return a dyn_array of RealtimeTask_t, NULL on error or if the table is too short
+    dyn_array_t *realtime_periodic_tasks(const dyn_array_t *pcbs, const dyn_array_t *deadlines);
+
+    // Loads a deadline table written as raw PcbDeadline_t records
+    // \param input_file the file to read
+    // \return a dyn_array of PcbDeadline_t, NULL on error
+    dyn_array_t *realtime_load_deadlines(const char *input_file);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -0,0 +1,125 @@
+#ifndef RESULT_CACHE_H
+#define RESULT_CACHE_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "dyn_array.h"
+
+/*
+    Result cache notes!
+
+    A directory of simulation results keyed by a hash of everything that went into them:
+    the trace and input file contents and the run's settings, fed to a ResultHasher_t by
+    the caller. The same inputs give the same key on any machine, so a cache directory can
+    be shared by jobs and kept between runs; a different input gives a different key and
+    simply misses. The hash is a fast 128 bit one, not a cryptographic one: it keeps honest
+    inputs apart, it does not stand up to someone crafting collisions.
+
+    Every entry is one file, <32 hex digit key>.res: a header with a magic, the key, the
+    payload size and a hash of the payload, then the payload. Entries are written to a
+    temporary file in the same directory and renamed over the final name, so readers only
+    ever see whole entries, and concurrent writers of the same key leave one of their
+    (identical) entries. A hit whose header or payload hash does not match is removed and
+    reported as a miss.
+
+    Hashing a large trace on every run costs more than many of the runs it keys, so
+    result_hasher_file_memo keeps each trace's digest next to it in "<trace>.digest",
+    with the trace's size, modification time (ns) and inode, and only reads the trace
+    again once one of those changed. Like "<trace>.idx" it is written to a temporary
+    file and renamed into place. A rewrite that keeps all three (same size, a restored
+    mtime, in place) is not noticed; result_hasher_file always reads the file.
+
+    Recency is the entry's modification time: a hit touches it. After every store the
+    cache adds up its entries and removes the least recently used until it fits in
+    max_bytes. An entry larger than max_bytes is not stored at all.
+*/
+
+    // Content key of a cached result
+    typedef struct
+    {
+        uint64_t high;
+        uint64_t low;
+    }
+    ResultKey_t;
+
+    // Hash state being fed the inputs of a run
+    typedef struct
+    {
+        uint64_t lanes[2];
+        uint64_t length;            // bytes fed so far
+        uint8_t tail[8];            // bytes waiting to make up a whole word
+    }
+    ResultHasher_t;
+
+    typedef struct result_cache ResultCache_t;
+
+    // \param hasher the hasher to reset
+    void result_hasher_init(ResultHasher_t *hasher);
+
+    // Feeds bytes to the hash
+    // \param hasher the hasher
+    // \param data the bytes
+    // \param size how many
+    void result_hasher_update(ResultHasher_t *hasher, const void *data, size_t size);
+
+    // Feeds a number to the hash, the same on every byte order
+    // \param hasher the hasher
+    // \param value the number
+    void result_hasher_u64(ResultHasher_t *hasher, uint64_t value);
+
+    // Feeds a file's size and contents to the hash
+    // \param hasher the hasher
+    // \param path the file
+    // \return true if the whole file was read
+    bool result_hasher_file(ResultHasher_t *hasher, const char *path);
+
+    // Feeds a file like result_hasher_file, reusing the digest kept in "<path>.digest" while
+    // the file's size, modification time and inode still match it, and refreshing it otherwise
+    // \param hasher the hasher
+    // \param path the file
+    // \return true if the file's digest was found or the whole file was read
+    bool result_hasher_file_memo(ResultHasher_t *hasher, const char *path);
+
+    // \param hasher the hasher, left as it was
+    // \return the key of everything fed so far
+    ResultKey_t result_hasher_final(const ResultHasher_t *hasher);
+
+    // Opens a cache directory, creating it if it does not exist
+    // \param path the directory
+    // \param max_bytes how many bytes of entries it may hold
+    // \return the cache, NULL on error
+    ResultCache_t *result_cache_open(const char *path, uint64_t max_bytes);
+
+    // \param cache the cache to close; its entries stay on disk
+    void result_cache_close(ResultCache_t *cache);
+
+    // Looks a result up, marking it as just used
+    // \param cache the cache
+    // \param key the key
+    // \param payload a dyn_array of uint8_t, resized to the stored payload on a hit
+    // \return true on a hit
+    bool result_cache_get(ResultCache_t *cache, ResultKey_t key, dyn_array_t *payload);
+
+    // Stores a result, then evicts the least recently used entries until the cache fits
+    // \param cache the cache
+    // \param key the key
+    // \param data the payload
+    // \param size its size in bytes
+    // \return true if it was stored
+    bool result_cache_put(ResultCache_t *cache, ResultKey_t key, const void *data, size_t size);
+
+    // \param cache the cache
+    // \return bytes its entries take up, headers included
+    uint64_t result_cache_bytes(const ResultCache_t *cache);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
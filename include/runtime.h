@@ -0,0 +1,88 @@
+#ifndef RUNTIME_H
+#define RUNTIME_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "processing_scheduling.h"
+
+/*
+    Runtime notes!
+
+    The runtime executes real work on real threads with the same policies the simulator
+    models. Producers call runtime_submit from any thread; submissions go through a
+    lock-free MPSC queue and never block. Worker threads drain that queue into the
+    ready queue and dispatch by the policy in the ScheduleConfig_t:
+
+      FCFS        submission order, run to completion
+      SJF         smallest remaining_burst_time estimate, run to completion
+      PRIORITY    smallest priority value, run to completion
+      RR          submission order, one step per dispatch, then back of the queue
+      SRTF        smallest remaining_burst_time estimate, re-evaluated after every step
+
+    Work is a step function that does at most one quantum of work and returns true while
+    more remains. Non-preemptive policies call it until it returns false; the preemptive
+    ones put the task back after every step. For SRTF each step counts as config->quantum
+    units off the task's remaining_burst_time estimate.
+
+    Dispatch latency is the time from runtime_submit to the first step starting.
+    A task the ready queue has no room for (the allocation failed) is dropped and
+    counted, so runtime_wait still returns once every task is completed or dropped.
+*/
+
+    typedef struct runtime Runtime_t;
+
+    // One step of a task's work
+    // \param arg the argument given at submission
+    // \return true if the task has more work, false once it is done
+    typedef bool (*RuntimeWork_t)(void *arg);
+
+    typedef struct
+    {
+        uint64_t submitted;                 // tasks accepted by runtime_submit
+        uint64_t completed;                 // tasks whose work returned false
+        uint64_t dropped;                   // tasks given up unfinished because the ready queue could not grow
+        uint64_t dispatches;                // steps handed to workers
+        uint64_t total_dispatch_latency_ns; // sum over tasks of submit to first step
+        uint64_t max_dispatch_latency_ns;   // worst single dispatch latency
+    }
+    RuntimeStats_t;
+
+    // Starts a runtime with the given number of worker threads
+    // \param workers number of worker threads (at least one)
+    // \param config the dispatch policy and RR/SRTF quantum (copied)
+    // \return the runtime, NULL on error
+    Runtime_t *runtime_create(size_t workers, const ScheduleConfig_t *config);
+
+    // Queues a task. Lock-free, callable from any thread
+    // \param runtime the runtime
+    // \param descriptor burst estimate and priority used by the policy (arrival is ignored)
+    // \param work the step function
+    // \param arg passed to every step
+    // \return true if the task was queued
+    bool runtime_submit(Runtime_t *runtime, const ProcessControlBlock_t *descriptor, RuntimeWork_t work, void *arg);
+
+    // Blocks until every task submitted so far has completed
+    // \param runtime the runtime
+    void runtime_wait(Runtime_t *runtime);
+
+    // Copies the runtime's counters
+    // \param runtime the runtime
+    // \param stats destination for the counters
+    // \return true if function ran successful else false for an error
+    bool runtime_stats(Runtime_t *runtime, RuntimeStats_t *stats);
+
+    // Waits for outstanding work, stops the workers and frees the runtime
+    // \param runtime the runtime to destroy
+    void runtime_destroy(Runtime_t *runtime);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
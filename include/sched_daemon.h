@@ -0,0 +1,143 @@
+#ifndef SCHED_DAEMON_H
+#define SCHED_DAEMON_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "processing_scheduling.h"
+
+/*
+    Scheduling daemon notes!
+
+    A long running process that keeps traces in memory and answers scheduling queries over
+    a Unix domain socket, so interactive tools pay neither process start up nor a trace load
+    per question. A trace is pinned the first time a query names it (or up front with
+    sched_daemon_pin): the file is read into memory the daemon owns, and a trace that is not
+    sorted by arrival gets a stable (arrival, record) order next to it. A query only copies
+    out the PCBs it keeps, since a run consumes their burst times. Every query checks the
+    file's inode, size and modification time, and a trace that changed is read again; the
+    old copy lives on until the queries still reading it are done. Loads run outside the
+    trace table's lock, so a big load does not stall queries on other traces; two workers
+    loading the same trace at once keep whichever copy is pinned first. Because the daemon
+    never reads the file through a mapping, a trace may be rewritten, truncated or replaced
+    at any time without taking the daemon down.
+
+    Queries take the same window as trace_merge: without one the whole trace runs in file
+    order, like load_process_control_blocks; with one, the PCBs arriving in [arrival_start,
+    arrival_end], in arrival order with ties in file order, then pcb_count of those from
+    first_pcb. The daemon runs the single CPU engine without side inputs, so GROUP, deadlines,
+    phases and tenants are not available through it.
+
+    Protocol, one exchange at a time per connection, any number of exchanges per connection:
+      request   uint32_t magic, uint32_t path length, SchedQuery_t, the trace path (no NUL)
+      answer    SchedAnswer_t
+    Both ends are on one machine and built from this header, so the structs travel as they
+    are in memory; the magic carries a version and a mismatched client is disconnected.
+
+    One thread polls the listening socket and the idle connections and hands every
+    connection with a request waiting to a pool of workers; a worker answers that one
+    request and gives the connection back. A client that stalls mid request is dropped
+    after SCHED_DAEMON_TIMEOUT_MS.
+*/
+
+    #define SCHED_DAEMON_MAGIC 0x31445153u       // "SQD1"
+    #define SCHED_DAEMON_PATH_MAX 4096
+    #define SCHED_DAEMON_TIMEOUT_MS 5000
+
+    typedef enum
+    {
+        SCHED_DAEMON_OK,
+        SCHED_DAEMON_BAD_QUERY,         // unknown policy or an empty arrival range
+        SCHED_DAEMON_NO_TRACE,          // the trace could not be read
+        SCHED_DAEMON_RUN_FAILED         // the engine refused the run (e.g. GROUP, an empty window)
+    }
+    SchedDaemonStatus_t;
+
+    typedef struct
+    {
+        uint32_t policy;                // SchedulePolicy_t
+        uint32_t windowed;              // apply the window below, in arrival order
+        uint64_t quantum;               // 0 keeps the policy's default
+        ScheduleCostModel_t costs;
+        uint64_t seed;                  // lottery seed
+        uint32_t arrival_start;         // earliest arrival kept
+        uint32_t arrival_end;           // latest arrival kept (inclusive)
+        uint64_t first_pcb;             // PCBs of the window to skip
+        uint64_t pcb_count;             // PCBs to keep after those, UINT64_MAX for all
+    }
+    SchedQuery_t;
+
+    typedef struct
+    {
+        uint32_t status;                // SchedDaemonStatus_t
+        uint32_t reserved;
+        ScheduleResult_t result;
+        ScheduleStats_t stats;
+        uint64_t pcbs;                  // PCBs the query ran
+        uint64_t total_burst;           // their burst times, summed
+        uint64_t longest_burst;
+        uint64_t priority_sum;
+        uint64_t last_arrival;
+        uint64_t run_ns;                // time the daemon spent on the query
+    }
+    SchedAnswer_t;
+
+    typedef struct sched_daemon SchedDaemon_t;
+    typedef struct sched_client SchedClient_t;
+
+    // Fills in a query of the whole trace in file order with the policy's defaults and free switches
+    // \param query the query to initialise
+    // \param policy the algorithm it runs
+    void sched_query_init(SchedQuery_t *query, SchedulePolicy_t policy);
+
+    // Binds and listens on a socket, replacing a stale socket file left at the path
+    // \param socket_path where to listen
+    // \param workers queries answered at once, 0 for one per online CPU
+    // \return the daemon, NULL on error
+    SchedDaemon_t *sched_daemon_create(const char *socket_path, size_t workers);
+
+    // Reads a trace in now rather than on its first query
+    // \param daemon the daemon
+    // \param trace_path the trace
+    // \return true if it is pinned
+    bool sched_daemon_pin(SchedDaemon_t *daemon, const char *trace_path);
+
+    // Answers queries until sched_daemon_stop; call once
+    // \param daemon the daemon
+    // \return true if it stopped because it was asked to
+    bool sched_daemon_serve(SchedDaemon_t *daemon);
+
+    // Makes sched_daemon_serve return. Safe from other threads and from signal handlers
+    // \param daemon the daemon
+    void sched_daemon_stop(SchedDaemon_t *daemon);
+
+    // Closes the socket, removes its file and frees the traces
+    // \param daemon the daemon to destroy, no longer serving
+    void sched_daemon_destroy(SchedDaemon_t *daemon);
+
+    // \param socket_path the daemon's socket
+    // \return a connection, NULL if no daemon listens there
+    SchedClient_t *sched_client_open(const char *socket_path);
+
+    // Asks one query. Relative trace paths are resolved against the caller's directory
+    // \param client the connection
+    // \param trace_path the trace
+    // \param query what to run \ref SchedQuery_t
+    // \param answer receives the answer, its status telling whether the query ran
+    // \return true if an answer came back, false if the connection failed
+    bool sched_client_query(SchedClient_t *client, const char *trace_path, const SchedQuery_t *query,
+                            SchedAnswer_t *answer);
+
+    // \param client the connection to close
+    void sched_client_close(SchedClient_t *client);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -0,0 +1,354 @@
+#ifndef SCHED_KERNEL_HPP
+#define SCHED_KERNEL_HPP
+
+#include <algorithm>
+#include <cstdint>
+
+#include "dyn_array.hpp"
+#include "processing_scheduling.h"
+#include "timeline.h"
+
+/*
+    Scheduler kernel notes!
+
+    sched::Kernel<Queue, Preemption> is the single CPU simulation loop with the policy
+    pulled out into three kinds of type parameter:
+
+      Queue        how the ready queue orders jobs: FifoQueue, or MinKeyQueue<Key> with
+                   ArrivalKey, RemainingKey or PriorityKey (ties go to the earliest admitted)
+      Preemption   how long a dispatched job may run: NonPreemptive, PreemptOnArrival or
+                   Quantum (RR's time slice)
+      Collector    what is measured: MeanMetrics (ScheduleResult_t), TimelineMetrics,
+                   SwitchCounter, or any two combined with Collect<A, B>
+
+    Everything is resolved at compile time, so each combination becomes one loop with the
+    key reads, comparisons and collector calls inlined. A new policy is a new combination
+    (or one new small type), not a new loop. The common ones are aliased below and give the
+    same results as schedule_run with free switches and no I/O phases.
+*/
+
+namespace sched
+{
+
+// A PCB in flight: pid is its index in the input, sequence its admission order
+struct Job
+{
+    ProcessControlBlock_t *pcb;
+    uint32_t pid;
+    uint32_t burst;
+    uint64_t sequence;
+};
+
+struct ArrivalKey
+{
+    static uint32_t key(const Job &job)
+    {
+        return job.pcb->arrival;
+    }
+};
+
+struct RemainingKey
+{
+    static uint32_t key(const Job &job)
+    {
+        return job.pcb->remaining_burst_time;
+    }
+};
+
+struct PriorityKey
+{
+    static uint32_t key(const Job &job)
+    {
+        return job.pcb->priority;
+    }
+};
+
+// Queue disciplines: push(job), empty(), pop() -> job
+
+class FifoQueue
+{
+public:
+    void push(const Job &job)
+    {
+        jobs_.push_back(job);
+    }
+
+    bool empty() const
+    {
+        return head_ == jobs_.size();
+    }
+
+    Job pop()
+    {
+        const Job job = jobs_[head_++];
+        // drop the consumed prefix once it dominates, one memmove instead of a shift per pop
+        if (head_ > 64 && head_ * 2 > jobs_.size())
+        {
+            jobs_.erase(0, head_);
+            head_ = 0;
+        }
+        return job;
+    }
+
+private:
+    dyn::dyn_array<Job> jobs_;
+    size_t head_ = 0;
+};
+
+template <typename Key>
+class MinKeyQueue
+{
+public:
+    void push(const Job &job)
+    {
+        jobs_.push_back(job);
+    }
+
+    bool empty() const
+    {
+        return jobs_.empty();
+    }
+
+    Job pop()
+    {
+        const Job *first = jobs_.begin();
+        const Job *best = first;
+        for (const Job *job = first + 1; job != jobs_.end(); ++job)
+        {
+            const uint32_t key = Key::key(*job);
+            const uint32_t best_key = Key::key(*best);
+            if (key < best_key || (key == best_key && job->sequence < best->sequence))
+            {
+                best = job;
+            }
+        }
+        const Job job = *best;
+        jobs_.erase(static_cast<size_t>(best - first));
+        return job;
+    }
+
+private:
+    dyn::dyn_array<Job> jobs_;
+};
+
+// Preemption rules: slice(job, ticks until the next arrival) -> ticks to run
+
+struct NonPreemptive
+{
+    uint32_t slice(const Job &job, uint64_t) const
+    {
+        return job.pcb->remaining_burst_time;
+    }
+};
+
+struct PreemptOnArrival
+{
+    uint32_t slice(const Job &job, uint64_t until_arrival) const
+    {
+        return until_arrival < job.pcb->remaining_burst_time ? static_cast<uint32_t>(until_arrival)
+                                                              : job.pcb->remaining_burst_time;
+    }
+};
+
+struct Quantum
+{
+    explicit Quantum(uint32_t ticks = 1) : quantum(ticks) {}
+
+    uint32_t slice(const Job &job, uint64_t) const
+    {
+        return quantum < job.pcb->remaining_burst_time ? quantum : job.pcb->remaining_burst_time;
+    }
+
+    uint32_t quantum;
+};
+
+// Collectors: slice(job, start, length), complete(job, clock), finish(clock, count)
+
+class MeanMetrics
+{
+public:
+    void slice(const Job &, uint64_t, uint32_t) {}
+
+    void complete(const Job &job, uint64_t clock)
+    {
+        const uint64_t turnaround = clock - job.pcb->arrival;
+        turnaround_ += turnaround;
+        waiting_ += turnaround - job.burst;
+    }
+
+    void finish(uint64_t clock, size_t count)
+    {
+        result_.average_waiting_time = static_cast<float>(waiting_) / count;
+        result_.average_turnaround_time = static_cast<float>(turnaround_) / count;
+        result_.total_run_time = clock;
+    }
+
+    const ScheduleResult_t &result() const
+    {
+        return result_;
+    }
+
+private:
+    uint64_t waiting_ = 0;
+    uint64_t turnaround_ = 0;
+    ScheduleResult_t result_ = ScheduleResult_t();
+};
+
+class TimelineMetrics
+{
+public:
+    explicit TimelineMetrics(Timeline_t *timeline) : timeline_(timeline) {}
+
+    void slice(const Job &job, uint64_t start, uint32_t length)
+    {
+        timeline_record(timeline_, job.pid, start, length);
+    }
+
+    void complete(const Job &, uint64_t) {}
+    void finish(uint64_t, size_t) {}
+
+    Timeline_t *timeline() const
+    {
+        return timeline_;
+    }
+
+private:
+    Timeline_t *timeline_;
+};
+
+class SwitchCounter
+{
+public:
+    void slice(const Job &job, uint64_t, uint32_t)
+    {
+        if (job.pid != last_)
+        {
+            switches_ += last_ != UINT32_MAX;
+            last_ = job.pid;
+        }
+    }
+
+    void complete(const Job &, uint64_t) {}
+    void finish(uint64_t, size_t) {}
+
+    uint64_t switches() const
+    {
+        return switches_;
+    }
+
+private:
+    uint64_t switches_ = 0;
+    uint32_t last_ = UINT32_MAX;    // nothing has run yet
+};
+
+template <typename A, typename B>
+struct Collect
+{
+    void slice(const Job &job, uint64_t start, uint32_t length)
+    {
+        first.slice(job, start, length);
+        second.slice(job, start, length);
+    }
+
+    void complete(const Job &job, uint64_t clock)
+    {
+        first.complete(job, clock);
+        second.complete(job, clock);
+    }
+
+    void finish(uint64_t clock, size_t count)
+    {
+        first.finish(clock, count);
+        second.finish(clock, count);
+    }
+
+    A first;
+    B second;
+};
+
+template <typename Queue, typename Preemption>
+struct Kernel
+{
+    // Simulates pcbs (consuming their remaining_burst_time) and reports to collector
+    // \return false for an empty input, or a preemption giving a slice of 0 to a job with burst
+    //         left (e.g. Quantum(0)), which would never finish
+    template <typename Collector>
+    static bool run(dyn::dyn_array<ProcessControlBlock_t> &pcbs, Collector &collector,
+                    const Preemption &preemption = Preemption())
+    {
+        const size_t n = pcbs.size();
+        if (!n)
+        {
+            return false;
+        }
+
+        dyn::dyn_array<Job> jobs(n);
+        for (size_t i = 0; i < n; ++i)
+        {
+            jobs.push_back(Job{&pcbs[i], static_cast<uint32_t>(i), pcbs[i].remaining_burst_time, 0});
+        }
+        jobs.sort([](const Job &a, const Job &b) {
+            return a.pcb->arrival != b.pcb->arrival ? a.pcb->arrival < b.pcb->arrival : a.pid < b.pid;
+        });
+
+        Queue ready;
+        size_t next = 0;
+        uint64_t clock = 0;
+        uint64_t sequence = 0;
+        while (next < n || !ready.empty())
+        {
+            while (next < n && jobs[next].pcb->arrival <= clock)
+            {
+                jobs[next].sequence = sequence++;
+                ready.push(jobs[next++]);
+            }
+            if (ready.empty())
+            {
+                clock = jobs[next].pcb->arrival;
+                continue;
+            }
+
+            Job job = ready.pop();
+            const uint64_t until_arrival = next < n ? jobs[next].pcb->arrival - clock : UINT64_MAX;
+            const uint32_t slice = preemption.slice(job, until_arrival);
+            if (!slice && job.pcb->remaining_burst_time)
+            {
+                return false;
+            }
+
+            job.pcb->started = true;
+            job.pcb->remaining_burst_time -= slice;
+            collector.slice(job, clock, slice);
+            clock += slice;
+
+            // arrivals during the slice are admitted ahead of the job being put back
+            while (next < n && jobs[next].pcb->arrival <= clock)
+            {
+                jobs[next].sequence = sequence++;
+                ready.push(jobs[next++]);
+            }
+            if (job.pcb->remaining_burst_time)
+            {
+                ready.push(job);
+            }
+            else
+            {
+                collector.complete(job, clock);
+            }
+        }
+        collector.finish(clock, n);
+        return true;
+    }
+};
+
+typedef Kernel<FifoQueue, NonPreemptive> FirstComeFirstServe;
+typedef Kernel<MinKeyQueue<RemainingKey>, NonPreemptive> ShortestJobFirst;
+typedef Kernel<MinKeyQueue<PriorityKey>, NonPreemptive> Priority;
+typedef Kernel<FifoQueue, Quantum> RoundRobin;
+typedef Kernel<MinKeyQueue<RemainingKey>, PreemptOnArrival> ShortestRemainingTimeFirst;
+// composed rather than written: priority with preemption at arrivals
+typedef Kernel<MinKeyQueue<PriorityKey>, PreemptOnArrival> PreemptivePriority;
+
+}
+
+#endif
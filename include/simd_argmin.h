@@ -0,0 +1,53 @@
+#ifndef SIMD_ARGMIN_H
+#define SIMD_ARGMIN_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+    SIMD argmin notes!
+
+    Finds the first smallest value of a uint32_t column, the selection step of the key based
+    policies. Each vector lane keeps the smallest value it has seen and the index it was
+    first seen at (a strictly-less update keeps the earliest), then the lanes are reduced
+    to the smallest value at the smallest index, so every level returns exactly what the
+    scalar loop does.
+
+    Levels are picked at run time from what the CPU supports: AVX2 (8 lanes), SSE4.1
+    (4 lanes) or the scalar loop. Non-x86 builds and compilers without the target
+    attribute only have the scalar loop.
+*/
+
+    typedef enum
+    {
+        SIMD_ARGMIN_SCALAR,
+        SIMD_ARGMIN_SSE41,
+        SIMD_ARGMIN_AVX2
+    }
+    SimdArgminLevel_t;
+
+    // \return the widest level this CPU runs
+    SimdArgminLevel_t simd_argmin_best_level(void);
+
+    // Finds the first smallest key with the best level for this CPU
+    // \param keys the column to scan
+    // \param count number of keys, must be at least 1
+    // \return index of the first smallest key
+    size_t simd_argmin_u32(const uint32_t *keys, size_t count);
+
+    // Finds the first smallest key with a given level, for tests and benchmarks
+    // \param level the kernel to use, clamped to simd_argmin_best_level
+    // \param keys the column to scan
+    // \param count number of keys, must be at least 1
+    // \return index of the first smallest key
+    size_t simd_argmin_u32_level(SimdArgminLevel_t level, const uint32_t *keys, size_t count);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -0,0 +1,87 @@
+#ifndef TIMELINE_H
+#define TIMELINE_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+    Timeline notes!
+
+    A timeline is the Gantt chart of a schedule stored as run-length encoded segments:
+    pid ran from start for length ticks. Recording a slice that continues the last
+    segment (same pid, starts where it ended) extends it instead of adding a segment,
+    so an SRTF run that is re-evaluated at every arrival still costs one segment per
+    actual dispatch.
+
+    Binary form ("TLN1"):
+      4 byte magic, varint segment count, then per segment
+      varint zigzag(start - end of previous segment), varint pid, varint length
+    Single CPU schedules have no overlap, so the gap is almost always a one byte zero.
+*/
+
+    typedef struct
+    {
+        uint64_t start;     // tick the segment starts at
+        uint32_t pid;       // PCB that ran (index in the ready queue)
+        uint32_t length;    // ticks it ran for
+    }
+    TimelineSegment_t;
+
+    typedef struct timeline Timeline_t;
+
+    // Creates an empty timeline
+    // \return the timeline, NULL on error
+    Timeline_t *timeline_create(void);
+
+    // Frees the timeline and its segments
+    // \param timeline the timeline to destroy
+    void timeline_destroy(Timeline_t *timeline);
+
+    // Removes all segments, keeping the buffer for reuse
+    // \param timeline the timeline
+    void timeline_clear(Timeline_t *timeline);
+
+    // Appends a slice, coalescing it into the last segment when it continues it
+    // \param timeline the timeline
+    // \param pid the PCB that ran
+    // \param start the tick it started at
+    // \param length number of ticks (zero length slices are ignored)
+    // \return true if function ran successful else false for an error
+    bool timeline_record(Timeline_t *timeline, uint32_t pid, uint64_t start, uint32_t length);
+
+    // \param timeline the timeline
+    // \return the number of segments, 0 on error
+    size_t timeline_size(const Timeline_t *timeline);
+
+    // \param timeline the timeline
+    // \param index the segment to return
+    // \return pointer to the segment, NULL on error
+    const TimelineSegment_t *timeline_at(const Timeline_t *timeline, size_t index);
+
+    // Writes the segments as "pid,start,length" CSV lines with a header
+    // \param timeline the timeline
+    // \param path the file to create
+    // \return true if function ran successful else false for an error
+    bool timeline_write_csv(const Timeline_t *timeline, const char *path);
+
+    // Writes the compact binary form described above
+    // \param timeline the timeline
+    // \param path the file to create
+    // \return true if function ran successful else false for an error
+    bool timeline_write_binary(const Timeline_t *timeline, const char *path);
+
+    // Reads a timeline written by timeline_write_binary
+    // \param path the file to read
+    // \return the timeline, NULL on error
+    Timeline_t *timeline_read_binary(const char *path);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -0,0 +1,157 @@
+#ifndef TOPOLOGY_H
+#define TOPOLOGY_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+    Topology notes!
+
+    The machine a multi-CPU run is simulated on: logical CPUs, each an SMT thread of a
+    core, cores grouped under shared last level caches and sockets. How far apart two
+    CPUs are decides what moving a PCB between them costs:
+      TOPOLOGY_SAME     the same CPU
+      TOPOLOGY_SMT      SMT siblings, the same core and its private caches
+      TOPOLOGY_CACHE    different cores sharing a last level cache
+      TOPOLOGY_SOCKET   the same socket, different last level caches
+      TOPOLOGY_REMOTE   different sockets, across the interconnect
+
+    Besides the one-off migration cost per distance, two penalties stretch the time a
+    slice takes: remote_percent while a PCB runs off the socket that holds its memory
+    (where its tenant was first queued), and smt_percent while the CPU's SMT sibling is busy.
+
+    CPUs need not be equally fast. Every CPU has a speed in per-mille of a reference core
+    (1000, the default): a CPU of speed 2000 retires two units of burst per tick. CPUs of
+    the same speed form a core class, numbered from 0 for the slowest. Detected topologies
+    take speeds from cpu_capacity where the kernel reports it (big.LITTLE and other
+    asymmetric machines), scaled so the largest capacity is 1000; a CPU the kernel gives
+    no capacity for among ones it does is taken to be as fast as the largest.
+
+    File form (topology_load), one statement per line, '#' starts a comment:
+      cpu <socket> <core> <cache> [speed]
+                                      one logical CPU, in CPU id order; CPUs with the same
+                                      socket and core are SMT siblings, cache names the
+                                      last level cache (ids are per machine)
+      uniform <sockets> <cores> <threads>
+                                      shorthand for sockets * cores * threads CPUs with one
+                                      last level cache per socket
+      speed <first cpu> <last cpu> <speed>
+                                      sets the speed of CPUs already listed
+      migrate <smt> <cache> <socket> <remote>
+                                      migration cost in ticks per distance
+      remote <percent>
+      smt <percent>
+    Costs not given keep the defaults of topology_costs_init.
+*/
+
+    // Speed of the reference core, which retires one unit of burst per tick
+    #define TOPOLOGY_SPEED_REFERENCE 1000
+
+    typedef enum
+    {
+        TOPOLOGY_SAME,
+        TOPOLOGY_SMT,
+        TOPOLOGY_CACHE,
+        TOPOLOGY_SOCKET,
+        TOPOLOGY_REMOTE,
+        TOPOLOGY_DISTANCES
+    }
+    TopologyDistance_t;
+
+    typedef struct
+    {
+        uint32_t socket;            // package, dense from 0
+        uint32_t core;              // core, dense from 0 across the machine
+        uint32_t cache;             // last level cache, dense from 0 across the machine
+        uint32_t thread;            // SMT thread within the core, from 0
+        uint32_t speed;             // burst retired per 1000 ticks, 1000 for the reference core
+        uint32_t speed_class;       // core class, dense from 0 in ascending speed
+    }
+    TopologyCpu_t;
+
+    typedef struct
+    {
+        uint32_t migrate[TOPOLOGY_DISTANCES];   // ticks a PCB pays to resume this far from where it last ran
+        uint32_t remote_percent;                // slowdown while running off its memory's socket
+        uint32_t smt_percent;                   // slowdown while the SMT sibling is busy
+    }
+    TopologyCosts_t;
+
+    typedef struct topology Topology_t;
+
+    // Fills in the default costs: migrations of 0, 1, 5 and 20 ticks from SMT sibling to
+    // remote socket, 30% remote memory and 25% SMT slowdown
+    // \param costs the costs to initialise
+    void topology_costs_init(TopologyCosts_t *costs);
+
+    // Creates a machine of sockets * cores * threads CPUs with one last level cache per socket.
+    // CPU ids run thread fastest, then core, then socket
+    // \param sockets number of sockets
+    // \param cores cores per socket
+    // \param threads SMT threads per core
+    // \return the topology with default costs, NULL on error
+    Topology_t *topology_create_uniform(uint32_t sockets, uint32_t cores, uint32_t threads);
+
+    // Reads a topology in the file form described above
+    // \param path the file to read
+    // \return the topology, NULL on error
+    Topology_t *topology_load(const char *path);
+
+    // Reads the topology of the local machine from sysfs
+    // \param root the sysfs cpu directory, NULL for /sys/devices/system/cpu
+    // \return the topology of the online CPUs with default costs, NULL on error
+    Topology_t *topology_detect(const char *root);
+
+    // Frees the topology
+    // \param topology the topology to destroy
+    void topology_destroy(Topology_t *topology);
+
+    // \param topology the topology
+    // \return the number of logical CPUs
+    size_t topology_cpus(const Topology_t *topology);
+
+    // \param topology the topology
+    // \param cpu the CPU id
+    // \return where the CPU sits, NULL if there is no such CPU
+    const TopologyCpu_t *topology_cpu(const Topology_t *topology, size_t cpu);
+
+    // \param topology the topology
+    // \return the number of sockets
+    size_t topology_sockets(const Topology_t *topology);
+
+    // Changes how fast a CPU runs, renumbering the core classes
+    // \param topology the topology
+    // \param cpu the CPU id
+    // \param speed burst retired per 1000 ticks, not 0
+    // \return true if the CPU exists and the speed is valid
+    bool topology_set_speed(Topology_t *topology, size_t cpu, uint32_t speed);
+
+    // \param topology the topology
+    // \return the number of core classes, distinct CPU speeds
+    size_t topology_classes(const Topology_t *topology);
+
+    // \param topology the topology
+    // \param a a CPU id
+    // \param b a CPU id
+    // \return how far apart the two CPUs are
+    TopologyDistance_t topology_distance(const Topology_t *topology, size_t a, size_t b);
+
+    // \param topology the topology
+    // \return its costs
+    const TopologyCosts_t *topology_costs(const Topology_t *topology);
+
+    // Replaces the costs
+    // \param topology the topology
+    // \param costs the new costs
+    void topology_set_costs(Topology_t *topology, const TopologyCosts_t *costs);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -0,0 +1,100 @@
+#ifndef TRACE_INDEX_H
+#define TRACE_INDEX_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+    Trace index notes!
+
+    A sparse arrival index over a raw PCB file: the file is cut into blocks of
+    TRACE_INDEX_BLOCK records and the index keeps each block's smallest and largest
+    arrival. That is 12 bytes per 1024 PCBs, so a trace of a billion PCBs indexes
+    in ~12 MB and any arrival window maps to the blocks that can hold it:
+
+      sorted trace      binary search the block maxima, then at most one block of reads
+      unsorted trace    only blocks whose [min, max] overlaps the window are read
+
+    Building reads every block once, spread across threads with positional reads.
+    Threads claim TRACE_INDEX_GRAIN blocks at a time: an entry is only 12 bytes but
+    stands for 16 KB of reads, so the default byte-sized chunks would hand a whole
+    trace to one thread.
+    The index is stored next to the trace as "<trace>.idx" and is only reused while
+    the trace's size and modification time match what it was built from. It is written
+    to a temporary file and renamed into place, so a reader never sees half an index.
+
+    File form ("TIX1"): 4 byte magic, then uint32 block records, uint64 records,
+    uint64 trace size, int64 trace mtime (ns), uint64 block count, then per block uint32
+    min arrival, uint32 max arrival, uint32 flags (1: arrivals ascending inside the
+    block). Native endianness, like the traces themselves.
+*/
+
+#define TRACE_INDEX_BLOCK 1024
+#define TRACE_INDEX_GRAIN 16
+
+    typedef struct trace_index TraceIndex_t;
+
+    // Indexes a trace with a parallel pass over its blocks
+    // \param trace_path the PCB file
+    // \param threads threads to read with, 0 for one per online CPU
+    // \return the index, NULL on error
+    TraceIndex_t *trace_index_build(const char *trace_path, size_t threads);
+
+    // Reads an index file, checking it still describes the trace
+    // \param index_path the index file
+    // \param trace_path the PCB file it was built from
+    // \return the index, NULL on error or if the trace changed since
+    TraceIndex_t *trace_index_read(const char *index_path, const char *trace_path);
+
+    // Writes an index in the file form described above
+    // \param index the index
+    // \param index_path where to write it
+    // \return true if function ran successful else false for an error
+    bool trace_index_write(const TraceIndex_t *index, const char *index_path);
+
+    // Reads "<trace>.idx" if it is current, otherwise builds the index and tries to store it there
+    // \param trace_path the PCB file
+    // \param threads threads to build with, 0 for one per online CPU
+    // \return the index, NULL on error
+    TraceIndex_t *trace_index_load(const char *trace_path, size_t threads);
+
+    // Frees the index
+    // \param index the index to destroy
+    void trace_index_destroy(TraceIndex_t *index);
+
+    // \param index the index
+    // \return the number of whole PCBs in the trace, 0 on error
+    size_t trace_index_records(const TraceIndex_t *index);
+
+    // \param index the index
+    // \return true if the whole trace is in ascending arrival order
+    bool trace_index_sorted(const TraceIndex_t *index);
+
+    // \param index the index
+    // \return the number of blocks, 0 on error
+    size_t trace_index_blocks(const TraceIndex_t *index);
+
+    // Gives the arrival range of a block
+    // \param index the index
+    // \param block the block number
+    // \param min receives the smallest arrival in the block
+    // \param max receives the largest arrival in the block
+    // \return true if function ran successful else false for an error
+    bool trace_index_block_range(const TraceIndex_t *index, size_t block, uint32_t *min, uint32_t *max);
+
+    // For a sorted trace, finds the block the first PCB arriving at or after arrival is in
+    // \param index the index
+    // \param arrival the arrival to look for
+    // \return the block number, trace_index_blocks if every PCB arrives before arrival
+    size_t trace_index_seek(const TraceIndex_t *index, uint64_t arrival);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
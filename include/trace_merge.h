@@ -0,0 +1,84 @@
+#ifndef TRACE_MERGE_H
+#define TRACE_MERGE_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "dyn_array.h"
+#include "processing_scheduling.h"
+
+/*
+    Trace merge notes!
+
+    A trace can be split over many PCB files (shards), each in the raw format
+    load_process_control_blocks reads. Merging streams them as one trace in arrival
+    order: a min-heap holds the next PCB of every shard, so only one read-ahead block
+    per sorted shard is in memory however big the shards are. Equal arrivals come out in
+    shard order, then file order, so the same shards always give the same stream.
+
+    Opening a shard loads its sparse arrival index (trace_index.h), reusing the
+    "<shard>.idx" file next to it when current. A shard that is already sorted by
+    arrival, the normal case for per host/per hour captures, is searched for the
+    window start through the block maxima plus one block of reads, and everything from
+    there is read sequentially. An unsorted shard cannot be streamed: opening it reads
+    the blocks whose arrival range overlaps the window once, in file order, and keeps the
+    PCBs inside the window in memory sorted by (arrival, record), which the merge then
+    takes them from without touching the file again.
+
+    A window keeps the PCBs arriving in [arrival_start, arrival_end], then of those
+    the pcb_count starting at merged position first_pcb.
+*/
+
+    typedef struct
+    {
+        uint32_t arrival_start;     // earliest arrival kept
+        uint32_t arrival_end;       // latest arrival kept (inclusive)
+        size_t first_pcb;           // PCBs of the windowed stream to skip
+        size_t pcb_count;           // PCBs to keep after those, SIZE_MAX for all
+    }
+    TraceWindow_t;
+
+    typedef struct trace_merge TraceMerge_t;
+
+    // Sets a window that keeps everything
+    // \param window the window to initialise
+    void trace_window_init(TraceWindow_t *window);
+
+    // Opens and indexes the shards and positions every one at the window start
+    // \param paths the shard files
+    // \param count number of shards
+    // \param window what to keep, NULL for everything
+    // \return the merge, NULL on error (missing file, bad window)
+    TraceMerge_t *trace_merge_open(const char *const *paths, size_t count, const TraceWindow_t *window);
+
+    // Reads the next PCB of the merged stream
+    // \param merge the merge
+    // \param pcb receives the PCB
+    // \return true if a PCB was read, false at the end of the stream or on error
+    bool trace_merge_next(TraceMerge_t *merge, ProcessControlBlock_t *pcb);
+
+    // \param merge the merge
+    // \return true if a read failed, telling an error apart from the end of the stream
+    bool trace_merge_failed(const TraceMerge_t *merge);
+
+    // Closes the shards and frees the merge
+    // \param merge the merge to close
+    void trace_merge_close(TraceMerge_t *merge);
+
+    // Merges the shards into a ready queue, like load_process_control_blocks does for one file
+    // \param paths the shard files
+    // \param count number of shards
+    // \param window what to keep, NULL for everything
+    // \return the PCBs in arrival order, NULL on error
+    dyn_array_t *trace_merge_load(const char *const *paths, size_t count, const TraceWindow_t *window);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -0,0 +1,81 @@
+#ifndef TRACE_SAMPLE_H
+#define TRACE_SAMPLE_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "processing_scheduling.h"
+
+/*
+    Trace sampling notes!
+
+    An approximate analysis for traces too big to replay for every dashboard refresh.
+    The arrival span of the trace (read from the shards' trace indexes, so nothing is
+    scanned) is cut into equal strata, and one window of window_length arrival ticks is
+    simulated from each: at a random offset inside its stratum, except the last one,
+    which sits flush against the last arrival so its final clock estimates the run time.
+
+    Every window is simulated with the warmup ticks of arrivals before it, so it does not
+    start from an unrealistically empty queue; only the PCBs arriving inside the window are
+    measured, using their completion time from the window's timeline. Windows end with the
+    queue draining, so backlog that later arrivals would have added is missed: windows
+    much longer than a typical busy period keep that bias small.
+
+    The averages are ratio estimates (measured sum over measured PCBs across windows) with
+    the usual cluster sampling variance, giving a two sided interval at the configured
+    confidence. If either half width exceeds error_bound times its estimate (waiting
+    times below one tick count as one tick), or fewer than two windows held PCBs, the
+    whole trace is replayed instead and the result is exact.
+
+    Runs with bursts, timelines, stats or deadlines are not sampled; the config's timeline,
+    stats, bursts and deadline settings are ignored.
+*/
+
+    typedef struct
+    {
+        size_t windows;             // strata the arrival span is cut into, one window simulated per stratum
+        uint32_t window_length;     // arrival ticks measured per window
+        uint32_t warmup;            // arrival ticks simulated before each window but not measured
+        double confidence;          // two sided confidence level of the intervals, in (0, 1)
+        double error_bound;         // largest accepted half width relative to its estimate
+        uint64_t seed;              // places the windows inside their strata
+    }
+    TraceSampleConfig_t;
+
+    typedef struct
+    {
+        ScheduleResult_t result;        // estimated (or exact) results
+        double waiting_half_width;      // half width of the average waiting time interval, 0 when exact
+        double turnaround_half_width;   // half width of the average turnaround time interval, 0 when exact
+        size_t sampled_pcbs;            // PCBs measured by the windows (all of them when exact)
+        size_t total_pcbs;              // PCBs in the trace
+        bool exact;                     // true if the whole trace was replayed
+    }
+    TraceSampleResult_t;
+
+    // Fills in the defaults: 32 windows of 10000 ticks, 1000 ticks of warmup, 95% confidence,
+    // a 5% error bound and seed 1
+    // \param config the config to initialise
+    void trace_sample_config_init(TraceSampleConfig_t *config);
+
+    // Estimates the results of running config over the merged shards, falling back to a full
+    // replay when the estimate misses the error bound
+    // \param paths the shard files, as for trace_merge_open
+    // \param count number of shards
+    // \param config the algorithm and its options \ref ScheduleConfig_t
+    // \param sample how to sample \ref TraceSampleConfig_t
+    // \param result receives the estimate
+    // \return true if function ran successful else false for an error
+    bool trace_sample_run(const char *const *paths, size_t count, const ScheduleConfig_t *config,
+                          const TraceSampleConfig_t *sample, TraceSampleResult_t *result);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
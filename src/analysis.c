@@ -1,127 +1,1113 @@
 #include <stdio.h>
 #include <stdlib.h>
 
+#include "../include/autotune.h"
+#include "../include/burst_arena.h"
 #include "../include/dyn_array.h"
+#include "../include/dyn_array_parallel.h"
+#include "../include/group_tree.h"
+#include "../include/instrument.h"
 #include "../include/processing_scheduling.h"
+#include "../include/realtime.h"
+#include "../include/result_cache.h"
+#include "../include/sched_daemon.h"
+#include "../include/timeline.h"
+#include "../include/topology.h"
+#include "../include/trace_merge.h"
+#include "../include/trace_sample.h"
 
-#define FCFS "FCFS"
-#define P "P"
-#define RR "RR"
-#define SJF "SJF"
-#define SRT "SRT"
+// Heading printed above each algorithm's results, indexed by SchedulePolicy_t
+static const char *const result_titles[] = {
+    "FCFS", "Shortest Job First", "Priority", "Round Robin", "Shortest Remaining Time",
+    "Earliest Deadline First", "Stride", "Lottery", "Group"};
 
-int main(int argc, char **argv) 
+// Workload totals, taken before scheduling consumes the remaining burst times
+typedef struct
 {
-    if (argc < 3) 
+    uint64_t total_burst;
+    uint64_t longest_burst;
+    uint64_t priority_sum;
+    uint64_t last_arrival;
+}
+TraceSummary_t;
+
+static void summary_fold(void *const accumulator, const void *const object, void *arg)
+{
+    (void) arg;
+    TraceSummary_t *summary = (TraceSummary_t *) accumulator;
+    const ProcessControlBlock_t *pcb = (const ProcessControlBlock_t *) object;
+    summary->total_burst += pcb->remaining_burst_time;
+    summary->priority_sum += pcb->priority;
+    if (pcb->remaining_burst_time > summary->longest_burst)
+    {
+        summary->longest_burst = pcb->remaining_burst_time;
+    }
+    if (pcb->arrival > summary->last_arrival)
+    {
+        summary->last_arrival = pcb->arrival;
+    }
+}
+
+static void summary_combine(void *const accumulator, const void *const partial, void *arg)
+{
+    (void) arg;
+    TraceSummary_t *summary = (TraceSummary_t *) accumulator;
+    const TraceSummary_t *other = (const TraceSummary_t *) partial;
+    summary->total_burst += other->total_burst;
+    summary->priority_sum += other->priority_sum;
+    if (other->longest_burst > summary->longest_burst)
+    {
+        summary->longest_burst = other->longest_burst;
+    }
+    if (other->last_arrival > summary->last_arrival)
+    {
+        summary->last_arrival = other->last_arrival;
+    }
+}
+
+// Parses "<first>:<second>"
+// \return true if both numbers were there
+static bool parse_pair(const char *text, unsigned long long *first, unsigned long long *second)
+{
+    char *end;
+    *first = strtoull(text, &end, 10);
+    if (end == text || *end != ':')
+    {
+        return false;
+    }
+    text = end + 1;
+    *second = strtoull(text, &end, 10);
+    return end != text && *end == '\0';
+}
+
+// \return true if text is a plain decimal number, like a quantum
+static bool is_number(const char *text)
+{
+    if (!*text)
+    {
+        return false;
+    }
+    for (; *text; ++text)
+    {
+        if (*text < '0' || *text > '9')
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Option names, indexed by the enum they select
+static const char *const placement_names[] = {"spread", "pack", "affinity", "speed"};
+static const char *const balance_names[] = {"none", "steal", "socket"};
+static const char *const search_names[] = {"grid", "random", "halving"};
+static const char *const objective_names[] = {"wait", "p99", "throughput"};
+
+// Looks a name up in one of the tables above
+// \return true if it is there, its index in *index
+static bool find_name(const char *const *names, size_t count, const char *name, int *index)
+{
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (strcmp(name, names[i]) == 0)
+        {
+            *index = (int) i;
+            return true;
+        }
+    }
+    return false;
+}
+
+#define FIND_NAME(names, name, index) find_name((names), sizeof(names) / sizeof((names)[0]), (name), (index))
+
+// Parses a --tune-policies list, names separated by commas
+// \return true if every name is a policy and there are at most max of them
+static bool parse_policies(char *list, SchedulePolicy_t *policies, size_t max, size_t *count)
+{
+    *count = 0;
+    for (char *name = strtok(list, ","); name; name = strtok(NULL, ","))
+    {
+        if (*count == max || !schedule_policy_from_name(name, &policies[*count]))
+        {
+            return false;
+        }
+        ++*count;
+    }
+    return *count != 0;
+}
+
+// Prints one tuned candidate, * marking the Pareto front
+static void print_candidate(const AutotuneResult_t *result, bool placed)
+{
+    printf("%c %s", result->pareto ? '*' : ' ', schedule_policy_name(result->params.policy));
+    if (result->params.quantum)
+    {
+        printf(" quantum %zu", result->params.quantum);
+    }
+    if (placed)
     {
-        printf("%s <pcb file> <schedule algorithm> [quantum]\n", argv[0]);
+        printf(" placement %s balance %s", placement_names[result->params.placement],
+               balance_names[result->params.balance]);
+    }
+    printf(": wait %f, p99 turnaround %f, throughput %f, PCBs %zu\n", result->mean_wait,
+           result->p99_turnaround, result->throughput, result->pcbs);
+}
+
+// Reads a tenant table: one raw uint32_t tenant id per PCB
+static dyn_array_t *load_tenants(const char *path)
+{
+    FILE *file = fopen(path, "rb");
+    if (!file)
+    {
+        return NULL;
+    }
+    dyn_array_t *tenants = dyn_array_create(0, sizeof(uint32_t), NULL);
+    uint32_t tenant;
+    while (tenants && fread(&tenant, sizeof(tenant), 1, file) == 1)
+    {
+        if (!dyn_array_push_back(tenants, &tenant))
+        {
+            dyn_array_destroy(tenants);
+            tenants = NULL;
+        }
+    }
+    fclose(file);
+    return tenants;
+}
+
+// Everything a run prints, as kept in the result cache, followed by its shares and core classes
+typedef struct
+{
+    ScheduleResult_t result;
+    ScheduleStats_t stats;
+    ScheduleDeadlineStats_t deadline_stats;
+    TraceSummary_t summary;
+    uint64_t pcbs;
+    uint64_t periodic_tasks;        // tasks the periodic PCBs of a deadline table stand for
+    double periodic_utilisation;
+    uint32_t edf_schedulable;       // EdfVerdict_t of the demand bound test on them
+    uint32_t reserved;
+    uint64_t shares;
+    uint64_t core_classes;
+}
+CachedRun_t;
+
+typedef enum { EDF_UNSCHEDULABLE, EDF_SCHEDULABLE, EDF_UNKNOWN } EdfVerdict_t;
+
+// Runs the schedulability tests on the task set the periodic PCBs stand for, before the run
+// consumes their bursts
+static bool periodic_analysis(const dyn_array_t *pcbs, const dyn_array_t *deadlines, CachedRun_t *run)
+{
+    dyn_array_t *tasks = realtime_periodic_tasks(pcbs, deadlines);
+    if (!tasks)
+    {
+        return false;
+    }
+    bool schedulable = false;
+    run->periodic_tasks = dyn_array_size(tasks);
+    run->periodic_utilisation = 0;
+    realtime_utilisation_test(tasks, &run->periodic_utilisation);
+    run->edf_schedulable = !realtime_demand_bound_test(tasks, &schedulable) ? EDF_UNKNOWN
+                           : schedulable ? EDF_SCHEDULABLE : EDF_UNSCHEDULABLE;
+    dyn_array_destroy(tasks);
+    return true;
+}
+
+// Default bound of a --cache directory
+#define CACHE_DEFAULT_BYTES (64ull << 20)
+
+// Feeds an optional input file to the key, telling a missing one from an empty one
+static bool hash_input(ResultHasher_t *hasher, const char *path)
+{
+    result_hasher_u64(hasher, path != NULL);
+    return !path || result_hasher_file(hasher, path);
+}
+
+// Keys a run by the contents of its inputs and every setting that changes its results. The
+// thread count is left out: split runs give the same results as whole ones
+static bool run_key(ResultKey_t *key, const dyn_array_t *pcb_files, bool merged, const TraceWindow_t *window,
+                    const ScheduleConfig_t *config, const char *const *inputs, size_t input_count)
+{
+    static const char version[] = "analysis result v2";
+    ResultHasher_t hasher;
+    result_hasher_init(&hasher);
+    result_hasher_update(&hasher, version, sizeof(version));
+    result_hasher_u64(&hasher, sizeof(CachedRun_t));
+    result_hasher_u64(&hasher, sizeof(ScheduleShare_t));
+    result_hasher_u64(&hasher, sizeof(ScheduleCoreClass_t));
+
+    bool read = true;
+    result_hasher_u64(&hasher, dyn_array_size(pcb_files));
+    for (size_t i = 0; i < dyn_array_size(pcb_files); ++i)
+    {
+        read = read && result_hasher_file_memo(&hasher, *(const char *const *) dyn_array_at(pcb_files, i));
+    }
+    result_hasher_u64(&hasher, merged);
+    if (merged)
+    {
+        result_hasher_u64(&hasher, window->arrival_start);
+        result_hasher_u64(&hasher, window->arrival_end);
+        result_hasher_u64(&hasher, window->first_pcb);
+        result_hasher_u64(&hasher, window->pcb_count);
+    }
+    for (size_t i = 0; i < input_count; ++i)
+    {
+        read = read && hash_input(&hasher, inputs[i]);
+    }
+
+    result_hasher_u64(&hasher, config->policy);
+    result_hasher_u64(&hasher, config->quantum);
+    result_hasher_u64(&hasher, config->costs.switch_cost);
+    result_hasher_u64(&hasher, config->costs.refill_max);
+    result_hasher_u64(&hasher, config->costs.refill_halflife);
+    result_hasher_u64(&hasher, config->costs.migration_cost);
+    result_hasher_u64(&hasher, config->io_devices);
+    result_hasher_u64(&hasher, config->admission);
+    result_hasher_u64(&hasher, config->seed);
+    result_hasher_u64(&hasher, config->tenants != NULL);
+    result_hasher_u64(&hasher, config->shares != NULL);
+    result_hasher_u64(&hasher, config->topology != NULL);
+    if (config->topology)
+    {
+        // the machine itself rather than its file, so that "sys" misses on a different machine
+        result_hasher_u64(&hasher, config->placement);
+        result_hasher_u64(&hasher, config->balance);
+        result_hasher_u64(&hasher, topology_cpus(config->topology));
+        for (size_t c = 0; c < topology_cpus(config->topology); ++c)
+        {
+            const TopologyCpu_t *cpu = topology_cpu(config->topology, c);
+            result_hasher_u64(&hasher, cpu->socket);
+            result_hasher_u64(&hasher, cpu->core);
+            result_hasher_u64(&hasher, cpu->cache);
+            result_hasher_u64(&hasher, cpu->thread);
+            result_hasher_u64(&hasher, cpu->speed);
+        }
+        const TopologyCosts_t *costs = topology_costs(config->topology);
+        for (size_t d = 0; d < TOPOLOGY_DISTANCES; ++d)
+        {
+            result_hasher_u64(&hasher, costs->migrate[d]);
+        }
+        result_hasher_u64(&hasher, costs->remote_percent);
+        result_hasher_u64(&hasher, costs->smt_percent);
+    }
+    *key = result_hasher_final(&hasher);
+    return read;
+}
+
+// Stores a run and the shares and core classes in its config
+static bool cache_store(ResultCache_t *cache, ResultKey_t key, CachedRun_t *run, const ScheduleConfig_t *config)
+{
+    run->shares = config->shares ? dyn_array_size(config->shares) : 0;
+    run->core_classes = config->core_classes ? dyn_array_size(config->core_classes) : 0;
+    dyn_array_t *payload = dyn_array_create(sizeof(CachedRun_t), sizeof(uint8_t), NULL);
+    bool stored = payload && dyn_array_append_n(payload, run, sizeof(CachedRun_t))
+                  && dyn_array_append_n(payload, dyn_array_export(config->shares), run->shares * sizeof(ScheduleShare_t))
+                  && dyn_array_append_n(payload, dyn_array_export(config->core_classes),
+                                        run->core_classes * sizeof(ScheduleCoreClass_t))
+                  && result_cache_put(cache, key, dyn_array_export(payload), dyn_array_size(payload));
+    dyn_array_destroy(payload);
+    return stored;
+}
+
+// Looks a run up, filling in the shares and core classes of its config on a hit
+static bool cache_fetch(ResultCache_t *cache, ResultKey_t key, CachedRun_t *run, ScheduleConfig_t *config)
+{
+    dyn_array_t *payload = dyn_array_create(0, sizeof(uint8_t), NULL);
+    bool hit = payload && result_cache_get(cache, key, payload) && dyn_array_size(payload) >= sizeof(CachedRun_t);
+    if (hit)
+    {
+        const uint8_t *bytes = dyn_array_export(payload);
+        memcpy(run, bytes, sizeof(CachedRun_t));
+        bytes += sizeof(CachedRun_t);
+        const size_t share_bytes = run->shares * sizeof(ScheduleShare_t);
+        const size_t class_bytes = run->core_classes * sizeof(ScheduleCoreClass_t);
+        // the key covers whether shares and core classes are kept, so a mismatch is a damaged entry
+        hit = dyn_array_size(payload) == sizeof(CachedRun_t) + share_bytes + class_bytes
+              && (config->shares || !run->shares) && (config->core_classes || !run->core_classes)
+              && (!config->shares || dyn_array_resize(config->shares, run->shares, NULL))
+              && (!config->core_classes || dyn_array_resize(config->core_classes, run->core_classes, NULL));
+        if (hit && share_bytes)
+        {
+            memcpy(dyn_array_front(config->shares), bytes, share_bytes);
+        }
+        if (hit && class_bytes)
+        {
+            memcpy(dyn_array_front(config->core_classes), bytes + share_bytes, class_bytes);
+        }
+    }
+    dyn_array_destroy(payload);
+    return hit;
+}
+
+// Asks a running daemon for the results instead of loading the trace here
+static bool ask_daemon(const char *socket_path, const char *pcb_file, const ScheduleConfig_t *config,
+                       const TraceWindow_t *window, CachedRun_t *run)
+{
+    SchedQuery_t query;
+    sched_query_init(&query, config->policy);
+    query.quantum = config->quantum;
+    query.costs = config->costs;
+    query.seed = config->seed;
+    if (window)
+    {
+        query.windowed = 1;
+        query.arrival_start = window->arrival_start;
+        query.arrival_end = window->arrival_end;
+        query.first_pcb = window->first_pcb;
+        query.pcb_count = window->pcb_count == SIZE_MAX ? UINT64_MAX : window->pcb_count;
+    }
+    SchedClient_t *client = sched_client_open(socket_path);
+    SchedAnswer_t answer;
+    const bool asked = client && sched_client_query(client, pcb_file, &query, &answer);
+    sched_client_close(client);
+    if (!asked || answer.status != SCHED_DAEMON_OK)
+    {
+        fprintf(stderr, asked ? "The daemon at %s could not run the query (status %u)\n" : "No daemon answers at %s\n",
+                socket_path, asked ? answer.status : 0);
+        return false;
+    }
+    run->result = answer.result;
+    run->stats = answer.stats;
+    run->summary.total_burst = answer.total_burst;
+    run->summary.longest_burst = answer.longest_burst;
+    run->summary.priority_sum = answer.priority_sum;
+    run->summary.last_arrival = answer.last_arrival;
+    run->pcbs = answer.pcbs;
+    return true;
+}
+
+// Writes the timeline as CSV when the file name ends in .csv, in the binary form otherwise
+static bool write_timeline(const Timeline_t *timeline, const char *path)
+{
+    const size_t length = strlen(path);
+    if (length > 4 && strcmp(path + length - 4, ".csv") == 0)
+    {
+        return timeline_write_csv(timeline, path);
+    }
+    return timeline_write_binary(timeline, path);
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 3)
+    {
+        printf("%s <pcb file> <schedule algorithm> [quantum] [--timeline <file.csv|file.bin>]\n"
+               "    [--switch-cost <ticks>] [--refill-max <ticks>] [--refill-halflife <ticks>]\n"
+               "    [--bursts <phase file>] [--io-devices <count>]\n"
+               "    [--trace <more pcb files>...] [--window <first arrival>:<last arrival>]\n"
+               "    [--pcbs <first>:<count>]\n"
+               "    [--sample <windows>:<window ticks>] [--warmup <ticks>] [--confidence <level>]\n"
+               "    [--error-bound <fraction>] [--threads <count>]\n"
+               "    [--deadlines <deadline file>] [--admission]\n"
+               "    [--shares] [--tenants <tenant file>] [--seed <lottery seed>]\n"
+               "    [--groups <group tree file>] [--group-map <group path file>]\n"
+               "    [--topology <topology file|sys>] [--placement spread|pack|affinity|speed]\n"
+               "    [--balance none|steal|socket] [--migration-cost <ticks>]\n"
+               "    [--tune grid|random|halving] [--objective wait|p99|throughput] [--quanta <min>:<max>]\n"
+               "    [--tune-policies <algorithm,...>] [--candidates <count>] [--min-pcbs <count>]\n"
+               "    [--finalists <count>] [--cache <directory>] [--cache-size <bytes>]\n"
+               "    [--daemon <socket>]\n", argv[0]);
         return EXIT_FAILURE;
     }
 
     const char *pcb_file = argv[1];
     const char *algorithm = argv[2];
-    size_t quantum = 0;
+    const char *timeline_file = NULL;
+    const char *burst_file = NULL;
+    const char *deadline_file = NULL;
+    const char *tenant_file = NULL;
+    const char *group_file = NULL;
+    const char *group_map_file = NULL;
+    const char *topology_file = NULL;
+    const char *cache_dir = NULL;
+    const char *daemon_socket = NULL;
+    uint64_t cache_bytes = CACHE_DEFAULT_BYTES;
+    bool shares = false;
+    TraceWindow_t window;
+    trace_window_init(&window);
+    bool sliced = false;
+    TraceSampleConfig_t sample;
+    trace_sample_config_init(&sample);
+    bool sampled = false;
+    // busy periods simulated at once, 1 runs the engine in one piece
+    size_t threads = 1;
 
-    // Load process control blocks from the binary file
-    ScheduleResult_t result = {0, 0, 0};
-    
-    dyn_array_t *ready_queue = load_process_control_blocks(pcb_file);
+    // the first PCB file plus any --trace shards, merged by arrival when there is more than one
+    dyn_array_t *pcb_files = dyn_array_create(0, sizeof(const char *), NULL);
+    if (!pcb_files || !dyn_array_push_back(pcb_files, &pcb_file))
+    {
+        return EXIT_FAILURE;
+    }
 
-    
+    ScheduleConfig_t config;
+    ScheduleStats_t stats;
+    ScheduleDeadlineStats_t deadline_stats;
+    SchedulePolicy_t policy;
+    if (!schedule_policy_from_name(algorithm, &policy))
+    {
+        fprintf(stderr, "Unknown scheduling algorithm: %s\n", algorithm);
+        return EXIT_FAILURE;
+    }
+    schedule_config_init(&config, policy);
+    config.stats = &stats;
+
+    // the tuner searches the named algorithm's parameters unless given a list of policies
+    AutotuneConfig_t tune;
+    SchedulePolicy_t tune_policies[16] = {policy};
+    autotune_config_init(&tune, &config);
+    tune.policies = tune_policies;
+    bool tuning = false;
 
-    // Execute the specified scheduling algorithm
-    if (strcmp(algorithm, FCFS) == 0) 
+    for (int i = 3; i < argc; ++i)
     {
-        if (first_come_first_serve(ready_queue, &result)) 
+        if (strcmp(argv[i], "--timeline") == 0 && i + 1 < argc)
+        {
+            timeline_file = argv[++i];
+        }
+        else if (strcmp(argv[i], "--switch-cost") == 0 && i + 1 < argc)
+        {
+            config.costs.switch_cost = (uint32_t) strtoul(argv[++i], NULL, 10);
+        }
+        else if (strcmp(argv[i], "--refill-max") == 0 && i + 1 < argc)
+        {
+            config.costs.refill_max = (uint32_t) strtoul(argv[++i], NULL, 10);
+        }
+        else if (strcmp(argv[i], "--refill-halflife") == 0 && i + 1 < argc)
+        {
+            config.costs.refill_halflife = (uint32_t) strtoul(argv[++i], NULL, 10);
+        }
+        else if (strcmp(argv[i], "--bursts") == 0 && i + 1 < argc)
+        {
+            burst_file = argv[++i];
+        }
+        else if (strcmp(argv[i], "--deadlines") == 0 && i + 1 < argc)
+        {
+            deadline_file = argv[++i];
+        }
+        else if (strcmp(argv[i], "--admission") == 0)
         {
-            // Print or store the scheduling results
-            printf("FCFS scheduling results:\n");
-            printf("Average Turnaround Time: %f\n", result.average_turnaround_time);
-            printf("Average Waiting Time: %f\n", result.average_waiting_time);
-            printf("Total Run Time: %lu\n", result.total_run_time);
-            // Output additional results if needed
+            config.admission = true;
         }
-        else 
+        else if (strcmp(argv[i], "--shares") == 0)
         {
-            fprintf(stderr, "Error executing FCFS scheduling algorithm\n");
-            EXIT_FAILURE;
+            shares = true;
+        }
+        else if (strcmp(argv[i], "--tenants") == 0 && i + 1 < argc)
+        {
+            tenant_file = argv[++i];
+        }
+        else if (strcmp(argv[i], "--groups") == 0 && i + 1 < argc)
+        {
+            group_file = argv[++i];
+        }
+        else if (strcmp(argv[i], "--group-map") == 0 && i + 1 < argc)
+        {
+            group_map_file = argv[++i];
+        }
+        else if (strcmp(argv[i], "--topology") == 0 && i + 1 < argc)
+        {
+            topology_file = argv[++i];
+        }
+        else if (strcmp(argv[i], "--placement") == 0 && i + 1 < argc)
+        {
+            int placement;
+            if (!FIND_NAME(placement_names, argv[++i], &placement))
+            {
+                fprintf(stderr, "Unknown placement: %s\n", argv[i]);
+                dyn_array_destroy(pcb_files);
+                return EXIT_FAILURE;
+            }
+            config.placement = (SchedulePlacement_t) placement;
+        }
+        else if (strcmp(argv[i], "--balance") == 0 && i + 1 < argc)
+        {
+            int balance;
+            if (!FIND_NAME(balance_names, argv[++i], &balance))
+            {
+                fprintf(stderr, "Unknown balance: %s\n", argv[i]);
+                dyn_array_destroy(pcb_files);
+                return EXIT_FAILURE;
+            }
+            config.balance = (ScheduleBalance_t) balance;
+        }
+        else if (strcmp(argv[i], "--tune") == 0 && i + 1 < argc)
+        {
+            int search;
+            if (!FIND_NAME(search_names, argv[++i], &search))
+            {
+                fprintf(stderr, "Unknown search: %s\n", argv[i]);
+                dyn_array_destroy(pcb_files);
+                return EXIT_FAILURE;
+            }
+            tune.search = (AutotuneSearch_t) search;
+            tuning = true;
+        }
+        else if (strcmp(argv[i], "--objective") == 0 && i + 1 < argc)
+        {
+            int objective;
+            if (!FIND_NAME(objective_names, argv[++i], &objective))
+            {
+                fprintf(stderr, "Unknown objective: %s\n", argv[i]);
+                dyn_array_destroy(pcb_files);
+                return EXIT_FAILURE;
+            }
+            tune.objective = (AutotuneObjective_t) objective;
+        }
+        else if (strcmp(argv[i], "--quanta") == 0 && i + 1 < argc)
+        {
+            unsigned long long low, high;
+            if (!parse_pair(argv[++i], &low, &high) || !low || low > high)
+            {
+                fprintf(stderr, "Bad quanta: %s\n", argv[i]);
+                dyn_array_destroy(pcb_files);
+                return EXIT_FAILURE;
+            }
+            tune.quantum_min = (size_t) low;
+            tune.quantum_max = (size_t) high;
+        }
+        else if (strcmp(argv[i], "--tune-policies") == 0 && i + 1 < argc)
+        {
+            if (!parse_policies(argv[++i], tune_policies, sizeof(tune_policies) / sizeof(tune_policies[0]),
+                                &tune.policy_count))
+            {
+                fprintf(stderr, "Bad policy list: %s\n", argv[i]);
+                dyn_array_destroy(pcb_files);
+                return EXIT_FAILURE;
+            }
+        }
+        else if (strcmp(argv[i], "--candidates") == 0 && i + 1 < argc)
+        {
+            tune.candidates = strtoul(argv[++i], NULL, 10);
+        }
+        else if (strcmp(argv[i], "--min-pcbs") == 0 && i + 1 < argc)
+        {
+            tune.min_pcbs = strtoul(argv[++i], NULL, 10);
+        }
+        else if (strcmp(argv[i], "--finalists") == 0 && i + 1 < argc)
+        {
+            tune.finalists = strtoul(argv[++i], NULL, 10);
+        }
+        else if (strcmp(argv[i], "--cache") == 0 && i + 1 < argc)
+        {
+            cache_dir = argv[++i];
+        }
+        else if (strcmp(argv[i], "--daemon") == 0 && i + 1 < argc)
+        {
+            daemon_socket = argv[++i];
+        }
+        else if (strcmp(argv[i], "--cache-size") == 0 && i + 1 < argc)
+        {
+            cache_bytes = strtoull(argv[++i], NULL, 10);
+        }
+        else if (strcmp(argv[i], "--migration-cost") == 0 && i + 1 < argc)
+        {
+            config.costs.migration_cost = (uint32_t) strtoul(argv[++i], NULL, 10);
+        }
+        else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc)
+        {
+            config.seed = strtoull(argv[++i], NULL, 10);
+        }
+        else if (strcmp(argv[i], "--io-devices") == 0 && i + 1 < argc)
+        {
+            config.io_devices = strtoul(argv[++i], NULL, 10);
+        }
+        else if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc)
+        {
+            // Shards run up to the next option or a bare number (the quantum); a shard
+            // whose name is a number can be given as ./<name>
+            while (i + 1 < argc && argv[i + 1][0] != '-' && !is_number(argv[i + 1]))
+            {
+                if (!dyn_array_push_back(pcb_files, &argv[++i]))
+                {
+                    fprintf(stderr, "Could not add trace shard: %s\n", argv[i]);
+                    dyn_array_destroy(pcb_files);
+                    return EXIT_FAILURE;
+                }
+            }
+        }
+        else if (strcmp(argv[i], "--window") == 0 && i + 1 < argc)
+        {
+            unsigned long long first, last;
+            if (!parse_pair(argv[++i], &first, &last) || first > last || last > UINT32_MAX)
+            {
+                fprintf(stderr, "Bad arrival window: %s\n", argv[i]);
+                dyn_array_destroy(pcb_files);
+                return EXIT_FAILURE;
+            }
+            window.arrival_start = (uint32_t) first;
+            window.arrival_end = (uint32_t) last;
+            sliced = true;
+        }
+        else if (strcmp(argv[i], "--pcbs") == 0 && i + 1 < argc)
+        {
+            unsigned long long first, count;
+            if (!parse_pair(argv[++i], &first, &count))
+            {
+                fprintf(stderr, "Bad PCB range: %s\n", argv[i]);
+                dyn_array_destroy(pcb_files);
+                return EXIT_FAILURE;
+            }
+            window.first_pcb = (size_t) first;
+            window.pcb_count = (size_t) count;
+            sliced = true;
+        }
+        else if (strcmp(argv[i], "--sample") == 0 && i + 1 < argc)
+        {
+            unsigned long long windows, length;
+            if (!parse_pair(argv[++i], &windows, &length) || !windows || !length || length > UINT32_MAX)
+            {
+                fprintf(stderr, "Bad sample: %s\n", argv[i]);
+                dyn_array_destroy(pcb_files);
+                return EXIT_FAILURE;
+            }
+            sample.windows = (size_t) windows;
+            sample.window_length = (uint32_t) length;
+            sampled = true;
+        }
+        else if (strcmp(argv[i], "--warmup") == 0 && i + 1 < argc)
+        {
+            sample.warmup = (uint32_t) strtoul(argv[++i], NULL, 10);
+        }
+        else if (strcmp(argv[i], "--confidence") == 0 && i + 1 < argc)
+        {
+            sample.confidence = strtod(argv[++i], NULL);
+        }
+        else if (strcmp(argv[i], "--error-bound") == 0 && i + 1 < argc)
+        {
+            sample.error_bound = strtod(argv[++i], NULL);
+        }
+        else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+        {
+            threads = strtoul(argv[++i], NULL, 10);
+            tune.threads = threads;
+        }
+        else if ((policy == SCHEDULE_RR || policy == SCHEDULE_STRIDE || policy == SCHEDULE_LOTTERY
+                  || policy == SCHEDULE_GROUP || policy == SCHEDULE_SRTF) && argv[i][0] != '-')
+        {
+            config.quantum = strtoul(argv[i], NULL, 10);
+        }
+        else
+        {
+            fprintf(stderr, "Unknown argument: %s\n", argv[i]);
+            dyn_array_destroy(pcb_files);
+            return EXIT_FAILURE;
+        }
+    }
+
+    const bool merged = sliced || dyn_array_size(pcb_files) > 1;
+    if (topology_file && (shares || timeline_file))
+    {
+        // shares are not modelled on many CPUs, and a timeline has no CPU to tell overlapping slices apart
+        fprintf(stderr, "--topology cannot be combined with --shares or --timeline\n");
+        dyn_array_destroy(pcb_files);
+        return EXIT_FAILURE;
+    }
+    // on many CPUs tenants only say where each PCB's memory lives; on one they are reported on
+    shares = shares || (tenant_file && !topology_file);
+    if (merged && (burst_file || deadline_file || tenant_file || group_map_file))
+    {
+        // phase lists, deadlines, tenants and groups are matched to PCBs by position in a single file
+        fprintf(stderr, "--bursts, --deadlines, --tenants and --group-map need a single, unsliced PCB file\n");
+        dyn_array_destroy(pcb_files);
+        return EXIT_FAILURE;
+    }
+
+    // Results that are known without running: asked of a daemon, or found in the cache below
+    CachedRun_t cached;
+    memset(&cached, 0, sizeof(cached));
+    bool answered = false;
+    if (daemon_socket)
+    {
+        // the daemon runs the plain single CPU engine over one trace it keeps in memory
+        if (burst_file || deadline_file || shares || tenant_file || group_file || group_map_file || topology_file || timeline_file
+            || tuning || sampled || cache_dir || config.admission || dyn_array_size(pcb_files) > 1
+            || policy == SCHEDULE_GROUP)
+        {
+            fprintf(stderr, "--daemon cannot be combined with GROUP, --trace, --bursts, --deadlines, --admission, "
+                            "--shares, --tenants, --groups, --topology, --timeline, --tune, --sample or --cache\n");
+            dyn_array_destroy(pcb_files);
+            return EXIT_FAILURE;
+        }
+        answered = ask_daemon(daemon_socket, pcb_file, &config, sliced ? &window : NULL, &cached);
+        if (!answered)
+        {
+            dyn_array_destroy(pcb_files);
+            return EXIT_FAILURE;
         }
     }
-    else if (strcmp(algorithm, SJF) == 0) 
+
+    if (sampled)
     {
-        if (shortest_job_first(ready_queue, &result)) 
+        // sampling picks its own windows and only estimates the averages and the run time
+        if (burst_file || deadline_file || shares || timeline_file || sliced || topology_file || tuning
+            || policy == SCHEDULE_GROUP)
         {
-            // Print or store the scheduling results
-            printf("Shortest Job First scheduling results:\n");
-            printf("Average Turnaround Time: %f\n", result.average_turnaround_time);
-            printf("Average Waiting Time: %f\n", result.average_waiting_time);
-            printf("Total Run Time: %lu\n", result.total_run_time);
-            // Output additional results if needed
+            fprintf(stderr, "--sample cannot be combined with GROUP, --bursts, --deadlines, --shares, --timeline, "
+                            "--window, --pcbs, --topology or --tune\n");
+            dyn_array_destroy(pcb_files);
+            return EXIT_FAILURE;
         }
-        else 
+        TraceSampleResult_t estimate;
+        const bool ok = trace_sample_run(dyn_array_export(pcb_files), dyn_array_size(pcb_files), &config, &sample,
+                                         &estimate);
+        dyn_array_destroy(pcb_files);
+        if (!ok)
         {
-            fprintf(stderr, "Error executing Shortest Job First scheduling algorithm\n");
-            EXIT_FAILURE;
+            fprintf(stderr, "Error sampling %s scheduling algorithm\n", result_titles[policy]);
+            return EXIT_FAILURE;
         }
+        printf("%s scheduling results (%s):\n", result_titles[policy], estimate.exact ? "exact" : "sampled");
+        printf("Average Turnaround Time: %f +/- %f\n", estimate.result.average_turnaround_time,
+               estimate.turnaround_half_width);
+        printf("Average Waiting Time: %f +/- %f\n", estimate.result.average_waiting_time,
+               estimate.waiting_half_width);
+        printf("Total Run Time: %lu\n", estimate.result.total_run_time);
+        printf("Sampled PCBs: %zu of %zu\n", estimate.sampled_pcbs, estimate.total_pcbs);
+        return EXIT_SUCCESS;
     }
-    else if (strcmp(algorithm, P) == 0) 
+
+    if (timeline_file)
     {
-        if (priority(ready_queue, &result)) 
+        config.timeline = timeline_create();
+    }
+
+    BurstArena_t *bursts = NULL;
+    if (burst_file)
+    {
+        bursts = burst_arena_load(burst_file);
+        if (!bursts)
         {
-            // Print or store the scheduling results
-            printf("Priority scheduling results:\n");
-            printf("Average Turnaround Time: %f\n", result.average_turnaround_time);
-            printf("Average Waiting Time: %f\n", result.average_waiting_time);
-            printf("Total Run Time: %lu\n", result.total_run_time);
-            // Output additional results if needed
+            fprintf(stderr, "Could not load CPU/I/O phases from %s\n", burst_file);
+            timeline_destroy(config.timeline);
+            dyn_array_destroy(pcb_files);
+            return EXIT_FAILURE;
         }
-        else 
+        config.bursts = bursts;
+    }
+
+    dyn_array_t *deadlines = NULL;
+    if (deadline_file)
+    {
+        deadlines = realtime_load_deadlines(deadline_file);
+        if (!deadlines)
         {
-            fprintf(stderr, "Error executing Priority scheduling algorithm\n");
-            EXIT_FAILURE;
+            fprintf(stderr, "Could not load deadlines from %s\n", deadline_file);
+            timeline_destroy(config.timeline);
+            burst_arena_destroy(bursts);
+            dyn_array_destroy(pcb_files);
+            return EXIT_FAILURE;
         }
+        config.deadlines = deadlines;
+        config.deadline_stats = &deadline_stats;
     }
-    else if (strcmp(algorithm, RR) == 0) 
+
+    Topology_t *topology = NULL;
+    if (topology_file)
     {
-        if (round_robin(ready_queue, &result, quantum)) 
+        topology = strcmp(topology_file, "sys") == 0 ? topology_detect(NULL) : topology_load(topology_file);
+        if (!topology)
         {
-            // Print or store the scheduling results
-            printf("Round Robin scheduling results:\n");
-            printf("Average Turnaround Time: %f\n", result.average_turnaround_time);
-            printf("Average Waiting Time: %f\n", result.average_waiting_time);
-            printf("Total Run Time: %lu\n", result.total_run_time);
-            // Output additional results if needed
+            fprintf(stderr, "Could not load a topology from %s\n", topology_file);
+            timeline_destroy(config.timeline);
+            burst_arena_destroy(bursts);
+            dyn_array_destroy(deadlines);
+            dyn_array_destroy(pcb_files);
+            return EXIT_FAILURE;
         }
-        else 
+        config.topology = topology;
+        config.core_classes = dyn_array_create(0, sizeof(ScheduleCoreClass_t), NULL);
+    }
+
+    dyn_array_t *tenants = tenant_file ? load_tenants(tenant_file) : NULL;
+    if (topology && tenant_file)
+    {
+        if (!tenants)
         {
-            fprintf(stderr, "Error executing Round Robin scheduling algorithm\n");
-            EXIT_FAILURE;
+            fprintf(stderr, "Could not load tenants from %s\n", tenant_file);
+            timeline_destroy(config.timeline);
+            burst_arena_destroy(bursts);
+            dyn_array_destroy(deadlines);
+            topology_destroy(topology);
+            dyn_array_destroy(config.core_classes);
+            dyn_array_destroy(pcb_files);
+            return EXIT_FAILURE;
         }
+        config.tenants = tenants;
     }
-    else if (strcmp(algorithm, SRT) == 0) 
+    if (shares)
     {
-        if (shortest_remaining_time_first(ready_queue, &result)) 
+        config.tenants = tenants;
+        config.shares = dyn_array_create(0, sizeof(ScheduleShare_t), NULL);
+        if ((tenant_file && !tenants) || !config.shares)
         {
-            // Print or store the scheduling results
-            printf("Shortest Remaining Time scheduling results:\n");
-            printf("Average Turnaround Time: %f\n", result.average_turnaround_time);
-            printf("Average Waiting Time: %f\n", result.average_waiting_time);
-            printf("Total Run Time: %lu\n", result.total_run_time);
+            fprintf(stderr, "Could not load tenants from %s\n", tenant_file ? tenant_file : "(none)");
+            timeline_destroy(config.timeline);
+            topology_destroy(topology);
+            dyn_array_destroy(config.core_classes);
+            burst_arena_destroy(bursts);
+            dyn_array_destroy(deadlines);
+            dyn_array_destroy(tenants);
+            dyn_array_destroy(config.shares);
+            dyn_array_destroy(pcb_files);
+            return EXIT_FAILURE;
         }
-        else 
+    }
+
+    GroupTree_t *groups = NULL;
+    dyn_array_t *group_of = NULL;
+    if (policy == SCHEDULE_GROUP)
+    {
+        groups = group_file ? group_tree_load(group_file) : group_tree_create(GROUP_FAIR);
+        group_of = groups && group_map_file ? group_tree_load_map(groups, group_map_file) : NULL;
+        if (!group_of)
         {
-            fprintf(stderr, "Error executing Shortest Remaining Time scheduling algorithm\n");
-            EXIT_FAILURE;
+            fprintf(stderr, "GROUP needs a readable --group-map (and --groups if given)\n");
+            group_tree_destroy(groups);
+            timeline_destroy(config.timeline);
+            topology_destroy(topology);
+            dyn_array_destroy(config.core_classes);
+            burst_arena_destroy(bursts);
+            dyn_array_destroy(deadlines);
+            dyn_array_destroy(tenants);
+            dyn_array_destroy(config.shares);
+            dyn_array_destroy(pcb_files);
+            return EXIT_FAILURE;
         }
+        config.groups = groups;
+        config.group_of = group_of;
     }
-    else 
+
+    ScheduleResult_t result = {0, 0, 0};
+    TraceSummary_t summary = {0, 0, 0, 0};
+    size_t pcb_count = 0;
+
+    // A run seen before is answered from the cache without reading its PCBs. Timelines, tuning
+    // and instrumented builds produce more than the cache keeps, so they always run
+    ResultCache_t *cache = NULL;
+    ResultKey_t key = {0, 0};
+    if (cache_dir && !timeline_file && !tuning && !instrument_enabled())
     {
-        fprintf(stderr, "Unknown scheduling algorithm: %s\n", algorithm);
-        EXIT_FAILURE;
+        const char *const inputs[] = {burst_file, deadline_file, tenant_file, group_file, group_map_file};
+        cache = result_cache_open(cache_dir, cache_bytes);
+        if (!cache || !run_key(&key, pcb_files, merged, &window, &config, inputs, sizeof(inputs) / sizeof(inputs[0])))
+        {
+            // a PCB file that cannot be read fails below, with or without the cache
+            result_cache_close(cache);
+            cache = NULL;
+        }
+        answered = cache && cache_fetch(cache, key, &cached, &config);
+    }
+    if (answered)
+    {
+        result = cached.result;
+        stats = cached.stats;
+        deadline_stats = cached.deadline_stats;
+        summary = cached.summary;
+        pcb_count = (size_t) cached.pcbs;
+    }
+
+    // Load process control blocks from the binary file
+    dyn_array_t *ready_queue = NULL;
+    if (!answered)
+    {
+        ready_queue = merged
+            ? trace_merge_load(dyn_array_export(pcb_files), dyn_array_size(pcb_files), &window)
+            : load_process_control_blocks(pcb_file);
+        dyn_array_reduce(ready_queue, &summary, sizeof(summary), summary_fold, summary_combine, NULL, 0);
+        pcb_count = ready_queue ? dyn_array_size(ready_queue) : 0;
+        if (ready_queue && deadlines && !periodic_analysis(ready_queue, deadlines, &cached))
+        {
+            fprintf(stderr, "Could not analyse the periodic PCBs\n");
+        }
+    }
+
+    // Instrumented builds can dump a Chrome trace/Perfetto timeline of the run
+    const char *trace_file = getenv("SCHED_TRACE");
+    const bool tracing = instrument_enabled() && trace_file;
+    if (tracing && !instrument_trace_open(trace_file))
+    {
+        fprintf(stderr, "Could not open trace file %s\n", trace_file);
+    }
+    instrument_reset();
+
+    int status = EXIT_SUCCESS;
+
+    if (tuning)
+    {
+        // candidates draw from the lottery seed too, so one --seed reproduces the whole search
+        tune.seed = config.seed;
+        // runs on several threads would write their slices into one trace timeline at once
+        tune.threads = tracing ? 1 : tune.threads;
+        dyn_array_t *tuned = ready_queue ? autotune_run(ready_queue, &tune) : NULL;
+        if (tuned)
+        {
+            printf("Tuning results (%s search, best %s first):\n", search_names[tune.search],
+                   objective_names[tune.objective]);
+            for (size_t i = 0; i < dyn_array_size(tuned); ++i)
+            {
+                print_candidate(dyn_array_at(tuned, i), topology != NULL);
+            }
+            printf("Pareto front:\n");
+            for (size_t i = 0; i < dyn_array_size(tuned); ++i)
+            {
+                const AutotuneResult_t *candidate = dyn_array_at(tuned, i);
+                if (candidate->pareto)
+                {
+                    print_candidate(candidate, topology != NULL);
+                }
+            }
+        }
+        else
+        {
+            fprintf(stderr, "Error tuning the scheduling algorithms\n");
+            status = EXIT_FAILURE;
+        }
+        dyn_array_destroy(tuned);
+    }
+
+    // Execute the specified scheduling algorithm. Busy periods simulated at once would write
+    // overlapping slices into the trace, so a traced run stays in one piece
+    const bool ran = answered || (!tuning && (threads == 1 || tracing
+        ? schedule_run(ready_queue, &result, &config)
+        : schedule_run_parallel(ready_queue, &result, &config, threads)));
+    if (ran && cache && !answered)
+    {
+        cached.result = result;
+        cached.stats = stats;
+        if (deadlines)
+        {
+            cached.deadline_stats = deadline_stats;
+        }
+        cached.summary = summary;
+        cached.pcbs = pcb_count;
+        if (!cache_store(cache, key, &cached, &config))
+        {
+            fprintf(stderr, "Could not store the results in %s\n", cache_dir);
+        }
+    }
+    if (ran)
+    {
+        // Print or store the scheduling results
+        printf("%s scheduling results:\n", result_titles[policy]);
+        printf("Average Turnaround Time: %f\n", result.average_turnaround_time);
+        printf("Average Waiting Time: %f\n", result.average_waiting_time);
+        printf("Total Run Time: %lu\n", result.total_run_time);
+        printf("Context Switches: %llu\n", (unsigned long long) stats.context_switches);
+        printf("Switch Overhead: %llu\n", (unsigned long long) stats.switch_overhead);
+        printf("Cache Refill Overhead: %llu\n", (unsigned long long) stats.refill_overhead);
+        if (topology)
+        {
+            printf("CPUs: %zu\n", topology_cpus(topology));
+            printf("Migrations: %llu\n", (unsigned long long) stats.migrations);
+            printf("Migration Overhead: %llu\n", (unsigned long long) stats.migration_overhead);
+            printf("Locality Overhead: %llu\n", (unsigned long long) stats.locality_overhead);
+            // one class is the whole machine, already reported above
+            for (size_t k = 0; config.core_classes && dyn_array_size(config.core_classes) > 1
+                               && k < dyn_array_size(config.core_classes); ++k)
+            {
+                const ScheduleCoreClass_t *kind = dyn_array_at(config.core_classes, k);
+                printf("Core Class %zu: speed %u, CPUs %u, utilisation %f, work %llu, slices %llu, "
+                       "finished %llu, average turnaround %f\n",
+                       k, kind->speed, kind->cpus,
+                       result.total_run_time ? (double) kind->busy / ((double) result.total_run_time * kind->cpus) : 0.0,
+                       (unsigned long long) kind->work, (unsigned long long) kind->slices,
+                       (unsigned long long) kind->finished,
+                       kind->finished ? (double) kind->turnaround / kind->finished : 0.0);
+            }
+        }
+        if (result.total_run_time)
+        {
+            // busy ticks are summed over every CPU of a multi-CPU run
+            const size_t cpus = topology ? topology_cpus(topology) : 1;
+            printf("CPU Utilisation: %f\n", (double) stats.cpu_busy / ((double) result.total_run_time * cpus));
+            printf("I/O Utilisation: %f\n", (double) stats.io_busy / result.total_run_time);
+            printf("Throughput: %f\n", (double) pcb_count / result.total_run_time);
+        }
+        printf("Total Burst Time: %llu\n", (unsigned long long) summary.total_burst);
+        printf("Longest Burst Time: %llu\n", (unsigned long long) summary.longest_burst);
+        printf("Last Arrival: %llu\n", (unsigned long long) summary.last_arrival);
+        printf("Mean Priority: %f\n", (double) summary.priority_sum / pcb_count);
+        if (deadlines)
+        {
+            printf("Deadline PCBs: %llu\n", (unsigned long long) deadline_stats.jobs);
+            printf("Deadline Misses: %llu\n", (unsigned long long) deadline_stats.misses);
+            printf("Rejected PCBs: %llu\n", (unsigned long long) deadline_stats.rejected);
+            printf("Max Lateness: %llu\n", (unsigned long long) deadline_stats.max_lateness);
+            if (deadline_stats.misses)
+            {
+                printf("Mean Lateness Of Misses: %f\n",
+                       (double) deadline_stats.total_lateness / deadline_stats.misses);
+            }
+            for (size_t b = 1; b < SCHEDULE_LATENESS_BUCKETS; ++b)
+            {
+                if (deadline_stats.lateness[b])
+                {
+                    printf("Late By %llu-%llu: %llu\n", 1ull << (b - 1), (1ull << b) - 1,
+                           (unsigned long long) deadline_stats.lateness[b]);
+                }
+            }
+            if (cached.periodic_tasks)
+            {
+                static const char *const verdicts[] = {"no", "yes", "unknown"};
+                printf("Periodic Tasks: %llu\n", (unsigned long long) cached.periodic_tasks);
+                printf("Periodic Utilisation: %f\n", cached.periodic_utilisation);
+                printf("EDF Schedulable: %s\n", verdicts[cached.edf_schedulable]);
+            }
+        }
+
+        if (config.shares)
+        {
+            printf("Share Error: %f\n", schedule_share_error(config.shares));
+            // without a tenant table every PCB is its own tenant, too many to list
+            for (size_t t = 0; tenants && t < dyn_array_size(config.shares); ++t)
+            {
+                const ScheduleShare_t *share = dyn_array_at(config.shares, t);
+                if (share->pcbs)
+                {
+                    printf("Tenant %zu: tickets %llu, received %llu, entitled %f\n", t,
+                           (unsigned long long) share->tickets, (unsigned long long) share->received,
+                           share->entitled);
+                }
+            }
+        }
+
+        if (timeline_file && !write_timeline(config.timeline, timeline_file))
+        {
+            fprintf(stderr, "Could not write timeline to %s\n", timeline_file);
+            status = EXIT_FAILURE;
+        }
+    }
+    else if (!tuning)
+    {
+        fprintf(stderr, "Error executing %s scheduling algorithm\n", result_titles[policy]);
+        status = EXIT_FAILURE;
+    }
+
+    if (instrument_enabled())
+    {
+        InstrumentCounters_t counters;
+        instrument_snapshot(&counters);
+        printf("Instrumented Context Switches: %llu\n", (unsigned long long) counters.context_switches);
+        printf("Queue Operations: %llu\n", (unsigned long long) counters.queue_ops);
+        printf("Memmove Bytes: %llu\n", (unsigned long long) counters.memmove_bytes);
+        printf("Reallocs: %llu\n", (unsigned long long) counters.reallocs);
+        printf("Comparator Calls: %llu\n", (unsigned long long) counters.comparator_calls);
+        instrument_trace_close();
     }
 
     // Clean up allocated memory
+    timeline_destroy(config.timeline);
+    burst_arena_destroy(bursts);
+    dyn_array_destroy(deadlines);
+    dyn_array_destroy(tenants);
+    dyn_array_destroy(config.shares);
+    group_tree_destroy(groups);
+    dyn_array_destroy(group_of);
+    topology_destroy(topology);
+    dyn_array_destroy(config.core_classes);
     dyn_array_destroy(ready_queue);
+    dyn_array_destroy(pcb_files);
+    result_cache_close(cache);
 
-    return EXIT_SUCCESS;    
+    return status;
 }
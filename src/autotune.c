@@ -0,0 +1,386 @@
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "autotune.h"
+#include "dyn_array_parallel.h"
+#include "timeline.h"
+
+// Percentile of the turnaround times an evaluation reports
+#define AUTOTUNE_PERCENTILE 0.99
+
+// A candidate on its way through the search
+typedef struct
+{
+    AutotuneResult_t result;
+    double score;                   // the objective, lower is better
+    size_t index;                   // order the candidate was generated in, breaks ties
+    bool ok;
+}
+AutotuneTrial_t;
+
+// What every evaluation of a round shares
+typedef struct
+{
+    const dyn_array_t *ready_queue;
+    const AutotuneConfig_t *config;
+    size_t pcbs;                    // PCBs of the trace the round runs on
+}
+AutotuneRound_t;
+
+void autotune_config_init(AutotuneConfig_t *config, const ScheduleConfig_t *base)
+{
+    static const SchedulePolicy_t round_robin = SCHEDULE_RR;
+    if (config)
+    {
+        memset(config, 0, sizeof(*config));
+        config->base = base;
+        config->policies = &round_robin;
+        config->policy_count = 1;
+        config->quantum_min = 1;
+        config->quantum_max = 64;
+        config->search = AUTOTUNE_GRID;
+        config->objective = AUTOTUNE_MEAN_WAIT;
+        config->candidates = 32;
+        config->min_pcbs = 1000;
+        config->finalists = 4;
+        config->seed = 1;
+        config->threads = 0;
+    }
+}
+
+static uint64_t splitmix64(uint64_t *state)
+{
+    uint64_t z = (*state += 0x9e3779b97f4a7c15ull);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+    return z ^ (z >> 31);
+}
+
+// Whether the policy has a quantum worth tuning under the base config
+static bool uses_quantum(SchedulePolicy_t policy, const ScheduleConfig_t *base)
+{
+    return policy == SCHEDULE_RR || policy == SCHEDULE_STRIDE || policy == SCHEDULE_LOTTERY
+           || policy == SCHEDULE_GROUP || (policy == SCHEDULE_SRTF && base->topology);
+}
+
+static int cmpfuncTurnaround(const void *a, const void *b)
+{
+    const uint64_t turnaround_a = *(const uint64_t *) a;
+    const uint64_t turnaround_b = *(const uint64_t *) b;
+    return turnaround_a < turnaround_b ? -1 : (turnaround_a > turnaround_b);
+}
+
+// The score the objective ranks on, lower is better
+static double objective_score(AutotuneObjective_t objective, const AutotuneResult_t *result)
+{
+    switch (objective)
+    {
+        case AUTOTUNE_P99_TURNAROUND:
+            return result->p99_turnaround;
+        case AUTOTUNE_THROUGHPUT:
+            return -result->throughput;
+        default:
+            return result->mean_wait;
+    }
+}
+
+bool autotune_better(AutotuneObjective_t objective, const AutotuneResult_t *a, const AutotuneResult_t *b)
+{
+    return a && b && objective_score(objective, a) < objective_score(objective, b);
+}
+
+// dyn_array_parallel_for_each_grain callback: runs one candidate on the round's part of the trace
+static void autotune_evaluate(void *const object, void *arg)
+{
+    AutotuneTrial_t *trial = (AutotuneTrial_t *) object;
+    const AutotuneRound_t *round = (const AutotuneRound_t *) arg;
+    const AutotuneParams_t *params = &trial->result.params;
+    trial->ok = false;
+
+    // the engine consumes the bursts, so every run gets its own copy
+    dyn_array_t *queue = dyn_array_create(round->pcbs, sizeof(ProcessControlBlock_t), NULL);
+    dyn_array_t *turnarounds = dyn_array_create(round->pcbs, sizeof(uint64_t), NULL);
+    Timeline_t *timeline = timeline_create();
+    const uint64_t zero = 0;
+    ScheduleConfig_t config = *round->config->base;
+    config.policy = params->policy;
+    config.quantum = params->quantum;
+    config.placement = params->placement;
+    config.balance = params->balance;
+    config.timeline = timeline;
+    config.stats = NULL;
+    config.deadline_stats = NULL;
+    config.shares = NULL;
+    config.core_classes = NULL;
+    ScheduleResult_t result = {0, 0, 0};
+    if (queue && turnarounds && timeline
+        && dyn_array_append_n(queue, dyn_array_export(round->ready_queue), round->pcbs)
+        && dyn_array_resize(turnarounds, round->pcbs, &zero) && schedule_run(queue, &result, &config))
+    {
+        // a PCB is done when its last slice ends; ones that never ran took no time
+        uint64_t *done = dyn_array_front(turnarounds);
+        for (size_t i = 0; i < timeline_size(timeline); ++i)
+        {
+            const TimelineSegment_t *segment = timeline_at(timeline, i);
+            const uint64_t end = segment->start + segment->length;
+            done[segment->pid] = end > done[segment->pid] ? end : done[segment->pid];
+        }
+        const ProcessControlBlock_t *pcbs = dyn_array_export(round->ready_queue);
+        for (size_t i = 0; i < round->pcbs; ++i)
+        {
+            done[i] = done[i] > pcbs[i].arrival ? done[i] - pcbs[i].arrival : 0;
+        }
+        dyn_array_sort(turnarounds, cmpfuncTurnaround);
+        const size_t rank = (size_t) ceil(AUTOTUNE_PERCENTILE * round->pcbs);
+
+        trial->result.mean_wait = result.average_waiting_time;
+        trial->result.p99_turnaround = (double) done[rank ? rank - 1 : 0];
+        trial->result.throughput = result.total_run_time ? (double) round->pcbs / result.total_run_time : 0.0;
+        trial->result.pcbs = round->pcbs;
+        trial->score = objective_score(round->config->objective, &trial->result);
+        trial->ok = true;
+    }
+    timeline_destroy(timeline);
+    dyn_array_destroy(turnarounds);
+    dyn_array_destroy(queue);
+}
+
+// Evaluates every trial on the first pcbs PCBs of the trace
+static bool autotune_round(dyn_array_t *trials, const dyn_array_t *ready_queue, const AutotuneConfig_t *config,
+                           size_t pcbs)
+{
+    AutotuneRound_t round = {ready_queue, config, pcbs};
+    if (!dyn_array_parallel_for_each_grain(trials, autotune_evaluate, &round, config->threads, 1))
+    {
+        return false;
+    }
+    for (size_t i = 0; i < dyn_array_size(trials); ++i)
+    {
+        if (!((AutotuneTrial_t *) dyn_array_at(trials, i))->ok)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Longest evaluations first, then best score, then generation order
+static int cmpfuncTrial(const void *a, const void *b)
+{
+    const AutotuneTrial_t *trial_a = (const AutotuneTrial_t *) a;
+    const AutotuneTrial_t *trial_b = (const AutotuneTrial_t *) b;
+    if (trial_a->result.pcbs != trial_b->result.pcbs)
+    {
+        return trial_a->result.pcbs > trial_b->result.pcbs ? -1 : 1;
+    }
+    if (trial_a->score != trial_b->score)
+    {
+        return trial_a->score < trial_b->score ? -1 : 1;
+    }
+    return trial_a->index < trial_b->index ? -1 : (trial_a->index > trial_b->index);
+}
+
+// Adds a candidate with every placement and balance policy when there is a topology to place on
+static bool add_candidate(dyn_array_t *trials, const AutotuneConfig_t *config, SchedulePolicy_t policy,
+                          size_t quantum)
+{
+    const bool placed = config->base->topology != NULL;
+    for (int placement = 0; placement <= (placed ? SCHEDULE_PLACE_SPEED : 0); ++placement)
+    {
+        for (int balance = 0; balance <= (placed ? SCHEDULE_BALANCE_SOCKET : 0); ++balance)
+        {
+            AutotuneTrial_t trial;
+            memset(&trial, 0, sizeof(trial));
+            trial.result.params.policy = policy;
+            trial.result.params.quantum = quantum;
+            trial.result.params.placement = placed ? (SchedulePlacement_t) placement : config->base->placement;
+            trial.result.params.balance = placed ? (ScheduleBalance_t) balance : config->base->balance;
+            trial.index = dyn_array_size(trials);
+            if (!dyn_array_push_back(trials, &trial))
+            {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+static bool grid_candidates(dyn_array_t *trials, const AutotuneConfig_t *config)
+{
+    for (size_t p = 0; p < config->policy_count; ++p)
+    {
+        const SchedulePolicy_t policy = config->policies[p];
+        if (!uses_quantum(policy, config->base))
+        {
+            if (!add_candidate(trials, config, policy, 0))
+            {
+                return false;
+            }
+            continue;
+        }
+        for (size_t quantum = config->quantum_min;; quantum *= 2)
+        {
+            quantum = quantum < config->quantum_max ? quantum : config->quantum_max;
+            if (!add_candidate(trials, config, policy, quantum))
+            {
+                return false;
+            }
+            if (quantum == config->quantum_max)
+            {
+                break;
+            }
+        }
+    }
+    return true;
+}
+
+static bool same_params(const AutotuneParams_t *a, const AutotuneParams_t *b)
+{
+    return a->policy == b->policy && a->quantum == b->quantum && a->placement == b->placement
+           && a->balance == b->balance;
+}
+
+// Draws distinct candidates, giving up on the ones left once draws keep repeating (a small space)
+static bool random_candidates(dyn_array_t *trials, const AutotuneConfig_t *config)
+{
+    uint64_t state = config->seed;
+    const double low = log((double) config->quantum_min);
+    const double high = log((double) config->quantum_max);
+    for (size_t draw = 0; dyn_array_size(trials) < config->candidates && draw < 16 * config->candidates; ++draw)
+    {
+        const SchedulePolicy_t policy = config->policies[splitmix64(&state) % config->policy_count];
+        // 53 random bits give a uniform double in [0, 1)
+        const double unit = (double) (splitmix64(&state) >> 11) / 9007199254740992.0;
+        size_t quantum = 0;
+        if (uses_quantum(policy, config->base))
+        {
+            quantum = (size_t) llround(exp(low + unit * (high - low)));
+            quantum = quantum < config->quantum_min ? config->quantum_min : quantum;
+            quantum = quantum > config->quantum_max ? config->quantum_max : quantum;
+        }
+        AutotuneTrial_t trial;
+        memset(&trial, 0, sizeof(trial));
+        trial.result.params.policy = policy;
+        trial.result.params.quantum = quantum;
+        trial.result.params.placement = config->base->placement;
+        trial.result.params.balance = config->base->balance;
+        if (config->base->topology)
+        {
+            trial.result.params.placement = (SchedulePlacement_t) (splitmix64(&state) % (SCHEDULE_PLACE_SPEED + 1));
+            trial.result.params.balance = (ScheduleBalance_t) (splitmix64(&state) % (SCHEDULE_BALANCE_SOCKET + 1));
+        }
+        bool repeated = false;
+        for (size_t i = 0; !repeated && i < dyn_array_size(trials); ++i)
+        {
+            repeated = same_params(&trial.result.params, &((AutotuneTrial_t *) dyn_array_at(trials, i))->result.params);
+        }
+        trial.index = dyn_array_size(trials);
+        if (!repeated && !dyn_array_push_back(trials, &trial))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Successive halving: rounds on twice the PCBs of the last, keeping the better half each time.
+// Pruned trials move to done with the results of the last round they ran
+static bool halving(dyn_array_t *trials, dyn_array_t *done, const dyn_array_t *ready_queue,
+                    const AutotuneConfig_t *config)
+{
+    const size_t total = dyn_array_size(ready_queue);
+    const size_t finalists = config->finalists ? config->finalists : 1;
+    size_t pcbs = config->min_pcbs && config->min_pcbs < total ? config->min_pcbs : total;
+    for (;;)
+    {
+        if (dyn_array_size(trials) <= finalists)
+        {
+            pcbs = total;
+        }
+        if (!autotune_round(trials, ready_queue, config, pcbs))
+        {
+            return false;
+        }
+        if (pcbs == total)
+        {
+            return true;
+        }
+        dyn_array_sort(trials, cmpfuncTrial);
+        const size_t count = dyn_array_size(trials);
+        const size_t keep = (count + 1) / 2 > finalists ? (count + 1) / 2 : finalists;
+        while (dyn_array_size(trials) > keep)
+        {
+            AutotuneTrial_t pruned;
+            if (!dyn_array_extract_back(trials, &pruned) || !dyn_array_push_back(done, &pruned))
+            {
+                return false;
+            }
+        }
+        pcbs = pcbs < total / 2 ? pcbs * 2 : total;
+    }
+}
+
+// Marks the full replays no other full replay dominates
+static void mark_pareto(dyn_array_t *trials, size_t total)
+{
+    const size_t n = dyn_array_size(trials);
+    for (size_t i = 0; i < n; ++i)
+    {
+        AutotuneResult_t *a = &((AutotuneTrial_t *) dyn_array_at(trials, i))->result;
+        a->pareto = a->pcbs == total;
+        for (size_t j = 0; a->pareto && j < n; ++j)
+        {
+            const AutotuneResult_t *b = &((AutotuneTrial_t *) dyn_array_at(trials, j))->result;
+            const bool no_worse = b->mean_wait <= a->mean_wait && b->p99_turnaround <= a->p99_turnaround
+                                  && b->throughput >= a->throughput;
+            const bool better = b->mean_wait < a->mean_wait || b->p99_turnaround < a->p99_turnaround
+                                || b->throughput > a->throughput;
+            a->pareto = !(j != i && b->pcbs == total && no_worse && better);
+        }
+    }
+}
+
+dyn_array_t *autotune_run(const dyn_array_t *ready_queue, const AutotuneConfig_t *config)
+{
+    if (!ready_queue || !config || !config->base || !config->policies || !config->policy_count
+        || dyn_array_empty(ready_queue) || dyn_array_data_size(ready_queue) != sizeof(ProcessControlBlock_t)
+        || !config->quantum_min || config->quantum_min > config->quantum_max
+        || (config->search == AUTOTUNE_RANDOM && !config->candidates))
+    {
+        return NULL;
+    }
+    dyn_array_t *trials = dyn_array_create(0, sizeof(AutotuneTrial_t), NULL);
+    dyn_array_t *done = dyn_array_create(0, sizeof(AutotuneTrial_t), NULL);
+    const bool drawn = config->search == AUTOTUNE_RANDOM || (config->search == AUTOTUNE_HALVING && config->candidates);
+    bool ok = trials && done && (drawn ? random_candidates(trials, config) : grid_candidates(trials, config));
+    if (ok)
+    {
+        ok = config->search == AUTOTUNE_HALVING
+            ? halving(trials, done, ready_queue, config)
+            : autotune_round(trials, ready_queue, config, dyn_array_size(ready_queue));
+    }
+    dyn_array_t *results = ok ? dyn_array_create(dyn_array_size(trials) + dyn_array_size(done),
+                                                 sizeof(AutotuneResult_t), NULL) : NULL;
+    if (results && dyn_array_append_n(trials, dyn_array_export(done), dyn_array_size(done)))
+    {
+        mark_pareto(trials, dyn_array_size(ready_queue));
+        dyn_array_sort(trials, cmpfuncTrial);
+        for (size_t i = 0; results && i < dyn_array_size(trials); ++i)
+        {
+            if (!dyn_array_push_back(results, &((AutotuneTrial_t *) dyn_array_at(trials, i))->result))
+            {
+                dyn_array_destroy(results);
+                results = NULL;
+            }
+        }
+    }
+    else
+    {
+        dyn_array_destroy(results);
+        results = NULL;
+    }
+    dyn_array_destroy(trials);
+    dyn_array_destroy(done);
+    return results;
+}
@@ -0,0 +1,117 @@
+#include <stdio.h>
+
+#include "burst_arena.h"
+#include "dyn_array.h"
+
+// Where one PCB's phases start in the shared buffer and how many there are
+typedef struct
+{
+    uint32_t offset;
+    uint32_t count;
+}
+BurstSpan_t;
+
+struct burst_arena
+{
+    dyn_array_t *phases;    // uint32_t, every PCB's phases back to back
+    dyn_array_t *spans;     // BurstSpan_t, one per PCB
+};
+
+BurstArena_t *burst_arena_create(void)
+{
+    BurstArena_t *arena = (BurstArena_t *) malloc(sizeof(BurstArena_t));
+    if (arena)
+    {
+        arena->phases = dyn_array_create(0, sizeof(uint32_t), NULL);
+        arena->spans = dyn_array_create(0, sizeof(BurstSpan_t), NULL);
+        if (arena->phases && arena->spans)
+        {
+            return arena;
+        }
+        burst_arena_destroy(arena);
+    }
+    return NULL;
+}
+
+void burst_arena_destroy(BurstArena_t *arena)
+{
+    if (arena)
+    {
+        dyn_array_destroy(arena->phases);
+        dyn_array_destroy(arena->spans);
+        free(arena);
+    }
+}
+
+bool burst_arena_add(BurstArena_t *arena, const uint32_t *phases, size_t count)
+{
+    if (!arena || !phases || !(count & 1) || dyn_array_size(arena->phases) + count > UINT32_MAX)
+    {
+        return false;
+    }
+
+    BurstSpan_t span = {(uint32_t) dyn_array_size(arena->phases), (uint32_t) count};
+    if (!dyn_array_push_back(arena->spans, &span))
+    {
+        return false;
+    }
+    if (!dyn_array_append_n(arena->phases, phases, count))
+    {
+        // keep the arena consistent
+        dyn_array_pop_back(arena->spans);
+        return false;
+    }
+    return true;
+}
+
+size_t burst_arena_size(const BurstArena_t *arena)
+{
+    return arena ? dyn_array_size(arena->spans) : 0;
+}
+
+const uint32_t *burst_arena_phases(const BurstArena_t *arena, size_t pid, size_t *count)
+{
+    if (!arena || !count)
+    {
+        return NULL;
+    }
+    const BurstSpan_t *span = dyn_array_at(arena->spans, pid);
+    if (!span)
+    {
+        return NULL;
+    }
+    *count = span->count;
+    return dyn_array_at(arena->phases, span->offset);
+}
+
+BurstArena_t *burst_arena_load(const char *path)
+{
+    if (!path)
+    {
+        return NULL;
+    }
+
+    FILE *file = fopen(path, "rb");
+    if (!file)
+    {
+        return NULL;
+    }
+
+    BurstArena_t *arena = burst_arena_create();
+    dyn_array_t *scratch = dyn_array_create(0, sizeof(uint32_t), NULL);
+    uint32_t count;
+    while (arena && scratch && fread(&count, sizeof(count), 1, file) == 1)
+    {
+        if (!count || !dyn_array_resize(scratch, count, NULL)
+            || fread(dyn_array_at(scratch, 0), sizeof(uint32_t), count, file) != count
+            || !burst_arena_add(arena, dyn_array_export(scratch), count))
+        {
+            burst_arena_destroy(arena);
+            arena = NULL;
+        }
+    }
+
+    dyn_array_destroy(scratch);
+    fclose(file);
+    return arena;
+}
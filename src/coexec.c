@@ -0,0 +1,252 @@
+#define _XOPEN_SOURCE 600
+
+#include <time.h>
+#include <ucontext.h>
+
+#include "coexec.h"
+#include "dyn_array.h"
+
+#define COEXEC_DEFAULT_STACK (64 * 1024)
+
+typedef struct
+{
+    ProcessControlBlock_t pcb;
+    CoTaskFunc_t func;
+    void *arg;
+    ucontext_t context;
+    void *stack;
+    uint64_t sequence;
+    uint32_t used;          // ticks reported since the current dispatch
+    bool finished;
+}
+CoTask_t;
+
+struct coexec
+{
+    ScheduleConfig_t config;
+    size_t stack_size;
+    dyn_array_t *ready;     // CoTask_t pointers in admission order
+    ucontext_t scheduler;
+    CoTask_t *current;
+    uint64_t sequence;
+    uint64_t switch_started_ns; // set when a task leaves the CPU, 0 when no switch is in flight
+    CoExecStats_t stats;
+};
+
+// The executor running on this thread, so tasks can reach it without an argument
+static _Thread_local CoExecutor_t *running_executor = NULL;
+
+static uint64_t now_ns(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t) now.tv_sec * 1000000000ull + (uint64_t) now.tv_nsec;
+}
+
+// Closes the timing of the switch that just brought a task onto the CPU
+static void coexec_resumed(CoExecutor_t *executor)
+{
+    if (executor->switch_started_ns)
+    {
+        executor->stats.total_switch_ns += now_ns() - executor->switch_started_ns;
+        ++executor->stats.switches;
+        executor->switch_started_ns = 0;
+    }
+}
+
+static void coexec_trampoline(void)
+{
+    CoExecutor_t *executor = running_executor;
+    CoTask_t *task = executor->current;
+
+    coexec_resumed(executor);
+    task->func(task->arg);
+    task->finished = true;
+    executor->switch_started_ns = now_ns();
+    // returning follows uc_link back to the executor
+}
+
+static void coexec_free_task(CoTask_t *task)
+{
+    free(task->stack);
+    free(task);
+}
+
+CoExecutor_t *coexec_create(const ScheduleConfig_t *config, size_t stack_size)
+{
+    if (!config || config->policy > SCHEDULE_SRTF
+        || ((config->policy == SCHEDULE_RR || config->policy == SCHEDULE_SRTF) && !config->quantum))
+    {
+        return NULL;
+    }
+
+    CoExecutor_t *executor = (CoExecutor_t *) calloc(1, sizeof(CoExecutor_t));
+    if (executor)
+    {
+        executor->config = *config;
+        executor->config.timeline = NULL;
+        executor->stack_size = stack_size ? stack_size : COEXEC_DEFAULT_STACK;
+        executor->ready = dyn_array_create(0, sizeof(CoTask_t *), NULL);
+        if (executor->ready)
+        {
+            return executor;
+        }
+        free(executor);
+    }
+    return NULL;
+}
+
+bool coexec_spawn(CoExecutor_t *executor, const ProcessControlBlock_t *descriptor, CoTaskFunc_t func, void *arg)
+{
+    if (!executor || !descriptor || !func)
+    {
+        return false;
+    }
+
+    CoTask_t *task = (CoTask_t *) calloc(1, sizeof(CoTask_t));
+    if (!task)
+    {
+        return false;
+    }
+    task->stack = malloc(executor->stack_size);
+    if (!task->stack || getcontext(&task->context) != 0)
+    {
+        coexec_free_task(task);
+        return false;
+    }
+
+    task->pcb = *descriptor;
+    task->pcb.started = false;
+    task->func = func;
+    task->arg = arg;
+    task->sequence = executor->sequence++;
+    task->context.uc_stack.ss_sp = task->stack;
+    task->context.uc_stack.ss_size = executor->stack_size;
+    task->context.uc_link = &executor->scheduler;
+    makecontext(&task->context, coexec_trampoline, 0);
+
+    if (!dyn_array_push_back(executor->ready, &task))
+    {
+        coexec_free_task(task);
+        return false;
+    }
+    return true;
+}
+
+// Removes the task the policy runs next from a non-empty ready queue
+static CoTask_t *coexec_pick(CoExecutor_t *executor)
+{
+    const SchedulePolicy_t policy = executor->config.policy;
+    const size_t n = dyn_array_size(executor->ready);
+    size_t best = 0;
+
+    if (policy != SCHEDULE_FCFS && policy != SCHEDULE_RR)
+    {
+        const CoTask_t *first = *(CoTask_t **) dyn_array_at(executor->ready, 0);
+        uint64_t best_key = schedule_policy_key(policy, &first->pcb, first->sequence);
+        for (size_t i = 1; i < n; ++i)
+        {
+            const CoTask_t *candidate = *(CoTask_t **) dyn_array_at(executor->ready, i);
+            const uint64_t key = schedule_policy_key(policy, &candidate->pcb, candidate->sequence);
+            if (key < best_key)
+            {
+                best = i;
+                best_key = key;
+            }
+        }
+    }
+
+    CoTask_t *task;
+    dyn_array_extract(executor->ready, best, &task);
+    return task;
+}
+
+bool coexec_run(CoExecutor_t *executor, CoExecStats_t *stats)
+{
+    if (!executor || running_executor)
+    {
+        return false;
+    }
+
+    bool ok = true;
+    running_executor = executor;
+    while (!dyn_array_empty(executor->ready))
+    {
+        CoTask_t *task = coexec_pick(executor);
+        task->used = 0;
+        task->pcb.started = true;
+        executor->current = task;
+        ++executor->stats.dispatches;
+
+        swapcontext(&executor->scheduler, &task->context);
+
+        executor->current = NULL;
+        if (task->finished)
+        {
+            coexec_free_task(task);
+            ++executor->stats.completed;
+        }
+        else if (!dyn_array_push_back(executor->ready, &task))
+        {
+            // a task that cannot be queued again is abandoned mid way, the others still run
+            coexec_free_task(task);
+            ok = false;
+        }
+    }
+    running_executor = NULL;
+    // the last task's exit has nobody to switch to
+    executor->switch_started_ns = 0;
+
+    if (stats)
+    {
+        *stats = executor->stats;
+    }
+    return ok;
+}
+
+void coexec_yield(void)
+{
+    CoExecutor_t *executor = running_executor;
+    if (!executor || !executor->current)
+    {
+        return;
+    }
+
+    CoTask_t *task = executor->current;
+    executor->switch_started_ns = now_ns();
+    swapcontext(&task->context, &executor->scheduler);
+    coexec_resumed(executor);
+}
+
+void coexec_tick(uint32_t ticks)
+{
+    CoExecutor_t *executor = running_executor;
+    if (!executor || !executor->current)
+    {
+        return;
+    }
+
+    CoTask_t *task = executor->current;
+    task->pcb.remaining_burst_time -= ticks < task->pcb.remaining_burst_time ? ticks : task->pcb.remaining_burst_time;
+    task->used += ticks;
+
+    const SchedulePolicy_t policy = executor->config.policy;
+    if ((policy == SCHEDULE_RR || policy == SCHEDULE_SRTF) && task->used >= executor->config.quantum)
+    {
+        coexec_yield();
+    }
+}
+
+void coexec_destroy(CoExecutor_t *executor)
+{
+    if (executor)
+    {
+        const size_t n = dyn_array_size(executor->ready);
+        for (size_t i = 0; i < n; ++i)
+        {
+            coexec_free_task(*(CoTask_t **) dyn_array_at(executor->ready, i));
+        }
+        dyn_array_destroy(executor->ready);
+        free(executor);
+    }
+}
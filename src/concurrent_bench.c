@@ -0,0 +1,146 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "../include/dyn_array.h"
+#include "../include/dyn_array_concurrent.h"
+#include "../include/processing_scheduling.h"
+
+// Baseline: the plain array behind one mutex, the way a shared ready queue would be done today
+typedef struct
+{
+    pthread_mutex_t lock;
+    dyn_array_t *array;
+}
+LockedArray_t;
+
+typedef struct
+{
+    LockedArray_t *locked;
+    dyn_array_concurrent_t *concurrent;
+    size_t pushes;
+    uint32_t first;
+    pthread_barrier_t *start;
+}
+BenchWorker_t;
+
+static uint64_t now_ns(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t) now.tv_sec * 1000000000ull + (uint64_t) now.tv_nsec;
+}
+
+static void *push_locked(void *arg)
+{
+    BenchWorker_t *worker = (BenchWorker_t *) arg;
+    pthread_barrier_wait(worker->start);
+    for (size_t i = 0; i < worker->pushes; ++i)
+    {
+        ProcessControlBlock_t pcb = {(uint32_t) i + 1, 0, worker->first, false};
+        pthread_mutex_lock(&worker->locked->lock);
+        dyn_array_push_back(worker->locked->array, &pcb);
+        pthread_mutex_unlock(&worker->locked->lock);
+    }
+    return NULL;
+}
+
+static void *push_concurrent(void *arg)
+{
+    BenchWorker_t *worker = (BenchWorker_t *) arg;
+    pthread_barrier_wait(worker->start);
+    for (size_t i = 0; i < worker->pushes; ++i)
+    {
+        ProcessControlBlock_t pcb = {(uint32_t) i + 1, 0, worker->first, false};
+        dyn_array_concurrent_push_back(worker->concurrent, &pcb, NULL);
+    }
+    return NULL;
+}
+
+// Times threads workers each pushing pushes PCBs through routine
+// \return nanoseconds from the start barrier to the last join, 0 on error
+static uint64_t run(void *(*routine)(void *), size_t threads, size_t pushes, LockedArray_t *locked,
+                    dyn_array_concurrent_t *concurrent)
+{
+    pthread_t *handles = malloc(threads * sizeof(pthread_t));
+    BenchWorker_t *workers = malloc(threads * sizeof(BenchWorker_t));
+    pthread_barrier_t start;
+    if (!handles || !workers || pthread_barrier_init(&start, NULL, (unsigned) threads + 1))
+    {
+        free(handles);
+        free(workers);
+        return 0;
+    }
+
+    size_t started = 0;
+    for (; started < threads; ++started)
+    {
+        workers[started] = (BenchWorker_t){locked, concurrent, pushes, (uint32_t) started, &start};
+        if (pthread_create(&handles[started], NULL, routine, &workers[started]))
+        {
+            fprintf(stderr, "Could not start thread %zu\n", started);
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    pthread_barrier_wait(&start);
+    const uint64_t begin = now_ns();
+    for (size_t i = 0; i < started; ++i)
+    {
+        pthread_join(handles[i], NULL);
+    }
+    const uint64_t elapsed = now_ns() - begin;
+
+    pthread_barrier_destroy(&start);
+    free(handles);
+    free(workers);
+    return elapsed ? elapsed : 1;
+}
+
+int main(int argc, char **argv)
+{
+    const size_t max_threads = argc > 1 ? strtoul(argv[1], NULL, 10) : 32;
+    const size_t pushes = argc > 2 ? strtoul(argv[2], NULL, 10) : 100000;
+    if (!max_threads || !pushes)
+    {
+        printf("%s [max threads] [pushes per thread]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    printf("%8s %16s %16s %10s\n", "threads", "mutex Mpush/s", "lock-free Mpush/s", "speedup");
+    for (size_t threads = 1; threads <= max_threads; threads <<= 1)
+    {
+        LockedArray_t locked;
+        pthread_mutex_init(&locked.lock, NULL);
+        locked.array = dyn_array_create(0, sizeof(ProcessControlBlock_t), NULL);
+        dyn_array_concurrent_t *concurrent = dyn_array_concurrent_create(sizeof(ProcessControlBlock_t));
+        if (!locked.array || !concurrent)
+        {
+            fprintf(stderr, "Could not create arrays\n");
+            return EXIT_FAILURE;
+        }
+
+        const uint64_t locked_ns = run(push_locked, threads, pushes, &locked, NULL);
+        const uint64_t concurrent_ns = run(push_concurrent, threads, pushes, NULL, concurrent);
+        if (!locked_ns || !concurrent_ns
+            || dyn_array_size(locked.array) != threads * pushes
+            || dyn_array_concurrent_size(concurrent) != threads * pushes)
+        {
+            fprintf(stderr, "Run with %zu threads failed\n", threads);
+            return EXIT_FAILURE;
+        }
+
+        const double total = (double) threads * pushes * 1000.0;
+        printf("%8zu %16.2f %16.2f %9.2fx\n", threads, total / locked_ns, total / concurrent_ns,
+               (double) locked_ns / concurrent_ns);
+
+        dyn_array_destroy(locked.array);
+        pthread_mutex_destroy(&locked.lock);
+        dyn_array_concurrent_destroy(concurrent);
+    }
+    return EXIT_SUCCESS;
+}
@@ -1,14 +1,16 @@
 #include "dyn_array.h"
+#include "instrument.h"
 
 // Flag values
-// SHRUNK to indicate shrink_to_fit was called and size needs to be corrected
-// SORTED to track if the objects have been sorted by us (sorted is set by sort and unset by insert/push)
-// these are just ideas
-// typedef enum {NONE = 0x00, SHRUNK = 0x01, SORTED = 0x02, ALL = 0xFF} DYN_FLAGS;
+// INLINE_STORAGE: array is not its own allocation (the tail of the header's allocation or a caller's buffer),
+//   so growth copies out to the heap instead of realloc'ing, and destroy doesn't free it
+// EMBEDDED_HEADER: the header lives in caller storage (dyn_array_init), so destroy doesn't free it
+// SHRUNK/SORTED were ideas for tracking shrink_to_fit and sort state, shrink_to_fit no longer needs one
+typedef enum { DYN_NONE = 0x00, DYN_INLINE_STORAGE = 0x01, DYN_EMBEDDED_HEADER = 0x02 } DYN_FLAGS;
 
 struct dyn_array 
 {
-    // DYN_FLAGS flags;
+    DYN_FLAGS flags;
     size_t capacity;
     size_t size;
     size_t data_size;
@@ -16,6 +18,13 @@ struct dyn_array
     void (*destructor)(void *);
 };
 
+_Static_assert(sizeof(dyn_array_t) <= sizeof(dyn_array_storage_t), "dyn_array_storage_t is too small");
+
+// Arrays created with at most this many bytes of storage get it in the same allocation as the header
+#ifndef DYN_INLINE_BYTES
+#define DYN_INLINE_BYTES 512
+#endif
+
 // Supports 64bit+ size_t!
 // Semi-arbitrary cap on contents. We'll run out of memory before this happens anyway.
 // Allowing it to be externally set
@@ -43,6 +52,8 @@ bool dyn_shift_insert(dyn_array_t *const dyn_array, const size_t position, const
 bool dyn_shift_remove(dyn_array_t *const dyn_array, const size_t position, const size_t count,
                       const DYN_SHIFT_MODE mode, void *const data_dst);
 
+// Checks to see if the object can handle an increase in size (and optionally increases capacity)
+bool dyn_request_size_increase(dyn_array_t *const dyn_array, const size_t increment);
 
 
 
@@ -50,34 +61,29 @@ dyn_array_t *dyn_array_create(const size_t capacity, const size_t data_type_size
 {
     if (data_type_size && capacity <= DYN_MAX_CAPACITY) 
     {
-        dyn_array_t *dyn_array = (dyn_array_t *) malloc(sizeof(dyn_array_t));
-        if (dyn_array) 
+        // would have inf loop if requested size was between DYN_MAX_CAPACITY
+        // and SIZE_MAX
+        size_t actual_capacity = 16;
+        while (capacity > actual_capacity) 
         {
-            // would have inf loop if requested size was between DYN_MAX_CAPACITY
-            // and SIZE_MAX
-            size_t actual_capacity = 16;
-            while (capacity > actual_capacity) 
-            {
-                actual_capacity <<= 1;
-            }
+            actual_capacity <<= 1;
+        }
 
+        // small arrays are a single allocation, the objects right after the header
+        const size_t bytes = data_type_size * actual_capacity;
+        const bool inline_storage = bytes <= DYN_INLINE_BYTES;
+        dyn_array_t *dyn_array = (dyn_array_t *) malloc(sizeof(dyn_array_t) + (inline_storage ? bytes : 0));
+        if (dyn_array) 
+        {
+            dyn_array->flags = inline_storage ? DYN_INLINE_STORAGE : DYN_NONE;
             dyn_array->capacity = actual_capacity;
             dyn_array->size = 0;
             dyn_array->data_size = data_type_size;
             dyn_array->destructor = destruct_func;
-
-            dyn_array->array = malloc(data_type_size * actual_capacity);
-
-            // I had an idea... and it compiles
-            // const members of a malloc'd struct are so annoying
-            memcpy(dyn_array, &((dyn_array_t){actual_capacity, 0, data_type_size,
-                                              malloc(data_type_size * actual_capacity), destruct_func}),
-                   sizeof(dyn_array_t));
+            dyn_array->array = inline_storage ? (void *) (dyn_array + 1) : malloc(bytes);
 
             if (dyn_array->array) 
             {
-                // other malloc worked, yay!
-                // we're done?
                 return dyn_array;
             }
             free(dyn_array);
@@ -86,6 +92,28 @@ dyn_array_t *dyn_array_create(const size_t capacity, const size_t data_type_size
     return NULL;
 }
 
+dyn_array_t *dyn_array_init(dyn_array_storage_t *const storage, void *const buffer, const size_t capacity,
+                            const size_t data_type_size, void (*destruct_func)(void *))
+{
+    if (storage && data_type_size && (buffer || !capacity) && capacity <= DYN_MAX_CAPACITY)
+    {
+        dyn_array_t *dyn_array = (dyn_array_t *) storage;
+        dyn_array->flags = DYN_EMBEDDED_HEADER | DYN_INLINE_STORAGE;
+        dyn_array->capacity = capacity;
+        dyn_array->size = 0;
+        dyn_array->data_size = data_type_size;
+        dyn_array->destructor = destruct_func;
+        dyn_array->array = buffer;
+        return dyn_array;
+    }
+    return NULL;
+}
+
+void dyn_array_deinit(dyn_array_t *const dyn_array)
+{
+    dyn_array_destroy(dyn_array);
+}
+
 // Creates a dynamic array from a standard array
 dyn_array_t *dyn_array_import(const void *const data, const size_t count, const size_t data_type_size,
                               void (*destruct_func)(void *)) 
@@ -120,8 +148,12 @@ void dyn_array_destroy(dyn_array_t *dyn_array)
 {
     if (dyn_array) {
         dyn_array_clear(dyn_array);
-        free(dyn_array->array);
-        free(dyn_array);
+        if (!(dyn_array->flags & DYN_INLINE_STORAGE)) {
+            free(dyn_array->array);
+        }
+        if (!(dyn_array->flags & DYN_EMBEDDED_HEADER)) {
+            free(dyn_array);
+        }
     }
 }
 
@@ -311,18 +343,102 @@ bool dyn_array_for_each(dyn_array_t *const dyn_array, void (*const func)(void *c
 }
 
 
-/*
-    // No return value. It either goes or it doesn't. shrink_to_fit is more of a request
-    void dyn_array_shrink_to_fit(dyn_array_t *const dyn_array) {
-    if (dyn_array) {
-        void *new_address = realloc(dyn_array->data, DYN_ARRAY_SIZE_N_ELEMS(dyn_array, dyn_array->size));
-        if (new_address) {
-            dyn_array->data = new_address;
-            SET_FLAG(dyn_array,SHRUNK);
+bool dyn_array_append_n(dyn_array_t *const dyn_array, const void *const objects, const size_t count)
+{
+    return dyn_array && dyn_array_insert_n(dyn_array, dyn_array->size, objects, count);
+}
+
+bool dyn_array_insert_n(dyn_array_t *const dyn_array, const size_t index, const void *const objects,
+                        const size_t count)
+{
+    // nothing to copy, so objects may be NULL (e.g. the export of an empty array)
+    if (dyn_array && !count)
+    {
+        return index <= dyn_array->size;
+    }
+    return objects && dyn_shift_insert(dyn_array, index, count, MODE_INSERT, objects);
+}
+
+bool dyn_array_erase_range(dyn_array_t *const dyn_array, const size_t index, const size_t count)
+{
+    // dyn_shift_remove checks the range, but index + count could wrap around first
+    if (!dyn_array || index > dyn_array->size || count > dyn_array->size - index)
+    {
+        return false;
+    }
+    return !count || dyn_shift_remove(dyn_array, index, count, MODE_ERASE, NULL);
+}
+
+bool dyn_array_extract_range(dyn_array_t *const dyn_array, const size_t index, const size_t count,
+                             void *const objects)
+{
+    // dyn_shift_remove checks the range, but index + count could wrap around first
+    return dyn_array && objects && index <= dyn_array->size && count <= dyn_array->size - index
+           && dyn_shift_remove(dyn_array, index, count, MODE_EXTRACT, objects);
+}
+
+bool dyn_array_reserve(dyn_array_t *const dyn_array, const size_t capacity)
+{
+    if (dyn_array)
+    {
+        return capacity <= dyn_array->capacity || dyn_request_size_increase(dyn_array, capacity - dyn_array->size);
+    }
+    return false;
+}
+
+// Capacity is left as is when it is already tight; the next growth doubles from whatever it is
+bool dyn_array_shrink_to_fit(dyn_array_t *const dyn_array)
+{
+    if (dyn_array)
+    {
+        const size_t capacity = dyn_array->size ? dyn_array->size : 1;
+        // inline storage can't be given back on its own
+        if (capacity >= dyn_array->capacity || (dyn_array->flags & DYN_INLINE_STORAGE))
+        {
+            return true;
         }
+        void *new_array = realloc(dyn_array->array, DYN_SIZE_N_ELEMS(dyn_array, capacity));
+        INSTRUMENT_ADD(reallocs, 1);
+        if (new_array)
+        {
+            dyn_array->array = new_array;
+            dyn_array->capacity = capacity;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool dyn_array_resize(dyn_array_t *const dyn_array, const size_t size, const void *const fill)
+{
+    if (!dyn_array)
+    {
+        return false;
     }
+    if (size <= dyn_array->size)
+    {
+        return dyn_array_erase_range(dyn_array, size, dyn_array->size - size);
     }
-*/
+    if (!dyn_array_reserve(dyn_array, size))
+    {
+        return false;
+    }
+
+    uint8_t *arr_pos = DYN_ARRAY_POSITION(dyn_array, dyn_array->size);
+    if (fill)
+    {
+        for (size_t total = size - dyn_array->size; total; --total, arr_pos += dyn_array->data_size)
+        {
+            memcpy(arr_pos, fill, dyn_array->data_size);
+        }
+    }
+    else
+    {
+        memset(arr_pos, 0, DYN_SIZE_N_ELEMS(dyn_array, size - dyn_array->size));
+    }
+    dyn_array->size = size;
+    return true;
+}
 
 
 
@@ -334,9 +450,6 @@ bool dyn_array_for_each(dyn_array_t *const dyn_array, void (*const func)(void *c
 //
 
 
-// Checks to see if the object can handle an increase in size (and optionally increases capacity)
-bool dyn_request_size_increase(dyn_array_t *const dyn_array, const size_t increment);
-
 #define MODE_IS_TYPE(mode, type) ((mode) & (type))
 
 // inserting between idx 1 and 2 (between B and C) means you're moving everything from 2 down to make room
@@ -358,6 +471,7 @@ bool dyn_shift_insert(dyn_array_t *const dyn_array, const size_t position, const
             {  
                 memmove(DYN_ARRAY_POSITION(dyn_array, position + count), DYN_ARRAY_POSITION(dyn_array, position),
                         DYN_SIZE_N_ELEMS(dyn_array, dyn_array->size - position));
+                INSTRUMENT_ADD(memmove_bytes, DYN_SIZE_N_ELEMS(dyn_array, dyn_array->size - position));
             }
             memcpy(DYN_ARRAY_POSITION(dyn_array, position), data_src, dyn_array->data_size * count);
             dyn_array->size += count;
@@ -411,6 +525,7 @@ bool dyn_shift_remove(dyn_array_t *const dyn_array, const size_t position, const
             // there's a actual gap, not just a hole to make at the end
             memmove(DYN_ARRAY_POSITION(dyn_array, position), DYN_ARRAY_POSITION(dyn_array, position + count),
                     DYN_SIZE_N_ELEMS(dyn_array, dyn_array->size - (position + count)));
+            INSTRUMENT_ADD(memmove_bytes, DYN_SIZE_N_ELEMS(dyn_array, dyn_array->size - (position + count)));
         }
         // decrease the size and return
         dyn_array->size -= count;
@@ -436,11 +551,11 @@ bool dyn_request_size_increase(dyn_array_t *const dyn_array, const size_t increm
         // have to reallocate, is that even possible?
         size_t needed_size = dyn_array->size + increment;
 
-        // INSERT SHRINK_TO_FIT CORRECTION HERE
-
-        if (needed_size <= DYN_MAX_CAPACITY) 
+        // increment > DYN_MAX_CAPACITY would wrap needed_size around
+        if (increment <= DYN_MAX_CAPACITY && needed_size <= DYN_MAX_CAPACITY) 
         {
-            size_t new_capacity = dyn_array->capacity << 1;
+            // an init'ed array may start with no buffer at all
+            size_t new_capacity = dyn_array->capacity ? dyn_array->capacity << 1 : 16;
             while (new_capacity < needed_size) 
             {
                 new_capacity <<= 1;
@@ -449,12 +564,27 @@ bool dyn_request_size_increase(dyn_array_t *const dyn_array, const size_t increm
             // we can theoretically hold this, check if we can allocate that
             // if (!MULTIPLY_MAY_OVERFLOW(new_capacity, dyn_array->data_size)) {
             // we won't overflow, so we can at least REQUEST this change
-            void *new_array = realloc(dyn_array->array, new_capacity * dyn_array->data_size);
+            // inline storage isn't ours to realloc, so it moves out to the heap instead
+            void *new_array;
+            if (dyn_array->flags & DYN_INLINE_STORAGE) 
+            {
+                new_array = malloc(new_capacity * dyn_array->data_size);
+                if (new_array && dyn_array->size) 
+                {
+                    memcpy(new_array, dyn_array->array, DYN_SIZE_N_ELEMS(dyn_array, dyn_array->size));
+                }
+            } 
+            else 
+            {
+                new_array = realloc(dyn_array->array, new_capacity * dyn_array->data_size);
+            }
+            INSTRUMENT_ADD(reallocs, 1);
             if (new_array) 
             {
                 // success! Wasn't that easy?
                 dyn_array->array    = new_array;
                 dyn_array->capacity = new_capacity;
+                dyn_array->flags   &= ~DYN_INLINE_STORAGE;
                 return true;
             }
         }
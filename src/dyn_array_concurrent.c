@@ -0,0 +1,199 @@
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "dyn_array_concurrent.h"
+
+// Segment k holds DYN_SEGMENT_FIRST << k objects, so segment k starts at index
+// DYN_SEGMENT_FIRST * (2^k - 1). 40 segments of 64 and up is ~7e13 objects
+#define DYN_SEGMENT_FIRST_SHIFT 6
+#define DYN_SEGMENT_FIRST (((size_t) 1) << DYN_SEGMENT_FIRST_SHIFT)
+#define DYN_SEGMENT_COUNT 40
+
+// A segment is the objects followed by one published flag per object
+typedef struct
+{
+    uint8_t *objects;
+    atomic_uchar *published;
+}
+DynSegment_t;
+
+struct dyn_array_concurrent
+{
+    size_t data_size;
+    atomic_size_t reserved;                         // indices handed out
+    _Atomic(uint8_t *) segments[DYN_SEGMENT_COUNT];  // installed once, never moved
+};
+
+static unsigned highest_bit(size_t value)
+{
+#if defined(__GNUC__)
+    return (unsigned) (sizeof(unsigned long long) * 8 - 1 - __builtin_clzll((unsigned long long) value));
+#else
+    unsigned bit = 0;
+    while (value >>= 1)
+    {
+        ++bit;
+    }
+    return bit;
+#endif
+}
+
+// Finds the segment and the offset within it that hold index
+static unsigned dyn_segment_of(const size_t index, size_t *const offset)
+{
+    const unsigned segment = highest_bit((index >> DYN_SEGMENT_FIRST_SHIFT) + 1);
+    *offset = index - DYN_SEGMENT_FIRST * ((((size_t) 1) << segment) - 1);
+    return segment;
+}
+
+static size_t dyn_segment_length(const unsigned segment)
+{
+    return DYN_SEGMENT_FIRST << segment;
+}
+
+static DynSegment_t dyn_segment_view(const dyn_array_concurrent_t *const dyn_array, uint8_t *memory,
+                                     const unsigned segment)
+{
+    DynSegment_t view = {memory, (atomic_uchar *) (memory + dyn_array->data_size * dyn_segment_length(segment))};
+    return view;
+}
+
+// Returns segment's memory, installing it if this thread is the first to need it
+static uint8_t *dyn_segment_acquire(dyn_array_concurrent_t *const dyn_array, const unsigned segment)
+{
+    uint8_t *memory = atomic_load_explicit(&dyn_array->segments[segment], memory_order_acquire);
+    if (memory)
+    {
+        return memory;
+    }
+
+    const size_t length = dyn_segment_length(segment);
+    uint8_t *fresh = malloc(length * (dyn_array->data_size + sizeof(atomic_uchar)));
+    if (!fresh)
+    {
+        return NULL;
+    }
+    atomic_uchar *published = dyn_segment_view(dyn_array, fresh, segment).published;
+    for (size_t i = 0; i < length; ++i)
+    {
+        atomic_init(&published[i], 0);
+    }
+
+    if (atomic_compare_exchange_strong_explicit(&dyn_array->segments[segment], &memory, fresh,
+                                                memory_order_acq_rel, memory_order_acquire))
+    {
+        return fresh;
+    }
+    // someone else installed it first, memory now holds theirs
+    free(fresh);
+    return memory;
+}
+
+dyn_array_concurrent_t *dyn_array_concurrent_create(const size_t data_type_size)
+{
+    if (!data_type_size)
+    {
+        return NULL;
+    }
+    dyn_array_concurrent_t *dyn_array = (dyn_array_concurrent_t *) malloc(sizeof(dyn_array_concurrent_t));
+    if (dyn_array)
+    {
+        dyn_array->data_size = data_type_size;
+        atomic_init(&dyn_array->reserved, 0);
+        for (unsigned segment = 0; segment < DYN_SEGMENT_COUNT; ++segment)
+        {
+            atomic_init(&dyn_array->segments[segment], NULL);
+        }
+    }
+    return dyn_array;
+}
+
+void dyn_array_concurrent_destroy(dyn_array_concurrent_t *const dyn_array)
+{
+    if (dyn_array)
+    {
+        for (unsigned segment = 0; segment < DYN_SEGMENT_COUNT; ++segment)
+        {
+            free(atomic_load_explicit(&dyn_array->segments[segment], memory_order_relaxed));
+        }
+        free(dyn_array);
+    }
+}
+
+bool dyn_array_concurrent_push_back(dyn_array_concurrent_t *const dyn_array, const void *const object,
+                                    size_t *const index)
+{
+    if (!dyn_array || !object)
+    {
+        return false;
+    }
+
+    // A failed push leaves its index as a hole that at() reports as NULL forever
+    const size_t slot = atomic_fetch_add_explicit(&dyn_array->reserved, 1, memory_order_relaxed);
+    size_t offset;
+    const unsigned segment = dyn_segment_of(slot, &offset);
+    if (segment >= DYN_SEGMENT_COUNT)
+    {
+        return false;
+    }
+    uint8_t *memory = dyn_segment_acquire(dyn_array, segment);
+    if (!memory)
+    {
+        return false;
+    }
+
+    DynSegment_t view = dyn_segment_view(dyn_array, memory, segment);
+    memcpy(view.objects + offset * dyn_array->data_size, object, dyn_array->data_size);
+    atomic_store_explicit(&view.published[offset], 1, memory_order_release);
+    if (index)
+    {
+        *index = slot;
+    }
+    return true;
+}
+
+void *dyn_array_concurrent_at(const dyn_array_concurrent_t *const dyn_array, const size_t index)
+{
+    if (!dyn_array || index >= atomic_load_explicit(&dyn_array->reserved, memory_order_relaxed))
+    {
+        return NULL;
+    }
+
+    size_t offset;
+    const unsigned segment = dyn_segment_of(index, &offset);
+    uint8_t *memory = segment < DYN_SEGMENT_COUNT
+                      ? atomic_load_explicit(&((dyn_array_concurrent_t *) dyn_array)->segments[segment],
+                                             memory_order_acquire)
+                      : NULL;
+    if (!memory)
+    {
+        return NULL;
+    }
+
+    DynSegment_t view = dyn_segment_view(dyn_array, memory, segment);
+    if (!atomic_load_explicit(&view.published[offset], memory_order_acquire))
+    {
+        return NULL;
+    }
+    return view.objects + offset * dyn_array->data_size;
+}
+
+size_t dyn_array_concurrent_size(const dyn_array_concurrent_t *const dyn_array)
+{
+    if (dyn_array)
+    {
+        return atomic_load_explicit(&((dyn_array_concurrent_t *) dyn_array)->reserved, memory_order_relaxed);
+    }
+    return 0;
+}
+
+size_t dyn_array_concurrent_data_size(const dyn_array_concurrent_t *const dyn_array)
+{
+    if (dyn_array)
+    {
+        return dyn_array->data_size;
+    }
+    return 0;
+}
@@ -0,0 +1,193 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <unistd.h>
+
+#include "dyn_array_parallel.h"
+
+#define CACHE_LINE 64
+
+// One parallel call. Exactly one of func and fold is set
+typedef struct
+{
+    uint8_t *base;
+    size_t count;
+    size_t data_size;
+    size_t chunk;           // objects per chunk, a multiple of CACHE_LINE bytes
+    size_t chunks;
+    atomic_size_t next;     // next unclaimed chunk
+
+    void (*func)(void *const, void *);
+    void (*fold)(void *const, const void *const, void *);
+    const void *identity;
+    uint8_t *partials;      // one accumulator per chunk, stride bytes apart
+    size_t stride;          // result size rounded up to a cache line so workers never share one
+    void *arg;
+}
+ParallelJob_t;
+
+static size_t gcd(size_t a, size_t b)
+{
+    while (b)
+    {
+        const size_t r = a % b;
+        a = b;
+        b = r;
+    }
+    return a;
+}
+
+// Objects per chunk: about DYN_PARALLEL_CHUNK_BYTES, and a multiple of the smallest
+// count of objects whose size is a multiple of CACHE_LINE. The data need not start on a
+// line, so this bounds the sharing between neighbouring chunks to one line each
+static size_t chunk_objects(const size_t data_size)
+{
+    const size_t line_objects = CACHE_LINE / gcd(CACHE_LINE, data_size);
+    const size_t objects = DYN_PARALLEL_CHUNK_BYTES / data_size;
+    const size_t lines = (objects + line_objects - 1) / line_objects;
+    return (lines ? lines : 1) * line_objects;
+}
+
+static size_t resolve_threads(const size_t threads, const size_t chunks)
+{
+    size_t count = threads;
+    if (!count)
+    {
+        const long online = sysconf(_SC_NPROCESSORS_ONLN);
+        count = online > 0 ? (size_t) online : 1;
+    }
+    return count < chunks ? count : chunks;
+}
+
+static void *parallel_worker(void *arg)
+{
+    ParallelJob_t *job = (ParallelJob_t *) arg;
+    size_t chunk;
+    while ((chunk = atomic_fetch_add_explicit(&job->next, 1, memory_order_relaxed)) < job->chunks)
+    {
+        const size_t first = chunk * job->chunk;
+        const size_t last = first + job->chunk < job->count ? first + job->chunk : job->count;
+        uint8_t *data_walker = job->base + first * job->data_size;
+        if (job->func)
+        {
+            for (size_t idx = first; idx < last; ++idx, data_walker += job->data_size)
+            {
+                job->func((void *const) data_walker, job->arg);
+            }
+        }
+        else
+        {
+            uint8_t *accumulator = job->partials + chunk * job->stride;
+            memcpy(accumulator, job->identity, job->stride);
+            for (size_t idx = first; idx < last; ++idx, data_walker += job->data_size)
+            {
+                job->fold(accumulator, data_walker, job->arg);
+            }
+        }
+    }
+    return NULL;
+}
+
+// Runs parallel_worker on the caller plus up to threads - 1 helpers and waits for all of them
+static void parallel_run(ParallelJob_t *job, const size_t threads)
+{
+    pthread_t *helpers = threads > 1 ? malloc((threads - 1) * sizeof(pthread_t)) : NULL;
+    size_t started = 0;
+    while (helpers && started + 1 < threads && pthread_create(&helpers[started], NULL, parallel_worker, job) == 0)
+    {
+        ++started;
+    }
+    parallel_worker(job);
+    while (started)
+    {
+        pthread_join(helpers[--started], NULL);
+    }
+    free(helpers);
+}
+
+static void parallel_job_init(ParallelJob_t *job, const dyn_array_t *const dyn_array, void *arg)
+{
+    job->base = (uint8_t *) dyn_array_front(dyn_array);
+    job->count = dyn_array_size(dyn_array);
+    job->data_size = dyn_array_data_size(dyn_array);
+    job->chunk = chunk_objects(job->data_size);
+    job->chunks = (job->count + job->chunk - 1) / job->chunk;
+    atomic_init(&job->next, 0);
+    job->func = NULL;
+    job->fold = NULL;
+    job->identity = NULL;
+    job->partials = NULL;
+    job->stride = 0;
+    job->arg = arg;
+}
+
+bool dyn_array_parallel_for_each(dyn_array_t *const dyn_array, void (*const func)(void *const, void *), void *arg,
+                                 const size_t threads)
+{
+    return dyn_array_parallel_for_each_grain(dyn_array, func, arg, threads, 0);
+}
+
+bool dyn_array_parallel_for_each_grain(dyn_array_t *const dyn_array, void (*const func)(void *const, void *),
+                                       void *arg, const size_t threads, const size_t grain)
+{
+    if (!dyn_array || !func)
+    {
+        return false;
+    }
+
+    ParallelJob_t job;
+    parallel_job_init(&job, dyn_array, arg);
+    if (grain)
+    {
+        job.chunk = grain;
+        job.chunks = (job.count + grain - 1) / grain;
+    }
+    job.func = func;
+    if (job.chunks)
+    {
+        parallel_run(&job, resolve_threads(threads, job.chunks));
+    }
+    return true;
+}
+
+bool dyn_array_reduce(const dyn_array_t *const dyn_array, void *const result, const size_t result_size,
+                      void (*const fold)(void *const, const void *const, void *),
+                      void (*const combine)(void *const, const void *const, void *), void *arg,
+                      const size_t threads)
+{
+    if (!dyn_array || !result || !result_size || !fold || !combine)
+    {
+        return false;
+    }
+
+    ParallelJob_t job;
+    parallel_job_init(&job, dyn_array, arg);
+    if (!job.chunks)
+    {
+        return true;
+    }
+    job.fold = fold;
+    job.stride = (result_size + CACHE_LINE - 1) / CACHE_LINE * CACHE_LINE;
+
+    // the identity is copied stride bytes at a time, so pad it the same way
+    uint8_t *buffer = aligned_alloc(CACHE_LINE, (job.chunks + 1) * job.stride);
+    if (!buffer)
+    {
+        return false;
+    }
+    memset(buffer, 0, job.stride);
+    memcpy(buffer, result, result_size);
+    job.identity = buffer;
+    job.partials = buffer + job.stride;
+
+    parallel_run(&job, resolve_threads(threads, job.chunks));
+
+    for (size_t chunk = 0; chunk < job.chunks; ++chunk)
+    {
+        combine(result, job.partials + chunk * job.stride, arg);
+    }
+    free(buffer);
+    return true;
+}
@@ -0,0 +1,265 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "group_tree.h"
+
+// Longest line the tree and map files may hold
+#define GROUP_LINE_MAX 4096
+
+// Where a node's last path component sits in the tree's text
+typedef struct
+{
+    size_t offset;
+    size_t length;
+}
+GroupName_t;
+
+struct group_tree
+{
+    dyn_array_t *nodes;         // GroupNode_t by id
+    dyn_array_t *names;         // GroupName_t by id
+    dyn_array_t *text;          // the names' characters, back to back
+    dyn_array_t *table;         // uint32_t ids hashed on (parent, name), UINT32_MAX for empty
+};
+
+static uint64_t name_hash(uint32_t parent, const char *name, size_t length)
+{
+    uint64_t hash = 14695981039346656037ull ^ parent;
+    for (size_t i = 0; i < length; ++i)
+    {
+        hash = (hash ^ (unsigned char) name[i]) * 1099511628211ull;
+    }
+    return hash ^ (hash >> 29);
+}
+
+// Looks up the child of parent called name
+// \return its id, UINT32_MAX if there is none; slot receives where it is or would go
+static uint32_t table_lookup(const GroupTree_t *tree, uint32_t parent, const char *name, size_t length, size_t *slot)
+{
+    const uint32_t *table = dyn_array_export(tree->table);
+    const size_t mask = dyn_array_size(tree->table) - 1;
+    for (size_t i = name_hash(parent, name, length) & mask;; i = (i + 1) & mask)
+    {
+        const uint32_t id = table[i];
+        if (id == UINT32_MAX)
+        {
+            *slot = i;
+            return UINT32_MAX;
+        }
+        const GroupNode_t *node = dyn_array_at(tree->nodes, id);
+        const GroupName_t *stored = dyn_array_at(tree->names, id);
+        if (node->parent == parent && stored->length == length
+            && memcmp(dyn_array_at(tree->text, stored->offset), name, length) == 0)
+        {
+            *slot = i;
+            return id;
+        }
+    }
+}
+
+// Doubles the hash table and reinserts every node but the root
+static bool table_grow(GroupTree_t *tree)
+{
+    const size_t size = dyn_array_size(tree->table) * 2;
+    const uint32_t empty = UINT32_MAX;
+    dyn_array_clear(tree->table);
+    if (!dyn_array_resize(tree->table, size, &empty))
+    {
+        return false;
+    }
+    for (uint32_t id = 1; id < dyn_array_size(tree->nodes); ++id)
+    {
+        const GroupNode_t *node = dyn_array_at(tree->nodes, id);
+        const GroupName_t *name = dyn_array_at(tree->names, id);
+        size_t slot;
+        table_lookup(tree, node->parent, dyn_array_at(tree->text, name->offset), name->length, &slot);
+        *(uint32_t *) dyn_array_at(tree->table, slot) = id;
+    }
+    return true;
+}
+
+// Adds a child called name under parent with the defaults
+// \return its id, UINT32_MAX on error
+static uint32_t node_add(GroupTree_t *tree, uint32_t parent, const char *name, size_t length, size_t slot)
+{
+    const uint32_t id = (uint32_t) dyn_array_size(tree->nodes);
+    const GroupNode_t *above = dyn_array_at(tree->nodes, parent);
+    GroupNode_t node = {parent, 1, above->depth + 1, GROUP_FAIR};
+    GroupName_t stored = {dyn_array_size(tree->text), length};
+    if (id == UINT32_MAX || !dyn_array_append_n(tree->text, name, length) || !dyn_array_push_back(tree->nodes, &node)
+        || !dyn_array_push_back(tree->names, &stored))
+    {
+        return UINT32_MAX;
+    }
+    *(uint32_t *) dyn_array_at(tree->table, slot) = id;
+    // keep the table at most half full
+    if (2 * dyn_array_size(tree->nodes) > dyn_array_size(tree->table) && !table_grow(tree))
+    {
+        return UINT32_MAX;
+    }
+    return id;
+}
+
+// Follows path from the root, adding missing nodes when create is set
+static bool path_walk(GroupTree_t *tree, const char *path, bool create, uint32_t *id)
+{
+    uint32_t node = 0;
+    while (*path)
+    {
+        const char *end = strchr(path, '/');
+        const size_t length = end ? (size_t) (end - path) : strlen(path);
+        if (length)
+        {
+            size_t slot;
+            uint32_t child = table_lookup(tree, node, path, length, &slot);
+            if (child == UINT32_MAX && (!create || (child = node_add(tree, node, path, length, slot)) == UINT32_MAX))
+            {
+                return false;
+            }
+            node = child;
+        }
+        path += length + (end != NULL);
+    }
+    *id = node;
+    return true;
+}
+
+GroupTree_t *group_tree_create(GroupPolicy_t root_policy)
+{
+    GroupTree_t *tree = calloc(1, sizeof(GroupTree_t));
+    if (!tree)
+    {
+        return NULL;
+    }
+    tree->nodes = dyn_array_create(0, sizeof(GroupNode_t), NULL);
+    tree->names = dyn_array_create(0, sizeof(GroupName_t), NULL);
+    tree->text = dyn_array_create(0, sizeof(char), NULL);
+    tree->table = dyn_array_create(0, sizeof(uint32_t), NULL);
+    const GroupNode_t root = {UINT32_MAX, 1, 0, root_policy};
+    const GroupName_t name = {0, 0};
+    const uint32_t empty = UINT32_MAX;
+    if (!tree->nodes || !tree->names || !tree->text || !tree->table || !dyn_array_push_back(tree->nodes, &root)
+        || !dyn_array_push_back(tree->names, &name) || !dyn_array_resize(tree->table, 16, &empty))
+    {
+        group_tree_destroy(tree);
+        return NULL;
+    }
+    return tree;
+}
+
+void group_tree_destroy(GroupTree_t *tree)
+{
+    if (tree)
+    {
+        dyn_array_destroy(tree->nodes);
+        dyn_array_destroy(tree->names);
+        dyn_array_destroy(tree->text);
+        dyn_array_destroy(tree->table);
+        free(tree);
+    }
+}
+
+bool group_tree_add(GroupTree_t *tree, const char *path, uint32_t weight, GroupPolicy_t policy, uint32_t *id)
+{
+    uint32_t node;
+    if (!tree || !path || (policy != GROUP_FAIR && policy != GROUP_RR) || !path_walk(tree, path, true, &node))
+    {
+        return false;
+    }
+    GroupNode_t *stored = dyn_array_at(tree->nodes, node);
+    stored->weight = weight;
+    stored->policy = policy;
+    if (id)
+    {
+        *id = node;
+    }
+    return true;
+}
+
+bool group_tree_find(const GroupTree_t *tree, const char *path, uint32_t *id)
+{
+    // a lookup never adds, so the cast only lets it share the walk
+    return tree && path && id && path_walk((GroupTree_t *) tree, path, false, id);
+}
+
+bool group_tree_intern(GroupTree_t *tree, const char *path, uint32_t *id)
+{
+    return tree && path && id && path_walk(tree, path, true, id);
+}
+
+size_t group_tree_size(const GroupTree_t *tree)
+{
+    return tree ? dyn_array_size(tree->nodes) : 0;
+}
+
+const GroupNode_t *group_tree_node(const GroupTree_t *tree, uint32_t id)
+{
+    if (!tree || id >= dyn_array_size(tree->nodes))
+    {
+        return NULL;
+    }
+    return dyn_array_at(tree->nodes, id);
+}
+
+// Cuts a line at its comment and trailing newline
+static void line_trim(char *line)
+{
+    line[strcspn(line, "#\r\n")] = '\0';
+}
+
+GroupTree_t *group_tree_load(const char *path)
+{
+    FILE *file = path ? fopen(path, "r") : NULL;
+    if (!file)
+    {
+        return NULL;
+    }
+    GroupTree_t *tree = group_tree_create(GROUP_FAIR);
+    char line[GROUP_LINE_MAX];
+    char name[GROUP_LINE_MAX];
+    char policy[8];
+    while (tree && fgets(line, sizeof(line), file))
+    {
+        line_trim(line);
+        unsigned weight;
+        policy[0] = '\0';
+        const int fields = sscanf(line, "%4095s %u %7s", name, &weight, policy);
+        if (fields <= 0)
+        {
+            continue;
+        }
+        const bool rr = strcmp(policy, "rr") == 0;
+        if (fields < 2 || (fields == 3 && !rr && strcmp(policy, "fair") != 0)
+            || !group_tree_add(tree, name, weight, rr ? GROUP_RR : GROUP_FAIR, NULL))
+        {
+            group_tree_destroy(tree);
+            tree = NULL;
+        }
+    }
+    fclose(file);
+    return tree;
+}
+
+dyn_array_t *group_tree_load_map(GroupTree_t *tree, const char *path)
+{
+    FILE *file = tree && path ? fopen(path, "r") : NULL;
+    if (!file)
+    {
+        return NULL;
+    }
+    dyn_array_t *map = dyn_array_create(0, sizeof(uint32_t), NULL);
+    char line[GROUP_LINE_MAX];
+    while (map && fgets(line, sizeof(line), file))
+    {
+        line_trim(line);
+        uint32_t id;
+        if (!group_tree_intern(tree, line, &id) || !dyn_array_push_back(map, &id))
+        {
+            dyn_array_destroy(map);
+            map = NULL;
+        }
+    }
+    fclose(file);
+    return map;
+}
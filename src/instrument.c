@@ -0,0 +1,95 @@
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "instrument.h"
+
+#ifdef INSTRUMENT
+_Thread_local InstrumentCounters_t instrument_counters;
+#endif
+
+// The open trace (if any) and whether an event has been written yet (for the commas),
+// shared by every thread and only touched under trace_lock
+static pthread_mutex_t trace_lock = PTHREAD_MUTEX_INITIALIZER;
+static FILE *trace_file = NULL;
+static bool trace_has_events = false;
+
+static void trace_close_locked(void)
+{
+    if (trace_file)
+    {
+        fputs("\n]}\n", trace_file);
+        fclose(trace_file);
+        trace_file = NULL;
+    }
+}
+
+bool instrument_enabled(void)
+{
+#ifdef INSTRUMENT
+    return true;
+#else
+    return false;
+#endif
+}
+
+void instrument_reset(void)
+{
+#ifdef INSTRUMENT
+    memset(&instrument_counters, 0, sizeof(instrument_counters));
+#endif
+}
+
+void instrument_snapshot(InstrumentCounters_t *counters)
+{
+    if (!counters)
+    {
+        return;
+    }
+#ifdef INSTRUMENT
+    *counters = instrument_counters;
+#else
+    memset(counters, 0, sizeof(*counters));
+#endif
+}
+
+bool instrument_trace_open(const char *path)
+{
+    pthread_mutex_lock(&trace_lock);
+    trace_close_locked();
+    trace_file = path ? fopen(path, "w") : NULL;
+    if (trace_file)
+    {
+        trace_has_events = false;
+        fputs("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n", trace_file);
+    }
+    const bool opened = trace_file != NULL;
+    pthread_mutex_unlock(&trace_lock);
+    return opened;
+}
+
+void instrument_trace_slice(uint32_t pid, uint64_t start, uint64_t length)
+{
+    if (!length)
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&trace_lock);
+    if (trace_file)
+    {
+        // Every PCB gets its own track (tid) so the viewer draws one row per PCB
+        fprintf(trace_file, "%s{\"name\":\"pcb %u\",\"ph\":\"X\",\"pid\":0,\"tid\":%u,\"ts\":%llu,\"dur\":%llu}",
+                trace_has_events ? ",\n" : "", (unsigned) pid, (unsigned) pid, (unsigned long long) start,
+                (unsigned long long) length);
+        trace_has_events = true;
+    }
+    pthread_mutex_unlock(&trace_lock);
+}
+
+void instrument_trace_close(void)
+{
+    pthread_mutex_lock(&trace_lock);
+    trace_close_locked();
+    pthread_mutex_unlock(&trace_lock);
+}
@@ -0,0 +1,115 @@
+#include <stdatomic.h>
+#include <stdlib.h>
+
+#include "mpsc_queue.h"
+
+// Vyukov's intrusive MPSC queue with a stub node.
+// Producers swing head with an exchange and then link the previous node to theirs,
+// the consumer walks from tail following the next links.
+
+typedef struct mpsc_node
+{
+    _Atomic(struct mpsc_node *) next;
+    void *item;
+}
+MpscNode_t;
+
+struct mpsc_queue
+{
+    _Atomic(MpscNode_t *) head;     // last pushed node, producers only
+    MpscNode_t *tail;               // next node to pop, consumer only
+    MpscNode_t stub;                // parked in the queue whenever it would otherwise run dry
+};
+
+static void mpsc_link(MpscQueue_t *queue, MpscNode_t *node)
+{
+    atomic_store_explicit(&node->next, NULL, memory_order_relaxed);
+    MpscNode_t *previous = atomic_exchange_explicit(&queue->head, node, memory_order_acq_rel);
+    // between the exchange and this store the queue looks cut short to the consumer
+    atomic_store_explicit(&previous->next, node, memory_order_release);
+}
+
+MpscQueue_t *mpsc_queue_create(void)
+{
+    MpscQueue_t *queue = (MpscQueue_t *) malloc(sizeof(MpscQueue_t));
+    if (queue)
+    {
+        atomic_init(&queue->stub.next, NULL);
+        queue->stub.item = NULL;
+        atomic_init(&queue->head, &queue->stub);
+        queue->tail = &queue->stub;
+    }
+    return queue;
+}
+
+void mpsc_queue_destroy(MpscQueue_t *queue)
+{
+    if (queue)
+    {
+        while (mpsc_queue_pop(queue))
+        {
+        }
+        free(queue);
+    }
+}
+
+bool mpsc_queue_push(MpscQueue_t *queue, void *item)
+{
+    if (!queue || !item)
+    {
+        return false;
+    }
+
+    MpscNode_t *node = (MpscNode_t *) malloc(sizeof(MpscNode_t));
+    if (!node)
+    {
+        return false;
+    }
+    node->item = item;
+    mpsc_link(queue, node);
+    return true;
+}
+
+void *mpsc_queue_pop(MpscQueue_t *queue)
+{
+    if (!queue)
+    {
+        return NULL;
+    }
+
+    MpscNode_t *tail = queue->tail;
+    MpscNode_t *next = atomic_load_explicit(&tail->next, memory_order_acquire);
+
+    // skip over the stub
+    if (tail == &queue->stub)
+    {
+        if (!next)
+        {
+            return NULL;
+        }
+        queue->tail = next;
+        tail = next;
+        next = atomic_load_explicit(&tail->next, memory_order_acquire);
+    }
+
+    if (!next)
+    {
+        // tail may be the last node. If a producer is already past its exchange we have
+        // to wait for its link, otherwise park the stub behind tail so it can be taken
+        if (tail != atomic_load_explicit(&queue->head, memory_order_acquire))
+        {
+            return NULL;
+        }
+        mpsc_link(queue, &queue->stub);
+        next = atomic_load_explicit(&tail->next, memory_order_acquire);
+        if (!next)
+        {
+            return NULL;
+        }
+    }
+
+    queue->tail = next;
+    void *item = tail->item;
+    free(tail);
+    return item;
+}
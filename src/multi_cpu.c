@@ -0,0 +1,689 @@
+#include <limits.h>
+#include <string.h>
+
+#include "dyn_array.h"
+#include "instrument.h"
+#include "multi_cpu.h"
+
+// pid or CPU of "none"
+#define MULTI_NONE UINT32_MAX
+
+// Queue entries a thief looks through for the PCB it takes, from the back of the heap, so
+// stealing stays cheap however long the victim's queue grows
+#define MULTI_STEAL_SCAN 64
+
+// A PCB as the multi-CPU engine sees it; pid is its index in the caller's ready queue
+typedef struct
+{
+    ProcessControlBlock_t *pcb;
+    uint32_t pid;
+    uint32_t burst;
+    uint32_t tenant;
+    uint32_t last_cpu;              // where it last ran, MULTI_NONE before its first slice
+    unsigned long last_ran;         // when its latest slice ended
+    uint64_t ran;                   // ticks it spent on a CPU, stretch included
+}
+MultiJob_t;
+
+// A queued PCB, ordered by (key, sequence)
+typedef struct
+{
+    uint64_t key;
+    uint64_t sequence;
+    uint32_t job;                   // index in the jobs array
+}
+MultiEntry_t;
+
+// A slice ending, ordered by (time, cpu)
+typedef struct
+{
+    unsigned long time;
+    uint32_t cpu;
+}
+MultiEvent_t;
+
+typedef struct
+{
+    dyn_array_t *queue;             // MultiEntry_t min-heap
+    uint32_t running;               // job on the CPU, MULTI_NONE while idle
+    uint32_t last_pid;              // pid of the latest dispatch, for switch costs
+    uint32_t load;                  // queued jobs plus the running one
+    uint32_t speed;                 // burst retired per 1000 ticks
+    uint64_t work;                  // burst left in the queue, not counting the running slice
+    unsigned long busy_until;       // when the running slice ends
+}
+MultiCpu_t;
+
+typedef struct
+{
+    const ScheduleConfig_t *config;
+    const Topology_t *topology;
+    const TopologyCosts_t *costs;
+    dyn_array_t *jobs;              // MultiJob_t in arrival order
+    size_t next;                    // first job that has not arrived
+    size_t done;
+    dyn_array_t *cpus;              // MultiCpu_t by CPU id
+    dyn_array_t *events;            // MultiEvent_t min-heap of the running slices
+    dyn_array_t *core_busy;         // uint32_t running SMT threads per core
+    dyn_array_t *core_load;         // uint32_t load summed over each core's threads
+    dyn_array_t *homes;             // uint32_t socket each tenant was first queued on, MULTI_NONE before
+    uint64_t sequence;
+    unsigned long clock;
+    uint64_t total_waiting_time;
+    uint64_t total_turnaround_time;
+    ScheduleStats_t stats;
+    dyn_array_t *classes;           // ScheduleCoreClass_t per core class, when the config asks for them
+}
+MultiContext_t;
+
+static int cmpfuncMultiArrival(const void *a, const void *b)
+{
+    const MultiJob_t *job_a = (const MultiJob_t *) a;
+    const MultiJob_t *job_b = (const MultiJob_t *) b;
+    if (job_a->pcb->arrival != job_b->pcb->arrival)
+    {
+        return job_a->pcb->arrival < job_b->pcb->arrival ? -1 : 1;
+    }
+    return job_a->pid < job_b->pid ? -1 : (job_a->pid > job_b->pid);
+}
+
+static inline bool entry_before(const MultiEntry_t *a, const MultiEntry_t *b)
+{
+    return a->key < b->key || (a->key == b->key && a->sequence < b->sequence);
+}
+
+static inline bool event_before(const MultiEvent_t *a, const MultiEvent_t *b)
+{
+    return a->time < b->time || (a->time == b->time && a->cpu < b->cpu);
+}
+
+// Defines name(array, item), pushing onto a heap of entries or events (the two element types
+// the engine keeps in heaps); false when the array cannot grow
+#define HEAP_PUSH_DEFINE(name, type, before)                                                        \
+    static bool name(dyn_array_t *array, const type item)                                           \
+    {                                                                                               \
+        if (!dyn_array_push_back(array, &item))                                                     \
+        {                                                                                           \
+            return false;                                                                           \
+        }                                                                                           \
+        type *heap = dyn_array_front(array);                                                        \
+        size_t index = dyn_array_size(array) - 1;                                                   \
+        while (index && before(&item, &heap[(index - 1) / 2]))                                      \
+        {                                                                                           \
+            heap[index] = heap[(index - 1) / 2];                                                    \
+            index = (index - 1) / 2;                                                                \
+        }                                                                                           \
+        heap[index] = item;                                                                         \
+        return true;                                                                                \
+    }
+
+HEAP_PUSH_DEFINE(entry_push, MultiEntry_t, entry_before)
+HEAP_PUSH_DEFINE(event_push, MultiEvent_t, event_before)
+
+// Takes the top off a heap of entries or events into *out
+#define HEAP_POP(array, type, before, out)                                                          \
+    do                                                                                              \
+    {                                                                                               \
+        type *heap_ = dyn_array_front(array);                                                       \
+        *(out) = heap_[0];                                                                          \
+        type moving_;                                                                               \
+        dyn_array_extract_back((array), &moving_);                                                  \
+        const size_t n_ = dyn_array_size(array);                                                    \
+        size_t index_ = 0;                                                                          \
+        for (size_t child_ = 1; n_ && child_ < n_; child_ = 2 * index_ + 1)                         \
+        {                                                                                           \
+            child_ += child_ + 1 < n_ && before(&heap_[child_ + 1], &heap_[child_]);                \
+            if (!before(&heap_[child_], &moving_))                                                  \
+            {                                                                                       \
+                break;                                                                              \
+            }                                                                                       \
+            heap_[index_] = heap_[child_];                                                          \
+            index_ = child_;                                                                        \
+        }                                                                                           \
+        if (n_)                                                                                     \
+        {                                                                                           \
+            heap_[index_] = moving_;                                                                \
+        }                                                                                           \
+    } while (0)
+
+static void multi_destroy(MultiContext_t *ctx)
+{
+    for (size_t c = 0; c < dyn_array_size(ctx->cpus); ++c)
+    {
+        dyn_array_destroy(((MultiCpu_t *) dyn_array_at(ctx->cpus, c))->queue);
+    }
+    dyn_array_destroy(ctx->cpus);
+    dyn_array_destroy(ctx->jobs);
+    dyn_array_destroy(ctx->events);
+    dyn_array_destroy(ctx->core_busy);
+    dyn_array_destroy(ctx->core_load);
+    dyn_array_destroy(ctx->homes);
+}
+
+static bool multi_init(MultiContext_t *ctx, dyn_array_t *ready_queue, const ScheduleConfig_t *config)
+{
+    memset(ctx, 0, sizeof(*ctx));
+    ctx->config = config;
+    ctx->topology = config->topology;
+    ctx->costs = topology_costs(config->topology);
+    const size_t n = dyn_array_size(ready_queue);
+    const size_t cpus = topology_cpus(config->topology);
+    const uint32_t none = MULTI_NONE;
+    const uint32_t zero = 0;
+    ctx->jobs = dyn_array_create(n, sizeof(MultiJob_t), NULL);
+    ctx->cpus = dyn_array_create(cpus, sizeof(MultiCpu_t), NULL);
+    ctx->events = dyn_array_create(cpus, sizeof(MultiEvent_t), NULL);
+    ctx->core_busy = dyn_array_create(cpus, sizeof(uint32_t), NULL);
+    ctx->core_load = dyn_array_create(cpus, sizeof(uint32_t), NULL);
+    ctx->homes = dyn_array_create(0, sizeof(uint32_t), NULL);
+    if (!ctx->jobs || !ctx->cpus || !ctx->events || !ctx->core_busy || !ctx->core_load || !ctx->homes
+        || !dyn_array_resize(ctx->core_busy, cpus, &zero) || !dyn_array_resize(ctx->core_load, cpus, &zero))
+    {
+        multi_destroy(ctx);
+        return false;
+    }
+    ctx->classes = config->core_classes;
+    if (ctx->classes)
+    {
+        ScheduleCoreClass_t empty;
+        memset(&empty, 0, sizeof(empty));
+        dyn_array_clear(ctx->classes);
+        if (!dyn_array_resize(ctx->classes, topology_classes(config->topology), &empty))
+        {
+            multi_destroy(ctx);
+            return false;
+        }
+    }
+    for (size_t c = 0; c < cpus; ++c)
+    {
+        const TopologyCpu_t *where = topology_cpu(config->topology, c);
+        MultiCpu_t cpu = {dyn_array_create(0, sizeof(MultiEntry_t), NULL), MULTI_NONE, MULTI_NONE, 0, where->speed, 0, 0};
+        if (!cpu.queue || !dyn_array_push_back(ctx->cpus, &cpu))
+        {
+            dyn_array_destroy(cpu.queue);
+            multi_destroy(ctx);
+            return false;
+        }
+        if (ctx->classes)
+        {
+            ScheduleCoreClass_t *kind = dyn_array_at(ctx->classes, where->speed_class);
+            kind->speed = where->speed;
+            ++kind->cpus;
+        }
+    }
+    for (size_t i = 0; i < n; ++i)
+    {
+        MultiJob_t job;
+        job.pcb = dyn_array_at(ready_queue, i);
+        job.pid = (uint32_t) i;
+        job.burst = job.pcb->remaining_burst_time;
+        job.tenant = config->tenants ? *(const uint32_t *) dyn_array_at(config->tenants, i) : (uint32_t) i;
+        job.last_cpu = MULTI_NONE;
+        job.last_ran = 0;
+        job.ran = 0;
+        if (!dyn_array_push_back(ctx->jobs, &job)
+            || (job.tenant >= dyn_array_size(ctx->homes) && !dyn_array_resize(ctx->homes, (size_t) job.tenant + 1, &none)))
+        {
+            multi_destroy(ctx);
+            return false;
+        }
+    }
+    dyn_array_sort(ctx->jobs, cmpfuncMultiArrival);
+    timeline_clear(config->timeline);
+    return true;
+}
+
+static inline MultiCpu_t *multi_cpu(const MultiContext_t *ctx, size_t c)
+{
+    return dyn_array_at(ctx->cpus, c);
+}
+
+static inline uint32_t *core_counter(dyn_array_t *counters, const MultiContext_t *ctx, size_t c)
+{
+    return dyn_array_at(counters, topology_cpu(ctx->topology, c)->core);
+}
+
+// Ticks a CPU of the given speed takes to retire work units of burst
+static inline uint64_t multi_ticks(uint64_t work, uint32_t speed)
+{
+    return (work * TOPOLOGY_SPEED_REFERENCE + speed - 1) / speed;
+}
+
+// Changes a CPU's load, keeping its core's total in step
+static void multi_load(MultiContext_t *ctx, size_t c, int delta)
+{
+    multi_cpu(ctx, c)->load += delta;
+    *core_counter(ctx->core_load, ctx, c) += delta;
+}
+
+// Queues a job on a CPU under the policy's key, false when the queue cannot grow
+static bool multi_enqueue(MultiContext_t *ctx, size_t c, uint32_t index)
+{
+    const MultiJob_t *job = dyn_array_at(ctx->jobs, index);
+    const uint64_t sequence = ctx->sequence++;
+    const MultiEntry_t entry = {schedule_policy_key(ctx->config->policy, job->pcb, sequence), sequence, index};
+    if (!entry_push(multi_cpu(ctx, c)->queue, entry))
+    {
+        return false;
+    }
+    multi_cpu(ctx, c)->work += job->pcb->remaining_burst_time;
+    multi_load(ctx, c, 1);
+    INSTRUMENT_ADD(queue_ops, 1);
+    return true;
+}
+
+// Takes entry index out of a queue's heap
+static MultiEntry_t multi_remove(dyn_array_t *queue, size_t index)
+{
+    MultiEntry_t *heap = dyn_array_front(queue);
+    const MultiEntry_t removed = heap[index];
+    MultiEntry_t moving;
+    dyn_array_extract_back(queue, &moving);
+    const size_t n = dyn_array_size(queue);
+    if (index == n)
+    {
+        return removed;
+    }
+    // the last entry fills the hole, moving up or down to where it belongs
+    while (index && entry_before(&moving, &heap[(index - 1) / 2]))
+    {
+        heap[index] = heap[(index - 1) / 2];
+        index = (index - 1) / 2;
+    }
+    for (size_t child = 2 * index + 1; child < n; child = 2 * index + 1)
+    {
+        child += child + 1 < n && entry_before(&heap[child + 1], &heap[child]);
+        if (!entry_before(&heap[child], &moving))
+        {
+            break;
+        }
+        heap[index] = heap[child];
+        index = child;
+    }
+    heap[index] = moving;
+    return removed;
+}
+
+// Whether CPU a is a better spread target than CPU b: less loaded, then on a less loaded core
+static bool spread_before(MultiContext_t *ctx, size_t a, size_t b)
+{
+    const uint32_t load_a = multi_cpu(ctx, a)->load, load_b = multi_cpu(ctx, b)->load;
+    if (load_a != load_b)
+    {
+        return load_a < load_b;
+    }
+    return *core_counter(ctx->core_load, ctx, a) < *core_counter(ctx->core_load, ctx, b);
+}
+
+// Picks the spread target among the CPUs on socket, or all CPUs for MULTI_NONE
+static size_t spread_pick(MultiContext_t *ctx, uint32_t socket)
+{
+    size_t best = SIZE_MAX;
+    for (size_t c = 0; c < dyn_array_size(ctx->cpus); ++c)
+    {
+        if ((socket == MULTI_NONE || topology_cpu(ctx->topology, c)->socket == socket)
+            && (best == SIZE_MAX || spread_before(ctx, c, best)))
+        {
+            best = c;
+        }
+    }
+    return best;
+}
+
+// Ticks until a CPU could get through its running slice and its queue
+static uint64_t multi_drain(const MultiContext_t *ctx, const MultiCpu_t *cpu)
+{
+    const bool running = cpu->running != MULTI_NONE && cpu->busy_until > ctx->clock;
+    return (running ? cpu->busy_until - ctx->clock : 0) + multi_ticks(cpu->work, cpu->speed);
+}
+
+// Picks the CPU that would finish a PCB of burst work first, ties going to the spread target
+static size_t speed_pick(MultiContext_t *ctx, uint32_t work)
+{
+    size_t best = 0;
+    uint64_t best_finish = UINT64_MAX;
+    for (size_t c = 0; c < dyn_array_size(ctx->cpus); ++c)
+    {
+        const MultiCpu_t *cpu = multi_cpu(ctx, c);
+        const uint64_t finish = multi_drain(ctx, cpu) + multi_ticks(work, cpu->speed);
+        if (finish < best_finish || (finish == best_finish && spread_before(ctx, c, best)))
+        {
+            best = c;
+            best_finish = finish;
+        }
+    }
+    return best;
+}
+
+// Chooses the CPU an arriving job is queued on
+static size_t multi_place(MultiContext_t *ctx, const MultiJob_t *job)
+{
+    const size_t cpus = dyn_array_size(ctx->cpus);
+    switch (ctx->config->placement)
+    {
+        case SCHEDULE_PLACE_PACK:
+        {
+            size_t best = 0;
+            for (size_t c = 0; c < cpus; ++c)
+            {
+                if (!multi_cpu(ctx, c)->load)
+                {
+                    return c;
+                }
+                best = multi_cpu(ctx, c)->load < multi_cpu(ctx, best)->load ? c : best;
+            }
+            return best;
+        }
+        case SCHEDULE_PLACE_AFFINITY:
+        {
+            const uint32_t home = *(uint32_t *) dyn_array_at(ctx->homes, job->tenant);
+            const size_t anywhere = spread_pick(ctx, MULTI_NONE);
+            if (home == MULTI_NONE)
+            {
+                return anywhere;
+            }
+            // stay home unless that leaves the job queued behind more than one extra job
+            const size_t local = spread_pick(ctx, home);
+            return multi_cpu(ctx, local)->load <= multi_cpu(ctx, anywhere)->load + 1 ? local : anywhere;
+        }
+        case SCHEDULE_PLACE_SPEED:
+            return speed_pick(ctx, job->pcb->remaining_burst_time);
+        default:
+            return spread_pick(ctx, MULTI_NONE);
+    }
+}
+
+// Lets an idle CPU with an empty queue take the least urgent of the last queued jobs of the
+// nearest CPU with a backlog; false when the thief's queue cannot grow
+static bool multi_steal(MultiContext_t *ctx, size_t thief)
+{
+    const ScheduleBalance_t balance = ctx->config->balance;
+    size_t victim = SIZE_MAX;
+    TopologyDistance_t nearest = TOPOLOGY_DISTANCES;
+    for (size_t c = 0; c < dyn_array_size(ctx->cpus); ++c)
+    {
+        const size_t queued = dyn_array_size(multi_cpu(ctx, c)->queue);
+        const TopologyDistance_t distance = topology_distance(ctx->topology, thief, c);
+        if (!queued || c == thief || (balance == SCHEDULE_BALANCE_SOCKET && distance == TOPOLOGY_REMOTE))
+        {
+            continue;
+        }
+        if (distance < nearest || (distance == nearest && queued > dyn_array_size(multi_cpu(ctx, victim)->queue)))
+        {
+            victim = c;
+            nearest = distance;
+        }
+    }
+    if (victim == SIZE_MAX)
+    {
+        return true;
+    }
+    MultiCpu_t *from = multi_cpu(ctx, victim);
+    MultiCpu_t *to = multi_cpu(ctx, thief);
+    const MultiEntry_t *heap = dyn_array_front(from->queue);
+    // the back of the heap holds its least urgent entries (all leaves once the queue is long),
+    // and the whole queue when it is short
+    const size_t last = dyn_array_size(from->queue) - 1;
+    const size_t first = last >= MULTI_STEAL_SCAN ? last - MULTI_STEAL_SCAN + 1 : 0;
+    size_t index = last;
+    if (to->speed > from->speed)
+    {
+        // a faster thief takes the longest PCB, which gains the most from it
+        uint32_t longest = 0;
+        for (size_t i = first; i <= last; ++i)
+        {
+            const MultiJob_t *job = dyn_array_at(ctx->jobs, heap[i].job);
+            if (job->pcb->remaining_burst_time > longest)
+            {
+                longest = job->pcb->remaining_burst_time;
+                index = i;
+            }
+        }
+    }
+    else
+    {
+        for (size_t i = first; i < last; ++i)
+        {
+            index = entry_before(&heap[index], &heap[i]) ? i : index;
+        }
+    }
+    if (to->speed < from->speed)
+    {
+        // a slower one only helps if it is done before the victim would get to the end of its queue
+        const MultiJob_t *job = dyn_array_at(ctx->jobs, heap[index].job);
+        if (multi_ticks(job->pcb->remaining_burst_time, to->speed) >= multi_drain(ctx, from))
+        {
+            return true;
+        }
+    }
+    const MultiEntry_t entry = multi_remove(from->queue, index);
+    const uint32_t burst = ((MultiJob_t *) dyn_array_at(ctx->jobs, entry.job))->pcb->remaining_burst_time;
+    from->work -= burst;
+    multi_load(ctx, victim, -1);
+    if (!entry_push(to->queue, entry))
+    {
+        return false;
+    }
+    to->work += burst;
+    multi_load(ctx, thief, 1);
+    return true;
+}
+
+// Cache refill owed by a job coming back after off ticks away from the CPU
+static uint32_t multi_refill_cost(const ScheduleCostModel_t *costs, const MultiJob_t *job, unsigned long now)
+{
+    if (job->last_cpu == MULTI_NONE || !costs->refill_halflife)
+    {
+        return costs->refill_max;
+    }
+    const uint64_t off = now - job->last_ran;
+    return (uint32_t) ((uint64_t) costs->refill_max * off / (off + costs->refill_halflife));
+}
+
+// Starts the next queued job on an idle CPU, false when its end cannot be scheduled
+static bool multi_dispatch(MultiContext_t *ctx, size_t c)
+{
+    MultiCpu_t *cpu = multi_cpu(ctx, c);
+    MultiEntry_t entry;
+    HEAP_POP(cpu->queue, MultiEntry_t, entry_before, &entry);
+    MultiJob_t *job = dyn_array_at(ctx->jobs, entry.job);
+    const ScheduleCostModel_t *costs = &ctx->config->costs;
+    const TopologyCpu_t *where = topology_cpu(ctx->topology, c);
+    cpu->work -= job->pcb->remaining_burst_time;
+
+    uint64_t overhead = 0;
+    if (cpu->last_pid != job->pid)
+    {
+        if (cpu->last_pid != MULTI_NONE)
+        {
+            INSTRUMENT_ADD(context_switches, 1);
+            ++ctx->stats.context_switches;
+            overhead += costs->switch_cost;
+            ctx->stats.switch_overhead += costs->switch_cost;
+        }
+        const uint32_t refill = multi_refill_cost(costs, job, ctx->clock);
+        overhead += refill;
+        ctx->stats.refill_overhead += refill;
+    }
+    if (job->last_cpu != MULTI_NONE && job->last_cpu != c)
+    {
+        const uint64_t migration = costs->migration_cost
+                                   + ctx->costs->migrate[topology_distance(ctx->topology, job->last_cpu, c)];
+        ++ctx->stats.migrations;
+        ctx->stats.migration_overhead += migration;
+        overhead += migration;
+    }
+
+    // the policy decides how much work the slice does, speed and locality how long that takes
+    const SchedulePolicy_t policy = ctx->config->policy;
+    uint32_t work = job->pcb->remaining_burst_time;
+    if (policy == SCHEDULE_RR || policy == SCHEDULE_SRTF)
+    {
+        // as much as fits in a quantum at this CPU's speed, at least one unit
+        const uint64_t fits = (uint64_t) ctx->config->quantum * cpu->speed / TOPOLOGY_SPEED_REFERENCE;
+        work = fits < work ? (uint32_t) (fits ? fits : 1) : work;
+    }
+    const uint64_t ticks = multi_ticks(work, cpu->speed);
+    const uint32_t home = *(uint32_t *) dyn_array_at(ctx->homes, job->tenant);
+    uint32_t *core_busy = core_counter(ctx->core_busy, ctx, c);
+    const uint64_t percent = (home != where->socket ? ctx->costs->remote_percent : 0)
+                             + (*core_busy ? ctx->costs->smt_percent : 0);
+    const uint64_t stretch = (ticks * percent + 99) / 100;
+    ctx->stats.locality_overhead += stretch;
+    ++*core_busy;
+
+    const unsigned long start = ctx->clock + overhead;
+    const uint64_t length = ticks + stretch;
+    job->pcb->started = true;
+    job->pcb->remaining_burst_time -= work;
+    INSTRUMENT_SLICE(job->pid, start, length);
+    if (ctx->config->timeline)
+    {
+        timeline_record(ctx->config->timeline, job->pid, start, (uint32_t) (length < UINT32_MAX ? length : UINT32_MAX));
+    }
+    ctx->stats.cpu_busy += length;
+    if (ctx->classes)
+    {
+        ScheduleCoreClass_t *kind = dyn_array_at(ctx->classes, where->speed_class);
+        kind->busy += length;
+        kind->work += work;
+        ++kind->slices;
+    }
+    job->ran += length;
+    job->last_cpu = (uint32_t) c;
+    job->last_ran = start + length;
+    cpu->busy_until = start + length;
+    cpu->running = entry.job;
+    cpu->last_pid = job->pid;
+    const MultiEvent_t event = {start + length, (uint32_t) c};
+    return event_push(ctx->events, event);
+}
+
+// Ends the slice running on a CPU: the job is done or queues again where it ran (false when
+// it cannot)
+static bool multi_slice_done(MultiContext_t *ctx, size_t c)
+{
+    MultiCpu_t *cpu = multi_cpu(ctx, c);
+    const uint32_t index = cpu->running;
+    MultiJob_t *job = dyn_array_at(ctx->jobs, index);
+    cpu->running = MULTI_NONE;
+    --*core_counter(ctx->core_busy, ctx, c);
+    multi_load(ctx, c, -1);
+    if (job->pcb->remaining_burst_time)
+    {
+        return multi_enqueue(ctx, c, index);
+    }
+    const unsigned long turnaround = ctx->clock - job->pcb->arrival;
+    ctx->total_turnaround_time += turnaround;
+    ctx->total_waiting_time += turnaround - job->ran;
+    ++ctx->done;
+    if (ctx->classes)
+    {
+        ScheduleCoreClass_t *kind = dyn_array_at(ctx->classes, topology_cpu(ctx->topology, c)->speed_class);
+        ++kind->finished;
+        kind->turnaround += turnaround;
+    }
+    return true;
+}
+
+// Runs the jobs to completion, false when a queue or the event heap cannot grow
+static bool multi_simulate(MultiContext_t *ctx)
+{
+    const size_t n = dyn_array_size(ctx->jobs);
+    const size_t cpus = dyn_array_size(ctx->cpus);
+    while (ctx->done < n)
+    {
+        unsigned long now = ULONG_MAX;
+        if (ctx->next < n)
+        {
+            now = ((MultiJob_t *) dyn_array_at(ctx->jobs, ctx->next))->pcb->arrival;
+        }
+        if (!dyn_array_empty(ctx->events))
+        {
+            const MultiEvent_t *first = dyn_array_front(ctx->events);
+            now = first->time < now ? first->time : now;
+        }
+        ctx->clock = now > ctx->clock ? now : ctx->clock;
+
+        // slices ending now, then arrivals, then every idle CPU looks for work in CPU id order
+        while (!dyn_array_empty(ctx->events) && ((MultiEvent_t *) dyn_array_front(ctx->events))->time <= ctx->clock)
+        {
+            MultiEvent_t event;
+            HEAP_POP(ctx->events, MultiEvent_t, event_before, &event);
+            if (!multi_slice_done(ctx, event.cpu))
+            {
+                return false;
+            }
+        }
+        while (ctx->next < n && ((MultiJob_t *) dyn_array_at(ctx->jobs, ctx->next))->pcb->arrival <= ctx->clock)
+        {
+            const MultiJob_t *job = dyn_array_at(ctx->jobs, ctx->next);
+            const size_t c = multi_place(ctx, job);
+            // a tenant's memory lives on the socket its first PCB was queued on
+            uint32_t *home = dyn_array_at(ctx->homes, job->tenant);
+            if (*home == MULTI_NONE)
+            {
+                *home = topology_cpu(ctx->topology, c)->socket;
+            }
+            if (!multi_enqueue(ctx, c, (uint32_t) ctx->next))
+            {
+                return false;
+            }
+            ++ctx->next;
+        }
+        for (size_t c = 0; c < cpus; ++c)
+        {
+            MultiCpu_t *cpu = multi_cpu(ctx, c);
+            if (cpu->running != MULTI_NONE)
+            {
+                continue;
+            }
+            if (dyn_array_empty(cpu->queue) && ctx->config->balance != SCHEDULE_BALANCE_NONE
+                && !multi_steal(ctx, c))
+            {
+                return false;
+            }
+            if (!dyn_array_empty(cpu->queue) && !multi_dispatch(ctx, c))
+            {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+bool multi_cpu_run(dyn_array_t *ready_queue, ScheduleResult_t *result, const ScheduleConfig_t *config)
+{
+    if (!ready_queue || !result || !config || !config->topology || !topology_cpus(config->topology)
+        || dyn_array_empty(ready_queue) || dyn_array_data_size(ready_queue) != sizeof(ProcessControlBlock_t)
+        || config->policy > SCHEDULE_SRTF
+        || ((config->policy == SCHEDULE_RR || config->policy == SCHEDULE_SRTF) && !config->quantum)
+        || config->bursts || config->deadlines || config->admission || config->shares
+        || (config->core_classes && dyn_array_data_size(config->core_classes) != sizeof(ScheduleCoreClass_t))
+        || (config->tenants && (dyn_array_size(config->tenants) < dyn_array_size(ready_queue)
+                                || dyn_array_data_size(config->tenants) != sizeof(uint32_t))))
+    {
+        return false;
+    }
+    MultiContext_t ctx;
+    if (!multi_init(&ctx, ready_queue, config))
+    {
+        return false;
+    }
+    if (!multi_simulate(&ctx))
+    {
+        multi_destroy(&ctx);
+        return false;
+    }
+
+    const size_t n = dyn_array_size(ctx.jobs);
+    result->average_waiting_time = (float) ctx.total_waiting_time / n;
+    result->average_turnaround_time = (float) ctx.total_turnaround_time / n;
+    result->total_run_time = ctx.clock;
+    if (config->stats)
+    {
+        *config->stats = ctx.stats;
+    }
+    multi_destroy(&ctx);
+    return true;
+}
@@ -1,244 +1,1573 @@
 #include <fcntl.h>
+#include <limits.h>
+#include <math.h>
 #include <stdio.h>
 #include <string.h>
 #include <unistd.h>
-#include <math.h>
+#include "burst_arena.h"
 #include "dyn_array.h"
+#include "dyn_array_parallel.h"
+#include "instrument.h"
+#include "multi_cpu.h"
 #include "processing_scheduling.h"
+#include "simd_argmin.h"
 
 #define UNUSED(x) (void)(x)
 
+// pid of "nobody ran yet", used to skip counting the very first dispatch as a switch
+#define NO_PID UINT32_MAX
+
+// Runs of up to this many PCBs keep their queues inside the SimContext_t, off the heap
+#define SIM_INLINE_JOBS 8
+
+// Key based policies pick from a key column scanned with simd_argmin_u32 while the ready queue
+// is short, and switch to a heap on (key, admission order) once it grows past SIM_HEAP_ENTER.
+// They only switch back below SIM_HEAP_LEAVE, so a queue hovering at the limit does not flap
+#define SIM_HEAP_ENTER 1024
+#define SIM_HEAP_LEAVE 256
+
+// schedule_run_parallel packs consecutive busy periods into segments of at least this many
+// jobs, so sparse traces with thousands of one-job periods do not pay a run setup for each
+#define SIM_SEGMENT_JOBS 1024
+
+// The field a policy minimises when it picks the next PCB from the ready queue. Lottery has
+// no key, its ready queue is a bag of ticket holders
+typedef enum { KEY_ARRIVAL, KEY_REMAINING, KEY_PRIORITY, KEY_DEADLINE, KEY_PASS, KEY_TICKETS } SchedKey_t;
+
+// Densities are fixed point with this many fraction bits, so a whole CPU is 1 << SIM_DENSITY_BITS
+#define SIM_DENSITY_BITS 32
+
+// Pass a stride PCB with one ticket advances per tick; one with t tickets advances SIM_STRIDE1 / t,
+// at least 256 for the SCHEDULE_TICKETS_MAX the runs accept
+#define SIM_STRIDE1 ((uint64_t) 1 << 24)
+_Static_assert(SIM_STRIDE1 / SCHEDULE_TICKETS_MAX >= 256, "stride rounding must stay under 1/256");
+
+// A PCB as the simulator sees it. The PCB itself stays in the caller's ready queue,
+// pid is its index there and burst is its total CPU demand
+typedef struct
+{
+    ProcessControlBlock_t *pcb;
+    const uint32_t *phases;         // CPU/I/O phases from the burst arena, NULL for a single CPU burst
+    uint32_t phase_count;
+    uint32_t phase;                 // index of the current phase (even: CPU, odd: I/O)
+    uint32_t pid;
+    uint32_t burst;
+    unsigned long last_ran;         // clock at the end of its latest slice
+    unsigned long io_done;          // when the I/O it is doing completes (while on a device)
+    unsigned long blocked_since;    // when it last left the CPU for I/O
+    unsigned long blocked;          // total ticks spent blocked, device queueing included
+    uint64_t sequence;              // when it last joined the ready queue, breaks key ties in heap mode
+    uint64_t deadline;              // absolute deadline, UINT64_MAX for none
+    uint64_t pass;                  // stride scheduling's virtual time of the job
+    double joined;                  // ctx->share_time when it last became runnable (with shares)
+    uint32_t tickets;               // proportional share weight, max(priority, 1)
+    uint32_t tenant;
+    bool ran;                       // whether it has had a slice yet
+}
+SimJob_t;
+
+// State of one run: its options, its queues and the totals that become the ScheduleResult_t.
+// The queue headers live in storage and point at inline_jobs/inline_keys, all inside this
+// struct, so a SimContext_t must stay where sim_init put it and must never be copied
+typedef struct
+{
+    const ScheduleConfig_t *config;
+    dyn_array_t *jobs;              // every job in arrival order
+    size_t next;                    // first job in jobs that has not arrived yet
+    dyn_array_t *ready;             // runnable jobs in admission order, or a heap while heap is set
+    dyn_array_t *keys;              // uint32_t key of every ready job, in step with ready (key based scan mode)
+    SchedKey_t key;                 // what the policy minimises
+    bool heap;                      // ready is a min-heap on (key, sequence)
+    uint64_t admitted;              // sequence of the next job to join the ready queue
+    dyn_array_t *io_waiting;        // blocked jobs queued for a device, FIFO
+    dyn_array_t *io_active;         // blocked jobs on a device
+    unsigned long clock;
+    uint64_t total_waiting_time;
+    uint64_t total_turnaround_time;
+    uint32_t last_pid;
+    ScheduleStats_t stats;
+    ScheduleDeadlineStats_t deadline_stats;
+    dyn_array_t *releases;          // SimRelease_t min-heap on deadline, with admission control
+    uint64_t density;               // density of the admitted jobs whose deadlines are still ahead
+    uint64_t global_pass;           // pass of the latest stride dispatch, where joining jobs start
+    dyn_array_t *lottery;           // uint64_t Fenwick tree over the tickets of the ready slots (lottery)
+    uint64_t lottery_tickets;       // tickets in the ready queue (lottery)
+    uint64_t random;                // splitmix64 state of the lottery draws
+    dyn_array_t *shares;            // the config's shares, when it has them
+    uint64_t runnable_tickets;      // tickets of the ready and running jobs (with shares)
+    double share_time;              // CPU ticks owed per ticket so far (with shares)
+    dyn_array_t *groups;            // SimGroup_t by group id (SCHEDULE_GROUP)
+    dyn_array_t *group_jobs;        // SimJob_t by pid, for the jobs in the group tree
+    dyn_array_t *group_path;        // uint32_t groups the latest pick went through, from the top
+    uint64_t group_sequence;        // queueing order of the group tree's entries
+    dyn_array_storage_t storage[4];                 // headers of the four queues
+    SimJob_t inline_jobs[4][SIM_INLINE_JOBS];       // their objects, for small runs
+    dyn_array_storage_t key_storage;                // header of the key column
+    uint32_t inline_keys[SIM_INLINE_JOBS];
+}
+SimContext_t;
+
+// A runnable child of a group node: a subgroup or a PCB
+typedef struct
+{
+    uint64_t key;                   // virtual runtime under GROUP_FAIR, 0 under GROUP_RR
+    uint64_t sequence;              // when it was queued, breaks key ties first come first served
+    uint32_t id;                    // group id or pid
+    bool group;
+}
+SimGroupEntry_t;
+
+// A group node during a SCHEDULE_GROUP run
+typedef struct
+{
+    dyn_array_t *queue;             // SimGroupEntry_t min-heap of the runnable children
+    uint64_t vruntime;              // ticks run below it, each scaled by SIM_STRIDE1 / weight
+    uint64_t min_vruntime;          // key of its latest pick, where joining children start
+    uint32_t runnable;              // runnable PCBs anywhere below it
+    uint32_t parent;
+    uint64_t stride;                // SIM_STRIDE1 / weight
+    GroupPolicy_t policy;
+}
+SimGroup_t;
+
+// An admitted job's density, held against the CPU until its deadline passes
+typedef struct
+{
+    uint64_t deadline;
+    uint64_t density;
+}
+SimRelease_t;
+
+static uint64_t splitmix64(uint64_t *state)
+{
+    uint64_t z = (*state += 0x9e3779b97f4a7c15ull);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+    return z ^ (z >> 31);
+}
+
 // private function
-void virtual_cpu(ProcessControlBlock_t *process_control_block) 
+void virtual_cpu(ProcessControlBlock_t *process_control_block, uint32_t ticks)
 {
-    // decrement the burst time of the pcb
-    --process_control_block->remaining_burst_time;
+    // retire ticks units of the pcb's burst
+    process_control_block->remaining_burst_time -= ticks;
 }
 
-int cmpfuncArrival(const void *a, const void *b) // compare function for shortest job first
+int cmpfuncArrival(const void *a, const void *b) // orders jobs by arrival, ties by their position in the ready queue
 {
-    if (((ProcessControlBlock_t *)a)->arrival < ((ProcessControlBlock_t *)b)->arrival)
+    const SimJob_t *job_a = (const SimJob_t *)a;
+    const SimJob_t *job_b = (const SimJob_t *)b;
+
+    INSTRUMENT_ADD(comparator_calls, 1);
+    if (job_a->pcb->arrival != job_b->pcb->arrival)
     {
-        return -1;
+        return job_a->pcb->arrival < job_b->pcb->arrival ? -1 : 1;
     }
-    else if (((ProcessControlBlock_t *)a)->arrival == ((ProcessControlBlock_t *)b)->arrival)
+    return job_a->pid < job_b->pid ? -1 : (job_a->pid > job_b->pid);
+}
+
+// Returns the value the policy minimises for this job
+static inline uint32_t job_key(const SimJob_t *job, SchedKey_t key)
+{
+    switch (key)
     {
-        return 0;
+        case KEY_REMAINING:
+            return job->pcb->remaining_burst_time;
+        case KEY_PRIORITY:
+            return job->pcb->priority;
+        case KEY_DEADLINE:
+            return job->deadline < UINT32_MAX ? (uint32_t) job->deadline : UINT32_MAX;
+        case KEY_PASS:
+            return job->pass < UINT32_MAX ? (uint32_t) job->pass : UINT32_MAX;
+        default:
+            return job->pcb->arrival;
     }
+}
 
-    return 1;
+// Deadlines and passes are 64 bit, so those policies keep the ready queue a heap on the full value
+// at every length, which also keeps them O(log n) per event. Lottery keeps it a bag
+static inline bool sim_key_fixed(SchedKey_t key)
+{
+    return key == KEY_DEADLINE || key == KEY_PASS || key == KEY_TICKETS;
 }
 
-int cmpfuncRemainingTime(const void *a, const void *b)
+// The field a policy minimises, KEY_ARRIVAL for the FIFO ones
+static SchedKey_t sim_policy_key(SchedulePolicy_t policy)
 {
-    return (((ProcessControlBlock_t *)a)->remaining_burst_time - ((ProcessControlBlock_t *)b)->remaining_burst_time); // compare the remaining burst time
+    switch (policy)
+    {
+        case SCHEDULE_SJF:
+        case SCHEDULE_SRTF:
+            return KEY_REMAINING;
+        case SCHEDULE_PRIORITY:
+            return KEY_PRIORITY;
+        case SCHEDULE_EDF:
+            return KEY_DEADLINE;
+        case SCHEDULE_STRIDE:
+            return KEY_PASS;
+        case SCHEDULE_LOTTERY:
+            return KEY_TICKETS;
+        default:
+            return KEY_ARRIVAL;
+    }
 }
 
+// Fills in a job's phases from the burst arena (if any) and its total CPU demand
+static bool sim_job_phases(SimJob_t *job, const BurstArena_t *bursts)
+{
+    job->burst = job->pcb->remaining_burst_time;
+    if (!bursts)
+    {
+        return true;
+    }
 
-// Comparison function for sorting based on remaining burst time
-int compare_remaining_burst_time(const void *a, const void *b) {
-    const ProcessControlBlock_t *pcb_a = (const ProcessControlBlock_t *)a;
-    const ProcessControlBlock_t *pcb_b = (const ProcessControlBlock_t *)b;
+    size_t count;
+    job->phases = burst_arena_phases(bursts, job->pid, &count);
+    if (!job->phases)
+    {
+        return false;
+    }
+    job->phase_count = (uint32_t) count;
+    job->burst = 0;
+    for (size_t i = 0; i < count; i += 2)
+    {
+        job->burst += job->phases[i];
+    }
+    job->pcb->remaining_burst_time = job->phases[0];
+    return true;
+}
 
-    // Compare remaining burst times
-    if (pcb_a->remaining_burst_time < pcb_b->remaining_burst_time) {
-        return -1;
-    } else if (pcb_a->remaining_burst_time > pcb_b->remaining_burst_time) {
-        return 1;
-    } else {
-        return 0;
+static void sim_destroy(SimContext_t *ctx)
+{
+    dyn_array_deinit(ctx->jobs);
+    dyn_array_deinit(ctx->ready);
+    dyn_array_deinit(ctx->io_waiting);
+    dyn_array_deinit(ctx->io_active);
+    dyn_array_deinit(ctx->keys);
+    dyn_array_destroy(ctx->releases);
+    dyn_array_destroy(ctx->lottery);
+    for (size_t g = 0; g < dyn_array_size(ctx->groups); ++g)
+    {
+        dyn_array_destroy(((SimGroup_t *) dyn_array_at(ctx->groups, g))->queue);
     }
+    dyn_array_destroy(ctx->groups);
+    dyn_array_destroy(ctx->group_jobs);
+    dyn_array_destroy(ctx->group_path);
 }
 
+// Virtual time a tick costs something of this weight
+static inline uint64_t sim_stride(uint32_t weight)
+{
+    const uint64_t stride = SIM_STRIDE1 / (weight ? weight : 1);
+    return stride ? stride : 1;
+}
 
+// Builds the run time state of every node of the config's group tree
+static bool sim_groups_init(SimContext_t *ctx, size_t n)
+{
+    const GroupTree_t *tree = ctx->config->groups;
+    const size_t count = group_tree_size(tree);
+    ctx->groups = dyn_array_create(count, sizeof(SimGroup_t), NULL);
+    ctx->group_jobs = dyn_array_create(n, sizeof(SimJob_t), NULL);
+    ctx->group_path = dyn_array_create(0, sizeof(uint32_t), NULL);
+    if (!ctx->groups || !ctx->group_jobs || !ctx->group_path || !dyn_array_resize(ctx->group_jobs, n, NULL))
+    {
+        return false;
+    }
+    for (uint32_t g = 0; g < count; ++g)
+    {
+        const GroupNode_t *node = group_tree_node(tree, g);
+        SimGroup_t group;
+        memset(&group, 0, sizeof(group));
+        if (node->weight > SCHEDULE_TICKETS_MAX)
+        {
+            return false;
+        }
+        group.parent = node->parent;
+        group.stride = sim_stride(node->weight);
+        group.policy = node->policy;
+        group.queue = dyn_array_create(0, sizeof(SimGroupEntry_t), NULL);
+        if (!group.queue || !dyn_array_push_back(ctx->groups, &group))
+        {
+            dyn_array_destroy(group.queue);
+            return false;
+        }
+    }
+    return true;
+}
 
-bool first_come_first_serve(dyn_array_t *ready_queue, ScheduleResult_t *result) 
+// Sets up the four queues of a run over n jobs, reserved up front so pointers into them survive pushes
+static bool sim_queues_init(SimContext_t *ctx, const ScheduleConfig_t *config, size_t n)
 {
-    if (ready_queue == NULL || result == NULL)
+    ctx->config = config;
+    ctx->last_pid = NO_PID;
+    dyn_array_t **queues[] = {&ctx->jobs, &ctx->ready, &ctx->io_waiting, &ctx->io_active};
+    const bool small = n <= SIM_INLINE_JOBS;
+    for (size_t q = 0; q < 4; ++q)
     {
+        *queues[q] = dyn_array_init(&ctx->storage[q], small ? ctx->inline_jobs[q] : NULL,
+                                    small ? SIM_INLINE_JOBS : 0, sizeof(SimJob_t), NULL);
+    }
+    ctx->key = sim_policy_key(config->policy);
+    ctx->heap = sim_key_fixed(ctx->key) && ctx->key != KEY_TICKETS;
+    ctx->random = config->seed;
+    ctx->keys = dyn_array_init(&ctx->key_storage, small ? ctx->inline_keys : NULL, small ? SIM_INLINE_JOBS : 0,
+                               sizeof(uint32_t), NULL);
+    if (!dyn_array_reserve(ctx->jobs, n) || !dyn_array_reserve(ctx->ready, n)
+        || (ctx->key != KEY_ARRIVAL && !sim_key_fixed(ctx->key) && !dyn_array_reserve(ctx->keys, n))
+        || (ctx->key == KEY_TICKETS && !((ctx->lottery = dyn_array_create(n + 1, sizeof(uint64_t), NULL))
+                                         && dyn_array_resize(ctx->lottery, n + 1, NULL)))
+        || (config->bursts && (!dyn_array_reserve(ctx->io_waiting, n) || !dyn_array_reserve(ctx->io_active, n)))
+        || (config->admission && !(ctx->releases = dyn_array_create(0, sizeof(SimRelease_t), NULL)))
+        || (config->policy == SCHEDULE_GROUP && !sim_groups_init(ctx, n)))
+    {
+        sim_destroy(ctx);
         return false;
     }
-    
-    if (!dyn_array_sort(ready_queue, cmpfuncArrival)) // Sort array by arrival time
+    return true;
+}
+
+// Grows the shares to cover job's tenant and counts the job in it
+static bool sim_share_open(SimContext_t *ctx, const SimJob_t *job)
+{
+    if (!ctx->shares)
+    {
+        ctx->shares = ctx->config->shares;
+        dyn_array_clear(ctx->shares);
+    }
+    const size_t have = dyn_array_size(ctx->shares);
+    if (job->tenant >= have)
+    {
+        if (!dyn_array_resize(ctx->shares, (size_t) job->tenant + 1, NULL))
+        {
+            return false;
+        }
+        memset(dyn_array_at(ctx->shares, have), 0, (job->tenant + 1 - have) * sizeof(ScheduleShare_t));
+    }
+    ScheduleShare_t *share = dyn_array_at(ctx->shares, job->tenant);
+    ++share->pcbs;
+    share->tickets += job->tickets;
+    return true;
+}
+
+// Validates the inputs and sets up a run with every job in arrival order
+// \return false if the queue is empty, does not hold PCBs or does not match the burst arena
+static bool sim_init(SimContext_t *ctx, dyn_array_t *ready_queue, ScheduleResult_t *result,
+                     const ScheduleConfig_t *config)
+{
+    memset(ctx, 0, sizeof(*ctx));
+    if (!ready_queue || !result || !config || dyn_array_empty(ready_queue)
+        || dyn_array_data_size(ready_queue) != sizeof(ProcessControlBlock_t)
+        || (config->bursts && burst_arena_size(config->bursts) < dyn_array_size(ready_queue))
+        || (config->deadlines && (dyn_array_size(config->deadlines) < dyn_array_size(ready_queue)
+                                  || dyn_array_data_size(config->deadlines) != sizeof(PcbDeadline_t)))
+        || (config->tenants && (dyn_array_size(config->tenants) < dyn_array_size(ready_queue)
+                                || dyn_array_data_size(config->tenants) != sizeof(uint32_t)))
+        || (config->shares && dyn_array_data_size(config->shares) != sizeof(ScheduleShare_t))
+        || (config->policy == SCHEDULE_GROUP
+            && (!config->groups || !config->group_of || dyn_array_size(config->group_of) < dyn_array_size(ready_queue)
+                || dyn_array_data_size(config->group_of) != sizeof(uint32_t))))
     {
         return false;
-    };
+    }
 
-     float waittime = 0;
-    unsigned long runtime = 0;
-    float total_wait_time = 0;
-    int n = dyn_array_size(ready_queue);
+    const size_t n = dyn_array_size(ready_queue);
+    if (!sim_queues_init(ctx, config, n))
+    {
+        return false;
+    }
 
-    for (int i = 0; i < n; i++) // loop through the ready queue
+    for (size_t i = 0; i < n; ++i)
     {
-        total_wait_time += ((ProcessControlBlock_t *)dyn_array_at(ready_queue, i))->arrival;
-        int x = n - i;                                                                            // set the wait time multiplier
-        runtime += ((ProcessControlBlock_t *)dyn_array_at(ready_queue, i))->remaining_burst_time; // add the burst time to the runtime
-        if (i > 0)
+        SimJob_t job;
+        memset(&job, 0, sizeof(job));
+        job.pcb = dyn_array_at(ready_queue, i);
+        job.pid = (uint32_t) i;
+        const PcbDeadline_t *deadline = config->deadlines ? dyn_array_at(config->deadlines, i) : NULL;
+        // a periodic PCB without a deadline of its own is due by its next release
+        const uint32_t relative = !deadline ? 0 : deadline->deadline ? deadline->deadline : deadline->period;
+        job.deadline = relative ? (uint64_t) job.pcb->arrival + relative : UINT64_MAX;
+        job.tickets = job.pcb->priority ? job.pcb->priority : 1;
+        const bool strided = config->policy == SCHEDULE_STRIDE || config->policy == SCHEDULE_GROUP;
+        job.tenant = config->tenants ? *(const uint32_t *) dyn_array_at(config->tenants, i) : (uint32_t) i;
+        if ((strided && job.tickets > SCHEDULE_TICKETS_MAX) || !sim_job_phases(&job, config->bursts)
+            || (config->shares && !sim_share_open(ctx, &job))
+            || (config->group_of && config->policy == SCHEDULE_GROUP
+                && *(const uint32_t *) dyn_array_at(config->group_of, i) >= group_tree_size(config->groups)))
         {
-            waittime += ((ProcessControlBlock_t *)dyn_array_at(ready_queue, i - 1))->remaining_burst_time * x; // add the wait time to the waittime
+            sim_destroy(ctx);
+            return false;
         }
+        dyn_array_push_back(ctx->jobs, &job);
     }
+    dyn_array_sort(ctx->jobs, cmpfuncArrival);
+    timeline_clear(config->timeline);
+    return true;
+}
 
-    for (int i = 0; i < n; i++)
+static inline unsigned long sim_next_arrival(const SimContext_t *ctx)
+{
+    if (ctx->next < dyn_array_size(ctx->jobs))
     {
-        ProcessControlBlock_t *current = (ProcessControlBlock_t *)dyn_array_at(ready_queue, i);
+        return ((SimJob_t *) dyn_array_at(ctx->jobs, ctx->next))->pcb->arrival;
+    }
+    return ULONG_MAX;
+}
 
-        while (current->remaining_burst_time > 0) // run the process until the burst time is 0
+// Finds the device that frees up first
+// \return its completion time, ULONG_MAX if no I/O is in flight
+static unsigned long sim_next_io(const SimContext_t *ctx, size_t *index)
+{
+    unsigned long earliest = ULONG_MAX;
+    const size_t n = dyn_array_size(ctx->io_active);
+    for (size_t i = 0; i < n; ++i)
+    {
+        const SimJob_t *job = dyn_array_at(ctx->io_active, i);
+        if (job->io_done < earliest)
         {
-            virtual_cpu(current);
+            earliest = job->io_done;
+            *index = i;
         }
     }
+    return earliest;
+}
 
-    dyn_array_destroy(ready_queue); // cleanup
+// When something next joins the ready queue, ULONG_MAX if nothing will
+static unsigned long sim_next_event(const SimContext_t *ctx)
+{
+    size_t index;
+    const unsigned long io = sim_next_io(ctx, &index);
+    const unsigned long arrival = sim_next_arrival(ctx);
+    return io < arrival ? io : arrival;
+}
 
-    result->average_waiting_time = (waittime - total_wait_time) / n; // set the result
-    result->average_turnaround_time = ((float)runtime + waittime - total_wait_time) / n;
-    result->total_run_time = runtime;
-    return true; // return true
+static bool sim_pending(const SimContext_t *ctx)
+{
+    return ctx->next < dyn_array_size(ctx->jobs) || !dyn_array_empty(ctx->ready) || !dyn_array_empty(ctx->io_active);
 }
 
-bool shortest_job_first(dyn_array_t *ready_queue, ScheduleResult_t *result) 
+// Puts a blocked job on a device at time now
+static void sim_io_start(SimContext_t *ctx, SimJob_t *job, unsigned long now)
 {
-    if (!ready_queue || !result) {
-        return false;
+    job->io_done = now + job->phases[job->phase];
+    ctx->stats.io_busy += job->phases[job->phase];
+    dyn_array_push_back(ctx->io_active, job);
+}
+
+// Sends a job that just finished a CPU phase off to do its next I/O phase
+static void sim_block(SimContext_t *ctx, SimJob_t *job)
+{
+    ++job->phase;
+    job->blocked_since = ctx->clock;
+    if (!ctx->config->io_devices || dyn_array_size(ctx->io_active) < ctx->config->io_devices)
+    {
+        sim_io_start(ctx, job, ctx->clock);
+    }
+    else
+    {
+        dyn_array_push_back(ctx->io_waiting, job);
+    }
+}
+
+// Whether ready job a goes before ready job b in heap mode
+static inline bool sim_heap_before(const SimContext_t *ctx, const SimJob_t *a, const SimJob_t *b)
+{
+    if (ctx->key == KEY_DEADLINE)
+    {
+        return a->deadline < b->deadline || (a->deadline == b->deadline && a->sequence < b->sequence);
+    }
+    if (ctx->key == KEY_PASS)
+    {
+        return a->pass < b->pass || (a->pass == b->pass && a->sequence < b->sequence);
+    }
+    const uint32_t key_a = job_key(a, ctx->key);
+    const uint32_t key_b = job_key(b, ctx->key);
+    return key_a < key_b || (key_a == key_b && a->sequence < b->sequence);
+}
+
+static void sim_heap_sift_up(SimContext_t *ctx, size_t index)
+{
+    SimJob_t *jobs = (SimJob_t *) dyn_array_front(ctx->ready);
+    const SimJob_t moving = jobs[index];
+    while (index)
+    {
+        const size_t parent = (index - 1) / 2;
+        if (!sim_heap_before(ctx, &moving, &jobs[parent]))
+        {
+            break;
+        }
+        jobs[index] = jobs[parent];
+        index = parent;
+    }
+    jobs[index] = moving;
+}
+
+static void sim_heap_sift_down(SimContext_t *ctx, size_t index)
+{
+    SimJob_t *jobs = (SimJob_t *) dyn_array_front(ctx->ready);
+    const size_t n = dyn_array_size(ctx->ready);
+    const SimJob_t moving = jobs[index];
+    for (;;)
+    {
+        size_t child = 2 * index + 1;
+        if (child >= n)
+        {
+            break;
+        }
+        if (child + 1 < n && sim_heap_before(ctx, &jobs[child + 1], &jobs[child]))
+        {
+            ++child;
+        }
+        if (!sim_heap_before(ctx, &jobs[child], &moving))
+        {
+            break;
+        }
+        jobs[index] = jobs[child];
+        index = child;
     }
+    jobs[index] = moving;
+}
 
-    unsigned long current_time = 0;
-    unsigned long total_waiting_time = 0;
+// Adds delta (two's complement for a decrease) to the tickets of ready slot index
+static inline void sim_lottery_add(SimContext_t *ctx, size_t index, uint64_t delta)
+{
+    uint64_t *tree = dyn_array_front(ctx->lottery);
+    const size_t n = dyn_array_size(ctx->lottery);
+    for (size_t i = index + 1; i < n; i += i & (0 - i))
+    {
+        tree[i] += delta;
+    }
+}
+
+// Takes a ready job out of the lottery bag: draws a ticket, finds its holder by descending the
+// Fenwick tree, and moves the last slot into the hole
+static void sim_lottery_draw(SimContext_t *ctx, SimJob_t *job)
+{
+    const uint64_t *tree = dyn_array_front(ctx->lottery);
+    const size_t n = dyn_array_size(ctx->lottery) - 1;
+    uint64_t ticket = splitmix64(&ctx->random) % ctx->lottery_tickets;
+    size_t slot = 0;
+    size_t step = 1;
+    while (step <= n / 2)
+    {
+        step <<= 1;
+    }
+    for (; step; step >>= 1)
+    {
+        if (slot + step <= n && tree[slot + step] <= ticket)
+        {
+            slot += step;
+            ticket -= tree[slot];
+        }
+    }
 
-    // Sort the ready queue based on remaining burst time (shortest first)
-    dyn_array_sort(ready_queue, compare_remaining_burst_time);
+    SimJob_t last;
+    dyn_array_extract_back(ctx->ready, &last);
+    const size_t last_slot = dyn_array_size(ctx->ready);
+    sim_lottery_add(ctx, last_slot, 0 - (uint64_t) last.tickets);
+    if (slot == last_slot)
+    {
+        *job = last;
+    }
+    else
+    {
+        SimJob_t *hole = dyn_array_at(ctx->ready, slot);
+        *job = *hole;
+        sim_lottery_add(ctx, slot, (uint64_t) last.tickets - job->tickets);
+        *hole = last;
+    }
+    ctx->lottery_tickets -= job->tickets;
+}
 
-    while (dyn_array_size(ready_queue) > 0) {
-        // Get the PCB with the shortest remaining burst time
-        ProcessControlBlock_t *pcb = dyn_array_at(ready_queue, 0);
+// Puts a job back in the ready queue under the sequence it already has
+static void sim_ready_insert(SimContext_t *ctx, const SimJob_t *job)
+{
+    dyn_array_push_back(ctx->ready, job);
+    if (ctx->key == KEY_TICKETS)
+    {
+        sim_lottery_add(ctx, dyn_array_size(ctx->ready) - 1, job->tickets);
+        ctx->lottery_tickets += job->tickets;
+    }
+    else if (ctx->heap)
+    {
+        sim_heap_sift_up(ctx, dyn_array_size(ctx->ready) - 1);
+    }
+    else if (ctx->key != KEY_ARRIVAL)
+    {
+        const uint32_t key = job_key(job, ctx->key);
+        dyn_array_push_back(ctx->keys, &key);
+    }
+}
+
+// A job joins the ready queue behind everything already in it. A stride job does not keep
+// a pass from before it blocked that would let it catch up on the time it was away
+static void sim_ready_push(SimContext_t *ctx, SimJob_t *job)
+{
+    job->sequence = ctx->admitted++;
+    if (job->pass < ctx->global_pass)
+    {
+        job->pass = ctx->global_pass;
+    }
+    if (ctx->shares)
+    {
+        job->joined = ctx->share_time;
+        ctx->runnable_tickets += job->tickets;
+    }
+    sim_ready_insert(ctx, job);
+}
+
+// Takes the first job off the ready heap
+static void sim_heap_pop(SimContext_t *ctx, SimJob_t *job)
+{
+    SimJob_t last;
+    *job = *(SimJob_t *) dyn_array_front(ctx->ready);
+    dyn_array_extract_back(ctx->ready, &last);
+    if (!dyn_array_empty(ctx->ready))
+    {
+        *(SimJob_t *) dyn_array_front(ctx->ready) = last;
+        sim_heap_sift_down(ctx, 0);
+    }
+}
+
+static int cmpfuncSequence(const void *a, const void *b)
+{
+    const SimJob_t *job_a = (const SimJob_t *) a;
+    const SimJob_t *job_b = (const SimJob_t *) b;
+    return job_a->sequence < job_b->sequence ? -1 : (job_a->sequence > job_b->sequence);
+}
+
+// Moves the ready queue between the scanned column and the heap as its length demands
+static void sim_ready_shape(SimContext_t *ctx)
+{
+    const size_t n = dyn_array_size(ctx->ready);
+    if (sim_key_fixed(ctx->key))
+    {
+        return;
+    }
+    if (!ctx->heap && n > SIM_HEAP_ENTER)
+    {
+        ctx->heap = true;
+        dyn_array_clear(ctx->keys);
+        for (size_t i = n / 2; i-- > 0;)
+        {
+            sim_heap_sift_down(ctx, i);
+        }
+    }
+    else if (ctx->heap && n < SIM_HEAP_LEAVE)
+    {
+        // back to admission order, which is what the scan's first-minimum tie break relies on
+        ctx->heap = false;
+        dyn_array_sort(ctx->ready, cmpfuncSequence);
+        for (size_t i = 0; i < n; ++i)
+        {
+            const uint32_t key = job_key(dyn_array_at(ctx->ready, i), ctx->key);
+            dyn_array_push_back(ctx->keys, &key);
+        }
+    }
+}
 
-        // Execute the PCB
-        current_time += pcb->remaining_burst_time;
-        total_waiting_time += current_time - pcb->arrival - pcb->remaining_burst_time;
+// Whether release a leaves the admission heap before release b
+static inline bool sim_release_before(const SimRelease_t *a, const SimRelease_t *b)
+{
+    return a->deadline < b->deadline;
+}
 
-        // Remove the completed PCB from the ready queue
-        dyn_array_erase(ready_queue, 0);
+// Admission control: admits job if the densities of the admitted jobs whose deadlines are still
+// ahead, plus its own, fit on the CPU. Releases whose deadlines have passed are dropped first
+static bool sim_admission(SimContext_t *ctx, const SimJob_t *job)
+{
+    SimRelease_t *heap = dyn_array_front(ctx->releases);
+    size_t n = dyn_array_size(ctx->releases);
+    while (n && heap[0].deadline <= ctx->clock)
+    {
+        ctx->density -= heap[0].density;
+        const SimRelease_t moving = heap[--n];
+        size_t index = 0;
+        for (size_t child = 1; child < n; child = 2 * index + 1)
+        {
+            child += child + 1 < n && sim_release_before(&heap[child + 1], &heap[child]);
+            if (!sim_release_before(&heap[child], &moving))
+            {
+                break;
+            }
+            heap[index] = heap[child];
+            index = child;
+        }
+        heap[index] = moving;
+        dyn_array_pop_back(ctx->releases);
+    }
 
-        // Update the result values
-        result->average_waiting_time = (float)total_waiting_time / dyn_array_size(ready_queue);
-        result->average_turnaround_time = result->average_waiting_time + pcb->remaining_burst_time;
-        result->total_run_time = current_time;
+    const uint64_t relative = job->deadline - job->pcb->arrival;
+    const uint64_t whole = (uint64_t) 1 << SIM_DENSITY_BITS;
+    const uint64_t density = (((uint64_t) job->burst << SIM_DENSITY_BITS) + relative - 1) / relative;
+    if (density > whole - ctx->density)
+    {
+        return false;
     }
 
+    SimRelease_t release = {job->deadline, density};
+    if (!dyn_array_push_back(ctx->releases, &release))
+    {
+        return false;
+    }
+    heap = dyn_array_front(ctx->releases);
+    for (size_t index = dyn_array_size(ctx->releases) - 1; index;)
+    {
+        const size_t parent = (index - 1) / 2;
+        if (!sim_release_before(&release, &heap[parent]))
+        {
+            break;
+        }
+        heap[index] = heap[parent];
+        index = parent;
+        heap[index] = release;
+    }
+    ctx->density += density;
     return true;
 }
 
+// Moves every job that has arrived or finished its I/O by the current clock into the ready queue,
+// in the order those events happened
+static void sim_admit(SimContext_t *ctx)
+{
+    for (;;)
+    {
+        size_t io_index = 0;
+        const unsigned long io = sim_next_io(ctx, &io_index);
+        const unsigned long arrival = sim_next_arrival(ctx);
+        if (arrival <= io && arrival <= ctx->clock)
+        {
+            SimJob_t *job = dyn_array_at(ctx->jobs, ctx->next);
+            ++ctx->next;
+            if (ctx->releases && job->deadline != UINT64_MAX && !sim_admission(ctx, job))
+            {
+                ++ctx->deadline_stats.rejected;
+                continue;
+            }
+            sim_ready_push(ctx, job);
+        }
+        else if (io < arrival && io <= ctx->clock)
+        {
+            SimJob_t job;
+            dyn_array_extract(ctx->io_active, io_index, &job);
+            job.blocked += io - job.blocked_since;
+            ++job.phase;
+            job.pcb->remaining_burst_time = job.phases[job.phase];
+            sim_ready_push(ctx, &job);
 
-bool round_robin(dyn_array_t *ready_queue, ScheduleResult_t *result, size_t quantum) 
+            // the device goes straight to the next job queued for it
+            SimJob_t queued;
+            if (dyn_array_extract_front(ctx->io_waiting, &queued))
+            {
+                sim_io_start(ctx, &queued, io);
+            }
+        }
+        else
+        {
+            break;
+        }
+        INSTRUMENT_ADD(queue_ops, 1);
+    }
+}
+
+// Cache refill owed by a PCB coming back after off ticks away from the CPU
+static uint32_t sim_refill_cost(const ScheduleCostModel_t *costs, const SimJob_t *job, unsigned long now)
+{
+    if (!job->ran || !costs->refill_halflife)
+    {
+        return costs->refill_max;
+    }
+    const uint64_t off = now - job->last_ran;
+    return (uint32_t) ((uint64_t) costs->refill_max * off / (off + costs->refill_halflife));
+}
+
+// Puts job on the CPU, charging the cost model if that is a context switch
+// \return true if the clock moved (callers should admit what arrived meanwhile)
+static bool sim_dispatch(SimContext_t *ctx, SimJob_t *job)
 {
-    if (!ready_queue || !result) {
+    if (ctx->last_pid == job->pid)
+    {
         return false;
     }
 
-    unsigned long current_time = 0;  // Initialize the current time
-    unsigned long total_waiting_time = 0;  // Initialize the total waiting time
+    const ScheduleCostModel_t *costs = &ctx->config->costs;
+    uint32_t overhead = 0;
+    if (ctx->last_pid != NO_PID)
+    {
+        INSTRUMENT_ADD(context_switches, 1);
+        ++ctx->stats.context_switches;
+        overhead += costs->switch_cost;
+        ctx->stats.switch_overhead += costs->switch_cost;
+    }
+    const uint32_t refill = sim_refill_cost(costs, job, ctx->clock);
+    overhead += refill;
+    ctx->stats.refill_overhead += refill;
 
-    // Process each PCB in the ready queue
-    while (dyn_array_size(ready_queue) > 0) {
-        // Get the PCB at the front of the queue
-        ProcessControlBlock_t *pcb = dyn_array_front(ready_queue);
+    ctx->last_pid = job->pid;
+    ctx->clock += overhead;
+    return overhead != 0;
+}
 
-        // Increment the current time by the minimum of quantum and remaining burst time
-        unsigned int time_slice = fmin(quantum, pcb->remaining_burst_time);
-        current_time += time_slice;
+// Runs job on the virtual cpu for slice ticks starting at the current clock
+static void sim_run(SimContext_t *ctx, SimJob_t *job, uint32_t slice)
+{
+    job->pcb->started = true;
+    virtual_cpu(job->pcb, slice);
+    INSTRUMENT_SLICE(job->pid, ctx->clock, slice);
+    if (ctx->config->timeline)
+    {
+        timeline_record(ctx->config->timeline, job->pid, ctx->clock, slice);
+    }
+    ctx->clock += slice;
+    ctx->stats.cpu_busy += slice;
+    if (ctx->shares)
+    {
+        ((ScheduleShare_t *) dyn_array_at(ctx->shares, job->tenant))->received += slice;
+        ctx->share_time += (double) slice / ctx->runnable_tickets;
+    }
+    job->last_ran = ctx->clock;
+    job->ran = true;
+}
 
-        // Update the remaining burst time for the current PCB
-        pcb->remaining_burst_time -= time_slice;
+// Handles a job whose CPU phase just ran out: off to I/O if it has more phases, done otherwise
+static void sim_phase_done(SimContext_t *ctx, SimJob_t *job)
+{
+    if (ctx->shares)
+    {
+        // it stops being runnable: settle what its tickets were owed since it joined
+        ScheduleShare_t *share = dyn_array_at(ctx->shares, job->tenant);
+        share->entitled += (ctx->share_time - job->joined) * job->tickets;
+        ctx->runnable_tickets -= job->tickets;
+    }
+    if (job->phase + 1 < job->phase_count)
+    {
+        sim_block(ctx, job);
+        return;
+    }
 
-        // If the PCB has completed its execution, calculate waiting time
-        if (pcb->remaining_burst_time == 0) {
-            total_waiting_time += (current_time - pcb->arrival - pcb->remaining_burst_time);
+    const unsigned long turnaround = ctx->clock - job->pcb->arrival;
+    ctx->total_turnaround_time += turnaround;
+    ctx->total_waiting_time += turnaround - job->burst - job->blocked;
 
-            // Remove the completed PCB from the ready queue
-            dyn_array_pop_front(ready_queue);
+    if (job->deadline != UINT64_MAX)
+    {
+        ScheduleDeadlineStats_t *stats = &ctx->deadline_stats;
+        ++stats->jobs;
+        uint64_t lateness = ctx->clock > job->deadline ? ctx->clock - job->deadline : 0;
+        if (lateness)
+        {
+            ++stats->misses;
+            stats->total_lateness += lateness;
+            stats->max_lateness = lateness > stats->max_lateness ? lateness : stats->max_lateness;
+        }
+        size_t bucket = 0;
+        for (; lateness && bucket + 1 < SCHEDULE_LATENESS_BUCKETS; lateness >>= 1)
+        {
+            ++bucket;
+        }
+        ++stats->lateness[bucket];
+    }
+}
+
+static void sim_finish(SimContext_t *ctx, ScheduleResult_t *result)
+{
+    // PCBs turned away by admission control never ran, they have no waiting or turnaround time
+    const size_t n = dyn_array_size(ctx->jobs) - ctx->deadline_stats.rejected;
+    result->average_waiting_time = n ? (float) ctx->total_waiting_time / n : 0;
+    result->average_turnaround_time = n ? (float) ctx->total_turnaround_time / n : 0;
+    result->total_run_time = ctx->clock;
+    if (ctx->config->stats)
+    {
+        *ctx->config->stats = ctx->stats;
+    }
+    if (ctx->config->deadline_stats)
+    {
+        *ctx->config->deadline_stats = ctx->deadline_stats;
+    }
+    sim_destroy(ctx);
+}
+
+// Single CPU simulation shared by the key based policies.
+// Non-preemptive policies run the selected job to the end of its CPU phase, preemptive
+// ones reconsider whenever a job arrives or comes back from I/O.
+// The ready queue is kept in admission order while it is scanned, so taking the first
+// minimum breaks ties first come first served; the heap breaks them on sequence, the same order
+static void simulate(SimContext_t *ctx, bool preemptive)
+{
+    while (sim_pending(ctx))
+    {
+        sim_admit(ctx);
+        if (dyn_array_empty(ctx->ready))
+        {
+            // idle until the next arrival or I/O completion
+            ctx->clock = sim_next_event(ctx);
+            continue;
+        }
+
+        // a heap job is taken out while it runs so arrivals cannot move it, a scanned one stays put
+        sim_ready_shape(ctx);
+        SimJob_t popped;
+        size_t pick = 0;
+        SimJob_t *job;
+        if (ctx->heap)
+        {
+            sim_heap_pop(ctx, &popped);
+            job = &popped;
+        }
+        else
+        {
+            if (ctx->key != KEY_ARRIVAL)
+            {
+                pick = simd_argmin_u32(dyn_array_export(ctx->keys), dyn_array_size(ctx->keys));
+                INSTRUMENT_ADD(comparator_calls, dyn_array_size(ctx->keys) - 1);
+            }
+            job = dyn_array_at(ctx->ready, pick);
+        }
+        INSTRUMENT_ADD(queue_ops, ctx->heap);
+
+        if (sim_dispatch(ctx, job))
+        {
+            // the switch is committed, whatever arrived while paying for it waits its turn
+            sim_admit(ctx);
+            job = ctx->heap ? &popped : dyn_array_at(ctx->ready, pick);
+        }
+        uint32_t slice = job->pcb->remaining_burst_time;
+        if (preemptive)
+        {
+            const unsigned long until_event = sim_next_event(ctx) - ctx->clock;
+            if (until_event < slice)
+            {
+                slice = (uint32_t) until_event;
+            }
+        }
+
+        sim_run(ctx, job, slice);
+        if (job->pcb->remaining_burst_time == 0)
+        {
+            SimJob_t done = *job;
+            if (!ctx->heap)
+            {
+                dyn_array_erase(ctx->ready, pick);
+                if (ctx->key != KEY_ARRIVAL)
+                {
+                    dyn_array_erase(ctx->keys, pick);
+                }
+                INSTRUMENT_ADD(queue_ops, 1);
+            }
+            sim_phase_done(ctx, &done);
+        }
+        else if (ctx->heap)
+        {
+            sim_ready_insert(ctx, job);
+        }
+        else if (ctx->key == KEY_REMAINING)
+        {
+            *(uint32_t *) dyn_array_at(ctx->keys, pick) = job->pcb->remaining_burst_time;
+        }
+    }
+}
+
+
+
+void schedule_config_init(ScheduleConfig_t *config, SchedulePolicy_t policy)
+{
+    if (config)
+    {
+        memset(config, 0, sizeof(*config));
+        config->policy = policy;
+        config->quantum = 1;
+    }
+}
+
+// Command line names, indexed by SchedulePolicy_t
+static const char *const policy_names[] = {"FCFS", "SJF", "P", "RR", "SRT", "EDF", "STRIDE", "LOTTERY", "GROUP"};
+
+bool schedule_policy_from_name(const char *name, SchedulePolicy_t *policy)
+{
+    if (!name || !policy)
+    {
+        return false;
+    }
+    for (size_t i = 0; i < sizeof(policy_names) / sizeof(policy_names[0]); ++i)
+    {
+        if (strcmp(name, policy_names[i]) == 0)
+        {
+            *policy = (SchedulePolicy_t) i;
+            return true;
+        }
+    }
+    return false;
+}
+
+const char *schedule_policy_name(SchedulePolicy_t policy)
+{
+    if ((size_t) policy < sizeof(policy_names) / sizeof(policy_names[0]))
+    {
+        return policy_names[policy];
+    }
+    return NULL;
+}
+
+static void simulate_round_robin(SimContext_t *ctx)
+{
+    const size_t quantum = ctx->config->quantum;
+    SimJob_t job;
+
+    while (sim_pending(ctx)) {
+        sim_admit(ctx);
+        if (dyn_array_empty(ctx->ready)) {
+            // idle until the next arrival or I/O completion
+            ctx->clock = sim_next_event(ctx);
+            continue;
+        }
+
+        // Take the PCB at the front of the queue and give it at most one quantum
+        dyn_array_extract_front(ctx->ready, &job);
+        INSTRUMENT_ADD(queue_ops, 1);
+        if (sim_dispatch(ctx, &job)) {
+            sim_admit(ctx);
+        }
+        const uint32_t slice = job.pcb->remaining_burst_time < quantum ? job.pcb->remaining_burst_time : (uint32_t) quantum;
+        sim_run(ctx, &job, slice);
+
+        // Anything that arrived during the slice queues up ahead of the preempted PCB
+        sim_admit(ctx);
+        if (job.pcb->remaining_burst_time == 0) {
+            sim_phase_done(ctx, &job);
         } else {
-            // Move the PCB to the back of the ready queue
-            dyn_array_pop_front(ready_queue);
-            dyn_array_push_back(ready_queue, pcb);
+            dyn_array_push_back(ctx->ready, &job);
+            INSTRUMENT_ADD(queue_ops, 1);
         }
     }
+}
 
-    // Calculate the average waiting time and turnaround time
-    result->average_waiting_time = (float)total_waiting_time / dyn_array_size(ready_queue);
-    result->average_turnaround_time = result->average_waiting_time + quantum;
-    result->total_run_time = current_time;
+// Proportional share: the picked job runs for at most one quantum, then goes back to compete.
+// Stride picks the smallest pass off the heap and charges the slice to it in proportion to the
+// job's stride, lottery draws from the ticket bag
+static void simulate_proportional(SimContext_t *ctx)
+{
+    const size_t quantum = ctx->config->quantum;
+    SimJob_t job;
 
-    return true;
+    while (sim_pending(ctx))
+    {
+        sim_admit(ctx);
+        if (dyn_array_empty(ctx->ready))
+        {
+            // idle until the next arrival or I/O completion
+            ctx->clock = sim_next_event(ctx);
+            continue;
+        }
+
+        if (ctx->key == KEY_PASS)
+        {
+            sim_heap_pop(ctx, &job);
+            ctx->global_pass = job.pass;
+        }
+        else
+        {
+            sim_lottery_draw(ctx, &job);
+        }
+        INSTRUMENT_ADD(queue_ops, 1);
+        if (sim_dispatch(ctx, &job))
+        {
+            sim_admit(ctx);
+        }
+        const uint32_t slice = job.pcb->remaining_burst_time < quantum ? job.pcb->remaining_burst_time : (uint32_t) quantum;
+        sim_run(ctx, &job, slice);
+        job.pass += slice * sim_stride(job.tickets);
+
+        sim_admit(ctx);
+        if (job.pcb->remaining_burst_time == 0)
+        {
+            sim_phase_done(ctx, &job);
+        }
+        else
+        {
+            sim_ready_insert(ctx, &job);
+            INSTRUMENT_ADD(queue_ops, 1);
+        }
+    }
 }
 
-dyn_array_t *load_process_control_blocks(const char *input_file) 
+static inline bool sim_group_before(const SimGroupEntry_t *a, const SimGroupEntry_t *b)
 {
-    //Error handling to ensure file is present
-    if (!input_file) {
-        return NULL;
+    return a->key < b->key || (a->key == b->key && a->sequence < b->sequence);
+}
+
+// Queues a runnable child on a group node, keyed by the node's policy
+static void sim_group_push(SimContext_t *ctx, SimGroup_t *group, uint64_t vruntime, uint32_t id, bool is_group)
+{
+    SimGroupEntry_t entry = {group->policy == GROUP_FAIR ? vruntime : 0, ctx->group_sequence++, id, is_group};
+    dyn_array_push_back(group->queue, &entry);
+    SimGroupEntry_t *heap = dyn_array_front(group->queue);
+    size_t index = dyn_array_size(group->queue) - 1;
+    while (index)
+    {
+        const size_t parent = (index - 1) / 2;
+        if (!sim_group_before(&entry, &heap[parent]))
+        {
+            break;
+        }
+        heap[index] = heap[parent];
+        index = parent;
     }
+    heap[index] = entry;
+}
 
-    //Error handling for empty files
-    FILE *file = fopen(input_file, "rb");
-    if (!file) {
-        return NULL;
+// Takes a group node's next child off its heap
+static SimGroupEntry_t sim_group_pop(SimGroup_t *group)
+{
+    SimGroupEntry_t *heap = dyn_array_front(group->queue);
+    const SimGroupEntry_t top = heap[0];
+    SimGroupEntry_t moving;
+    dyn_array_extract_back(group->queue, &moving);
+    const size_t n = dyn_array_size(group->queue);
+    if (n)
+    {
+        size_t index = 0;
+        for (size_t child = 1; child < n; child = 2 * index + 1)
+        {
+            child += child + 1 < n && sim_group_before(&heap[child + 1], &heap[child]);
+            if (!sim_group_before(&heap[child], &moving))
+            {
+                break;
+            }
+            heap[index] = heap[child];
+            index = child;
+        }
+        heap[index] = moving;
     }
+    if (group->policy == GROUP_FAIR)
+    {
+        group->min_vruntime = top.key;
+    }
+    return top;
+}
 
-    dyn_array_t *pcb_array = dyn_array_create(0, sizeof(ProcessControlBlock_t), NULL);
-    if (!pcb_array) {
-        fclose(file);
-        return NULL;
+// Moves the jobs sim_admit queued into the group tree. A child that becomes runnable starts no
+// further behind than its node's latest pick, so time spent idle is not banked
+static void sim_group_drain(SimContext_t *ctx)
+{
+    const size_t n = dyn_array_size(ctx->ready);
+    for (size_t i = 0; i < n; ++i)
+    {
+        const SimJob_t *ready = dyn_array_at(ctx->ready, i);
+        SimJob_t *job = dyn_array_at(ctx->group_jobs, ready->pid);
+        *job = *ready;
+        uint32_t id = *(const uint32_t *) dyn_array_at(ctx->config->group_of, job->pid);
+        SimGroup_t *group = dyn_array_at(ctx->groups, id);
+        job->pass = job->pass > group->min_vruntime ? job->pass : group->min_vruntime;
+        sim_group_push(ctx, group, job->pass, job->pid, false);
+        // every node above counts it; those that had nothing runnable join their parents
+        for (; id != UINT32_MAX; id = group->parent)
+        {
+            group = dyn_array_at(ctx->groups, id);
+            if (group->runnable++ == 0 && group->parent != UINT32_MAX)
+            {
+                SimGroup_t *parent = dyn_array_at(ctx->groups, group->parent);
+                group->vruntime = group->vruntime > parent->min_vruntime ? group->vruntime : parent->min_vruntime;
+                sim_group_push(ctx, parent, group->vruntime, id, true);
+            }
+        }
     }
+    dyn_array_clear(ctx->ready);
+}
 
-    ProcessControlBlock_t pcb;
-    size_t read_size;
+// Walks down from the root, taking every node's pick off its heap, to the job that runs next
+static SimJob_t *sim_group_pick(SimContext_t *ctx)
+{
+    dyn_array_clear(ctx->group_path);
+    SimGroupEntry_t entry = sim_group_pop(dyn_array_front(ctx->groups));
+    while (entry.group)
+    {
+        dyn_array_push_back(ctx->group_path, &entry.id);
+        entry = sim_group_pop(dyn_array_at(ctx->groups, entry.id));
+    }
+    return dyn_array_at(ctx->group_jobs, entry.id);
+}
 
-    while ((read_size = fread(&pcb, sizeof(ProcessControlBlock_t), 1, file)) > 0) { //Reads one line at a time
-        dyn_array_push_back(pcb_array, &pcb);
+// Charges a slice to the job and the groups the pick went through, then puts what is still
+// runnable back on the heaps from the bottom up
+static void sim_group_requeue(SimContext_t *ctx, SimJob_t *job, uint32_t slice, bool runnable)
+{
+    const uint32_t leaf = *(const uint32_t *) dyn_array_at(ctx->config->group_of, job->pid);
+    job->pass += slice * sim_stride(job->tickets);
+    if (runnable)
+    {
+        sim_group_push(ctx, dyn_array_at(ctx->groups, leaf), job->pass, job->pid, false);
+    }
+    else
+    {
+        for (uint32_t id = leaf; id != UINT32_MAX;)
+        {
+            SimGroup_t *group = dyn_array_at(ctx->groups, id);
+            --group->runnable;
+            id = group->parent;
+        }
     }
+    for (size_t i = dyn_array_size(ctx->group_path); i-- > 0;)
+    {
+        const uint32_t id = *(const uint32_t *) dyn_array_at(ctx->group_path, i);
+        SimGroup_t *group = dyn_array_at(ctx->groups, id);
+        group->vruntime += slice * group->stride;
+        if (group->runnable)
+        {
+            sim_group_push(ctx, dyn_array_at(ctx->groups, group->parent), group->vruntime, id, true);
+        }
+    }
+}
 
-    fclose(file);
+// Hierarchical group scheduling: jobs leave the ready queue for the group tree as soon as they
+// are admitted, and each pick runs one quantum of the job the tree's policies lead to
+static void simulate_groups(SimContext_t *ctx)
+{
+    const size_t quantum = ctx->config->quantum;
+    const SimGroup_t *root = dyn_array_front(ctx->groups);
 
-    return pcb_array;
+    while (sim_pending(ctx) || root->runnable)
+    {
+        sim_admit(ctx);
+        sim_group_drain(ctx);
+        if (!root->runnable)
+        {
+            // idle until the next arrival or I/O completion
+            ctx->clock = sim_next_event(ctx);
+            continue;
+        }
+
+        SimJob_t *job = sim_group_pick(ctx);
+        INSTRUMENT_ADD(queue_ops, dyn_array_size(ctx->group_path) + 1);
+        if (sim_dispatch(ctx, job))
+        {
+            sim_admit(ctx);
+            sim_group_drain(ctx);
+        }
+        const uint32_t slice = job->pcb->remaining_burst_time < quantum ? job->pcb->remaining_burst_time : (uint32_t) quantum;
+        sim_run(ctx, job, slice);
+
+        // arrivals join first, so the nodes on the pick's path still count the running job
+        sim_admit(ctx);
+        sim_group_drain(ctx);
+        const bool done = job->pcb->remaining_burst_time == 0;
+        sim_group_requeue(ctx, job, slice, !done);
+        if (done)
+        {
+            sim_phase_done(ctx, job);
+        }
+    }
 }
 
+// Runs the policy the context's config selects until every job is done
+static void sim_policy(SimContext_t *ctx)
+{
+    switch (ctx->config->policy)
+    {
+        case SCHEDULE_FCFS:
+        case SCHEDULE_SJF:
+        case SCHEDULE_PRIORITY:
+            simulate(ctx, false);
+            break;
+        case SCHEDULE_RR:
+            simulate_round_robin(ctx);
+            break;
+        case SCHEDULE_SRTF:
+        case SCHEDULE_EDF:
+            simulate(ctx, true);
+            break;
+        case SCHEDULE_STRIDE:
+        case SCHEDULE_LOTTERY:
+            simulate_proportional(ctx);
+            break;
+        case SCHEDULE_GROUP:
+            simulate_groups(ctx);
+            break;
+    }
+}
+
+// Whether config names a policy this engine runs (the time sliced ones need a quantum)
+static bool sim_policy_valid(const ScheduleConfig_t *config)
+{
+    return config && (size_t) config->policy < sizeof(policy_names) / sizeof(policy_names[0])
+           && (config->quantum || (config->policy != SCHEDULE_RR && config->policy != SCHEDULE_STRIDE
+                                   && config->policy != SCHEDULE_LOTTERY && config->policy != SCHEDULE_GROUP))
+           && (config->policy != SCHEDULE_GROUP || config->groups);
+}
 
-bool shortest_remaining_time_first(dyn_array_t *ready_queue, ScheduleResult_t *result) 
+uint64_t schedule_policy_key(SchedulePolicy_t policy, const ProcessControlBlock_t *pcb, uint64_t sequence)
 {
-    if (!ready_queue || !result) {
+    switch (policy)
+    {
+        case SCHEDULE_SJF:
+        case SCHEDULE_SRTF:
+            return pcb->remaining_burst_time;
+        case SCHEDULE_PRIORITY:
+            return pcb->priority;
+        default:
+            return sequence;
+    }
+}
+
+bool schedule_run(dyn_array_t *ready_queue, ScheduleResult_t *result, const ScheduleConfig_t *config)
+{
+    if (config && config->topology)
+    {
+        return multi_cpu_run(ready_queue, result, config);
+    }
+    SimContext_t ctx;
+    if (!sim_policy_valid(config) || !sim_init(&ctx, ready_queue, result, config))
+    {
         return false;
     }
+    sim_policy(&ctx);
+    sim_finish(&ctx, result);
+    return true;
+}
 
-    unsigned long current_time = 0;
-    unsigned long total_waiting_time = 0;
+// Whole busy periods of a parallel run: their jobs and, once simulated, their totals
+typedef struct
+{
+    size_t first;                   // first job of the period in arrival order
+    size_t count;
+    uint64_t total_waiting_time;
+    uint64_t total_turnaround_time;
+    unsigned long clock;            // when its last job finished
+    ScheduleStats_t stats;
+    ScheduleDeadlineStats_t deadline_stats;
+    Timeline_t *timeline;           // its own slices, when the run records a timeline
+    bool ok;
+}
+SimSegment_t;
 
-    while (dyn_array_size(ready_queue) > 0) {
-        // Find the PCB with the shortest remaining burst time
-        ProcessControlBlock_t *shortest_pcb = dyn_array_at(ready_queue, 0);
+// What every busy period of a parallel run shares
+typedef struct
+{
+    const dyn_array_t *jobs;        // SimJob_t of the whole run in arrival order
+    const ScheduleConfig_t *config;
+}
+SimSegmentRun_t;
 
-        for (size_t i = 1; i < dyn_array_size(ready_queue); ++i) {
-            ProcessControlBlock_t *pcb = dyn_array_at(ready_queue, i);
-            if (pcb->remaining_burst_time < shortest_pcb->remaining_burst_time) {
-                shortest_pcb = pcb;
+// dyn_array_parallel_for_each_grain callback: simulates one segment on its own
+static void sim_segment(void *const object, void *arg)
+{
+    SimSegment_t *segment = (SimSegment_t *) object;
+    const SimSegmentRun_t *run = (const SimSegmentRun_t *) arg;
+
+    ScheduleConfig_t config = *run->config;
+    config.timeline = segment->timeline;
+    config.stats = NULL;
+    config.deadline_stats = NULL;
+    SimContext_t ctx;
+    memset(&ctx, 0, sizeof(ctx));
+    if (!sim_queues_init(&ctx, &config, segment->count))
+    {
+        return;
+    }
+    dyn_array_append_n(ctx.jobs, dyn_array_at(run->jobs, segment->first), segment->count);
+    sim_policy(&ctx);
+
+    segment->total_waiting_time = ctx.total_waiting_time;
+    segment->total_turnaround_time = ctx.total_turnaround_time;
+    segment->clock = ctx.clock;
+    segment->stats = ctx.stats;
+    segment->deadline_stats = ctx.deadline_stats;
+    segment->ok = true;
+    sim_destroy(&ctx);
+}
+
+// Cuts the jobs (in arrival order) into segments at the ends of busy periods: the points where the
+// CPU would go idle before the next arrival. Without switch costs or I/O the CPU is busy exactly
+// while any work is left, whatever the policy, so clock = max(clock, arrival) + burst finds them
+static bool sim_busy_periods(const dyn_array_t *jobs, dyn_array_t *segments, bool with_timelines)
+{
+    uint64_t clock = 0;
+    SimSegment_t *current = NULL;
+    const size_t n = dyn_array_size(jobs);
+    for (size_t i = 0; i < n; ++i)
+    {
+        const SimJob_t *job = dyn_array_at(jobs, i);
+        if (!current || (job->pcb->arrival > clock && current->count >= SIM_SEGMENT_JOBS))
+        {
+            SimSegment_t segment;
+            memset(&segment, 0, sizeof(segment));
+            segment.first = i;
+            segment.timeline = with_timelines ? timeline_create() : NULL;
+            if ((with_timelines && !segment.timeline) || !dyn_array_push_back(segments, &segment))
+            {
+                timeline_destroy(segment.timeline);
+                return false;
             }
+            current = dyn_array_back(segments);
         }
+        ++current->count;
+        clock = (job->pcb->arrival > clock ? job->pcb->arrival : clock) + job->burst;
+    }
+    return true;
+}
 
-        // Execute the PCB
-        current_time += shortest_pcb->remaining_burst_time;
-        total_waiting_time += current_time - shortest_pcb->arrival - shortest_pcb->remaining_burst_time;
+bool schedule_run_parallel(dyn_array_t *ready_queue, ScheduleResult_t *result, const ScheduleConfig_t *config,
+                           size_t threads)
+{
+    if (!sim_policy_valid(config))
+    {
+        return false;
+    }
+    if (config->bursts || config->costs.switch_cost || config->costs.refill_max || config->admission
+        || config->shares || config->policy == SCHEDULE_STRIDE || config->policy == SCHEDULE_LOTTERY
+        || config->policy == SCHEDULE_GROUP || config->topology)
+    {
+        // switch costs and I/O make the busy periods depend on the policy, turned away PCBs
+        // leave gaps the pre-pass cannot see, and passes, draws, shares and placements carry
+        // across periods, so those run in one piece
+        return schedule_run(ready_queue, result, config);
+    }
 
-        // Remove the completed PCB from the ready queue
-        dyn_array_erase(ready_queue, 0);
+    SimContext_t ctx;
+    if (!sim_init(&ctx, ready_queue, result, config))
+    {
+        return false;
+    }
+    dyn_array_t *segments = dyn_array_create(0, sizeof(SimSegment_t), NULL);
+    SimSegmentRun_t run = {ctx.jobs, config};
+    bool ok = segments && sim_busy_periods(ctx.jobs, segments, config->timeline != NULL)
+              && dyn_array_parallel_for_each_grain(segments, sim_segment, &run, threads, 1);
 
-        // Update the result values
-        result->average_waiting_time = (float)total_waiting_time / dyn_array_size(ready_queue);
-        result->average_turnaround_time = result->average_waiting_time + shortest_pcb->remaining_burst_time;
-        result->total_run_time = current_time;
+    // totals are integers, so adding them up in any order gives exactly the serial run's
+    const size_t count = segments ? dyn_array_size(segments) : 0;
+    for (size_t i = 0; i < count; ++i)
+    {
+        SimSegment_t *segment = dyn_array_at(segments, i);
+        ok = ok && segment->ok;
+        if (ok)
+        {
+            ctx.total_waiting_time += segment->total_waiting_time;
+            ctx.total_turnaround_time += segment->total_turnaround_time;
+            ctx.clock = segment->clock;
+            ctx.stats.context_switches += segment->stats.context_switches;
+            ctx.stats.cpu_busy += segment->stats.cpu_busy;
+            const ScheduleDeadlineStats_t *deadlines = &segment->deadline_stats;
+            ctx.deadline_stats.jobs += deadlines->jobs;
+            ctx.deadline_stats.misses += deadlines->misses;
+            ctx.deadline_stats.total_lateness += deadlines->total_lateness;
+            if (deadlines->max_lateness > ctx.deadline_stats.max_lateness)
+            {
+                ctx.deadline_stats.max_lateness = deadlines->max_lateness;
+            }
+            for (size_t b = 0; b < SCHEDULE_LATENESS_BUCKETS; ++b)
+            {
+                ctx.deadline_stats.lateness[b] += deadlines->lateness[b];
+            }
+            for (size_t s = 0; ok && s < timeline_size(segment->timeline); ++s)
+            {
+                const TimelineSegment_t *slice = timeline_at(segment->timeline, s);
+                ok = timeline_record(config->timeline, slice->pid, slice->start, slice->length);
+            }
+        }
+        timeline_destroy(segment->timeline);
+    }
+    dyn_array_destroy(segments);
+    if (!ok)
+    {
+        sim_destroy(&ctx);
+        return false;
     }
 
+    // each segment after the first opens with a switch away from the last PCB of the one before
+    ctx.stats.context_switches += count - 1;
+    sim_finish(&ctx, result);
     return true;
 }
 
+double schedule_share_error(const dyn_array_t *shares)
+{
+    if (!shares || dyn_array_data_size(shares) != sizeof(ScheduleShare_t))
+    {
+        return 0;
+    }
+    double error = 0, entitled = 0;
+    for (size_t i = 0; i < dyn_array_size(shares); ++i)
+    {
+        const ScheduleShare_t *share = dyn_array_at(shares, i);
+        error += fabs((double) share->received - share->entitled);
+        entitled += share->entitled;
+    }
+    return entitled > 0 ? error / entitled : 0;
+}
+
+bool first_come_first_serve(dyn_array_t *ready_queue, ScheduleResult_t *result)
+{
+    ScheduleConfig_t config;
+    schedule_config_init(&config, SCHEDULE_FCFS);
+    return schedule_run(ready_queue, result, &config);
+}
+
+bool shortest_job_first(dyn_array_t *ready_queue, ScheduleResult_t *result)
+{
+    ScheduleConfig_t config;
+    schedule_config_init(&config, SCHEDULE_SJF);
+    return schedule_run(ready_queue, result, &config);
+}
+
+bool priority(dyn_array_t *ready_queue, ScheduleResult_t *result)
+{
+    ScheduleConfig_t config;
+    schedule_config_init(&config, SCHEDULE_PRIORITY);
+    return schedule_run(ready_queue, result, &config);
+}
+
+bool round_robin(dyn_array_t *ready_queue, ScheduleResult_t *result, size_t quantum)
+{
+    ScheduleConfig_t config;
+    schedule_config_init(&config, SCHEDULE_RR);
+    config.quantum = quantum;
+    return schedule_run(ready_queue, result, &config);
+}
+
+bool shortest_remaining_time_first(dyn_array_t *ready_queue, ScheduleResult_t *result)
+{
+    ScheduleConfig_t config;
+    schedule_config_init(&config, SCHEDULE_SRTF);
+    return schedule_run(ready_queue, result, &config);
+}
+
+dyn_array_t *load_process_control_blocks(const char *input_file)
+{
+    //Error handling to ensure file is present
+    if (!input_file) {
+        return NULL;
+    }
 
+    //Error handling for empty files
+    FILE *file = fopen(input_file, "rb");
+    if (!file) {
+        return NULL;
+    }
+
+    // Size the array from the file length so a whole trace is one allocation and one fread.
+    // The extra slot sees end of file in that same read; unseekable input grows as it goes
+    size_t chunk = 256;
+    if (fseek(file, 0, SEEK_END) == 0) {
+        const long length = ftell(file);
+        chunk = (length > 0 ? (size_t) length / sizeof(ProcessControlBlock_t) : 0) + 1;
+        rewind(file);
+    }
+
+    dyn_array_t *pcb_array = dyn_array_create(chunk, sizeof(ProcessControlBlock_t), NULL);
+    size_t count = 0;
+    size_t read_count;
+    do {
+        if (!dyn_array_resize(pcb_array, count + chunk, NULL)) {
+            dyn_array_destroy(pcb_array);
+            fclose(file);
+            return NULL;
+        }
+        read_count = fread(dyn_array_at(pcb_array, count), sizeof(ProcessControlBlock_t), chunk, file);
+        count += read_count;
+        chunk = count;
+    } while (read_count && count == dyn_array_size(pcb_array));
+    dyn_array_resize(pcb_array, count, NULL);
+
+    fclose(file);
+
+    return pcb_array;
+}
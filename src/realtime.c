@@ -0,0 +1,233 @@
+#include <math.h>
+#include <stdio.h>
+
+#include "processing_scheduling.h"
+#include "realtime.h"
+
+// Ticks the demand bound walk may reach before it gives up
+#define REALTIME_HORIZON ((uint64_t) 1 << 63)
+
+// A task's next absolute deadline, an entry of the demand bound walk's heap
+typedef struct
+{
+    uint64_t deadline;
+    const RealtimeTask_t *task;
+}
+RealtimeDeadline_t;
+
+static inline uint64_t task_deadline(const RealtimeTask_t *task)
+{
+    return task->deadline ? task->deadline : task->period;
+}
+
+// Whether every task in the array is usable
+static bool tasks_valid(const dyn_array_t *tasks)
+{
+    if (!tasks || dyn_array_data_size(tasks) != sizeof(RealtimeTask_t))
+    {
+        return false;
+    }
+    for (size_t i = 0; i < dyn_array_size(tasks); ++i)
+    {
+        if (!((const RealtimeTask_t *) dyn_array_at(tasks, i))->period)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool realtime_utilisation_test(const dyn_array_t *tasks, double *utilisation)
+{
+    if (!tasks_valid(tasks))
+    {
+        return false;
+    }
+    double sum = 0;
+    for (size_t i = 0; i < dyn_array_size(tasks); ++i)
+    {
+        const RealtimeTask_t *task = dyn_array_at(tasks, i);
+        sum += (double) task->wcet / task->period;
+    }
+    if (utilisation)
+    {
+        *utilisation = sum;
+    }
+    // the sum is rounded, so a set filling the CPU exactly may land a hair above 1
+    return sum <= 1.0 + 1e-9;
+}
+
+// Length of the synchronous busy period, the fixed point of w = sum ceil(w / T) C
+// \return false if it runs past the horizon
+static bool busy_period(const dyn_array_t *tasks, uint64_t *length)
+{
+    uint64_t w = 0;
+    for (size_t i = 0; i < dyn_array_size(tasks); ++i)
+    {
+        w += ((const RealtimeTask_t *) dyn_array_at(tasks, i))->wcet;
+    }
+    for (;;)
+    {
+        uint64_t next = 0;
+        for (size_t i = 0; i < dyn_array_size(tasks); ++i)
+        {
+            const RealtimeTask_t *task = dyn_array_at(tasks, i);
+            next += (w + task->period - 1) / task->period * task->wcet;
+            if (next >= REALTIME_HORIZON)
+            {
+                return false;
+            }
+        }
+        if (next == w)
+        {
+            *length = w;
+            return true;
+        }
+        w = next;
+    }
+}
+
+static inline void deadline_sift_down(RealtimeDeadline_t *heap, size_t n, size_t index)
+{
+    const RealtimeDeadline_t moving = heap[index];
+    for (size_t child = 2 * index + 1; child < n; child = 2 * index + 1)
+    {
+        child += child + 1 < n && heap[child + 1].deadline < heap[child].deadline;
+        if (heap[child].deadline >= moving.deadline)
+        {
+            break;
+        }
+        heap[index] = heap[child];
+        index = child;
+    }
+    heap[index] = moving;
+}
+
+bool realtime_demand_bound_test(const dyn_array_t *tasks, bool *schedulable)
+{
+    double utilisation;
+    if (!schedulable || !tasks_valid(tasks))
+    {
+        return false;
+    }
+    if (!realtime_utilisation_test(tasks, &utilisation))
+    {
+        *schedulable = false;
+        return true;
+    }
+    const size_t n = dyn_array_size(tasks);
+    uint64_t bound;
+    if (!n || !busy_period(tasks, &bound))
+    {
+        *schedulable = true;
+        return n == 0;
+    }
+    if (utilisation < 1.0)
+    {
+        // Baruah's bound: past max(D, sum (T - D) U / (1 - U)) the demand cannot catch up with t
+        double baruah = 0, longest = 0;
+        for (size_t i = 0; i < n; ++i)
+        {
+            const RealtimeTask_t *task = dyn_array_at(tasks, i);
+            const double deadline = (double) task_deadline(task);
+            baruah += (task->period - deadline) * task->wcet / task->period;
+            longest = deadline > longest ? deadline : longest;
+        }
+        baruah /= 1.0 - utilisation;
+        baruah = ceil(baruah > longest ? baruah : longest);
+        if (baruah < (double) bound)
+        {
+            bound = (uint64_t) baruah;
+        }
+    }
+
+    dyn_array_t *heap_array = dyn_array_create(n, sizeof(RealtimeDeadline_t), NULL);
+    if (!heap_array || !dyn_array_resize(heap_array, n, NULL))
+    {
+        dyn_array_destroy(heap_array);
+        return false;
+    }
+    RealtimeDeadline_t *heap = dyn_array_front(heap_array);
+    for (size_t i = 0; i < n; ++i)
+    {
+        heap[i].task = dyn_array_at(tasks, i);
+        heap[i].deadline = task_deadline(heap[i].task);
+    }
+    for (size_t i = n / 2; i-- > 0;)
+    {
+        deadline_sift_down(heap, n, i);
+    }
+
+    // every job due at or before t adds its wcet to the demand; the top is replaced by the
+    // task's following deadline, so each step is one sift
+    uint64_t demand = 0;
+    *schedulable = true;
+    while (heap[0].deadline <= bound)
+    {
+        demand += heap[0].task->wcet;
+        if (demand > heap[0].deadline)
+        {
+            *schedulable = false;
+            break;
+        }
+        heap[0].deadline += heap[0].task->period;
+        deadline_sift_down(heap, n, 0);
+    }
+    dyn_array_destroy(heap_array);
+    return true;
+}
+
+dyn_array_t *realtime_periodic_tasks(const dyn_array_t *pcbs, const dyn_array_t *deadlines)
+{
+    if (!pcbs || !deadlines || dyn_array_data_size(deadlines) != sizeof(PcbDeadline_t)
+        || dyn_array_size(deadlines) < dyn_array_size(pcbs))
+    {
+        return NULL;
+    }
+    dyn_array_t *tasks = dyn_array_create(0, sizeof(RealtimeTask_t), NULL);
+    for (size_t i = 0; tasks && i < dyn_array_size(pcbs); ++i)
+    {
+        const PcbDeadline_t *deadline = dyn_array_at(deadlines, i);
+        if (deadline->period)
+        {
+            const ProcessControlBlock_t *pcb = dyn_array_at(pcbs, i);
+            const RealtimeTask_t task = {pcb->remaining_burst_time, deadline->deadline, deadline->period};
+            if (!dyn_array_push_back(tasks, &task))
+            {
+                dyn_array_destroy(tasks);
+                tasks = NULL;
+            }
+        }
+    }
+    return tasks;
+}
+
+dyn_array_t *realtime_load_deadlines(const char *input_file)
+{
+    if (!input_file)
+    {
+        return NULL;
+    }
+    FILE *file = fopen(input_file, "rb");
+    if (!file)
+    {
+        return NULL;
+    }
+
+    dyn_array_t *deadlines = NULL;
+    long length = -1;
+    if (fseek(file, 0, SEEK_END) == 0 && (length = ftell(file)) >= 0 && fseek(file, 0, SEEK_SET) == 0
+        && length % sizeof(PcbDeadline_t) == 0)
+    {
+        const size_t count = (size_t) length / sizeof(PcbDeadline_t);
+        deadlines = dyn_array_create(count, sizeof(PcbDeadline_t), NULL);
+        if (deadlines && (!dyn_array_resize(deadlines, count, NULL)
+                          || (count && fread(dyn_array_front(deadlines), sizeof(PcbDeadline_t), count, file) != count)))
+        {
+            dyn_array_destroy(deadlines);
+            deadlines = NULL;
+        }
+    }
+    fclose(file);
+    return deadlines;
+}
@@ -0,0 +1,531 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "dyn_array.h"
+#include "result_cache.h"
+
+#define HASH_PRIME_1 0x9E3779B185EBCA87ull
+#define HASH_PRIME_2 0xC2B2AE3D27D4EB4Full
+#define HASH_PRIME_3 0x165667B19E3779F9ull
+#define KEY_DIGITS 32
+#define ENTRY_SUFFIX ".res"
+#define READ_CHUNK 65536
+#define DIGEST_SUFFIX ".digest"
+
+struct result_cache
+{
+    char *path;
+    uint64_t max_bytes;
+};
+
+// Header of every entry file, followed by size bytes of payload
+typedef struct
+{
+    char magic[4];
+    uint32_t reserved;
+    uint64_t high;
+    uint64_t low;
+    uint64_t size;
+    uint64_t checksum;      // result_hasher over the payload
+}
+ResultEntryHeader_t;
+
+// An entry found while evicting
+typedef struct
+{
+    int64_t mtime;
+    uint64_t bytes;
+    char name[KEY_DIGITS + sizeof(ENTRY_SUFFIX)];
+}
+ResultEntry_t;
+
+// Contents of a "<file>.digest" sidecar: a file's digest and the identity it was taken of
+typedef struct
+{
+    char magic[4];
+    uint32_t reserved;
+    uint64_t size;
+    int64_t mtime;          // nanoseconds
+    uint64_t inode;
+    uint64_t high;
+    uint64_t low;
+}
+ResultDigest_t;
+
+static const char result_cache_magic[4] = {'R', 'C', '0', '1'};
+static const char result_digest_magic[4] = {'R', 'D', '0', '1'};
+
+static inline uint64_t rotate_left(uint64_t value, unsigned bits)
+{
+    return (value << bits) | (value >> (64 - bits));
+}
+
+static inline uint64_t mix_final(uint64_t value)
+{
+    value ^= value >> 33;
+    value *= HASH_PRIME_2;
+    value ^= value >> 29;
+    value *= HASH_PRIME_3;
+    return value ^ (value >> 32);
+}
+
+static inline uint64_t load_word(const uint8_t *bytes)
+{
+    uint64_t word = 0;
+    for (int i = 7; i >= 0; --i)
+    {
+        word = (word << 8) | bytes[i];
+    }
+    return word;
+}
+
+static inline void hash_word(ResultHasher_t *hasher, uint64_t word)
+{
+    hasher->lanes[0] = rotate_left(hasher->lanes[0] ^ (word * HASH_PRIME_2), 31) * HASH_PRIME_1;
+    hasher->lanes[1] = rotate_left(hasher->lanes[1] + (word * HASH_PRIME_3), 27) * HASH_PRIME_1 + hasher->lanes[0];
+}
+
+void result_hasher_init(ResultHasher_t *hasher)
+{
+    if (hasher)
+    {
+        hasher->lanes[0] = HASH_PRIME_1;
+        hasher->lanes[1] = HASH_PRIME_2;
+        hasher->length = 0;
+        memset(hasher->tail, 0, sizeof(hasher->tail));
+    }
+}
+
+void result_hasher_update(ResultHasher_t *hasher, const void *data, size_t size)
+{
+    if (!hasher || !data)
+    {
+        return;
+    }
+    const uint8_t *bytes = (const uint8_t *) data;
+    size_t pending = hasher->length % 8;
+    hasher->length += size;
+    if (pending)
+    {
+        const size_t take = size < 8 - pending ? size : 8 - pending;
+        memcpy(hasher->tail + pending, bytes, take);
+        bytes += take;
+        size -= take;
+        if (pending + take < 8)
+        {
+            return;
+        }
+        hash_word(hasher, load_word(hasher->tail));
+    }
+    for (; size >= 8; bytes += 8, size -= 8)
+    {
+        hash_word(hasher, load_word(bytes));
+    }
+    memcpy(hasher->tail, bytes, size);
+}
+
+void result_hasher_u64(ResultHasher_t *hasher, uint64_t value)
+{
+    uint8_t bytes[8];
+    for (int i = 0; i < 8; ++i, value >>= 8)
+    {
+        bytes[i] = (uint8_t) value;
+    }
+    result_hasher_update(hasher, bytes, sizeof(bytes));
+}
+
+// Hashes a file's contents on their own
+static bool file_digest(const char *path, uint64_t *bytes, ResultKey_t *key)
+{
+    FILE *file = path ? fopen(path, "rb") : NULL;
+    if (!file)
+    {
+        return false;
+    }
+    uint8_t *chunk = malloc(READ_CHUNK);
+    size_t count = 0;
+    ResultHasher_t contents;
+    result_hasher_init(&contents);
+    *bytes = 0;
+    while (chunk && (count = fread(chunk, 1, READ_CHUNK, file)) > 0)
+    {
+        result_hasher_update(&contents, chunk, count);
+        *bytes += count;
+    }
+    const bool read = chunk && !ferror(file);
+    free(chunk);
+    fclose(file);
+    *key = result_hasher_final(&contents);
+    return read;
+}
+
+// Feeds a digest taken by file_digest
+static void hash_digest(ResultHasher_t *hasher, uint64_t bytes, ResultKey_t key)
+{
+    // the size goes first so that a file's bytes never run into what is fed after it
+    result_hasher_u64(hasher, bytes);
+    result_hasher_u64(hasher, key.high);
+    result_hasher_u64(hasher, key.low);
+}
+
+bool result_hasher_file(ResultHasher_t *hasher, const char *path)
+{
+    uint64_t bytes;
+    ResultKey_t key;
+    if (!hasher || !file_digest(path, &bytes, &key))
+    {
+        return false;
+    }
+    hash_digest(hasher, bytes, key);
+    return true;
+}
+
+static bool same_file(const ResultDigest_t *digest, const struct stat *info)
+{
+    return digest->size == (uint64_t) info->st_size
+           && digest->mtime == (int64_t) info->st_mtim.tv_sec * 1000000000 + info->st_mtim.tv_nsec
+           && digest->inode == (uint64_t) info->st_ino;
+}
+
+// Stores a digest next to the file through a temporary name, so a reader never sees half of one
+static void digest_write(const char *digest_path, const ResultDigest_t *digest)
+{
+    const size_t length = strlen(digest_path);
+    char *temporary = malloc(length + 32);
+    if (!temporary)
+    {
+        return;
+    }
+    snprintf(temporary, length + 32, "%s.%ld.tmp", digest_path, (long) getpid());
+    FILE *file = fopen(temporary, "wb");
+    bool ok = file && fwrite(digest, sizeof(*digest), 1, file) == 1;
+    ok = file && fclose(file) == 0 && ok;
+    if (!ok || rename(temporary, digest_path) != 0)
+    {
+        remove(temporary);
+    }
+    free(temporary);
+}
+
+bool result_hasher_file_memo(ResultHasher_t *hasher, const char *path)
+{
+    struct stat info;
+    char *digest_path = hasher && path ? malloc(strlen(path) + sizeof(DIGEST_SUFFIX)) : NULL;
+    if (!digest_path || stat(path, &info) != 0)
+    {
+        free(digest_path);
+        return false;
+    }
+    strcpy(digest_path, path);
+    strcat(digest_path, DIGEST_SUFFIX);
+
+    ResultDigest_t digest;
+    FILE *file = fopen(digest_path, "rb");
+    const bool stored = file && fread(&digest, sizeof(digest), 1, file) == 1
+                        && memcmp(digest.magic, result_digest_magic, sizeof(digest.magic)) == 0
+                        && same_file(&digest, &info);
+    if (file)
+    {
+        fclose(file);
+    }
+    if (!stored)
+    {
+        ResultKey_t key;
+        if (!file_digest(path, &digest.size, &key))
+        {
+            free(digest_path);
+            return false;
+        }
+        memcpy(digest.magic, result_digest_magic, sizeof(digest.magic));
+        digest.reserved = 0;
+        digest.high = key.high;
+        digest.low = key.low;
+        // only a file that did not change while it was read is remembered; storing is an
+        // optimisation, a read-only directory just means hashing again next time
+        struct stat after;
+        digest.mtime = (int64_t) info.st_mtim.tv_sec * 1000000000 + info.st_mtim.tv_nsec;
+        digest.inode = (uint64_t) info.st_ino;
+        if (stat(path, &after) == 0 && same_file(&digest, &after))
+        {
+            digest_write(digest_path, &digest);
+        }
+    }
+    free(digest_path);
+    hash_digest(hasher, digest.size, (ResultKey_t){digest.high, digest.low});
+    return true;
+}
+
+ResultKey_t result_hasher_final(const ResultHasher_t *hasher)
+{
+    ResultKey_t key = {0, 0};
+    if (!hasher)
+    {
+        return key;
+    }
+    ResultHasher_t last = *hasher;
+    const size_t pending = last.length % 8;
+    if (pending)
+    {
+        memset(last.tail + pending, 0, 8 - pending);
+        hash_word(&last, load_word(last.tail));
+    }
+    hash_word(&last, last.length);
+    key.high = mix_final(last.lanes[0] + rotate_left(last.lanes[1], 17));
+    key.low = mix_final(last.lanes[1] ^ key.high);
+    return key;
+}
+
+static uint64_t payload_checksum(const void *data, size_t size)
+{
+    ResultHasher_t hasher;
+    result_hasher_init(&hasher);
+    result_hasher_update(&hasher, data, size);
+    return result_hasher_final(&hasher).low;
+}
+
+ResultCache_t *result_cache_open(const char *path, uint64_t max_bytes)
+{
+    struct stat info;
+    if (!path || !*path || (mkdir(path, 0777) != 0 && errno != EEXIST) || stat(path, &info) != 0
+        || !S_ISDIR(info.st_mode))
+    {
+        return NULL;
+    }
+    ResultCache_t *cache = malloc(sizeof(ResultCache_t));
+    char *copy = malloc(strlen(path) + 1);
+    if (!cache || !copy)
+    {
+        free(cache);
+        free(copy);
+        return NULL;
+    }
+    cache->path = strcpy(copy, path);
+    cache->max_bytes = max_bytes;
+    return cache;
+}
+
+void result_cache_close(ResultCache_t *cache)
+{
+    if (cache)
+    {
+        free(cache->path);
+        free(cache);
+    }
+}
+
+// Builds "<dir>/<prefix><name><suffix>", NULL if it does not fit
+static char *cache_path(const ResultCache_t *cache, const char *prefix, const char *name, const char *suffix)
+{
+    const size_t length = strlen(cache->path) + strlen(prefix) + strlen(name) + strlen(suffix) + 2;
+    char *path = malloc(length);
+    if (path)
+    {
+        snprintf(path, length, "%s/%s%s%s", cache->path, prefix, name, suffix);
+    }
+    return path;
+}
+
+static char *entry_path(const ResultCache_t *cache, ResultKey_t key)
+{
+    char name[KEY_DIGITS + 1];
+    snprintf(name, sizeof(name), "%016llx%016llx", (unsigned long long) key.high, (unsigned long long) key.low);
+    return cache_path(cache, "", name, ENTRY_SUFFIX);
+}
+
+static bool read_all(int fd, void *data, size_t size)
+{
+    uint8_t *bytes = (uint8_t *) data;
+    while (size > 0)
+    {
+        const ssize_t count = read(fd, bytes, size);
+        if (count <= 0)
+        {
+            if (count < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            return false;
+        }
+        bytes += count;
+        size -= (size_t) count;
+    }
+    return true;
+}
+
+static bool write_all(int fd, const void *data, size_t size)
+{
+    const uint8_t *bytes = (const uint8_t *) data;
+    while (size > 0)
+    {
+        const ssize_t count = write(fd, bytes, size);
+        if (count < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            return false;
+        }
+        bytes += count;
+        size -= (size_t) count;
+    }
+    return true;
+}
+
+bool result_cache_get(ResultCache_t *cache, ResultKey_t key, dyn_array_t *payload)
+{
+    if (!cache || !payload || dyn_array_data_size(payload) != 1)
+    {
+        return false;
+    }
+    char *path = entry_path(cache, key);
+    const int fd = path ? open(path, O_RDONLY) : -1;
+    if (fd < 0)
+    {
+        free(path);
+        return false;
+    }
+    ResultEntryHeader_t header;
+    struct stat info;
+    bool hit = fstat(fd, &info) == 0 && read_all(fd, &header, sizeof(header))
+               && !memcmp(header.magic, result_cache_magic, sizeof(result_cache_magic)) && header.high == key.high
+               && header.low == key.low && header.size == (uint64_t) info.st_size - sizeof(header)
+               && dyn_array_resize(payload, header.size, NULL)
+               && (!header.size || read_all(fd, dyn_array_front(payload), header.size))
+               && payload_checksum(dyn_array_front(payload), header.size) == header.checksum;
+    if (hit)
+    {
+        // the modification time is the entry's last use
+        futimens(fd, NULL);
+    }
+    else
+    {
+        dyn_array_clear(payload);
+        unlink(path);
+    }
+    close(fd);
+    free(path);
+    return hit;
+}
+
+static int entry_compare(const void *a, const void *b)
+{
+    const ResultEntry_t *first = (const ResultEntry_t *) a;
+    const ResultEntry_t *second = (const ResultEntry_t *) b;
+    if (first->mtime != second->mtime)
+    {
+        return first->mtime < second->mtime ? -1 : 1;
+    }
+    return strcmp(first->name, second->name);
+}
+
+// Lists the entries, adding up their sizes, NULL on error
+static dyn_array_t *cache_entries(const ResultCache_t *cache, uint64_t *bytes)
+{
+    DIR *dir = opendir(cache->path);
+    dyn_array_t *entries = dir ? dyn_array_create(16, sizeof(ResultEntry_t), NULL) : NULL;
+    *bytes = 0;
+    const struct dirent *found = NULL;
+    while (entries && (found = readdir(dir)) != NULL)
+    {
+        const size_t length = strlen(found->d_name);
+        struct stat info;
+        if (length != KEY_DIGITS + strlen(ENTRY_SUFFIX) || strcmp(found->d_name + KEY_DIGITS, ENTRY_SUFFIX) != 0
+            || fstatat(dirfd(dir), found->d_name, &info, 0) != 0 || !S_ISREG(info.st_mode))
+        {
+            continue;
+        }
+        ResultEntry_t entry = {(int64_t) info.st_mtim.tv_sec * 1000000000 + info.st_mtim.tv_nsec,
+                               (uint64_t) info.st_size, {0}};
+        memcpy(entry.name, found->d_name, length + 1);
+        if (!dyn_array_push_back(entries, &entry))
+        {
+            dyn_array_destroy(entries);
+            entries = NULL;
+            break;
+        }
+        *bytes += entry.bytes;
+    }
+    if (dir)
+    {
+        closedir(dir);
+    }
+    return entries;
+}
+
+// Removes the least recently used entries until the cache fits
+static void cache_evict(const ResultCache_t *cache)
+{
+    uint64_t bytes = 0;
+    dyn_array_t *entries = cache_entries(cache, &bytes);
+    if (entries && bytes > cache->max_bytes && dyn_array_sort(entries, entry_compare))
+    {
+        for (size_t i = 0; i < dyn_array_size(entries) && bytes > cache->max_bytes; ++i)
+        {
+            const ResultEntry_t *entry = (const ResultEntry_t *) dyn_array_at(entries, i);
+            char *path = cache_path(cache, "", entry->name, "");
+            // another process may have removed it already, it is gone either way
+            if (path)
+            {
+                unlink(path);
+                bytes -= entry->bytes;
+            }
+            free(path);
+        }
+    }
+    dyn_array_destroy(entries);
+}
+
+bool result_cache_put(ResultCache_t *cache, ResultKey_t key, const void *data, size_t size)
+{
+    if (!cache || (!data && size) || sizeof(ResultEntryHeader_t) + (uint64_t) size > cache->max_bytes)
+    {
+        return false;
+    }
+    char *path = entry_path(cache, key);
+    char pid[24];
+    snprintf(pid, sizeof(pid), ".%ld.tmp", (long) getpid());
+    // the temporary name sits next to the entry so the rename cannot cross file systems
+    char *temporary = path ? cache_path(cache, ".", path + strlen(cache->path) + 1, pid) : NULL;
+    const int fd = temporary ? open(temporary, O_WRONLY | O_CREAT | O_TRUNC, 0666) : -1;
+    ResultEntryHeader_t header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, result_cache_magic, sizeof(result_cache_magic));
+    header.high = key.high;
+    header.low = key.low;
+    header.size = size;
+    header.checksum = payload_checksum(data, size);
+    bool stored = fd >= 0 && write_all(fd, &header, sizeof(header)) && write_all(fd, data, size) && fsync(fd) == 0;
+    if (fd >= 0)
+    {
+        stored = close(fd) == 0 && stored;
+        stored = stored && rename(temporary, path) == 0;
+        if (!stored)
+        {
+            unlink(temporary);
+        }
+    }
+    free(temporary);
+    free(path);
+    if (stored)
+    {
+        cache_evict(cache);
+    }
+    return stored;
+}
+
+uint64_t result_cache_bytes(const ResultCache_t *cache)
+{
+    uint64_t bytes = 0;
+    dyn_array_t *entries = cache ? cache_entries(cache, &bytes) : NULL;
+    dyn_array_destroy(entries);
+    return bytes;
+}
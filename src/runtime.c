@@ -0,0 +1,332 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <time.h>
+
+#include "dyn_array.h"
+#include "mpsc_queue.h"
+#include "runtime.h"
+
+// A submitted task. pcb.started doubles as "has been dispatched at least once"
+typedef struct
+{
+    ProcessControlBlock_t pcb;
+    RuntimeWork_t work;
+    void *arg;
+    uint64_t sequence;
+    uint64_t submitted_ns;
+}
+RuntimeTask_t;
+
+struct runtime
+{
+    ScheduleConfig_t config;
+    MpscQueue_t *submissions;       // producers -> workers, lock-free
+    dyn_array_t *ready;             // RuntimeTask_t pointers, guarded by lock
+
+    pthread_mutex_t lock;
+    pthread_cond_t work_available;
+    pthread_cond_t idle;
+    pthread_t *workers;
+    size_t worker_count;
+    bool stopping;
+
+    atomic_uint_fast64_t sequence;
+    atomic_uint_fast64_t pending;   // submitted but not completed
+    atomic_int sleepers;            // workers blocked on work_available
+
+    RuntimeStats_t stats;           // guarded by lock, except submitted
+    atomic_uint_fast64_t submitted;
+};
+
+static uint64_t now_ns(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t) now.tv_sec * 1000000000ull + (uint64_t) now.tv_nsec;
+}
+
+// Frees a task that is done, or that has to be dropped because the ready queue could not
+// take it, and wakes runtime_wait once nothing is pending. Caller holds lock
+static void runtime_retire(Runtime_t *runtime, RuntimeTask_t *task, bool completed)
+{
+    free(task);
+    if (completed)
+    {
+        ++runtime->stats.completed;
+    }
+    else
+    {
+        ++runtime->stats.dropped;
+    }
+    if (atomic_fetch_sub(&runtime->pending, 1) == 1)
+    {
+        pthread_cond_broadcast(&runtime->idle);
+        // workers sleeping through shutdown need to notice there is nothing left
+        if (runtime->stopping)
+        {
+            pthread_cond_broadcast(&runtime->work_available);
+        }
+    }
+}
+
+// Moves everything producers have submitted into the ready queue. Caller holds lock
+static void runtime_drain(Runtime_t *runtime)
+{
+    RuntimeTask_t *task;
+    while ((task = mpsc_queue_pop(runtime->submissions)))
+    {
+        if (!dyn_array_push_back(runtime->ready, &task))
+        {
+            runtime_retire(runtime, task, false);
+        }
+    }
+}
+
+// Removes the task the policy runs next. Caller holds lock and the ready queue is not empty
+static RuntimeTask_t *runtime_pick(Runtime_t *runtime)
+{
+    const SchedulePolicy_t policy = runtime->config.policy;
+    const size_t n = dyn_array_size(runtime->ready);
+    size_t best = 0;
+
+    // FIFO policies append in order, so the front is always next
+    if (policy != SCHEDULE_FCFS && policy != SCHEDULE_RR)
+    {
+        const RuntimeTask_t *first = *(RuntimeTask_t **) dyn_array_at(runtime->ready, 0);
+        uint64_t best_key = schedule_policy_key(policy, &first->pcb, first->sequence);
+        for (size_t i = 1; i < n; ++i)
+        {
+            const RuntimeTask_t *candidate = *(RuntimeTask_t **) dyn_array_at(runtime->ready, i);
+            const uint64_t key = schedule_policy_key(policy, &candidate->pcb, candidate->sequence);
+            if (key < best_key)
+            {
+                best = i;
+                best_key = key;
+            }
+        }
+    }
+
+    RuntimeTask_t *task;
+    dyn_array_extract(runtime->ready, best, &task);
+    return task;
+}
+
+// Runs one dispatch of task outside the lock
+// \return true if the task has to go back in the ready queue
+static bool runtime_execute(Runtime_t *runtime, RuntimeTask_t *task)
+{
+    switch (runtime->config.policy)
+    {
+        case SCHEDULE_RR:
+            return task->work(task->arg);
+        case SCHEDULE_SRTF:
+            if (!task->work(task->arg))
+            {
+                return false;
+            }
+            task->pcb.remaining_burst_time -= task->pcb.remaining_burst_time < runtime->config.quantum
+                                                  ? task->pcb.remaining_burst_time
+                                                  : (uint32_t) runtime->config.quantum;
+            return true;
+        default:
+            while (task->work(task->arg))
+            {
+            }
+            return false;
+    }
+}
+
+static void *runtime_worker(void *arg)
+{
+    Runtime_t *runtime = (Runtime_t *) arg;
+
+    pthread_mutex_lock(&runtime->lock);
+    for (;;)
+    {
+        runtime_drain(runtime);
+        if (dyn_array_empty(runtime->ready))
+        {
+            if (runtime->stopping && atomic_load(&runtime->pending) == 0)
+            {
+                break;
+            }
+
+            // Announce the sleep before the last look at the queue. A producer that pushes
+            // after that look is then guaranteed to see us and signal (see runtime_submit).
+            // The fence pairs with the one there: each side's store comes before its load
+            atomic_fetch_add(&runtime->sleepers, 1);
+            atomic_thread_fence(memory_order_seq_cst);
+            runtime_drain(runtime);
+            if (dyn_array_empty(runtime->ready))
+            {
+                pthread_cond_wait(&runtime->work_available, &runtime->lock);
+            }
+            atomic_fetch_sub(&runtime->sleepers, 1);
+            continue;
+        }
+
+        RuntimeTask_t *task = runtime_pick(runtime);
+        if (!task->pcb.started)
+        {
+            const uint64_t latency = now_ns() - task->submitted_ns;
+            task->pcb.started = true;
+            runtime->stats.total_dispatch_latency_ns += latency;
+            if (latency > runtime->stats.max_dispatch_latency_ns)
+            {
+                runtime->stats.max_dispatch_latency_ns = latency;
+            }
+        }
+        ++runtime->stats.dispatches;
+        pthread_mutex_unlock(&runtime->lock);
+
+        const bool more = runtime_execute(runtime, task);
+
+        pthread_mutex_lock(&runtime->lock);
+        if (!more || !dyn_array_push_back(runtime->ready, &task))
+        {
+            runtime_retire(runtime, task, !more);
+        }
+    }
+    pthread_mutex_unlock(&runtime->lock);
+    return NULL;
+}
+
+Runtime_t *runtime_create(size_t workers, const ScheduleConfig_t *config)
+{
+    if (!workers || !config || config->policy > SCHEDULE_SRTF
+        || ((config->policy == SCHEDULE_RR || config->policy == SCHEDULE_SRTF) && !config->quantum))
+    {
+        return NULL;
+    }
+
+    Runtime_t *runtime = (Runtime_t *) calloc(1, sizeof(Runtime_t));
+    if (!runtime)
+    {
+        return NULL;
+    }
+
+    runtime->config = *config;
+    runtime->config.timeline = NULL;
+    runtime->submissions = mpsc_queue_create();
+    runtime->ready = dyn_array_create(0, sizeof(RuntimeTask_t *), NULL);
+    runtime->workers = (pthread_t *) calloc(workers, sizeof(pthread_t));
+    atomic_init(&runtime->sequence, 0);
+    atomic_init(&runtime->pending, 0);
+    atomic_init(&runtime->sleepers, 0);
+    atomic_init(&runtime->submitted, 0);
+    pthread_mutex_init(&runtime->lock, NULL);
+    pthread_cond_init(&runtime->work_available, NULL);
+    pthread_cond_init(&runtime->idle, NULL);
+
+    if (runtime->submissions && runtime->ready && runtime->workers)
+    {
+        for (; runtime->worker_count < workers; ++runtime->worker_count)
+        {
+            if (pthread_create(&runtime->workers[runtime->worker_count], NULL, runtime_worker, runtime) != 0)
+            {
+                break;
+            }
+        }
+        if (runtime->worker_count == workers)
+        {
+            return runtime;
+        }
+    }
+
+    runtime_destroy(runtime);
+    return NULL;
+}
+
+bool runtime_submit(Runtime_t *runtime, const ProcessControlBlock_t *descriptor, RuntimeWork_t work, void *arg)
+{
+    if (!runtime || !descriptor || !work)
+    {
+        return false;
+    }
+
+    RuntimeTask_t *task = (RuntimeTask_t *) malloc(sizeof(RuntimeTask_t));
+    if (!task)
+    {
+        return false;
+    }
+    task->pcb = *descriptor;
+    task->pcb.started = false;
+    task->work = work;
+    task->arg = arg;
+    task->sequence = atomic_fetch_add(&runtime->sequence, 1);
+    task->submitted_ns = now_ns();
+
+    atomic_fetch_add(&runtime->pending, 1);
+    if (!mpsc_queue_push(runtime->submissions, task))
+    {
+        atomic_fetch_sub(&runtime->pending, 1);
+        free(task);
+        return false;
+    }
+    atomic_fetch_add_explicit(&runtime->submitted, 1, memory_order_relaxed);
+
+    // Only pay for the lock when somebody is actually asleep. The push is only a release
+    // store, which a later load may pass; the fence keeps the sleepers check after it, so
+    // either we see the worker's announcement or its last look at the queue sees the task
+    atomic_thread_fence(memory_order_seq_cst);
+    if (atomic_load(&runtime->sleepers) > 0)
+    {
+        pthread_mutex_lock(&runtime->lock);
+        pthread_cond_signal(&runtime->work_available);
+        pthread_mutex_unlock(&runtime->lock);
+    }
+    return true;
+}
+
+void runtime_wait(Runtime_t *runtime)
+{
+    if (runtime)
+    {
+        pthread_mutex_lock(&runtime->lock);
+        while (atomic_load(&runtime->pending) != 0)
+        {
+            pthread_cond_wait(&runtime->idle, &runtime->lock);
+        }
+        pthread_mutex_unlock(&runtime->lock);
+    }
+}
+
+bool runtime_stats(Runtime_t *runtime, RuntimeStats_t *stats)
+{
+    if (!runtime || !stats)
+    {
+        return false;
+    }
+    pthread_mutex_lock(&runtime->lock);
+    *stats = runtime->stats;
+    pthread_mutex_unlock(&runtime->lock);
+    stats->submitted = atomic_load_explicit(&runtime->submitted, memory_order_relaxed);
+    return true;
+}
+
+void runtime_destroy(Runtime_t *runtime)
+{
+    if (!runtime)
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&runtime->lock);
+    runtime->stopping = true;
+    pthread_cond_broadcast(&runtime->work_available);
+    pthread_mutex_unlock(&runtime->lock);
+    for (size_t i = 0; i < runtime->worker_count; ++i)
+    {
+        pthread_join(runtime->workers[i], NULL);
+    }
+
+    pthread_cond_destroy(&runtime->idle);
+    pthread_cond_destroy(&runtime->work_available);
+    pthread_mutex_destroy(&runtime->lock);
+    free(runtime->workers);
+    dyn_array_destroy(runtime->ready);
+    mpsc_queue_destroy(runtime->submissions);
+    free(runtime);
+}
@@ -0,0 +1,775 @@
+#define _XOPEN_SOURCE 700
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "dyn_array.h"
+#include "processing_scheduling.h"
+#include "sched_daemon.h"
+
+// A trace record in arrival order, for traces whose file is not sorted by arrival
+typedef struct
+{
+    uint32_t arrival;
+    uint32_t record;
+}
+TraceOrder_t;
+
+// A pinned trace
+typedef struct
+{
+    char *path;
+    const ProcessControlBlock_t *pcbs;  // the daemon's own copy, NULL for an empty trace
+    size_t count;
+    TraceOrder_t *order;                // NULL when the file is already in arrival order
+    dev_t device;
+    ino_t inode;
+    off_t size;
+    struct timespec mtime;
+    size_t refs;                        // the table's own reference plus one per query reading it
+}
+PinnedTrace_t;
+
+// Head of every request, followed by a SchedQuery_t and the path
+typedef struct
+{
+    uint32_t magic;
+    uint32_t path_length;
+}
+SchedRequest_t;
+
+struct sched_daemon
+{
+    char *socket_path;
+    int listener;
+    int wake[2];                // a worker returning a connection writes 'r', sched_daemon_stop 's'
+    size_t workers;
+    pthread_mutex_t lock;
+    pthread_cond_t work_available;
+    bool stopping;
+    dyn_array_t *ready;         // int, connections with a request waiting for a worker
+    dyn_array_t *returned;      // int, connections a worker is done with, back to be polled
+    pthread_mutex_t traces_lock;
+    dyn_array_t *traces;        // PinnedTrace_t *
+};
+
+struct sched_client
+{
+    int fd;
+};
+
+static uint64_t now_ns(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t) now.tv_sec * 1000000000ull + (uint64_t) now.tv_nsec;
+}
+
+void sched_query_init(SchedQuery_t *query, SchedulePolicy_t policy)
+{
+    if (query)
+    {
+        memset(query, 0, sizeof(SchedQuery_t));
+        ScheduleConfig_t config;
+        schedule_config_init(&config, policy);
+        query->policy = (uint32_t) policy;
+        query->seed = config.seed;
+        query->arrival_end = UINT32_MAX;
+        query->pcb_count = UINT64_MAX;
+    }
+}
+
+static int order_compare(const void *a, const void *b)
+{
+    const TraceOrder_t *first = (const TraceOrder_t *) a;
+    const TraceOrder_t *second = (const TraceOrder_t *) b;
+    if (first->arrival != second->arrival)
+    {
+        return first->arrival < second->arrival ? -1 : 1;
+    }
+    return first->record < second->record ? -1 : first->record > second->record;
+}
+
+static void trace_free(PinnedTrace_t *trace)
+{
+    if (trace)
+    {
+        free((void *) trace->pcbs);
+        free(trace->order);
+        free(trace->path);
+        free(trace);
+    }
+}
+
+static bool trace_current(const PinnedTrace_t *trace, const struct stat *info)
+{
+    return trace->device == info->st_dev && trace->inode == info->st_ino && trace->size == info->st_size
+           && trace->mtime.tv_sec == info->st_mtim.tv_sec && trace->mtime.tv_nsec == info->st_mtim.tv_nsec;
+}
+
+// Reads a trace into memory and finds its arrival order. The PCBs are copied rather than
+// mapped: a file truncated under a mapping would fault the daemon (SIGBUS) on its next read
+static PinnedTrace_t *trace_load(const char *path)
+{
+    PinnedTrace_t *trace = (PinnedTrace_t *) calloc(1, sizeof(PinnedTrace_t));
+    const int fd = trace ? open(path, O_RDONLY) : -1;
+    struct stat info;
+    if (fd < 0 || fstat(fd, &info) != 0 || !S_ISREG(info.st_mode))
+    {
+        if (fd >= 0)
+        {
+            close(fd);
+        }
+        free(trace);
+        return NULL;
+    }
+    // the identity is taken before the read, so a file changed while it is read is read again
+    // by the next query
+    trace->path = strdup(path);
+    trace->device = info.st_dev;
+    trace->inode = info.st_ino;
+    trace->size = info.st_size;
+    trace->mtime = info.st_mtim;
+    trace->refs = 1;
+    // a partial record at the end is left out, as load_process_control_blocks does
+    trace->count = (size_t) info.st_size / sizeof(ProcessControlBlock_t);
+    const size_t bytes = trace->count * sizeof(ProcessControlBlock_t);
+    bool loaded = trace->path && trace->count <= UINT32_MAX;
+    ProcessControlBlock_t *pcbs = loaded && bytes ? (ProcessControlBlock_t *) malloc(bytes) : NULL;
+    loaded = loaded && (!bytes || pcbs);
+    for (size_t done = 0; loaded && done < bytes;)
+    {
+        const ssize_t got = pread(fd, (char *) pcbs + done, bytes - done, (off_t) done);
+        // a file cut short since the fstat fails the load rather than leaving records unread
+        loaded = got > 0 || (got < 0 && errno == EINTR);
+        done += got > 0 ? (size_t) got : 0;
+    }
+    close(fd);
+    trace->pcbs = pcbs;
+
+    bool sorted = true;
+    for (size_t i = 1; loaded && sorted && i < trace->count; ++i)
+    {
+        sorted = trace->pcbs[i - 1].arrival <= trace->pcbs[i].arrival;
+    }
+    if (loaded && !sorted)
+    {
+        trace->order = (TraceOrder_t *) malloc(trace->count * sizeof(TraceOrder_t));
+        loaded = trace->order != NULL;
+        for (size_t i = 0; loaded && i < trace->count; ++i)
+        {
+            trace->order[i].arrival = trace->pcbs[i].arrival;
+            trace->order[i].record = (uint32_t) i;
+        }
+        if (loaded)
+        {
+            qsort(trace->order, trace->count, sizeof(TraceOrder_t), order_compare);
+        }
+    }
+    if (!loaded)
+    {
+        trace_free(trace);
+        return NULL;
+    }
+    return trace;
+}
+
+// Finds the pinned copy of path that is current for info, dropping a stale one from the table.
+// Called with traces_lock held
+static PinnedTrace_t *trace_find(SchedDaemon_t *daemon, const char *path, const struct stat *info)
+{
+    for (size_t i = 0; i < dyn_array_size(daemon->traces); ++i)
+    {
+        PinnedTrace_t *pinned = *(PinnedTrace_t **) dyn_array_at(daemon->traces, i);
+        if (strcmp(pinned->path, path) == 0)
+        {
+            if (trace_current(pinned, info))
+            {
+                return pinned;
+            }
+            // queries still reading the old copy drop the last reference
+            dyn_array_erase(daemon->traces, i);
+            if (--pinned->refs == 0)
+            {
+                trace_free(pinned);
+            }
+            return NULL;
+        }
+    }
+    return NULL;
+}
+
+// Takes a reference to a trace, loading it (again, if it changed) as needed. The load runs
+// without traces_lock, so queries on other traces are not held up by it; a worker that
+// loaded the same trace in the meantime wins and our copy is dropped
+static PinnedTrace_t *trace_acquire(SchedDaemon_t *daemon, const char *path)
+{
+    struct stat info;
+    if (stat(path, &info) != 0 || !S_ISREG(info.st_mode))
+    {
+        return NULL;
+    }
+    pthread_mutex_lock(&daemon->traces_lock);
+    PinnedTrace_t *trace = trace_find(daemon, path, &info);
+    if (trace)
+    {
+        ++trace->refs;
+    }
+    pthread_mutex_unlock(&daemon->traces_lock);
+    if (trace)
+    {
+        return trace;
+    }
+
+    PinnedTrace_t *loaded = trace_load(path);
+    if (!loaded)
+    {
+        return NULL;
+    }
+    pthread_mutex_lock(&daemon->traces_lock);
+    trace = trace_find(daemon, path, &info);
+    if (!trace && dyn_array_push_back(daemon->traces, &loaded))
+    {
+        trace = loaded;
+        loaded = NULL;
+    }
+    if (trace)
+    {
+        ++trace->refs;
+    }
+    pthread_mutex_unlock(&daemon->traces_lock);
+    trace_free(loaded);
+    return trace;
+}
+
+static void trace_release(SchedDaemon_t *daemon, PinnedTrace_t *trace)
+{
+    pthread_mutex_lock(&daemon->traces_lock);
+    if (--trace->refs == 0)
+    {
+        trace_free(trace);
+    }
+    pthread_mutex_unlock(&daemon->traces_lock);
+}
+
+static bool trace_take(dyn_array_t *queue, const ProcessControlBlock_t *pcb, SchedAnswer_t *answer)
+{
+    answer->total_burst += pcb->remaining_burst_time;
+    answer->priority_sum += pcb->priority;
+    if (pcb->remaining_burst_time > answer->longest_burst)
+    {
+        answer->longest_burst = pcb->remaining_burst_time;
+    }
+    if (pcb->arrival > answer->last_arrival)
+    {
+        answer->last_arrival = pcb->arrival;
+    }
+    return dyn_array_push_back(queue, pcb);
+}
+
+// \return the first position in arrival order from low on whose arrival is at least limit
+static size_t arrival_bound(const PinnedTrace_t *trace, size_t low, uint64_t limit)
+{
+    size_t high = trace->count;
+    while (low < high)
+    {
+        const size_t middle = low + (high - low) / 2;
+        const uint32_t arrival = trace->order ? trace->order[middle].arrival : trace->pcbs[middle].arrival;
+        if (arrival < limit)
+        {
+            low = middle + 1;
+        }
+        else
+        {
+            high = middle;
+        }
+    }
+    return low;
+}
+
+// Copies out the PCBs a query keeps, adding up the answer's workload totals
+static dyn_array_t *trace_window(const PinnedTrace_t *trace, const SchedQuery_t *query, SchedAnswer_t *answer)
+{
+    size_t first = 0;
+    size_t last = trace->count;
+    if (query->windowed)
+    {
+        first = arrival_bound(trace, 0, query->arrival_start);
+        last = arrival_bound(trace, first, (uint64_t) query->arrival_end + 1);
+        first = query->first_pcb < last - first ? first + (size_t) query->first_pcb : last;
+        if (query->pcb_count < last - first)
+        {
+            last = first + (size_t) query->pcb_count;
+        }
+    }
+    dyn_array_t *queue = dyn_array_create(last - first, sizeof(ProcessControlBlock_t), NULL);
+    for (size_t i = first; queue && i < last; ++i)
+    {
+        const ProcessControlBlock_t *pcb = &trace->pcbs[query->windowed && trace->order ? trace->order[i].record : i];
+        if (!trace_take(queue, pcb, answer))
+        {
+            dyn_array_destroy(queue);
+            queue = NULL;
+        }
+    }
+    answer->pcbs = queue ? dyn_array_size(queue) : 0;
+    return queue;
+}
+
+static void daemon_run(SchedDaemon_t *daemon, const char *path, const SchedQuery_t *query, SchedAnswer_t *answer)
+{
+    const uint64_t start = now_ns();
+    memset(answer, 0, sizeof(SchedAnswer_t));
+    if (query->policy > SCHEDULE_GROUP || (query->windowed && query->arrival_start > query->arrival_end))
+    {
+        answer->status = SCHED_DAEMON_BAD_QUERY;
+        return;
+    }
+    PinnedTrace_t *trace = trace_acquire(daemon, path);
+    if (!trace)
+    {
+        answer->status = SCHED_DAEMON_NO_TRACE;
+        return;
+    }
+    dyn_array_t *queue = trace_window(trace, query, answer);
+    trace_release(daemon, trace);
+
+    ScheduleConfig_t config;
+    schedule_config_init(&config, (SchedulePolicy_t) query->policy);
+    if (query->quantum)
+    {
+        config.quantum = (size_t) query->quantum;
+    }
+    config.costs = query->costs;
+    config.seed = query->seed;
+    config.stats = &answer->stats;
+    answer->status = queue && schedule_run(queue, &answer->result, &config) ? SCHED_DAEMON_OK
+                                                                            : SCHED_DAEMON_RUN_FAILED;
+    dyn_array_destroy(queue);
+    answer->run_ns = now_ns() - start;
+}
+
+static bool receive_all(int fd, void *data, size_t size)
+{
+    uint8_t *bytes = (uint8_t *) data;
+    while (size > 0)
+    {
+        const ssize_t count = recv(fd, bytes, size, 0);
+        if (count <= 0)
+        {
+            if (count < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            return false;
+        }
+        bytes += count;
+        size -= (size_t) count;
+    }
+    return true;
+}
+
+static bool send_all(int fd, const void *data, size_t size)
+{
+    const uint8_t *bytes = (const uint8_t *) data;
+    while (size > 0)
+    {
+        // a client that hung up must not take the daemon down with SIGPIPE
+        const ssize_t count = send(fd, bytes, size, MSG_NOSIGNAL);
+        if (count < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            return false;
+        }
+        bytes += count;
+        size -= (size_t) count;
+    }
+    return true;
+}
+
+// Answers one request
+// \return false if the connection is done with
+static bool daemon_answer(SchedDaemon_t *daemon, int fd)
+{
+    SchedRequest_t request;
+    SchedQuery_t query;
+    char path[SCHED_DAEMON_PATH_MAX + 1];
+    if (!receive_all(fd, &request, sizeof(request)) || request.magic != SCHED_DAEMON_MAGIC || !request.path_length
+        || request.path_length > SCHED_DAEMON_PATH_MAX || !receive_all(fd, &query, sizeof(query))
+        || !receive_all(fd, path, request.path_length))
+    {
+        return false;
+    }
+    path[request.path_length] = '\0';
+    SchedAnswer_t answer;
+    daemon_run(daemon, path, &query, &answer);
+    return send_all(fd, &answer, sizeof(answer));
+}
+
+static void daemon_wake(SchedDaemon_t *daemon, char reason)
+{
+    // a full pipe already has a wake up pending
+    while (write(daemon->wake[1], &reason, 1) < 0 && errno == EINTR)
+    {
+    }
+}
+
+static void *daemon_worker(void *arg)
+{
+    SchedDaemon_t *daemon = (SchedDaemon_t *) arg;
+    pthread_mutex_lock(&daemon->lock);
+    for (;;)
+    {
+        while (!daemon->stopping && dyn_array_empty(daemon->ready))
+        {
+            pthread_cond_wait(&daemon->work_available, &daemon->lock);
+        }
+        if (daemon->stopping)
+        {
+            break;
+        }
+        int fd;
+        dyn_array_extract_front(daemon->ready, &fd);
+        pthread_mutex_unlock(&daemon->lock);
+
+        const bool open = daemon_answer(daemon, fd);
+
+        pthread_mutex_lock(&daemon->lock);
+        if (open && dyn_array_push_back(daemon->returned, &fd))
+        {
+            daemon_wake(daemon, 'r');
+        }
+        else
+        {
+            close(fd);
+        }
+    }
+    pthread_mutex_unlock(&daemon->lock);
+    return NULL;
+}
+
+static void close_all(dyn_array_t *fds)
+{
+    for (size_t i = 0; fds && i < dyn_array_size(fds); ++i)
+    {
+        close(*(int *) dyn_array_at(fds, i));
+    }
+    dyn_array_clear(fds);
+}
+
+SchedDaemon_t *sched_daemon_create(const char *socket_path, size_t workers)
+{
+    struct sockaddr_un address;
+    if (!socket_path || strlen(socket_path) >= sizeof(address.sun_path))
+    {
+        return NULL;
+    }
+    SchedDaemon_t *daemon = (SchedDaemon_t *) calloc(1, sizeof(SchedDaemon_t));
+    if (!daemon)
+    {
+        return NULL;
+    }
+    if (!workers)
+    {
+        const long online = sysconf(_SC_NPROCESSORS_ONLN);
+        workers = online > 0 ? (size_t) online : 1;
+    }
+    daemon->workers = workers;
+    daemon->wake[0] = daemon->wake[1] = -1;
+    daemon->socket_path = strdup(socket_path);
+    daemon->ready = dyn_array_create(0, sizeof(int), NULL);
+    daemon->returned = dyn_array_create(0, sizeof(int), NULL);
+    daemon->traces = dyn_array_create(0, sizeof(PinnedTrace_t *), NULL);
+    pthread_mutex_init(&daemon->lock, NULL);
+    pthread_cond_init(&daemon->work_available, NULL);
+    pthread_mutex_init(&daemon->traces_lock, NULL);
+    daemon->listener = socket(AF_UNIX, SOCK_STREAM, 0);
+
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strcpy(address.sun_path, socket_path);
+    // a socket file nobody listens on is left over from a daemon that did not shut down
+    struct stat info;
+    const int probe = lstat(socket_path, &info) == 0 && S_ISSOCK(info.st_mode) ? socket(AF_UNIX, SOCK_STREAM, 0) : -1;
+    if (probe >= 0 && connect(probe, (const struct sockaddr *) &address, sizeof(address)) != 0
+        && errno == ECONNREFUSED)
+    {
+        unlink(socket_path);
+    }
+    if (probe >= 0)
+    {
+        close(probe);
+    }
+
+    if (daemon->socket_path && daemon->ready && daemon->returned && daemon->traces && daemon->listener >= 0
+        && pipe(daemon->wake) == 0 && fcntl(daemon->wake[0], F_SETFL, O_NONBLOCK) == 0
+        && fcntl(daemon->wake[1], F_SETFL, O_NONBLOCK) == 0 && fcntl(daemon->listener, F_SETFL, O_NONBLOCK) == 0
+        && bind(daemon->listener, (const struct sockaddr *) &address, sizeof(address)) == 0)
+    {
+        if (listen(daemon->listener, SOMAXCONN) == 0)
+        {
+            return daemon;
+        }
+        unlink(socket_path);
+    }
+    // the socket file is someone else's unless bind succeeded
+    free(daemon->socket_path);
+    daemon->socket_path = NULL;
+    sched_daemon_destroy(daemon);
+    return NULL;
+}
+
+bool sched_daemon_pin(SchedDaemon_t *daemon, const char *trace_path)
+{
+    char *path = daemon && trace_path ? realpath(trace_path, NULL) : NULL;
+    PinnedTrace_t *trace = path ? trace_acquire(daemon, path) : NULL;
+    if (trace)
+    {
+        trace_release(daemon, trace);
+    }
+    free(path);
+    return trace != NULL;
+}
+
+// Accepts every waiting connection into the idle set
+static void daemon_accept(SchedDaemon_t *daemon, dyn_array_t *idle)
+{
+    const struct timeval timeout = {SCHED_DAEMON_TIMEOUT_MS / 1000, (SCHED_DAEMON_TIMEOUT_MS % 1000) * 1000};
+    int fd;
+    while ((fd = accept(daemon->listener, NULL, NULL)) >= 0)
+    {
+        // accepted sockets do not inherit O_NONBLOCK on Linux, but do elsewhere
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) & ~O_NONBLOCK);
+        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+        if (!dyn_array_push_back(idle, &fd))
+        {
+            close(fd);
+        }
+    }
+}
+
+bool sched_daemon_serve(SchedDaemon_t *daemon)
+{
+    if (!daemon)
+    {
+        return false;
+    }
+    pthread_t *workers = (pthread_t *) calloc(daemon->workers, sizeof(pthread_t));
+    dyn_array_t *idle = dyn_array_create(0, sizeof(int), NULL);
+    dyn_array_t *polled = dyn_array_create(0, sizeof(struct pollfd), NULL);
+    size_t started = 0;
+    for (; workers && started < daemon->workers; ++started)
+    {
+        if (pthread_create(&workers[started], NULL, daemon_worker, daemon) != 0)
+        {
+            break;
+        }
+    }
+
+    bool stopped = false;
+    bool failed = !workers || !idle || !polled || started < daemon->workers;
+    while (!stopped && !failed)
+    {
+        // the wake pipe, the listener, then one entry per idle connection
+        const struct pollfd fixed[2] = {{daemon->wake[0], POLLIN, 0}, {daemon->listener, POLLIN, 0}};
+        failed = !dyn_array_resize(polled, 2 + dyn_array_size(idle), NULL);
+        if (failed)
+        {
+            break;
+        }
+        struct pollfd *entries = (struct pollfd *) dyn_array_front(polled);
+        memcpy(entries, fixed, sizeof(fixed));
+        for (size_t i = 0; i < dyn_array_size(idle); ++i)
+        {
+            entries[2 + i].fd = *(int *) dyn_array_at(idle, i);
+            entries[2 + i].events = POLLIN;
+            entries[2 + i].revents = 0;
+        }
+        if (poll(entries, dyn_array_size(polled), -1) < 0)
+        {
+            failed = errno != EINTR;
+            continue;
+        }
+
+        if (entries[0].revents)
+        {
+            char reasons[64];
+            ssize_t count;
+            while ((count = read(daemon->wake[0], reasons, sizeof(reasons))) > 0)
+            {
+                stopped = stopped || memchr(reasons, 's', (size_t) count) != NULL;
+            }
+        }
+        pthread_mutex_lock(&daemon->lock);
+        // connections with a request waiting go to the workers, hung up ones are closed. Walking
+        // backwards keeps the indices of entries still to be looked at
+        for (size_t i = dyn_array_size(idle); i-- > 0;)
+        {
+            const short events = entries[2 + i].revents;
+            int fd = entries[2 + i].fd;
+            if (events & POLLIN)
+            {
+                if (dyn_array_push_back(daemon->ready, &fd))
+                {
+                    pthread_cond_signal(&daemon->work_available);
+                }
+                else
+                {
+                    close(fd);
+                }
+                dyn_array_erase(idle, i);
+            }
+            else if (events & (POLLHUP | POLLERR | POLLNVAL))
+            {
+                close(fd);
+                dyn_array_erase(idle, i);
+            }
+        }
+        for (size_t i = 0; i < dyn_array_size(daemon->returned); ++i)
+        {
+            if (!dyn_array_push_back(idle, dyn_array_at(daemon->returned, i)))
+            {
+                close(*(int *) dyn_array_at(daemon->returned, i));
+            }
+        }
+        dyn_array_clear(daemon->returned);
+        pthread_mutex_unlock(&daemon->lock);
+
+        if (entries[1].revents)
+        {
+            daemon_accept(daemon, idle);
+        }
+    }
+
+    pthread_mutex_lock(&daemon->lock);
+    daemon->stopping = true;
+    pthread_cond_broadcast(&daemon->work_available);
+    pthread_mutex_unlock(&daemon->lock);
+    for (size_t i = 0; i < started; ++i)
+    {
+        pthread_join(workers[i], NULL);
+    }
+    close_all(idle);
+    close_all(daemon->ready);
+    close_all(daemon->returned);
+    dyn_array_destroy(idle);
+    dyn_array_destroy(polled);
+    free(workers);
+    return stopped;
+}
+
+void sched_daemon_stop(SchedDaemon_t *daemon)
+{
+    if (daemon)
+    {
+        daemon_wake(daemon, 's');
+    }
+}
+
+void sched_daemon_destroy(SchedDaemon_t *daemon)
+{
+    if (!daemon)
+    {
+        return;
+    }
+    if (daemon->listener >= 0)
+    {
+        close(daemon->listener);
+    }
+    if (daemon->socket_path)
+    {
+        unlink(daemon->socket_path);
+    }
+    for (int end = 0; end < 2; ++end)
+    {
+        if (daemon->wake[end] >= 0)
+        {
+            close(daemon->wake[end]);
+        }
+    }
+    for (size_t i = 0; daemon->traces && i < dyn_array_size(daemon->traces); ++i)
+    {
+        trace_free(*(PinnedTrace_t **) dyn_array_at(daemon->traces, i));
+    }
+    dyn_array_destroy(daemon->traces);
+    close_all(daemon->ready);
+    close_all(daemon->returned);
+    dyn_array_destroy(daemon->ready);
+    dyn_array_destroy(daemon->returned);
+    pthread_mutex_destroy(&daemon->lock);
+    pthread_cond_destroy(&daemon->work_available);
+    pthread_mutex_destroy(&daemon->traces_lock);
+    free(daemon->socket_path);
+    free(daemon);
+}
+
+SchedClient_t *sched_client_open(const char *socket_path)
+{
+    struct sockaddr_un address;
+    if (!socket_path || strlen(socket_path) >= sizeof(address.sun_path))
+    {
+        return NULL;
+    }
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strcpy(address.sun_path, socket_path);
+    SchedClient_t *client = (SchedClient_t *) malloc(sizeof(SchedClient_t));
+    if (client)
+    {
+        client->fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (client->fd < 0 || connect(client->fd, (const struct sockaddr *) &address, sizeof(address)) != 0)
+        {
+            sched_client_close(client);
+            client = NULL;
+        }
+    }
+    return client;
+}
+
+bool sched_client_query(SchedClient_t *client, const char *trace_path, const SchedQuery_t *query,
+                        SchedAnswer_t *answer)
+{
+    if (!client || !trace_path || !query || !answer)
+    {
+        return false;
+    }
+    // the daemon has its own working directory; a path that does not resolve goes as it is,
+    // for the daemon to report
+    char *path = realpath(trace_path, NULL);
+    const char *sent = path ? path : trace_path;
+    const size_t length = strlen(sent);
+    const SchedRequest_t request = {SCHED_DAEMON_MAGIC, (uint32_t) length};
+    const bool answered = length && length <= SCHED_DAEMON_PATH_MAX && send_all(client->fd, &request, sizeof(request))
+                          && send_all(client->fd, query, sizeof(SchedQuery_t)) && send_all(client->fd, sent, length)
+                          && receive_all(client->fd, answer, sizeof(SchedAnswer_t));
+    free(path);
+    return answered;
+}
+
+void sched_client_close(SchedClient_t *client)
+{
+    if (client)
+    {
+        if (client->fd >= 0)
+        {
+            close(client->fd);
+        }
+        free(client);
+    }
+}
@@ -0,0 +1,61 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../include/sched_daemon.h"
+
+// The daemon the signal handlers stop
+static SchedDaemon_t *running = NULL;
+
+static void on_signal(int signal_number)
+{
+    (void) signal_number;
+    sched_daemon_stop(running);
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+    {
+        printf("%s <socket> [--workers <count>] [pcb files to pin...]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    size_t workers = 0;
+    int first_trace = 2;
+    if (argc > 3 && strcmp(argv[2], "--workers") == 0)
+    {
+        workers = strtoul(argv[3], NULL, 10);
+        first_trace = 4;
+    }
+
+    running = sched_daemon_create(argv[1], workers);
+    if (!running)
+    {
+        fprintf(stderr, "Could not listen on %s\n", argv[1]);
+        return EXIT_FAILURE;
+    }
+    for (int i = first_trace; i < argc; ++i)
+    {
+        if (!sched_daemon_pin(running, argv[i]))
+        {
+            fprintf(stderr, "Could not read %s\n", argv[i]);
+            sched_daemon_destroy(running);
+            return EXIT_FAILURE;
+        }
+    }
+
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = on_signal;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+
+    const bool stopped = sched_daemon_serve(running);
+    sched_daemon_destroy(running);
+    return stopped ? EXIT_SUCCESS : EXIT_FAILURE;
+}
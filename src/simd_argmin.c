@@ -0,0 +1,156 @@
+#include <stdatomic.h>
+
+#include "simd_argmin.h"
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define SIMD_ARGMIN_X86 1
+#include <immintrin.h>
+#endif
+
+static size_t argmin_scalar(const uint32_t *keys, size_t first, size_t count, size_t best)
+{
+    uint32_t best_key = keys[best];
+    for (size_t i = first; i < count; ++i)
+    {
+        if (keys[i] < best_key)
+        {
+            best = i;
+            best_key = keys[i];
+        }
+    }
+    return best;
+}
+
+#ifdef SIMD_ARGMIN_X86
+
+// Lane values are compared as signed after flipping the top bit, which orders them as unsigned
+#define SIGN_FLIP ((int) 0x80000000u)
+
+__attribute__((target("sse4.1")))
+static size_t argmin_sse41(const uint32_t *keys, size_t count)
+{
+    if (count < 8)
+    {
+        return argmin_scalar(keys, 1, count, 0);
+    }
+    const __m128i flip = _mm_set1_epi32(SIGN_FLIP);
+    const __m128i step = _mm_set1_epi32(4);
+    __m128i index = _mm_setr_epi32(0, 1, 2, 3);
+    __m128i best = _mm_xor_si128(_mm_loadu_si128((const __m128i *) keys), flip);
+    __m128i best_index = index;
+    size_t i = 4;
+    for (; i + 4 <= count; i += 4)
+    {
+        index = _mm_add_epi32(index, step);
+        const __m128i value = _mm_xor_si128(_mm_loadu_si128((const __m128i *) (keys + i)), flip);
+        const __m128i less = _mm_cmplt_epi32(value, best);
+        best = _mm_blendv_epi8(best, value, less);
+        best_index = _mm_blendv_epi8(best_index, index, less);
+    }
+
+    int32_t values[4], indices[4];
+    _mm_storeu_si128((__m128i *) values, best);
+    _mm_storeu_si128((__m128i *) indices, best_index);
+    size_t result = (size_t) indices[0];
+    for (int lane = 1; lane < 4; ++lane)
+    {
+        if (values[lane] < values[0] || (values[lane] == values[0] && (size_t) indices[lane] < result))
+        {
+            values[0] = values[lane];
+            result = (size_t) indices[lane];
+        }
+    }
+    return argmin_scalar(keys, i, count, result);
+}
+
+__attribute__((target("avx2")))
+static size_t argmin_avx2(const uint32_t *keys, size_t count)
+{
+    if (count < 16)
+    {
+        return argmin_scalar(keys, 1, count, 0);
+    }
+    const __m256i flip = _mm256_set1_epi32(SIGN_FLIP);
+    const __m256i step = _mm256_set1_epi32(8);
+    __m256i index = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    __m256i best = _mm256_xor_si256(_mm256_loadu_si256((const __m256i *) keys), flip);
+    __m256i best_index = index;
+    size_t i = 8;
+    for (; i + 8 <= count; i += 8)
+    {
+        index = _mm256_add_epi32(index, step);
+        const __m256i value = _mm256_xor_si256(_mm256_loadu_si256((const __m256i *) (keys + i)), flip);
+        const __m256i less = _mm256_cmpgt_epi32(best, value);
+        best = _mm256_blendv_epi8(best, value, less);
+        best_index = _mm256_blendv_epi8(best_index, index, less);
+    }
+
+    int32_t values[8], indices[8];
+    _mm256_storeu_si256((__m256i *) values, best);
+    _mm256_storeu_si256((__m256i *) indices, best_index);
+    size_t result = (size_t) indices[0];
+    for (int lane = 1; lane < 8; ++lane)
+    {
+        if (values[lane] < values[0] || (values[lane] == values[0] && (size_t) indices[lane] < result))
+        {
+            values[0] = values[lane];
+            result = (size_t) indices[lane];
+        }
+    }
+    return argmin_scalar(keys, i, count, result);
+}
+
+#endif
+
+SimdArgminLevel_t simd_argmin_best_level(void)
+{
+#ifdef SIMD_ARGMIN_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+    {
+        return SIMD_ARGMIN_AVX2;
+    }
+    if (__builtin_cpu_supports("sse4.1"))
+    {
+        return SIMD_ARGMIN_SSE41;
+    }
+#endif
+    return SIMD_ARGMIN_SCALAR;
+}
+
+// Runs the kernel of a level the CPU is known to support. Lane indices are 32 bit, so
+// longer columns than that take the scalar loop
+static size_t argmin_dispatch(SimdArgminLevel_t level, const uint32_t *keys, size_t count)
+{
+    switch (count <= INT32_MAX ? level : SIMD_ARGMIN_SCALAR)
+    {
+#ifdef SIMD_ARGMIN_X86
+        case SIMD_ARGMIN_AVX2:
+            return argmin_avx2(keys, count);
+        case SIMD_ARGMIN_SSE41:
+            return argmin_sse41(keys, count);
+#endif
+        default:
+            return argmin_scalar(keys, 1, count, 0);
+    }
+}
+
+size_t simd_argmin_u32_level(SimdArgminLevel_t level, const uint32_t *keys, size_t count)
+{
+    const SimdArgminLevel_t best = simd_argmin_best_level();
+    return argmin_dispatch(level < best ? level : best, keys, count);
+}
+
+size_t simd_argmin_u32(const uint32_t *keys, size_t count)
+{
+    // the CPU does not change under a running process, so the level is looked up once;
+    // threads racing on the first call all store the same value
+    static atomic_int level = -1;
+    int known = atomic_load_explicit(&level, memory_order_relaxed);
+    if (known < 0)
+    {
+        known = (int) simd_argmin_best_level();
+        atomic_store_explicit(&level, known, memory_order_relaxed);
+    }
+    return argmin_dispatch((SimdArgminLevel_t) known, keys, count);
+}
@@ -0,0 +1,209 @@
+#include <stdio.h>
+
+#include "dyn_array.h"
+#include "timeline.h"
+
+#define TIMELINE_MAGIC "TLN1"
+
+struct timeline
+{
+    dyn_array_t *segments;
+};
+
+Timeline_t *timeline_create(void)
+{
+    Timeline_t *timeline = (Timeline_t *) malloc(sizeof(Timeline_t));
+    if (timeline)
+    {
+        timeline->segments = dyn_array_create(0, sizeof(TimelineSegment_t), NULL);
+        if (timeline->segments)
+        {
+            return timeline;
+        }
+        free(timeline);
+    }
+    return NULL;
+}
+
+void timeline_destroy(Timeline_t *timeline)
+{
+    if (timeline)
+    {
+        dyn_array_destroy(timeline->segments);
+        free(timeline);
+    }
+}
+
+void timeline_clear(Timeline_t *timeline)
+{
+    if (timeline)
+    {
+        dyn_array_clear(timeline->segments);
+    }
+}
+
+bool timeline_record(Timeline_t *timeline, uint32_t pid, uint64_t start, uint32_t length)
+{
+    if (!timeline)
+    {
+        return false;
+    }
+    if (!length)
+    {
+        return true;
+    }
+
+    TimelineSegment_t *last = dyn_array_back(timeline->segments);
+    if (last && last->pid == pid && last->start + last->length == start && last->length <= UINT32_MAX - length)
+    {
+        last->length += length;
+        return true;
+    }
+
+    TimelineSegment_t segment = {start, pid, length};
+    return dyn_array_push_back(timeline->segments, &segment);
+}
+
+size_t timeline_size(const Timeline_t *timeline)
+{
+    return timeline ? dyn_array_size(timeline->segments) : 0;
+}
+
+const TimelineSegment_t *timeline_at(const Timeline_t *timeline, size_t index)
+{
+    return timeline ? dyn_array_at(timeline->segments, index) : NULL;
+}
+
+bool timeline_write_csv(const Timeline_t *timeline, const char *path)
+{
+    if (!timeline || !path)
+    {
+        return false;
+    }
+
+    FILE *file = fopen(path, "w");
+    if (!file)
+    {
+        return false;
+    }
+
+    fputs("pid,start,length\n", file);
+    const size_t n = dyn_array_size(timeline->segments);
+    for (size_t i = 0; i < n; ++i)
+    {
+        const TimelineSegment_t *segment = dyn_array_at(timeline->segments, i);
+        fprintf(file, "%u,%llu,%u\n", (unsigned) segment->pid, (unsigned long long) segment->start,
+                (unsigned) segment->length);
+    }
+    return fclose(file) == 0;
+}
+
+// LEB128 style: 7 bits per byte, high bit set on every byte but the last
+static void write_varint(FILE *file, uint64_t value)
+{
+    while (value >= 0x80)
+    {
+        fputc((int) ((value & 0x7F) | 0x80), file);
+        value >>= 7;
+    }
+    fputc((int) value, file);
+}
+
+static bool read_varint(FILE *file, uint64_t *value)
+{
+    *value = 0;
+    for (unsigned shift = 0; shift < 64; shift += 7)
+    {
+        const int byte = fgetc(file);
+        if (byte == EOF)
+        {
+            return false;
+        }
+        *value |= (uint64_t) (byte & 0x7F) << shift;
+        if (!(byte & 0x80))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Gaps can be negative once segments come from more than one CPU, so they are zigzag encoded
+#define ZIGZAG_ENCODE(x) (((uint64_t) (x) << 1) ^ (uint64_t) ((x) >> 63))
+#define ZIGZAG_DECODE(x) ((int64_t) ((x) >> 1) ^ -(int64_t) ((x) & 1))
+
+bool timeline_write_binary(const Timeline_t *timeline, const char *path)
+{
+    if (!timeline || !path)
+    {
+        return false;
+    }
+
+    FILE *file = fopen(path, "wb");
+    if (!file)
+    {
+        return false;
+    }
+
+    const size_t n = dyn_array_size(timeline->segments);
+    fwrite(TIMELINE_MAGIC, 1, 4, file);
+    write_varint(file, n);
+
+    uint64_t previous_end = 0;
+    for (size_t i = 0; i < n; ++i)
+    {
+        const TimelineSegment_t *segment = dyn_array_at(timeline->segments, i);
+        const int64_t gap = (int64_t) (segment->start - previous_end);
+        write_varint(file, ZIGZAG_ENCODE(gap));
+        write_varint(file, segment->pid);
+        write_varint(file, segment->length);
+        previous_end = segment->start + segment->length;
+    }
+    return fclose(file) == 0;
+}
+
+Timeline_t *timeline_read_binary(const char *path)
+{
+    if (!path)
+    {
+        return NULL;
+    }
+
+    FILE *file = fopen(path, "rb");
+    if (!file)
+    {
+        return NULL;
+    }
+
+    char magic[4];
+    uint64_t count;
+    Timeline_t *timeline = NULL;
+    if (fread(magic, 1, 4, file) == 4 && memcmp(magic, TIMELINE_MAGIC, 4) == 0 && read_varint(file, &count))
+    {
+        timeline = timeline_create();
+        uint64_t previous_end = 0;
+        for (uint64_t i = 0; timeline && i < count; ++i)
+        {
+            uint64_t gap, pid, length;
+            if (!read_varint(file, &gap) || !read_varint(file, &pid) || !read_varint(file, &length)
+                || pid > UINT32_MAX || length > UINT32_MAX)
+            {
+                timeline_destroy(timeline);
+                timeline = NULL;
+                break;
+            }
+
+            // pushed directly so the file's segmentation is kept as written
+            TimelineSegment_t segment = {previous_end + (uint64_t) ZIGZAG_DECODE(gap), (uint32_t) pid, (uint32_t) length};
+            if (!dyn_array_push_back(timeline->segments, &segment))
+            {
+                timeline_destroy(timeline);
+                timeline = NULL;
+                break;
+            }
+            previous_end = segment.start + segment.length;
+        }
+    }
+    fclose(file);
+    return timeline;
+}
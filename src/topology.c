@@ -0,0 +1,471 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "dyn_array.h"
+#include "topology.h"
+
+// Longest line or path the loaders handle
+#define TOPOLOGY_LINE_MAX 512
+
+struct topology
+{
+    dyn_array_t *cpus;          // TopologyCpu_t by CPU id
+    dyn_array_t *raw;           // uint64_t ids as given, three per CPU (socket, core, cache), to densify new CPUs
+    size_t sockets;
+    size_t cores;
+    size_t caches;
+    size_t classes;
+    TopologyCosts_t costs;
+};
+
+void topology_costs_init(TopologyCosts_t *costs)
+{
+    if (costs)
+    {
+        memset(costs, 0, sizeof(*costs));
+        costs->migrate[TOPOLOGY_SMT] = 0;
+        costs->migrate[TOPOLOGY_CACHE] = 1;
+        costs->migrate[TOPOLOGY_SOCKET] = 5;
+        costs->migrate[TOPOLOGY_REMOTE] = 20;
+        costs->remote_percent = 30;
+        costs->smt_percent = 25;
+    }
+}
+
+static Topology_t *topology_create(void)
+{
+    Topology_t *topology = calloc(1, sizeof(Topology_t));
+    if (!topology)
+    {
+        return NULL;
+    }
+    topology->cpus = dyn_array_create(0, sizeof(TopologyCpu_t), NULL);
+    topology->raw = dyn_array_create(0, 3 * sizeof(uint64_t), NULL);
+    if (!topology->cpus || !topology->raw)
+    {
+        topology_destroy(topology);
+        return NULL;
+    }
+    topology_costs_init(&topology->costs);
+    return topology;
+}
+
+void topology_destroy(Topology_t *topology)
+{
+    if (topology)
+    {
+        dyn_array_destroy(topology->cpus);
+        dyn_array_destroy(topology->raw);
+        free(topology);
+    }
+}
+
+// Adds the next CPU given the socket, core and cache ids its source uses, which need not be
+// dense or unique across sockets: cores are told apart by (socket, core). Its core class is
+// set by the next topology_classify
+static bool topology_add(Topology_t *topology, uint64_t socket, uint64_t core, uint64_t cache, uint32_t speed)
+{
+    TopologyCpu_t cpu = {(uint32_t) topology->sockets, (uint32_t) topology->cores, (uint32_t) topology->caches, 0,
+                         speed, 0};
+    bool new_socket = true, new_core = true, new_cache = true;
+    for (size_t i = 0; i < dyn_array_size(topology->cpus); ++i)
+    {
+        const uint64_t *ids = dyn_array_at(topology->raw, i);
+        const TopologyCpu_t *other = dyn_array_at(topology->cpus, i);
+        if (ids[0] == socket && new_socket)
+        {
+            cpu.socket = other->socket;
+            new_socket = false;
+        }
+        if (ids[0] == socket && ids[1] == core)
+        {
+            cpu.core = other->core;
+            cpu.thread = other->thread + 1 > cpu.thread ? other->thread + 1 : cpu.thread;
+            new_core = false;
+        }
+        if (ids[2] == cache && new_cache)
+        {
+            cpu.cache = other->cache;
+            new_cache = false;
+        }
+    }
+    const uint64_t ids[3] = {socket, core, cache};
+    if (!dyn_array_push_back(topology->cpus, &cpu) || !dyn_array_push_back(topology->raw, ids))
+    {
+        return false;
+    }
+    topology->sockets += new_socket;
+    topology->cores += new_core;
+    topology->caches += new_cache;
+    return true;
+}
+
+static int cmpfuncSpeed(const void *a, const void *b)
+{
+    const uint32_t speed_a = *(const uint32_t *) a;
+    const uint32_t speed_b = *(const uint32_t *) b;
+    return speed_a < speed_b ? -1 : (speed_a > speed_b);
+}
+
+// Numbers the core classes by ascending speed
+static bool topology_classify(Topology_t *topology)
+{
+    const size_t n = dyn_array_size(topology->cpus);
+    dyn_array_t *speeds = dyn_array_create(n, sizeof(uint32_t), NULL);
+    for (size_t i = 0; speeds && i < n; ++i)
+    {
+        if (!dyn_array_push_back(speeds, &((TopologyCpu_t *) dyn_array_at(topology->cpus, i))->speed))
+        {
+            dyn_array_destroy(speeds);
+            speeds = NULL;
+        }
+    }
+    if (!speeds)
+    {
+        return false;
+    }
+    dyn_array_sort(speeds, cmpfuncSpeed);
+    // keep one of each speed
+    uint32_t *distinct = dyn_array_front(speeds);
+    size_t classes = 0;
+    for (size_t i = 0; i < n; ++i)
+    {
+        if (!classes || distinct[classes - 1] != distinct[i])
+        {
+            distinct[classes++] = distinct[i];
+        }
+    }
+    for (size_t i = 0; i < n; ++i)
+    {
+        TopologyCpu_t *cpu = dyn_array_at(topology->cpus, i);
+        const uint32_t *found = bsearch(&cpu->speed, distinct, classes, sizeof(uint32_t), cmpfuncSpeed);
+        cpu->speed_class = (uint32_t) (found - distinct);
+    }
+    topology->classes = classes;
+    dyn_array_destroy(speeds);
+    return true;
+}
+
+Topology_t *topology_create_uniform(uint32_t sockets, uint32_t cores, uint32_t threads)
+{
+    if (!sockets || !cores || !threads)
+    {
+        return NULL;
+    }
+    Topology_t *topology = topology_create();
+    for (uint32_t s = 0; topology && s < sockets; ++s)
+    {
+        for (uint32_t c = 0; topology && c < cores; ++c)
+        {
+            for (uint32_t t = 0; topology && t < threads; ++t)
+            {
+                if (!topology_add(topology, s, c, s, TOPOLOGY_SPEED_REFERENCE))
+                {
+                    topology_destroy(topology);
+                    topology = NULL;
+                }
+            }
+        }
+    }
+    if (topology && !topology_classify(topology))
+    {
+        topology_destroy(topology);
+        topology = NULL;
+    }
+    return topology;
+}
+
+Topology_t *topology_load(const char *path)
+{
+    FILE *file = path ? fopen(path, "r") : NULL;
+    if (!file)
+    {
+        return NULL;
+    }
+    Topology_t *topology = topology_create();
+    char line[TOPOLOGY_LINE_MAX];
+    while (topology && fgets(line, sizeof(line), file))
+    {
+        line[strcspn(line, "#\r\n")] = '\0';
+        char keyword[16];
+        unsigned long long a, b, c, d;
+        const int fields = sscanf(line, "%15s %llu %llu %llu %llu", keyword, &a, &b, &c, &d);
+        bool ok = fields <= 0;
+        if ((fields == 4 || (fields == 5 && d && d <= UINT32_MAX)) && strcmp(keyword, "cpu") == 0)
+        {
+            ok = topology_add(topology, a, b, c, fields == 5 ? (uint32_t) d : TOPOLOGY_SPEED_REFERENCE);
+        }
+        else if (fields == 4 && strcmp(keyword, "speed") == 0 && a <= b && b < dyn_array_size(topology->cpus)
+                 && c && c <= UINT32_MAX)
+        {
+            for (unsigned long long cpu = a; cpu <= b; ++cpu)
+            {
+                ((TopologyCpu_t *) dyn_array_at(topology->cpus, cpu))->speed = (uint32_t) c;
+            }
+            ok = true;
+        }
+        else if (fields == 4 && strcmp(keyword, "uniform") == 0 && a && b && c)
+        {
+            ok = true;
+            for (unsigned long long s = 0; ok && s < a; ++s)
+            {
+                for (unsigned long long core = 0; ok && core < b; ++core)
+                {
+                    for (unsigned long long t = 0; ok && t < c; ++t)
+                    {
+                        // offset the ids past any cpu lines so they stay distinct
+                        const uint64_t base = (uint64_t) 1 << 40;
+                        ok = topology_add(topology, base + s, core, base + s, TOPOLOGY_SPEED_REFERENCE);
+                    }
+                }
+            }
+        }
+        else if (fields == 5 && strcmp(keyword, "migrate") == 0)
+        {
+            topology->costs.migrate[TOPOLOGY_SMT] = (uint32_t) a;
+            topology->costs.migrate[TOPOLOGY_CACHE] = (uint32_t) b;
+            topology->costs.migrate[TOPOLOGY_SOCKET] = (uint32_t) c;
+            topology->costs.migrate[TOPOLOGY_REMOTE] = (uint32_t) d;
+            ok = true;
+        }
+        else if (fields == 2 && strcmp(keyword, "remote") == 0)
+        {
+            topology->costs.remote_percent = (uint32_t) a;
+            ok = true;
+        }
+        else if (fields == 2 && strcmp(keyword, "smt") == 0)
+        {
+            topology->costs.smt_percent = (uint32_t) a;
+            ok = true;
+        }
+        if (!ok)
+        {
+            topology_destroy(topology);
+            topology = NULL;
+        }
+    }
+    fclose(file);
+    if (topology && (!dyn_array_size(topology->cpus) || !topology_classify(topology)))
+    {
+        topology_destroy(topology);
+        topology = NULL;
+    }
+    return topology;
+}
+
+// Reads the first unsigned number in a sysfs file
+static bool read_number(const char *path, unsigned long long *value)
+{
+    FILE *file = fopen(path, "r");
+    if (!file)
+    {
+        return false;
+    }
+    const bool ok = fscanf(file, "%llu", value) == 1;
+    fclose(file);
+    return ok;
+}
+
+static int cmpfuncCpuId(const void *a, const void *b)
+{
+    const unsigned long long id_a = *(const unsigned long long *) a;
+    const unsigned long long id_b = *(const unsigned long long *) b;
+    return id_a < id_b ? -1 : (id_a > id_b);
+}
+
+// Finds the last level cache of a CPU: the highest level index, named by its id or, on older
+// kernels without one, by the first CPU sharing it
+static bool detect_cache(const char *root, unsigned long long cpu, unsigned long long *cache)
+{
+    char path[TOPOLOGY_LINE_MAX];
+    unsigned long long best_level = 0;
+    for (int index = 0;; ++index)
+    {
+        unsigned long long level, id;
+        snprintf(path, sizeof(path), "%s/cpu%llu/cache/index%d/level", root, cpu, index);
+        if (!read_number(path, &level))
+        {
+            break;
+        }
+        if (level < best_level)
+        {
+            continue;
+        }
+        snprintf(path, sizeof(path), "%s/cpu%llu/cache/index%d/id", root, cpu, index);
+        if (!read_number(path, &id))
+        {
+            snprintf(path, sizeof(path), "%s/cpu%llu/cache/index%d/shared_cpu_list", root, cpu, index);
+            if (!read_number(path, &id))
+            {
+                continue;
+            }
+        }
+        // level and id live in separate spaces, keep them apart
+        *cache = (level << 32) | id;
+        best_level = level;
+    }
+    return best_level != 0;
+}
+
+Topology_t *topology_detect(const char *root)
+{
+    root = root ? root : "/sys/devices/system/cpu";
+    DIR *dir = opendir(root);
+    if (!dir)
+    {
+        return NULL;
+    }
+    dyn_array_t *ids = dyn_array_create(0, sizeof(unsigned long long), NULL);
+    for (struct dirent *entry = readdir(dir); ids && entry; entry = readdir(dir))
+    {
+        char *end;
+        if (strncmp(entry->d_name, "cpu", 3) != 0 || entry->d_name[3] < '0' || entry->d_name[3] > '9')
+        {
+            continue;
+        }
+        const unsigned long long id = strtoull(entry->d_name + 3, &end, 10);
+        if (*end == '\0' && !dyn_array_push_back(ids, &id))
+        {
+            dyn_array_destroy(ids);
+            ids = NULL;
+        }
+    }
+    closedir(dir);
+    if (!ids)
+    {
+        return NULL;
+    }
+    dyn_array_sort(ids, cmpfuncCpuId);
+
+    Topology_t *topology = topology_create();
+    char path[TOPOLOGY_LINE_MAX];
+    // relative capacities of asymmetric CPUs, scaled to speeds once the largest is known
+    dyn_array_t *capacities = dyn_array_create(0, sizeof(unsigned long long), NULL);
+    unsigned long long max_capacity = 0;
+    if (!capacities)
+    {
+        topology_destroy(topology);
+        topology = NULL;
+    }
+    for (size_t i = 0; topology && i < dyn_array_size(ids); ++i)
+    {
+        const unsigned long long cpu = *(unsigned long long *) dyn_array_at(ids, i);
+        unsigned long long online = 1, socket, core, cache, capacity = 0;
+        // cpu0 often has no online file, it cannot be taken offline
+        snprintf(path, sizeof(path), "%s/cpu%llu/online", root, cpu);
+        read_number(path, &online);
+        snprintf(path, sizeof(path), "%s/cpu%llu/topology/physical_package_id", root, cpu);
+        if (!online || !read_number(path, &socket))
+        {
+            continue;
+        }
+        snprintf(path, sizeof(path), "%s/cpu%llu/topology/core_id", root, cpu);
+        if (!read_number(path, &core))
+        {
+            core = cpu;
+        }
+        if (!detect_cache(root, cpu, &cache))
+        {
+            cache = socket;
+        }
+        snprintf(path, sizeof(path), "%s/cpu%llu/cpu_capacity", root, cpu);
+        read_number(path, &capacity);
+        max_capacity = capacity > max_capacity ? capacity : max_capacity;
+        if (!topology_add(topology, socket, core, cache, TOPOLOGY_SPEED_REFERENCE)
+            || !dyn_array_push_back(capacities, &capacity))
+        {
+            topology_destroy(topology);
+            topology = NULL;
+        }
+    }
+    for (size_t i = 0; topology && max_capacity && i < dyn_array_size(capacities); ++i)
+    {
+        const unsigned long long capacity = *(unsigned long long *) dyn_array_at(capacities, i);
+        // a CPU without a capacity of its own (0) is taken to be one of the biggest cores
+        const unsigned long long speed = capacity ? capacity * TOPOLOGY_SPEED_REFERENCE / max_capacity
+                                                  : TOPOLOGY_SPEED_REFERENCE;
+        ((TopologyCpu_t *) dyn_array_at(topology->cpus, i))->speed = speed ? (uint32_t) speed : 1;
+    }
+    dyn_array_destroy(capacities);
+    dyn_array_destroy(ids);
+    if (topology && (!dyn_array_size(topology->cpus) || !topology_classify(topology)))
+    {
+        topology_destroy(topology);
+        topology = NULL;
+    }
+    return topology;
+}
+
+size_t topology_cpus(const Topology_t *topology)
+{
+    return topology ? dyn_array_size(topology->cpus) : 0;
+}
+
+const TopologyCpu_t *topology_cpu(const Topology_t *topology, size_t cpu)
+{
+    if (!topology || cpu >= dyn_array_size(topology->cpus))
+    {
+        return NULL;
+    }
+    return dyn_array_at(topology->cpus, cpu);
+}
+
+size_t topology_sockets(const Topology_t *topology)
+{
+    return topology ? topology->sockets : 0;
+}
+
+bool topology_set_speed(Topology_t *topology, size_t cpu, uint32_t speed)
+{
+    if (!topology || cpu >= dyn_array_size(topology->cpus) || !speed)
+    {
+        return false;
+    }
+    ((TopologyCpu_t *) dyn_array_at(topology->cpus, cpu))->speed = speed;
+    return topology_classify(topology);
+}
+
+size_t topology_classes(const Topology_t *topology)
+{
+    return topology ? topology->classes : 0;
+}
+
+TopologyDistance_t topology_distance(const Topology_t *topology, size_t a, size_t b)
+{
+    const TopologyCpu_t *cpu_a = topology_cpu(topology, a);
+    const TopologyCpu_t *cpu_b = topology_cpu(topology, b);
+    if (!cpu_a || !cpu_b)
+    {
+        return TOPOLOGY_REMOTE;
+    }
+    if (a == b)
+    {
+        return TOPOLOGY_SAME;
+    }
+    if (cpu_a->core == cpu_b->core)
+    {
+        return TOPOLOGY_SMT;
+    }
+    if (cpu_a->cache == cpu_b->cache)
+    {
+        return TOPOLOGY_CACHE;
+    }
+    return cpu_a->socket == cpu_b->socket ? TOPOLOGY_SOCKET : TOPOLOGY_REMOTE;
+}
+
+const TopologyCosts_t *topology_costs(const Topology_t *topology)
+{
+    return topology ? &topology->costs : NULL;
+}
+
+void topology_set_costs(Topology_t *topology, const TopologyCosts_t *costs)
+{
+    if (topology && costs)
+    {
+        topology->costs = *costs;
+    }
+}
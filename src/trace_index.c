@@ -0,0 +1,325 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "dyn_array.h"
+#include "dyn_array_parallel.h"
+#include "processing_scheduling.h"
+#include "trace_index.h"
+
+#define BLOCK_ASCENDING 0x1u
+#define BLOCK_UNREAD 0x80000000u    // only while building: the block's read failed
+
+// What the index knows about one block
+typedef struct
+{
+    uint32_t min;
+    uint32_t max;
+    uint32_t flags;
+}
+TraceIndexBlock_t;
+
+struct trace_index
+{
+    uint64_t records;
+    uint64_t trace_size;
+    int64_t trace_mtime;
+    bool sorted;
+    dyn_array_t *blocks;    // TraceIndexBlock_t
+};
+
+// Shared by the block readers of one build
+typedef struct
+{
+    int fd;
+    const TraceIndexBlock_t *first;
+    uint64_t records;
+}
+TraceIndexBuild_t;
+
+static const char trace_index_magic[4] = {'T', 'I', 'X', '1'};
+
+static bool trace_stat(const char *trace_path, uint64_t *size, int64_t *mtime)
+{
+    struct stat info;
+    if (!trace_path || stat(trace_path, &info) != 0)
+    {
+        return false;
+    }
+    *size = (uint64_t) info.st_size;
+    *mtime = (int64_t) info.st_mtim.tv_sec * 1000000000 + info.st_mtim.tv_nsec;
+    return true;
+}
+
+static TraceIndex_t *trace_index_create(size_t blocks)
+{
+    TraceIndex_t *index = (TraceIndex_t *) calloc(1, sizeof(TraceIndex_t));
+    if (index)
+    {
+        index->blocks = dyn_array_create(blocks, sizeof(TraceIndexBlock_t), NULL);
+        if (index->blocks && dyn_array_resize(index->blocks, blocks, NULL))
+        {
+            return index;
+        }
+        trace_index_destroy(index);
+    }
+    return NULL;
+}
+
+// A trace is sorted if every block is and each block starts no earlier than the last one ended
+static bool trace_index_check_sorted(const TraceIndex_t *index)
+{
+    const size_t count = dyn_array_size(index->blocks);
+    const TraceIndexBlock_t *blocks = dyn_array_export(index->blocks);
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (!(blocks[i].flags & BLOCK_ASCENDING) || (i && blocks[i - 1].max > blocks[i].min))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// dyn_array_parallel_for_each_grain callback: summarises the block the entry stands for
+static void trace_index_read_block(void *const object, void *arg)
+{
+    TraceIndexBlock_t *block = (TraceIndexBlock_t *) object;
+    const TraceIndexBuild_t *build = (const TraceIndexBuild_t *) arg;
+    const uint64_t first = (uint64_t) (block - build->first) * TRACE_INDEX_BLOCK;
+    const size_t count = build->records - first < TRACE_INDEX_BLOCK ? (size_t) (build->records - first)
+                                                                     : TRACE_INDEX_BLOCK;
+
+    ProcessControlBlock_t pcbs[TRACE_INDEX_BLOCK];
+    const size_t bytes = count * sizeof(ProcessControlBlock_t);
+    if (pread(build->fd, pcbs, bytes, (off_t) (first * sizeof(ProcessControlBlock_t))) != (ssize_t) bytes)
+    {
+        block->flags = BLOCK_UNREAD;
+        return;
+    }
+
+    block->min = block->max = pcbs[0].arrival;
+    block->flags = BLOCK_ASCENDING;
+    for (size_t i = 1; i < count; ++i)
+    {
+        const uint32_t arrival = pcbs[i].arrival;
+        if (arrival < pcbs[i - 1].arrival)
+        {
+            block->flags = 0;
+        }
+        block->min = arrival < block->min ? arrival : block->min;
+        block->max = arrival > block->max ? arrival : block->max;
+    }
+}
+
+TraceIndex_t *trace_index_build(const char *trace_path, size_t threads)
+{
+    uint64_t size;
+    int64_t mtime;
+    if (!trace_stat(trace_path, &size, &mtime))
+    {
+        return NULL;
+    }
+    const uint64_t records = size / sizeof(ProcessControlBlock_t);
+    TraceIndex_t *index = trace_index_create((size_t) ((records + TRACE_INDEX_BLOCK - 1) / TRACE_INDEX_BLOCK));
+    if (!index)
+    {
+        return NULL;
+    }
+    index->records = records;
+    index->trace_size = size;
+    index->trace_mtime = mtime;
+
+    TraceIndexBuild_t build = {open(trace_path, O_RDONLY), dyn_array_export(index->blocks), records};
+    bool read_all = build.fd >= 0
+                    && dyn_array_parallel_for_each_grain(index->blocks, trace_index_read_block, &build, threads,
+                                                         TRACE_INDEX_GRAIN);
+    for (size_t i = 0; read_all && i < dyn_array_size(index->blocks); ++i)
+    {
+        read_all = !(((TraceIndexBlock_t *) dyn_array_at(index->blocks, i))->flags & BLOCK_UNREAD);
+    }
+    if (build.fd >= 0)
+    {
+        close(build.fd);
+    }
+    if (!read_all)
+    {
+        trace_index_destroy(index);
+        return NULL;
+    }
+    index->sorted = trace_index_check_sorted(index);
+    return index;
+}
+
+TraceIndex_t *trace_index_read(const char *index_path, const char *trace_path)
+{
+    uint64_t size;
+    int64_t mtime;
+    FILE *file = index_path && trace_stat(trace_path, &size, &mtime) ? fopen(index_path, "rb") : NULL;
+    if (!file)
+    {
+        return NULL;
+    }
+
+    char magic[4];
+    uint32_t block_records;
+    uint64_t records, trace_size, block_count;
+    int64_t trace_mtime;
+    TraceIndex_t *index = NULL;
+    if (fread(magic, sizeof(magic), 1, file) == 1 && memcmp(magic, trace_index_magic, sizeof(magic)) == 0
+        && fread(&block_records, sizeof(block_records), 1, file) == 1 && block_records == TRACE_INDEX_BLOCK
+        && fread(&records, sizeof(records), 1, file) == 1 && fread(&trace_size, sizeof(trace_size), 1, file) == 1
+        && fread(&trace_mtime, sizeof(trace_mtime), 1, file) == 1
+        && fread(&block_count, sizeof(block_count), 1, file) == 1
+        && trace_size == size && trace_mtime == mtime && records == size / sizeof(ProcessControlBlock_t)
+        && block_count == (records + TRACE_INDEX_BLOCK - 1) / TRACE_INDEX_BLOCK)
+    {
+        index = trace_index_create((size_t) block_count);
+        if (index && (!block_count
+                      || fread(dyn_array_at(index->blocks, 0), sizeof(TraceIndexBlock_t), (size_t) block_count, file)
+                             == block_count))
+        {
+            index->records = records;
+            index->trace_size = trace_size;
+            index->trace_mtime = trace_mtime;
+            index->sorted = trace_index_check_sorted(index);
+        }
+        else
+        {
+            trace_index_destroy(index);
+            index = NULL;
+        }
+    }
+    fclose(file);
+    return index;
+}
+
+bool trace_index_write(const TraceIndex_t *index, const char *index_path)
+{
+    if (!index || !index_path)
+    {
+        return false;
+    }
+    // the temporary name sits next to the index so the rename cannot cross file systems
+    const size_t length = strlen(index_path);
+    char *temporary = (char *) malloc(length + 32);
+    if (!temporary)
+    {
+        return false;
+    }
+    snprintf(temporary, length + 32, "%s.%ld.tmp", index_path, (long) getpid());
+    FILE *file = fopen(temporary, "wb");
+    if (!file)
+    {
+        free(temporary);
+        return false;
+    }
+
+    const uint32_t block_records = TRACE_INDEX_BLOCK;
+    const uint64_t block_count = dyn_array_size(index->blocks);
+    bool ok = fwrite(trace_index_magic, sizeof(trace_index_magic), 1, file) == 1
+              && fwrite(&block_records, sizeof(block_records), 1, file) == 1
+              && fwrite(&index->records, sizeof(index->records), 1, file) == 1
+              && fwrite(&index->trace_size, sizeof(index->trace_size), 1, file) == 1
+              && fwrite(&index->trace_mtime, sizeof(index->trace_mtime), 1, file) == 1
+              && fwrite(&block_count, sizeof(block_count), 1, file) == 1
+              && (!block_count
+                  || fwrite(dyn_array_export(index->blocks), sizeof(TraceIndexBlock_t), (size_t) block_count, file)
+                         == block_count);
+    ok = ok && fflush(file) == 0 && fsync(fileno(file)) == 0;
+    ok = fclose(file) == 0 && ok;
+    ok = ok && rename(temporary, index_path) == 0;
+    if (!ok)
+    {
+        remove(temporary);
+    }
+    free(temporary);
+    return ok;
+}
+
+TraceIndex_t *trace_index_load(const char *trace_path, size_t threads)
+{
+    if (!trace_path)
+    {
+        return NULL;
+    }
+    const size_t length = strlen(trace_path);
+    char *index_path = (char *) malloc(length + sizeof(".idx"));
+    if (!index_path)
+    {
+        return NULL;
+    }
+    memcpy(index_path, trace_path, length);
+    memcpy(index_path + length, ".idx", sizeof(".idx"));
+
+    TraceIndex_t *index = trace_index_read(index_path, trace_path);
+    if (!index)
+    {
+        index = trace_index_build(trace_path, threads);
+        // storing it is an optimisation, a read-only directory just means rebuilding next time
+        trace_index_write(index, index_path);
+    }
+    free(index_path);
+    return index;
+}
+
+void trace_index_destroy(TraceIndex_t *index)
+{
+    if (index)
+    {
+        dyn_array_destroy(index->blocks);
+        free(index);
+    }
+}
+
+size_t trace_index_records(const TraceIndex_t *index)
+{
+    return index ? (size_t) index->records : 0;
+}
+
+bool trace_index_sorted(const TraceIndex_t *index)
+{
+    return index && index->sorted;
+}
+
+size_t trace_index_blocks(const TraceIndex_t *index)
+{
+    return index ? dyn_array_size(index->blocks) : 0;
+}
+
+bool trace_index_block_range(const TraceIndex_t *index, size_t block, uint32_t *min, uint32_t *max)
+{
+    const TraceIndexBlock_t *entry = index ? dyn_array_at(index->blocks, block) : NULL;
+    if (!entry || !min || !max)
+    {
+        return false;
+    }
+    *min = entry->min;
+    *max = entry->max;
+    return true;
+}
+
+size_t trace_index_seek(const TraceIndex_t *index, uint64_t arrival)
+{
+    // first block whose largest arrival reaches arrival
+    size_t low = 0;
+    size_t high = trace_index_blocks(index);
+    while (low < high)
+    {
+        const size_t middle = low + (high - low) / 2;
+        if (((TraceIndexBlock_t *) dyn_array_at(index->blocks, middle))->max < arrival)
+        {
+            low = middle + 1;
+        }
+        else
+        {
+            high = middle;
+        }
+    }
+    return low;
+}
@@ -0,0 +1,404 @@
+#include <stdio.h>
+
+#include "trace_index.h"
+#include "trace_merge.h"
+
+// PCBs read per fread, both when gathering an unsorted shard and when streaming a sorted one
+#define TRACE_BLOCK 256
+
+// A PCB of an unsorted shard's window and its record number in the file, for the tie break
+typedef struct
+{
+    ProcessControlBlock_t pcb;
+    uint32_t record;
+}
+TraceOrder_t;
+
+typedef struct
+{
+    FILE *file;
+    size_t records;             // whole PCBs in the file
+    dyn_array_t *order;         // TraceOrder_t of the window by (arrival, record), NULL if the file is sorted
+    size_t position;            // next position in arrival order
+    size_t end;                 // first position past the window
+    dyn_array_t *block;         // read-ahead of a sorted shard
+    size_t block_next;          // next PCB in block
+    ProcessControlBlock_t head; // smallest unread PCB, while has_head
+    bool has_head;
+}
+TraceShard_t;
+
+struct trace_merge
+{
+    dyn_array_t *shards;        // TraceShard_t
+    dyn_array_t *heap;          // shard indices, min-heap on (head arrival, shard index)
+    TraceWindow_t window;
+    size_t skipped;
+    size_t emitted;
+    bool failed;
+};
+
+void trace_window_init(TraceWindow_t *window)
+{
+    if (window)
+    {
+        window->arrival_start = 0;
+        window->arrival_end = UINT32_MAX;
+        window->first_pcb = 0;
+        window->pcb_count = SIZE_MAX;
+    }
+}
+
+static int cmpfuncOrder(const void *a, const void *b)
+{
+    const TraceOrder_t *order_a = (const TraceOrder_t *) a;
+    const TraceOrder_t *order_b = (const TraceOrder_t *) b;
+    if (order_a->pcb.arrival != order_b->pcb.arrival)
+    {
+        return order_a->pcb.arrival < order_b->pcb.arrival ? -1 : 1;
+    }
+    return order_a->record < order_b->record ? -1 : (order_a->record > order_b->record);
+}
+
+// Position of the first record arriving at or after arrival in a sorted shard. The index
+// narrows it to one block, which is read in one go and searched in memory
+static bool shard_seek(TraceShard_t *shard, const TraceIndex_t *index, uint64_t arrival, size_t *position)
+{
+    const size_t block = trace_index_seek(index, arrival);
+    size_t low = block * TRACE_INDEX_BLOCK;
+    if (low >= shard->records)
+    {
+        *position = shard->records;
+        return true;
+    }
+    const size_t count = shard->records - low < TRACE_INDEX_BLOCK ? shard->records - low : TRACE_INDEX_BLOCK;
+    ProcessControlBlock_t pcbs[TRACE_INDEX_BLOCK];
+    if (fseek(shard->file, (long) (low * sizeof(ProcessControlBlock_t)), SEEK_SET) != 0
+        || fread(pcbs, sizeof(ProcessControlBlock_t), count, shard->file) != count)
+    {
+        return false;
+    }
+    size_t first = 0, last = count;
+    while (first < last)
+    {
+        const size_t middle = first + (last - first) / 2;
+        if (pcbs[middle].arrival < arrival)
+        {
+            first = middle + 1;
+        }
+        else
+        {
+            last = middle;
+        }
+    }
+    *position = low + first;
+    return true;
+}
+
+// Collects the window's PCBs of an unsorted shard, from the blocks that can hold window
+// arrivals, and sorts them by (arrival, record) so they come out without further reads
+static bool shard_gather(TraceShard_t *shard, const TraceIndex_t *index, const TraceWindow_t *window)
+{
+    shard->order = shard->records <= UINT32_MAX ? dyn_array_create(0, sizeof(TraceOrder_t), NULL) : NULL;
+    if (!shard->order)
+    {
+        return false;
+    }
+
+    ProcessControlBlock_t block[TRACE_BLOCK];
+    for (size_t b = 0; b < trace_index_blocks(index); ++b)
+    {
+        uint32_t min, max;
+        trace_index_block_range(index, b, &min, &max);
+        if (max < window->arrival_start || min > window->arrival_end)
+        {
+            continue;
+        }
+        const size_t first = b * TRACE_INDEX_BLOCK;
+        const size_t last = shard->records - first < TRACE_INDEX_BLOCK ? shard->records : first + TRACE_INDEX_BLOCK;
+        if (fseek(shard->file, (long) (first * sizeof(ProcessControlBlock_t)), SEEK_SET) != 0)
+        {
+            return false;
+        }
+        for (size_t record = first; record < last;)
+        {
+            const size_t wanted = last - record < TRACE_BLOCK ? last - record : TRACE_BLOCK;
+            if (fread(block, sizeof(ProcessControlBlock_t), wanted, shard->file) != wanted)
+            {
+                return false;
+            }
+            for (size_t i = 0; i < wanted; ++i, ++record)
+            {
+                TraceOrder_t entry = {block[i], (uint32_t) record};
+                if (entry.pcb.arrival >= window->arrival_start && entry.pcb.arrival <= window->arrival_end
+                    && !dyn_array_push_back(shard->order, &entry))
+                {
+                    return false;
+                }
+            }
+        }
+    }
+    shard->end = dyn_array_size(shard->order);
+    return !shard->end || dyn_array_sort(shard->order, cmpfuncOrder);
+}
+
+// Loads the next PCB in the window into head, has_head is false once there is none
+static bool shard_advance(TraceShard_t *shard)
+{
+    shard->has_head = false;
+    if (shard->position >= shard->end)
+    {
+        return true;
+    }
+
+    if (shard->order)
+    {
+        shard->head = ((const TraceOrder_t *) dyn_array_at(shard->order, shard->position))->pcb;
+    }
+    else
+    {
+        if (shard->block_next == dyn_array_size(shard->block))
+        {
+            const size_t wanted = shard->end - shard->position < TRACE_BLOCK ? shard->end - shard->position
+                                                                               : TRACE_BLOCK;
+            if (!dyn_array_resize(shard->block, wanted, NULL)
+                || fread(dyn_array_at(shard->block, 0), sizeof(ProcessControlBlock_t), wanted, shard->file) != wanted)
+            {
+                return false;
+            }
+            shard->block_next = 0;
+        }
+        shard->head = *(ProcessControlBlock_t *) dyn_array_at(shard->block, shard->block_next++);
+    }
+    ++shard->position;
+    shard->has_head = true;
+    return true;
+}
+
+static bool shard_open(TraceShard_t *shard, const char *path, const TraceWindow_t *window)
+{
+    memset(shard, 0, sizeof(*shard));
+    shard->file = path ? fopen(path, "rb") : NULL;
+    shard->block = dyn_array_create(TRACE_BLOCK, sizeof(ProcessControlBlock_t), NULL);
+    TraceIndex_t *index = shard->file ? trace_index_load(path, 0) : NULL;
+    if (!shard->block || !index)
+    {
+        trace_index_destroy(index);
+        return false;
+    }
+    shard->records = trace_index_records(index);
+
+    bool ok;
+    if (trace_index_sorted(index))
+    {
+        // a sorted shard streams from the window start on
+        ok = shard_seek(shard, index, window->arrival_start, &shard->position)
+             && shard_seek(shard, index, (uint64_t) window->arrival_end + 1, &shard->end)
+             && fseek(shard->file, (long) (shard->position * sizeof(ProcessControlBlock_t)), SEEK_SET) == 0;
+    }
+    else
+    {
+        ok = shard_gather(shard, index, window);
+    }
+    trace_index_destroy(index);
+    return ok && shard_advance(shard);
+}
+
+static void shard_close(TraceShard_t *shard)
+{
+    if (shard->file)
+    {
+        fclose(shard->file);
+    }
+    dyn_array_destroy(shard->order);
+    dyn_array_destroy(shard->block);
+}
+
+static TraceShard_t *merge_shard(const TraceMerge_t *merge, size_t heap_index)
+{
+    return dyn_array_at(merge->shards, *(size_t *) dyn_array_at(merge->heap, heap_index));
+}
+
+// Whether heap entry a comes out before heap entry b
+static bool merge_before(const TraceMerge_t *merge, size_t a, size_t b)
+{
+    const uint32_t arrival_a = merge_shard(merge, a)->head.arrival;
+    const uint32_t arrival_b = merge_shard(merge, b)->head.arrival;
+    if (arrival_a != arrival_b)
+    {
+        return arrival_a < arrival_b;
+    }
+    return *(size_t *) dyn_array_at(merge->heap, a) < *(size_t *) dyn_array_at(merge->heap, b);
+}
+
+static void merge_swap(TraceMerge_t *merge, size_t a, size_t b)
+{
+    size_t *slot_a = dyn_array_at(merge->heap, a);
+    size_t *slot_b = dyn_array_at(merge->heap, b);
+    const size_t shard = *slot_a;
+    *slot_a = *slot_b;
+    *slot_b = shard;
+}
+
+static void merge_sift_down(TraceMerge_t *merge, size_t index)
+{
+    const size_t n = dyn_array_size(merge->heap);
+    for (;;)
+    {
+        size_t smallest = index;
+        const size_t left = 2 * index + 1;
+        if (left < n && merge_before(merge, left, smallest))
+        {
+            smallest = left;
+        }
+        if (left + 1 < n && merge_before(merge, left + 1, smallest))
+        {
+            smallest = left + 1;
+        }
+        if (smallest == index)
+        {
+            return;
+        }
+        merge_swap(merge, index, smallest);
+        index = smallest;
+    }
+}
+
+// Takes the smallest head out of the heap and refills from its shard
+static bool merge_pop(TraceMerge_t *merge, ProcessControlBlock_t *pcb)
+{
+    if (dyn_array_empty(merge->heap))
+    {
+        return false;
+    }
+    TraceShard_t *shard = merge_shard(merge, 0);
+    *pcb = shard->head;
+    if (!shard_advance(shard))
+    {
+        merge->failed = true;
+        return false;
+    }
+    if (!shard->has_head)
+    {
+        merge_swap(merge, 0, dyn_array_size(merge->heap) - 1);
+        dyn_array_pop_back(merge->heap);
+    }
+    merge_sift_down(merge, 0);
+    return true;
+}
+
+TraceMerge_t *trace_merge_open(const char *const *paths, size_t count, const TraceWindow_t *window)
+{
+    TraceWindow_t everything;
+    trace_window_init(&everything);
+    if (!window)
+    {
+        window = &everything;
+    }
+    if (!paths || !count || window->arrival_start > window->arrival_end)
+    {
+        return NULL;
+    }
+
+    TraceMerge_t *merge = (TraceMerge_t *) calloc(1, sizeof(TraceMerge_t));
+    if (!merge)
+    {
+        return NULL;
+    }
+    merge->window = *window;
+    merge->shards = dyn_array_create(count, sizeof(TraceShard_t), NULL);
+    merge->heap = dyn_array_create(count, sizeof(size_t), NULL);
+    if (!merge->shards || !merge->heap)
+    {
+        trace_merge_close(merge);
+        return NULL;
+    }
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        TraceShard_t shard;
+        const bool opened = shard_open(&shard, paths[i], window);
+        if (!opened || !dyn_array_push_back(merge->shards, &shard))
+        {
+            shard_close(&shard);
+            trace_merge_close(merge);
+            return NULL;
+        }
+        if (shard.has_head)
+        {
+            dyn_array_push_back(merge->heap, &i);
+        }
+    }
+    // heapify
+    for (size_t i = dyn_array_size(merge->heap) / 2; i-- > 0;)
+    {
+        merge_sift_down(merge, i);
+    }
+    return merge;
+}
+
+bool trace_merge_next(TraceMerge_t *merge, ProcessControlBlock_t *pcb)
+{
+    if (!merge || !pcb || merge->failed)
+    {
+        return false;
+    }
+    for (; merge->skipped < merge->window.first_pcb; ++merge->skipped)
+    {
+        if (!merge_pop(merge, pcb))
+        {
+            return false;
+        }
+    }
+    if (merge->emitted >= merge->window.pcb_count || !merge_pop(merge, pcb))
+    {
+        return false;
+    }
+    ++merge->emitted;
+    return true;
+}
+
+bool trace_merge_failed(const TraceMerge_t *merge)
+{
+    return !merge || merge->failed;
+}
+
+void trace_merge_close(TraceMerge_t *merge)
+{
+    if (merge)
+    {
+        for (size_t i = 0; i < dyn_array_size(merge->shards); ++i)
+        {
+            shard_close(dyn_array_at(merge->shards, i));
+        }
+        dyn_array_destroy(merge->shards);
+        dyn_array_destroy(merge->heap);
+        free(merge);
+    }
+}
+
+dyn_array_t *trace_merge_load(const char *const *paths, size_t count, const TraceWindow_t *window)
+{
+    TraceMerge_t *merge = trace_merge_open(paths, count, window);
+    dyn_array_t *pcb_array = merge ? dyn_array_create(0, sizeof(ProcessControlBlock_t), NULL) : NULL;
+    if (pcb_array)
+    {
+        ProcessControlBlock_t pcb;
+        while (trace_merge_next(merge, &pcb))
+        {
+            if (!dyn_array_push_back(pcb_array, &pcb))
+            {
+                dyn_array_destroy(pcb_array);
+                pcb_array = NULL;
+                break;
+            }
+        }
+        if (pcb_array && trace_merge_failed(merge))
+        {
+            dyn_array_destroy(pcb_array);
+            pcb_array = NULL;
+        }
+    }
+    trace_merge_close(merge);
+    return pcb_array;
+}
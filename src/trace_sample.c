@@ -0,0 +1,285 @@
+#include <math.h>
+#include <string.h>
+
+#include "dyn_array.h"
+#include "timeline.h"
+#include "trace_index.h"
+#include "trace_merge.h"
+#include "trace_sample.h"
+
+// What one simulated window measured
+typedef struct
+{
+    double turnaround;      // summed over the measured PCBs
+    double waiting;
+    size_t pcbs;
+    uint64_t clock;         // clock when the window's run finished
+}
+SampleWindow_t;
+
+void trace_sample_config_init(TraceSampleConfig_t *config)
+{
+    if (config)
+    {
+        config->windows = 32;
+        config->window_length = 10000;
+        config->warmup = 1000;
+        config->confidence = 0.95;
+        config->error_bound = 0.05;
+        config->seed = 1;
+    }
+}
+
+static uint64_t splitmix64(uint64_t *state)
+{
+    uint64_t z = (*state += 0x9e3779b97f4a7c15ull);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+    return z ^ (z >> 31);
+}
+
+// z such that a standard normal lands in [-z, z] with probability confidence
+static double normal_quantile(double confidence)
+{
+    double low = 0.0, high = 10.0;
+    for (int i = 0; i < 64; ++i)
+    {
+        const double middle = (low + high) / 2;
+        if (erfc(middle / sqrt(2.0)) > 1.0 - confidence)
+        {
+            low = middle;
+        }
+        else
+        {
+            high = middle;
+        }
+    }
+    return (low + high) / 2;
+}
+
+// Counts the PCBs and finds the arrival span of the shards from their indexes
+static bool sample_span(const char *const *paths, size_t count, size_t *records, uint32_t *first, uint32_t *last)
+{
+    *records = 0;
+    *first = UINT32_MAX;
+    *last = 0;
+    for (size_t i = 0; i < count; ++i)
+    {
+        TraceIndex_t *index = trace_index_load(paths[i], 0);
+        if (!index)
+        {
+            return false;
+        }
+        *records += trace_index_records(index);
+        for (size_t block = 0; block < trace_index_blocks(index); ++block)
+        {
+            uint32_t min, max;
+            trace_index_block_range(index, block, &min, &max);
+            *first = min < *first ? min : *first;
+            *last = max > *last ? max : *last;
+        }
+        trace_index_destroy(index);
+    }
+    return true;
+}
+
+// Simulates the PCBs arriving in [start - warmup, end] and measures those arriving from start on
+static bool sample_window(const char *const *paths, size_t count, const ScheduleConfig_t *config,
+                          uint32_t warmup_start, uint32_t start, uint32_t end, Timeline_t *timeline,
+                          SampleWindow_t *window)
+{
+    memset(window, 0, sizeof(*window));
+    TraceWindow_t range;
+    trace_window_init(&range);
+    range.arrival_start = warmup_start;
+    range.arrival_end = end;
+    dyn_array_t *ready_queue = trace_merge_load(paths, count, &range);
+    if (!ready_queue)
+    {
+        return false;
+    }
+    const size_t n = dyn_array_size(ready_queue);
+    if (!n)
+    {
+        dyn_array_destroy(ready_queue);
+        return true;
+    }
+
+    // the queue is in arrival order, so the measured PCBs are a suffix; keep their arrivals
+    // and bursts, which the run consumes, and collect their completions from the timeline
+    size_t measured = 0;
+    while (measured < n && ((ProcessControlBlock_t *) dyn_array_at(ready_queue, measured))->arrival < start)
+    {
+        ++measured;
+    }
+    dyn_array_t *pcbs = dyn_array_create(n - measured, sizeof(ProcessControlBlock_t), NULL);
+    dyn_array_t *completions = dyn_array_create(n - measured, sizeof(uint64_t), NULL);
+    bool ok = pcbs && completions
+              && dyn_array_append_n(pcbs, dyn_array_at(ready_queue, measured), n - measured)
+              && dyn_array_resize(completions, n - measured, NULL);
+
+    ScheduleConfig_t run = *config;
+    run.timeline = timeline;
+    run.stats = NULL;
+    run.bursts = NULL;
+    run.deadlines = NULL;
+    run.deadline_stats = NULL;
+    run.admission = false;
+    ScheduleResult_t result = {0, 0, 0};
+    timeline_clear(timeline);
+    ok = ok && schedule_run(ready_queue, &result, &run);
+
+    for (size_t i = 0; ok && i < timeline_size(timeline); ++i)
+    {
+        const TimelineSegment_t *segment = timeline_at(timeline, i);
+        if (segment->pid >= measured)
+        {
+            uint64_t *completion = dyn_array_at(completions, segment->pid - measured);
+            const uint64_t segment_end = segment->start + segment->length;
+            *completion = segment_end > *completion ? segment_end : *completion;
+        }
+    }
+    for (size_t i = 0; ok && i < n - measured; ++i)
+    {
+        const ProcessControlBlock_t *pcb = dyn_array_at(pcbs, i);
+        const uint64_t completion = *(uint64_t *) dyn_array_at(completions, i);
+        // zero length bursts never show up in the timeline, count them as done on arrival
+        const double turnaround = completion > pcb->arrival ? (double) (completion - pcb->arrival) : 0.0;
+        window->turnaround += turnaround;
+        window->waiting += turnaround > pcb->remaining_burst_time ? turnaround - pcb->remaining_burst_time : 0.0;
+    }
+    window->pcbs = n - measured;
+    window->clock = result.total_run_time;
+
+    dyn_array_destroy(pcbs);
+    dyn_array_destroy(completions);
+    dyn_array_destroy(ready_queue);
+    return ok;
+}
+
+// Replays the whole trace
+static bool sample_full(const char *const *paths, size_t count, const ScheduleConfig_t *config,
+                        TraceSampleResult_t *result)
+{
+    dyn_array_t *ready_queue = trace_merge_load(paths, count, NULL);
+    if (!ready_queue)
+    {
+        return false;
+    }
+    ScheduleConfig_t run = *config;
+    run.timeline = NULL;
+    run.stats = NULL;
+    run.bursts = NULL;
+    run.deadlines = NULL;
+    run.deadline_stats = NULL;
+    run.admission = false;
+    const bool ok = schedule_run(ready_queue, &result->result, &run);
+    result->sampled_pcbs = dyn_array_size(ready_queue);
+    result->waiting_half_width = 0;
+    result->turnaround_half_width = 0;
+    result->exact = true;
+    dyn_array_destroy(ready_queue);
+    return ok;
+}
+
+// Half width of the ratio estimate total / pcbs over the windows
+static double sample_half_width(const dyn_array_t *windows, size_t offset, double ratio, double pcbs,
+                                double sampled_fraction, double z)
+{
+    const size_t m = dyn_array_size(windows);
+    double squares = 0;
+    for (size_t i = 0; i < m; ++i)
+    {
+        const SampleWindow_t *window = dyn_array_at(windows, i);
+        const double total = *(const double *) ((const char *) window + offset);
+        const double residual = total - ratio * window->pcbs;
+        squares += residual * residual;
+    }
+    const double mean_pcbs = pcbs / m;
+    const double variance = (1.0 - sampled_fraction) * squares / ((double) m * (m - 1) * mean_pcbs * mean_pcbs);
+    return z * sqrt(variance > 0 ? variance : 0);
+}
+
+bool trace_sample_run(const char *const *paths, size_t count, const ScheduleConfig_t *config,
+                      const TraceSampleConfig_t *sample, TraceSampleResult_t *result)
+{
+    if (!paths || !count || !config || !sample || !result || !sample->windows || !sample->window_length
+        || !(sample->confidence > 0 && sample->confidence < 1) || !(sample->error_bound >= 0))
+    {
+        return false;
+    }
+    memset(result, 0, sizeof(*result));
+
+    uint32_t first, last;
+    if (!sample_span(paths, count, &result->total_pcbs, &first, &last))
+    {
+        return false;
+    }
+    const uint64_t span = result->total_pcbs ? (uint64_t) last - first + 1 : 0;
+    const uint64_t stratum = span / sample->windows;
+    if (stratum <= sample->window_length)
+    {
+        // the windows would cover (nearly) everything anyway
+        return sample_full(paths, count, config, result);
+    }
+
+    dyn_array_t *windows = dyn_array_create(sample->windows, sizeof(SampleWindow_t), NULL);
+    Timeline_t *timeline = timeline_create();
+    bool ok = windows && timeline;
+    uint64_t state = sample->seed;
+    for (size_t i = 0; ok && i < sample->windows; ++i)
+    {
+        const uint64_t stratum_start = first + i * stratum;
+        const uint64_t start = i + 1 == sample->windows
+            ? (uint64_t) last - sample->window_length + 1
+            : stratum_start + splitmix64(&state) % (stratum - sample->window_length + 1);
+        const uint64_t warmup_start = start - first > sample->warmup ? start - sample->warmup : first;
+        SampleWindow_t window;
+        ok = sample_window(paths, count, config, (uint32_t) warmup_start, (uint32_t) start,
+                           (uint32_t) (start + sample->window_length - 1), timeline, &window)
+             && dyn_array_push_back(windows, &window);
+        result->result.total_run_time = window.clock;
+    }
+    timeline_destroy(timeline);
+    if (!ok)
+    {
+        dyn_array_destroy(windows);
+        return false;
+    }
+
+    double turnaround = 0, waiting = 0, pcbs = 0;
+    size_t filled = 0;
+    for (size_t i = 0; i < dyn_array_size(windows); ++i)
+    {
+        const SampleWindow_t *window = dyn_array_at(windows, i);
+        turnaround += window->turnaround;
+        waiting += window->waiting;
+        pcbs += window->pcbs;
+        filled += window->pcbs != 0;
+    }
+    if (filled < 2)
+    {
+        dyn_array_destroy(windows);
+        return sample_full(paths, count, config, result);
+    }
+
+    const double mean_turnaround = turnaround / pcbs;
+    const double mean_waiting = waiting / pcbs;
+    const double z = normal_quantile(sample->confidence);
+    const double sampled_fraction = (double) sample->windows * sample->window_length / span;
+    result->turnaround_half_width = sample_half_width(windows, offsetof(SampleWindow_t, turnaround),
+                                                      mean_turnaround, pcbs, sampled_fraction, z);
+    result->waiting_half_width = sample_half_width(windows, offsetof(SampleWindow_t, waiting), mean_waiting, pcbs,
+                                                   sampled_fraction, z);
+    result->result.average_turnaround_time = (float) mean_turnaround;
+    result->result.average_waiting_time = (float) mean_waiting;
+    result->sampled_pcbs = (size_t) pcbs;
+    dyn_array_destroy(windows);
+
+    if (result->turnaround_half_width > sample->error_bound * mean_turnaround
+        || result->waiting_half_width > sample->error_bound * (mean_waiting > 1.0 ? mean_waiting : 1.0))
+    {
+        return sample_full(paths, count, config, result);
+    }
+    return true;
+}
@@ -1,14 +1,36 @@
 #include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
 #include <stdio.h>
 #include "gtest/gtest.h"
 #include <pthread.h>
+#include "../include/instrument.h"
 #include "../include/processing_scheduling.h"
+#include "../include/realtime.h"
+#include "../include/result_cache.h"
+#include "../include/sched_daemon.h"
+#include "../include/autotune.h"
+#include "../include/group_tree.h"
+#include "../include/topology.h"
+#include "../include/timeline.h"
+#include "../include/burst_arena.h"
+#include "../include/mpsc_queue.h"
+#include "../include/runtime.h"
+#include "../include/coexec.h"
+#include "../include/dyn_array_parallel.h"
+#include "../include/dyn_array_concurrent.h"
+#include "../include/simd_argmin.h"
+#include "../include/trace_index.h"
+#include "../include/trace_merge.h"
+#include "../include/trace_sample.h"
 
 // Using a C library requires extern "C" to prevent function managling
 extern "C" 
 {
 #include <dyn_array.h>
 }
+#include "../include/dyn_array.hpp"
+#include "../include/sched_kernel.hpp"
 
 
 #define NUM_PCB 30
@@ -197,6 +219,557 @@ TEST(load_process_control_blocks, Valid_File)
 }
 
 
+//Checks a file bigger than the initial guess loads completely in one pass
+TEST(load_process_control_blocks, LoadsWholeFile)
+{
+    ProcessControlBlock_t pcbs[1000];
+    for (uint32_t i = 0; i < 1000; ++i)
+    {
+        pcbs[i] = ProcessControlBlock_t{i + 1, i % 7, i, false};
+    }
+    FILE *file = fopen("load_test.bin", "wb");
+    ASSERT_TRUE(file != NULL);
+    fwrite(pcbs, sizeof(pcbs[0]), 1000, file);
+    fclose(file);
+
+    dyn_array_t *loaded = load_process_control_blocks("load_test.bin");
+    remove("load_test.bin");
+    ASSERT_TRUE(loaded != NULL);
+    ASSERT_EQ((size_t)1000, dyn_array_size(loaded));
+    EXPECT_EQ(0, memcmp(pcbs, dyn_array_export(loaded), sizeof(pcbs)));
+    dyn_array_destroy(loaded);
+}
+
+
+//Bulk dyn_array operation tests
+
+
+//Checks ranges are inserted, erased and extracted in order
+TEST(dyn_array_bulk, RangeOperations)
+{
+    const int values[] = {0, 1, 2, 3, 4, 5, 6, 7};
+    const int middle[] = {10, 11, 12};
+    dyn_array_t *array = dyn_array_create(0, sizeof(int), NULL);
+    ASSERT_TRUE(dyn_array_append_n(array, values, 8));
+    ASSERT_TRUE(dyn_array_insert_n(array, 4, middle, 3));
+    EXPECT_EQ(12, *(int *)dyn_array_at(array, 6));
+    EXPECT_EQ(4, *(int *)dyn_array_at(array, 7));
+
+    int out[3];
+    ASSERT_TRUE(dyn_array_extract_range(array, 4, 3, out));
+    EXPECT_EQ(0, memcmp(out, middle, sizeof(middle)));
+    EXPECT_EQ(0, memcmp(dyn_array_export(array), values, sizeof(values)));
+
+    ASSERT_TRUE(dyn_array_erase_range(array, 2, 5));
+    EXPECT_EQ((size_t)3, dyn_array_size(array));
+    EXPECT_EQ(7, *(int *)dyn_array_at(array, 2));
+    EXPECT_FALSE(dyn_array_erase_range(array, 2, 2));
+    EXPECT_FALSE(dyn_array_erase_range(array, 1, SIZE_MAX));
+    EXPECT_TRUE(dyn_array_append_n(array, values, 0));
+    EXPECT_TRUE(dyn_array_append_n(array, NULL, 0));
+    EXPECT_TRUE(dyn_array_insert_n(array, 3, NULL, 0));
+    EXPECT_FALSE(dyn_array_insert_n(array, 4, NULL, 0));
+    EXPECT_FALSE(dyn_array_append_n(array, NULL, 1));
+    dyn_array_destroy(array);
+}
+
+//Checks capacity management and resizing with and without a fill value
+TEST(dyn_array_bulk, ReserveResizeShrink)
+{
+    dyn_array_t *array = dyn_array_create(0, sizeof(int), NULL);
+    ASSERT_TRUE(dyn_array_reserve(array, 1000));
+    EXPECT_LE((size_t)1000, dyn_array_capacity(array));
+
+    const int seven = 7;
+    ASSERT_TRUE(dyn_array_resize(array, 10, NULL));
+    ASSERT_TRUE(dyn_array_resize(array, 20, &seven));
+    EXPECT_EQ(0, *(int *)dyn_array_at(array, 9));
+    EXPECT_EQ(7, *(int *)dyn_array_at(array, 19));
+
+    ASSERT_TRUE(dyn_array_resize(array, 5, NULL));
+    ASSERT_TRUE(dyn_array_shrink_to_fit(array));
+    EXPECT_EQ((size_t)5, dyn_array_capacity(array));
+    ASSERT_TRUE(dyn_array_push_back(array, &seven));
+    EXPECT_EQ((size_t)6, dyn_array_size(array));
+    EXPECT_FALSE(dyn_array_reserve(NULL, 1));
+    dyn_array_destroy(array);
+}
+
+
+
+//Trace merge tests
+
+
+static void write_shard(const char *path, const std::vector<ProcessControlBlock_t> &pcbs)
+{
+    FILE *file = fopen(path, "wb");
+    ASSERT_TRUE(file != NULL);
+    fwrite(pcbs.data(), sizeof(ProcessControlBlock_t), pcbs.size(), file);
+    fclose(file);
+}
+
+//Checks shards merge by arrival, ties by shard then file order, sorted or not
+TEST(trace_merge, MergesByArrival)
+{
+    std::vector<ProcessControlBlock_t> sorted, unsorted, big;
+    for (uint32_t i = 0; i < 1000; ++i)
+    {
+        sorted.push_back(ProcessControlBlock_t{1, 0, i * 3, false});
+        big.push_back(ProcessControlBlock_t{3, 0, i * 2, false});
+    }
+    for (uint32_t i = 0; i < 500; ++i)
+    {
+        unsorted.push_back(ProcessControlBlock_t{2, i, (i * 7) % 500 * 3, false});
+    }
+    write_shard("merge_a.bin", sorted);
+    write_shard("merge_b.bin", unsorted);
+    write_shard("merge_c.bin", big);
+    const char *paths[] = {"merge_a.bin", "merge_b.bin", "merge_c.bin"};
+
+    dyn_array_t *all = trace_merge_load(paths, 3, NULL);
+    ASSERT_TRUE(all != NULL);
+    ASSERT_EQ((size_t)2500, dyn_array_size(all));
+    for (size_t i = 1; i < 2500; ++i)
+    {
+        const ProcessControlBlock_t *a = (ProcessControlBlock_t *)dyn_array_at(all, i - 1);
+        const ProcessControlBlock_t *b = (ProcessControlBlock_t *)dyn_array_at(all, i);
+        ASSERT_TRUE(a->arrival < b->arrival || (a->arrival == b->arrival && a->remaining_burst_time <= b->remaining_burst_time));
+    }
+
+    TraceWindow_t window;
+    trace_window_init(&window);
+    window.arrival_start = 600;
+    window.arrival_end = 899;
+    dyn_array_t *slice = trace_merge_load(paths, 3, &window);
+    ASSERT_TRUE(slice != NULL);
+    // 100 + 150 arrivals from the regular shards, 100 from the permuted one
+    EXPECT_EQ((size_t)350, dyn_array_size(slice));
+    EXPECT_EQ((uint32_t)600, ((ProcessControlBlock_t *)dyn_array_at(slice, 0))->arrival);
+    EXPECT_EQ((uint32_t)898, ((ProcessControlBlock_t *)dyn_array_back(slice))->arrival);
+
+    window.first_pcb = 10;
+    window.pcb_count = 5;
+    dyn_array_t *range = trace_merge_load(paths, 3, &window);
+    ASSERT_TRUE(range != NULL);
+    ASSERT_EQ((size_t)5, dyn_array_size(range));
+    EXPECT_EQ(0, memcmp(dyn_array_at(slice, 10), dyn_array_export(range), 5 * sizeof(ProcessControlBlock_t)));
+
+    remove("merge_a.bin");
+    remove("merge_b.bin");
+    remove("merge_c.bin");
+    remove("merge_a.bin.idx");
+    remove("merge_b.bin.idx");
+    remove("merge_c.bin.idx");
+    dyn_array_destroy(all);
+    dyn_array_destroy(slice);
+    dyn_array_destroy(range);
+}
+
+//Checks missing shards and bad windows fail, and empty windows give empty queues
+TEST(trace_merge, Errors)
+{
+    std::vector<ProcessControlBlock_t> pcbs(10, ProcessControlBlock_t{1, 0, 5, false});
+    write_shard("merge_d.bin", pcbs);
+    const char *paths[] = {"merge_d.bin", "merge_missing.bin"};
+    EXPECT_TRUE(trace_merge_load(paths, 2, NULL) == NULL);
+    EXPECT_TRUE(trace_merge_open(paths, 0, NULL) == NULL);
+
+    TraceWindow_t window;
+    trace_window_init(&window);
+    window.arrival_start = 6;
+    dyn_array_t *empty = trace_merge_load(paths, 1, &window);
+    ASSERT_TRUE(empty != NULL);
+    EXPECT_EQ((size_t)0, dyn_array_size(empty));
+    window.arrival_end = 5;
+    EXPECT_TRUE(trace_merge_open(paths, 1, &window) == NULL);
+    dyn_array_destroy(empty);
+    remove("merge_d.bin");
+    remove("merge_d.bin.idx");
+}
+
+
+//Trace index tests
+
+
+//Checks block ranges and seeking on a sorted trace spanning several blocks and build grains
+TEST(trace_index, SeeksSortedTrace)
+{
+    const size_t blocks = 3 * TRACE_INDEX_GRAIN + 1;
+    std::vector<ProcessControlBlock_t> pcbs;
+    for (uint32_t i = 0; i < (blocks - 1) * TRACE_INDEX_BLOCK + 10; ++i)
+    {
+        pcbs.push_back(ProcessControlBlock_t{1, 0, i * 2, false});
+    }
+    write_shard("index_sorted.bin", pcbs);
+
+    TraceIndex_t *index = trace_index_build("index_sorted.bin", 2);
+    ASSERT_TRUE(index != NULL);
+    EXPECT_EQ(pcbs.size(), trace_index_records(index));
+    EXPECT_EQ(blocks, trace_index_blocks(index));
+    EXPECT_TRUE(trace_index_sorted(index));
+    uint32_t min, max;
+    ASSERT_TRUE(trace_index_block_range(index, 1, &min, &max));
+    EXPECT_EQ((uint32_t)(2 * TRACE_INDEX_BLOCK), min);
+    EXPECT_EQ((uint32_t)(4 * TRACE_INDEX_BLOCK - 2), max);
+    ASSERT_TRUE(trace_index_block_range(index, blocks - 1, &min, &max));
+    EXPECT_EQ((uint32_t)(2 * (blocks - 1) * TRACE_INDEX_BLOCK), min);
+    EXPECT_EQ((uint32_t)(2 * ((blocks - 1) * TRACE_INDEX_BLOCK + 9)), max);
+    EXPECT_FALSE(trace_index_block_range(index, blocks, &min, &max));
+
+    EXPECT_EQ((size_t)0, trace_index_seek(index, 0));
+    EXPECT_EQ((size_t)1, trace_index_seek(index, 2 * TRACE_INDEX_BLOCK - 1));
+    EXPECT_EQ((size_t)3, trace_index_seek(index, 6 * TRACE_INDEX_BLOCK + 1));
+    EXPECT_EQ(blocks, trace_index_seek(index, UINT32_MAX));
+
+    // a window in the middle of a later block merges to exactly its PCBs
+    TraceWindow_t window;
+    trace_window_init(&window);
+    window.arrival_start = 4 * TRACE_INDEX_BLOCK + 101;
+    window.arrival_end = 4 * TRACE_INDEX_BLOCK + 200;
+    const char *paths[] = {"index_sorted.bin"};
+    dyn_array_t *slice = trace_merge_load(paths, 1, &window);
+    ASSERT_TRUE(slice != NULL);
+    EXPECT_EQ((size_t)50, dyn_array_size(slice));
+    EXPECT_EQ((uint32_t)(4 * TRACE_INDEX_BLOCK + 102), ((ProcessControlBlock_t *)dyn_array_at(slice, 0))->arrival);
+
+    dyn_array_destroy(slice);
+    trace_index_destroy(index);
+    remove("index_sorted.bin");
+    remove("index_sorted.bin.idx");
+}
+
+//Checks an index round trips through its file and is rejected once the trace changes
+TEST(trace_index, FileRoundTripAndStaleness)
+{
+    std::vector<ProcessControlBlock_t> pcbs;
+    for (uint32_t i = 0; i < 2 * TRACE_INDEX_BLOCK; ++i)
+    {
+        pcbs.push_back(ProcessControlBlock_t{1, 0, (i * 37) % 1000, false});
+    }
+    write_shard("index_unsorted.bin", pcbs);
+
+    TraceIndex_t *built = trace_index_load("index_unsorted.bin", 0);
+    ASSERT_TRUE(built != NULL);
+    EXPECT_FALSE(trace_index_sorted(built));
+    TraceIndex_t *read = trace_index_read("index_unsorted.bin.idx", "index_unsorted.bin");
+    ASSERT_TRUE(read != NULL);
+    EXPECT_EQ(trace_index_records(built), trace_index_records(read));
+    ASSERT_EQ(trace_index_blocks(built), trace_index_blocks(read));
+    for (size_t b = 0; b < trace_index_blocks(built); ++b)
+    {
+        uint32_t built_min, built_max, read_min, read_max;
+        ASSERT_TRUE(trace_index_block_range(built, b, &built_min, &built_max));
+        ASSERT_TRUE(trace_index_block_range(read, b, &read_min, &read_max));
+        EXPECT_EQ(built_min, read_min);
+        EXPECT_EQ(built_max, read_max);
+    }
+
+    pcbs.push_back(ProcessControlBlock_t{1, 0, 5, false});
+    write_shard("index_unsorted.bin", pcbs);
+    EXPECT_TRUE(trace_index_read("index_unsorted.bin.idx", "index_unsorted.bin") == NULL);
+    TraceIndex_t *rebuilt = trace_index_load("index_unsorted.bin", 0);
+    ASSERT_TRUE(rebuilt != NULL);
+    EXPECT_EQ(pcbs.size(), trace_index_records(rebuilt));
+    EXPECT_EQ((size_t)3, trace_index_blocks(rebuilt));
+
+    trace_index_destroy(built);
+    trace_index_destroy(read);
+    trace_index_destroy(rebuilt);
+    remove("index_unsorted.bin");
+    remove("index_unsorted.bin.idx");
+}
+
+
+//Trace sample tests
+
+
+// A long single CPU trace around 70% busy, the same every time
+static std::vector<ProcessControlBlock_t> sample_trace(size_t count)
+{
+    std::vector<ProcessControlBlock_t> pcbs;
+    uint32_t state = 12345, arrival = 0;
+    for (size_t i = 0; i < count; ++i)
+    {
+        state = state * 1103515245u + 12345u;
+        arrival += (state >> 16) % 6;
+        pcbs.push_back(ProcessControlBlock_t{1 + (state >> 8) % 3, (state >> 4) % 10, arrival, false});
+    }
+    return pcbs;
+}
+
+//Checks a sampled estimate lands near the full replay and reports its interval
+TEST(trace_sample, EstimatesNearFullRun)
+{
+    write_shard("sample_big.bin", sample_trace(100000));
+    const char *paths[] = {"sample_big.bin"};
+    ScheduleConfig_t config;
+    schedule_config_init(&config, SCHEDULE_SJF);
+    TraceSampleConfig_t sample;
+    trace_sample_config_init(&sample);
+    sample.windows = 16;
+    sample.window_length = 2000;
+    sample.error_bound = 0.2;
+
+    TraceSampleResult_t estimate;
+    ASSERT_TRUE(trace_sample_run(paths, 1, &config, &sample, &estimate));
+    EXPECT_FALSE(estimate.exact);
+    EXPECT_EQ((size_t)100000, estimate.total_pcbs);
+    EXPECT_LT(estimate.sampled_pcbs, (size_t)20000);
+    EXPECT_GT(estimate.turnaround_half_width, 0.0);
+
+    dyn_array_t *all = trace_merge_load(paths, 1, NULL);
+    ASSERT_TRUE(all != NULL);
+    ScheduleResult_t exact = {0, 0, 0};
+    ASSERT_TRUE(schedule_run(all, &exact, &config));
+    EXPECT_NEAR(exact.average_turnaround_time, estimate.result.average_turnaround_time,
+                2 * estimate.turnaround_half_width);
+    EXPECT_NEAR(exact.average_waiting_time, estimate.result.average_waiting_time, 2 * estimate.waiting_half_width);
+    EXPECT_NEAR((double)exact.total_run_time, (double)estimate.result.total_run_time, exact.total_run_time * 0.01);
+
+    dyn_array_destroy(all);
+    remove("sample_big.bin");
+    remove("sample_big.bin.idx");
+}
+
+//Checks a missed error bound, or a trace too short to sample, falls back to the exact replay
+TEST(trace_sample, FallsBackToFullRun)
+{
+    write_shard("sample_small.bin", sample_trace(20000));
+    const char *paths[] = {"sample_small.bin"};
+    ScheduleConfig_t config;
+    schedule_config_init(&config, SCHEDULE_RR);
+    config.quantum = 2;
+    TraceSampleConfig_t sample;
+    trace_sample_config_init(&sample);
+    sample.windows = 8;
+    sample.window_length = 500;
+    sample.error_bound = 0;
+
+    dyn_array_t *all = trace_merge_load(paths, 1, NULL);
+    ASSERT_TRUE(all != NULL);
+    ScheduleResult_t exact = {0, 0, 0};
+    ASSERT_TRUE(schedule_run(all, &exact, &config));
+
+    TraceSampleResult_t estimate;
+    ASSERT_TRUE(trace_sample_run(paths, 1, &config, &sample, &estimate));
+    EXPECT_TRUE(estimate.exact);
+    EXPECT_EQ((size_t)20000, estimate.sampled_pcbs);
+    EXPECT_EQ(exact.average_turnaround_time, estimate.result.average_turnaround_time);
+    EXPECT_EQ(exact.total_run_time, estimate.result.total_run_time);
+
+    sample.error_bound = 0.05;
+    sample.window_length = 10000;
+    ASSERT_TRUE(trace_sample_run(paths, 1, &config, &sample, &estimate));
+    EXPECT_TRUE(estimate.exact);
+    sample.confidence = 1;
+    EXPECT_FALSE(trace_sample_run(paths, 1, &config, &sample, &estimate));
+
+    dyn_array_destroy(all);
+    remove("sample_small.bin");
+    remove("sample_small.bin.idx");
+}
+
+//Small dyn_array tests
+
+
+static int destructed_objects = 0;
+
+static void count_destruct(void *)
+{
+    ++destructed_objects;
+}
+
+//Checks a local array keeps its objects in the caller's buffer until it outgrows it
+TEST(dyn_array_small, LocalStorageSpillsToHeap)
+{
+    DYN_ARRAY_LOCAL(queue, ProcessControlBlock_t, 4);
+    ASSERT_TRUE(queue != NULL);
+    for (uint32_t i = 0; i < 4; ++i)
+    {
+        ProcessControlBlock_t pcb = {i + 1, 0, i, false};
+        ASSERT_TRUE(dyn_array_push_back(queue, &pcb));
+    }
+    EXPECT_TRUE(dyn_array_front(queue) == (void *)queue_buffer);
+    EXPECT_EQ((size_t)4, dyn_array_capacity(queue));
+
+    ProcessControlBlock_t fifth = {5, 0, 4, false};
+    ASSERT_TRUE(dyn_array_push_back(queue, &fifth));
+    EXPECT_TRUE(dyn_array_front(queue) != (void *)queue_buffer);
+    for (uint32_t i = 0; i < 5; ++i)
+    {
+        EXPECT_EQ(i + 1, ((ProcessControlBlock_t *)dyn_array_at(queue, i))->remaining_burst_time);
+    }
+
+    ScheduleResult_t r = {0, 0, 0};
+    EXPECT_EQ(true, first_come_first_serve(queue, &r));
+    EXPECT_EQ((unsigned long)15, r.total_run_time);
+    dyn_array_deinit(queue);
+}
+
+//Checks single-allocation arrays grow, shrink and destruct like heap ones
+TEST(dyn_array_small, InlineCreateGrows)
+{
+    destructed_objects = 0;
+    dyn_array_t *array = dyn_array_create(4, sizeof(int), count_destruct);
+    for (int i = 0; i < 1000; ++i)
+    {
+        ASSERT_TRUE(dyn_array_push_back(array, &i));
+    }
+    for (int i = 0; i < 1000; ++i)
+    {
+        ASSERT_EQ(i, *(int *)dyn_array_at(array, i));
+    }
+    ASSERT_TRUE(dyn_array_resize(array, 10, NULL));
+    EXPECT_EQ(990, destructed_objects);
+    EXPECT_TRUE(dyn_array_shrink_to_fit(array));
+    dyn_array_destroy(array);
+    EXPECT_EQ(1000, destructed_objects);
+
+    dyn_array_storage_t storage;
+    dyn_array_t *empty = dyn_array_init(&storage, NULL, 0, sizeof(int), NULL);
+    int value = 7;
+    ASSERT_TRUE(dyn_array_push_back(empty, &value));
+    EXPECT_EQ(7, *(int *)dyn_array_front(empty));
+    dyn_array_deinit(empty);
+    EXPECT_TRUE(dyn_array_init(&storage, NULL, 4, sizeof(int), NULL) == NULL);
+}
+
+//Parallel dyn_array tests
+
+
+static void parallel_increment(void *const object, void *arg)
+{
+    *(uint32_t *)object += *(uint32_t *)arg;
+}
+
+struct ParallelSum
+{
+    float value;
+    uint64_t count;
+};
+
+static void parallel_fold(void *const accumulator, const void *const object, void *)
+{
+    ((ParallelSum *)accumulator)->value += *(const float *)object;
+    ((ParallelSum *)accumulator)->count += 1;
+}
+
+static void parallel_combine(void *const accumulator, const void *const partial, void *)
+{
+    ((ParallelSum *)accumulator)->value += ((const ParallelSum *)partial)->value;
+    ((ParallelSum *)accumulator)->count += ((const ParallelSum *)partial)->count;
+}
+
+//Checks every element is visited exactly once across many chunks and threads
+TEST(dyn_array_parallel, ForEachVisitsAll)
+{
+    dyn_array_t *array = dyn_array_create(0, sizeof(uint32_t), NULL);
+    ASSERT_TRUE(dyn_array_resize(array, 200003, NULL));
+    uint32_t step = 3;
+    ASSERT_TRUE(dyn_array_parallel_for_each(array, parallel_increment, &step, 4));
+    ASSERT_TRUE(dyn_array_parallel_for_each(array, parallel_increment, &step, 0));
+    for (size_t i = 0; i < dyn_array_size(array); ++i)
+    {
+        ASSERT_EQ(6u, *(uint32_t *)dyn_array_at(array, i));
+    }
+    EXPECT_FALSE(dyn_array_parallel_for_each(NULL, parallel_increment, &step, 1));
+    dyn_array_destroy(array);
+}
+
+//Checks floating point reductions give the same bits whatever the thread count
+TEST(dyn_array_parallel, ReduceIsDeterministic)
+{
+    dyn_array_t *array = dyn_array_create(0, sizeof(float), NULL);
+    for (uint32_t i = 0; i < 100000; ++i)
+    {
+        const float value = 1.0f / (1 + i % 977) + (i % 3 ? 1e4f : -1e4f);
+        dyn_array_push_back(array, &value);
+    }
+
+    ParallelSum single = {0, 0};
+    ASSERT_TRUE(dyn_array_reduce(array, &single, sizeof(single), parallel_fold, parallel_combine, NULL, 1));
+    EXPECT_EQ((uint64_t)100000, single.count);
+    for (size_t threads : {2, 3, 8, 0})
+    {
+        ParallelSum sum = {0, 0};
+        ASSERT_TRUE(dyn_array_reduce(array, &sum, sizeof(sum), parallel_fold, parallel_combine, NULL, threads));
+        EXPECT_EQ(0, memcmp(&single.value, &sum.value, sizeof(float)));
+        EXPECT_EQ(single.count, sum.count);
+    }
+    dyn_array_destroy(array);
+}
+
+
+//Concurrent dyn_array tests
+
+
+struct ConcurrentProducer
+{
+    dyn_array_concurrent_t *array;
+    uint32_t first;
+};
+
+static void *concurrent_produce(void *arg)
+{
+    ConcurrentProducer *producer = (ConcurrentProducer *)arg;
+    for (uint32_t i = 0; i < 20000; ++i)
+    {
+        const uint32_t value = producer->first + i;
+        dyn_array_concurrent_push_back(producer->array, &value, NULL);
+    }
+    return NULL;
+}
+
+//Checks every value pushed from concurrent producers lands exactly once
+TEST(dyn_array_concurrent, ConcurrentPushBack)
+{
+    dyn_array_concurrent_t *array = dyn_array_concurrent_create(sizeof(uint32_t));
+    ASSERT_TRUE(array != NULL);
+    pthread_t threads[8];
+    ConcurrentProducer producers[8];
+    for (uint32_t t = 0; t < 8; ++t)
+    {
+        producers[t] = ConcurrentProducer{array, t * 20000};
+        pthread_create(&threads[t], NULL, concurrent_produce, &producers[t]);
+    }
+    for (pthread_t &thread : threads)
+    {
+        pthread_join(thread, NULL);
+    }
+
+    ASSERT_EQ((size_t)160000, dyn_array_concurrent_size(array));
+    std::vector<bool> seen(160000, false);
+    for (size_t i = 0; i < 160000; ++i)
+    {
+        uint32_t *value = (uint32_t *)dyn_array_concurrent_at(array, i);
+        ASSERT_TRUE(value != NULL);
+        ASSERT_FALSE(seen[*value]);
+        seen[*value] = true;
+    }
+    dyn_array_concurrent_destroy(array);
+}
+
+//Checks growth never moves objects that were already pushed
+TEST(dyn_array_concurrent, PointersStayValid)
+{
+    dyn_array_concurrent_t *array = dyn_array_concurrent_create(sizeof(uint64_t));
+    const uint64_t first = 42;
+    size_t index = 1;
+    ASSERT_TRUE(dyn_array_concurrent_push_back(array, &first, &index));
+    EXPECT_EQ((size_t)0, index);
+    uint64_t *pointer = (uint64_t *)dyn_array_concurrent_at(array, 0);
+    for (uint64_t i = 1; i < 100000; ++i)
+    {
+        ASSERT_TRUE(dyn_array_concurrent_push_back(array, &i, &index));
+        EXPECT_EQ(i, index);
+    }
+    EXPECT_EQ(pointer, dyn_array_concurrent_at(array, 0));
+    EXPECT_EQ((uint64_t)42, *pointer);
+    EXPECT_EQ((uint64_t)99999, *(uint64_t *)dyn_array_concurrent_at(array, 99999));
+    EXPECT_TRUE(dyn_array_concurrent_at(array, 100000) == NULL);
+    dyn_array_concurrent_destroy(array);
+}
+
 //Shortest Remaining Time tests
 
 
@@ -243,4 +816,1955 @@ TEST(shortest_remaining_time_first, Valid_PCB)
     EXPECT_EQ((float)4.6, r.average_waiting_time);
     EXPECT_TRUE((float)9.2 == (float)r.average_turnaround_time);
     EXPECT_EQ((unsigned long)23, r.total_run_time);
-}
\ No newline at end of file
+}
+
+//Instrumentation tests
+
+
+//Checks the counters read back as zero after a reset
+TEST(instrument, ResetClearsCounters)
+{
+    instrument_reset();
+    InstrumentCounters_t counters;
+    instrument_snapshot(&counters);
+
+    EXPECT_EQ((uint64_t)0, counters.context_switches);
+    EXPECT_EQ((uint64_t)0, counters.memmove_bytes);
+    EXPECT_EQ((uint64_t)0, counters.comparator_calls);
+}
+
+//Checks a scheduler run is counted when instrumentation is compiled in
+TEST(instrument, CountsContextSwitches)
+{
+    dyn_array_t *t = dyn_array_create(4, sizeof(ProcessControlBlock_t), NULL);
+    ScheduleResult_t r = {0, 0, 0};
+    ProcessControlBlock_t pcb1 = {4, 0, 0, false};
+    ProcessControlBlock_t pcb2 = {4, 0, 0, false};
+
+    dyn_array_push_back(t, &pcb1);
+    dyn_array_push_back(t, &pcb2);
+
+    instrument_reset();
+    EXPECT_EQ(true, round_robin(t, &r, 2));
+
+    InstrumentCounters_t counters;
+    instrument_snapshot(&counters);
+    EXPECT_EQ((uint64_t)(instrument_enabled() ? 3 : 0), counters.context_switches);
+    dyn_array_destroy(t);
+}
+
+//Checks the trace file is a complete JSON document
+TEST(instrument, TraceFileIsClosed)
+{
+    ASSERT_TRUE(instrument_trace_open("instrument_trace.json"));
+    instrument_trace_slice(1, 0, 5);
+    instrument_trace_slice(2, 5, 3);
+    instrument_trace_close();
+
+    FILE *file = fopen("instrument_trace.json", "r");
+    ASSERT_TRUE(file != NULL);
+    char buffer[512] = {0};
+    size_t length = fread(buffer, 1, sizeof(buffer) - 1, file);
+    fclose(file);
+    remove("instrument_trace.json");
+
+    EXPECT_TRUE(strstr(buffer, "\"tid\":2,\"ts\":5,\"dur\":3") != NULL);
+    EXPECT_EQ(0, strcmp("\n]}\n", buffer + length - 4));
+}
+
+
+//Timeline tests
+
+
+//Checks adjacent slices of the same PCB are coalesced
+TEST(timeline, CoalescesAdjacentSlices)
+{
+    Timeline_t *timeline = timeline_create();
+    EXPECT_EQ(true, timeline_record(timeline, 1, 0, 2));
+    EXPECT_EQ(true, timeline_record(timeline, 1, 2, 3));
+    EXPECT_EQ(true, timeline_record(timeline, 2, 5, 1));
+    EXPECT_EQ(true, timeline_record(timeline, 2, 8, 1));
+
+    ASSERT_EQ((size_t)3, timeline_size(timeline));
+    EXPECT_EQ((uint32_t)5, timeline_at(timeline, 0)->length);
+    EXPECT_EQ((uint64_t)8, timeline_at(timeline, 2)->start);
+    timeline_destroy(timeline);
+}
+
+//Checks SRTF re-evaluations at arrivals do not split the running PCB's segment
+TEST(timeline, RecordsScheduleRun)
+{
+    dyn_array_t *t = dyn_array_create(4, sizeof(ProcessControlBlock_t), NULL);
+    ScheduleResult_t r = {0, 0, 0};
+    ProcessControlBlock_t pcb1 = {3, 0, 0, false};
+    ProcessControlBlock_t pcb2 = {5, 0, 1, false};
+    ProcessControlBlock_t pcb3 = {1, 0, 4, false};
+
+    dyn_array_push_back(t, &pcb1);
+    dyn_array_push_back(t, &pcb2);
+    dyn_array_push_back(t, &pcb3);
+
+    ScheduleConfig_t config;
+    schedule_config_init(&config, SCHEDULE_SRTF);
+    config.timeline = timeline_create();
+    EXPECT_EQ(true, schedule_run(t, &r, &config));
+
+    ASSERT_EQ((size_t)4, timeline_size(config.timeline));
+    EXPECT_EQ((uint32_t)0, timeline_at(config.timeline, 0)->pid);
+    EXPECT_EQ((uint32_t)3, timeline_at(config.timeline, 0)->length);
+    EXPECT_EQ((uint32_t)2, timeline_at(config.timeline, 2)->pid);
+    EXPECT_EQ((uint64_t)4, timeline_at(config.timeline, 2)->start);
+    EXPECT_EQ((uint32_t)1, timeline_at(config.timeline, 3)->pid);
+    EXPECT_EQ((uint32_t)4, timeline_at(config.timeline, 3)->length);
+    EXPECT_EQ((unsigned long)9, r.total_run_time);
+
+    timeline_destroy(config.timeline);
+    dyn_array_destroy(t);
+}
+
+//Checks the binary form reads back the same segments
+TEST(timeline, BinaryRoundTrip)
+{
+    Timeline_t *timeline = timeline_create();
+    timeline_record(timeline, 7, 3, 300);
+    timeline_record(timeline, 70000, 303, 1);
+    timeline_record(timeline, 7, 1000, 2);
+    ASSERT_TRUE(timeline_write_binary(timeline, "timeline_test.bin"));
+
+    Timeline_t *copy = timeline_read_binary("timeline_test.bin");
+    remove("timeline_test.bin");
+    ASSERT_TRUE(copy != NULL);
+    ASSERT_EQ(timeline_size(timeline), timeline_size(copy));
+    for (size_t i = 0; i < timeline_size(timeline); ++i)
+    {
+        EXPECT_EQ(timeline_at(timeline, i)->start, timeline_at(copy, i)->start);
+        EXPECT_EQ(timeline_at(timeline, i)->pid, timeline_at(copy, i)->pid);
+        EXPECT_EQ(timeline_at(timeline, i)->length, timeline_at(copy, i)->length);
+    }
+    timeline_destroy(copy);
+    timeline_destroy(timeline);
+}
+
+
+//MPSC queue and runtime tests
+
+
+struct MpscProducer
+{
+    MpscQueue_t *queue;
+    uintptr_t first;
+};
+
+static void *mpsc_produce(void *arg)
+{
+    MpscProducer *producer = (MpscProducer *)arg;
+    for (uintptr_t i = 0; i < 1000; ++i)
+    {
+        mpsc_queue_push(producer->queue, (void *)(producer->first + i));
+    }
+    return NULL;
+}
+
+//Checks items from concurrent producers all arrive, in order per producer
+TEST(mpsc_queue, ConcurrentProducers)
+{
+    MpscQueue_t *queue = mpsc_queue_create();
+    pthread_t threads[4];
+    MpscProducer producers[4];
+    for (int i = 0; i < 4; ++i)
+    {
+        producers[i].queue = queue;
+        producers[i].first = 1 + (uintptr_t)i * 1000000;
+        pthread_create(&threads[i], NULL, mpsc_produce, &producers[i]);
+    }
+
+    uintptr_t last[4] = {0, 0, 0, 0};
+    size_t received = 0;
+    while (received < 4000)
+    {
+        uintptr_t item = (uintptr_t)mpsc_queue_pop(queue);
+        if (item)
+        {
+            size_t producer = (item - 1) / 1000000;
+            EXPECT_LT(last[producer], item);
+            last[producer] = item;
+            ++received;
+        }
+    }
+    for (int i = 0; i < 4; ++i)
+    {
+        pthread_join(threads[i], NULL);
+    }
+
+    EXPECT_TRUE(mpsc_queue_pop(queue) == NULL);
+    mpsc_queue_destroy(queue);
+}
+
+static bool runtime_step(void *arg)
+{
+    // each task needs three steps
+    int *steps = (int *)arg;
+    return __atomic_add_fetch(steps, 1, __ATOMIC_SEQ_CST) % 3 != 0;
+}
+
+//Checks every submitted task runs to completion under round robin
+TEST(runtime, RoundRobinCompletesAll)
+{
+    ScheduleConfig_t config;
+    schedule_config_init(&config, SCHEDULE_RR);
+    Runtime_t *runtime = runtime_create(2, &config);
+    ASSERT_TRUE(runtime != NULL);
+
+    int steps[64] = {0};
+    ProcessControlBlock_t descriptor = {3, 0, 0, false};
+    for (int i = 0; i < 64; ++i)
+    {
+        EXPECT_EQ(true, runtime_submit(runtime, &descriptor, runtime_step, &steps[i]));
+    }
+    runtime_wait(runtime);
+
+    RuntimeStats_t stats;
+    EXPECT_EQ(true, runtime_stats(runtime, &stats));
+    EXPECT_EQ((uint64_t)64, stats.submitted);
+    EXPECT_EQ((uint64_t)64, stats.completed);
+    EXPECT_EQ((uint64_t)0, stats.dropped);
+    EXPECT_EQ((uint64_t)192, stats.dispatches);
+    for (int i = 0; i < 64; ++i)
+    {
+        EXPECT_EQ(3, steps[i]);
+    }
+    runtime_destroy(runtime);
+}
+
+//Checks a quantum is required for the preemptive policies
+TEST(runtime, RejectsZeroQuantum)
+{
+    ScheduleConfig_t config;
+    schedule_config_init(&config, SCHEDULE_SRTF);
+    config.quantum = 0;
+    EXPECT_TRUE(runtime_create(1, &config) == NULL);
+}
+
+
+//Coroutine executor tests
+
+
+struct CoexecLog
+{
+    char order[64];
+    size_t length;
+};
+
+struct CoexecWorker
+{
+    CoexecLog *log;
+    char name;
+    int ticks;
+};
+
+static void coexec_worker(void *arg)
+{
+    CoexecWorker *worker = (CoexecWorker *)arg;
+    for (int i = 0; i < worker->ticks; ++i)
+    {
+        worker->log->order[worker->log->length++] = worker->name;
+        coexec_tick(1);
+    }
+}
+
+//Checks round robin interleaves tasks one quantum at a time
+TEST(coexec, RoundRobinInterleaves)
+{
+    ScheduleConfig_t config;
+    schedule_config_init(&config, SCHEDULE_RR);
+    config.quantum = 2;
+    CoExecutor_t *executor = coexec_create(&config, 0);
+    ASSERT_TRUE(executor != NULL);
+
+    CoexecLog log = {{0}, 0};
+    CoexecWorker a = {&log, 'A', 3};
+    CoexecWorker b = {&log, 'B', 4};
+    ProcessControlBlock_t descriptor = {4, 0, 0, false};
+    EXPECT_EQ(true, coexec_spawn(executor, &descriptor, coexec_worker, &a));
+    EXPECT_EQ(true, coexec_spawn(executor, &descriptor, coexec_worker, &b));
+
+    CoExecStats_t stats;
+    EXPECT_EQ(true, coexec_run(executor, &stats));
+    EXPECT_STREQ("AABBABB", log.order);
+    EXPECT_EQ((uint64_t)2, stats.completed);
+    // B yields after its last tick, so it is resumed once more just to return
+    EXPECT_EQ((uint64_t)5, stats.dispatches);
+    coexec_destroy(executor);
+}
+
+//Checks SRTF picks by the remaining estimate and re-evaluates at quantum boundaries
+TEST(coexec, ShortestRemainingFirst)
+{
+    ScheduleConfig_t config;
+    schedule_config_init(&config, SCHEDULE_SRTF);
+    config.quantum = 2;
+    CoExecutor_t *executor = coexec_create(&config, 0);
+
+    CoexecLog log = {{0}, 0};
+    CoexecWorker a = {&log, 'A', 5};
+    CoexecWorker b = {&log, 'B', 3};
+    ProcessControlBlock_t long_job = {5, 0, 0, false};
+    ProcessControlBlock_t short_job = {3, 0, 0, false};
+    coexec_spawn(executor, &long_job, coexec_worker, &a);
+    coexec_spawn(executor, &short_job, coexec_worker, &b);
+
+    EXPECT_EQ(true, coexec_run(executor, NULL));
+    EXPECT_STREQ("BBBAAAAA", log.order);
+    coexec_destroy(executor);
+}
+
+
+//Cost model tests
+
+
+//Checks switch and refill costs are charged and reported separately
+TEST(cost_model, ChargesSwitchesAndRefills)
+{
+    dyn_array_t *t = dyn_array_create(4, sizeof(ProcessControlBlock_t), NULL);
+    ScheduleResult_t r = {0, 0, 0};
+    ProcessControlBlock_t pcb1 = {4, 0, 0, false};
+    ProcessControlBlock_t pcb2 = {2, 0, 0, false};
+
+    dyn_array_push_back(t, &pcb1);
+    dyn_array_push_back(t, &pcb2);
+
+    ScheduleConfig_t config;
+    ScheduleStats_t stats;
+    schedule_config_init(&config, SCHEDULE_RR);
+    config.quantum = 2;
+    config.stats = &stats;
+    config.costs.switch_cost = 1;
+    config.costs.refill_max = 4;
+    config.costs.refill_halflife = 2;
+    EXPECT_EQ(true, schedule_run(t, &r, &config));
+
+    // A(cold 4) runs 4..6, switch 1 + B(cold 4) runs 11..13,
+    // switch 1 + A back after 7 ticks off (4 * 7 / 9 = 3) runs 17..19
+    EXPECT_EQ((uint64_t)2, stats.context_switches);
+    EXPECT_EQ((uint64_t)2, stats.switch_overhead);
+    EXPECT_EQ((uint64_t)11, stats.refill_overhead);
+    EXPECT_EQ((unsigned long)19, r.total_run_time);
+    EXPECT_EQ((float)16, r.average_turnaround_time);
+    dyn_array_destroy(t);
+}
+
+//Checks the default model keeps switches free
+TEST(cost_model, DefaultIsFree)
+{
+    dyn_array_t *t = dyn_array_create(4, sizeof(ProcessControlBlock_t), NULL);
+    ScheduleResult_t r = {0, 0, 0};
+    ProcessControlBlock_t pcb1 = {4, 0, 0, false};
+    ProcessControlBlock_t pcb2 = {2, 0, 1, false};
+
+    dyn_array_push_back(t, &pcb1);
+    dyn_array_push_back(t, &pcb2);
+
+    ScheduleConfig_t config;
+    ScheduleStats_t stats;
+    schedule_config_init(&config, SCHEDULE_SRTF);
+    config.stats = &stats;
+    EXPECT_EQ(true, schedule_run(t, &r, &config));
+    EXPECT_EQ((uint64_t)0, stats.switch_overhead + stats.refill_overhead);
+    EXPECT_EQ((unsigned long)6, r.total_run_time);
+    dyn_array_destroy(t);
+}
+
+
+//CPU/I/O burst tests
+
+
+//Checks I/O phases overlap with other PCBs' CPU phases
+TEST(io_bursts, OverlapsCpuAndIo)
+{
+    dyn_array_t *t = dyn_array_create(4, sizeof(ProcessControlBlock_t), NULL);
+    ScheduleResult_t r = {0, 0, 0};
+    ProcessControlBlock_t pcb1 = {0, 0, 0, false};
+    ProcessControlBlock_t pcb2 = {0, 0, 0, false};
+    dyn_array_push_back(t, &pcb1);
+    dyn_array_push_back(t, &pcb2);
+
+    const uint32_t phases_a[] = {2, 3, 2};
+    const uint32_t phases_b[] = {4};
+    BurstArena_t *arena = burst_arena_create();
+    EXPECT_EQ(true, burst_arena_add(arena, phases_a, 3));
+    EXPECT_EQ(true, burst_arena_add(arena, phases_b, 1));
+    EXPECT_EQ(false, burst_arena_add(arena, phases_a, 2));
+
+    ScheduleConfig_t config;
+    ScheduleStats_t stats;
+    schedule_config_init(&config, SCHEDULE_FCFS);
+    config.bursts = arena;
+    config.stats = &stats;
+    EXPECT_EQ(true, schedule_run(t, &r, &config));
+
+    // A 0..2, I/O 2..5 while B runs 2..6, A again 6..8
+    EXPECT_EQ((unsigned long)8, r.total_run_time);
+    EXPECT_EQ((float)1.5, r.average_waiting_time);
+    EXPECT_EQ((float)7, r.average_turnaround_time);
+    EXPECT_EQ((uint64_t)8, stats.cpu_busy);
+    EXPECT_EQ((uint64_t)3, stats.io_busy);
+
+    burst_arena_destroy(arena);
+    dyn_array_destroy(t);
+}
+
+//Checks I/O queues FIFO behind a limited number of devices
+TEST(io_bursts, DeviceQueueing)
+{
+    dyn_array_t *t = dyn_array_create(4, sizeof(ProcessControlBlock_t), NULL);
+    ScheduleResult_t r = {0, 0, 0};
+    ProcessControlBlock_t pcb = {0, 0, 0, false};
+    dyn_array_push_back(t, &pcb);
+    dyn_array_push_back(t, &pcb);
+
+    const uint32_t phases[] = {1, 5, 1};
+    BurstArena_t *arena = burst_arena_create();
+    burst_arena_add(arena, phases, 3);
+    burst_arena_add(arena, phases, 3);
+
+    ScheduleConfig_t config;
+    ScheduleStats_t stats;
+    schedule_config_init(&config, SCHEDULE_RR);
+    config.quantum = 4;
+    config.bursts = arena;
+    config.stats = &stats;
+    config.io_devices = 1;
+    EXPECT_EQ(true, schedule_run(t, &r, &config));
+
+    // B's I/O waits for A's to finish at 6, so B only comes back at 11
+    EXPECT_EQ((unsigned long)12, r.total_run_time);
+    EXPECT_EQ((float)0.5, r.average_waiting_time);
+    EXPECT_EQ((uint64_t)10, stats.io_busy);
+
+    burst_arena_destroy(arena);
+    dyn_array_destroy(t);
+}
+
+
+//Typed C++ dyn_array tests
+
+
+struct TypedPoint
+{
+    int x;
+    int y;
+
+    TypedPoint(int x_value, int y_value) : x(x_value), y(y_value) {}
+};
+
+//Checks emplace, iteration and checked access
+TEST(typed_dyn_array, EmplaceAndIterate)
+{
+    dyn::dyn_array<TypedPoint> points;
+    for (int i = 0; i < 40; ++i)
+    {
+        points.emplace_back(i, -i);
+    }
+
+    int sum = 0;
+    for (const TypedPoint &point : points)
+    {
+        sum += point.x + point.y;
+    }
+    EXPECT_EQ((size_t)40, points.size());
+    EXPECT_EQ(0, sum);
+    EXPECT_EQ(39, points[39].x);
+    EXPECT_THROW(points.at(40), std::out_of_range);
+}
+
+//Checks ownership moves and the C array can be passed to the schedulers
+TEST(typed_dyn_array, InteropWithScheduler)
+{
+    dyn::dyn_array<ProcessControlBlock_t> queue;
+    queue.push_back(ProcessControlBlock_t{4, 0, 2, false});
+    queue.push_back(ProcessControlBlock_t{9, 0, 3, false});
+    queue.push_back(ProcessControlBlock_t{2, 0, 0, false});
+    queue.push_back(ProcessControlBlock_t{12, 0, 6, false});
+    queue.push_back(ProcessControlBlock_t{6, 0, 1, false});
+
+    dyn::dyn_array<ProcessControlBlock_t> moved(std::move(queue));
+    EXPECT_TRUE(queue.get() == NULL);
+
+    ScheduleResult_t r = {0, 0, 0};
+    EXPECT_EQ(true, first_come_first_serve(moved.get(), &r));
+    EXPECT_EQ((unsigned long)33, r.total_run_time);
+
+    dyn_array_t *raw = moved.release();
+    dyn::dyn_array<ProcessControlBlock_t> adopted = dyn::dyn_array<ProcessControlBlock_t>::adopt(raw);
+    EXPECT_EQ((size_t)5, adopted.size());
+    EXPECT_THROW(dyn::dyn_array<int>::adopt(adopted.get()), std::invalid_argument);
+}
+
+// Deterministic PCBs with overlapping arrivals and plenty of key ties
+static void kernel_workload(dyn::dyn_array<ProcessControlBlock_t> &queue, size_t count)
+{
+    uint32_t seed = 12345;
+    uint32_t arrival = 0;
+    for (size_t i = 0; i < count; ++i)
+    {
+        seed = seed * 1103515245 + 12345;
+        arrival += (seed >> 16) % 4;
+        queue.push_back(ProcessControlBlock_t{1 + (seed >> 8) % 9, (seed >> 4) % 5, arrival, false});
+    }
+}
+
+//Checks every kernel alias matches the C engine on the same input
+TEST(sched_kernel, MatchesScheduleRun)
+{
+    const SchedulePolicy_t policies[] = {SCHEDULE_FCFS, SCHEDULE_SJF, SCHEDULE_PRIORITY, SCHEDULE_RR, SCHEDULE_SRTF};
+    for (SchedulePolicy_t policy : policies)
+    {
+        dyn::dyn_array<ProcessControlBlock_t> expected_queue;
+        dyn::dyn_array<ProcessControlBlock_t> queue;
+        kernel_workload(expected_queue, 300);
+        kernel_workload(queue, 300);
+
+        ScheduleConfig_t config;
+        ScheduleStats_t stats;
+        schedule_config_init(&config, policy);
+        config.quantum = 3;
+        config.stats = &stats;
+        ScheduleResult_t expected = {0, 0, 0};
+        ASSERT_EQ(true, schedule_run(expected_queue.get(), &expected, &config));
+
+        sched::Collect<sched::MeanMetrics, sched::SwitchCounter> metrics;
+        bool ran = false;
+        switch (policy)
+        {
+            case SCHEDULE_FCFS: ran = sched::FirstComeFirstServe::run(queue, metrics); break;
+            case SCHEDULE_SJF: ran = sched::ShortestJobFirst::run(queue, metrics); break;
+            case SCHEDULE_PRIORITY: ran = sched::Priority::run(queue, metrics); break;
+            case SCHEDULE_RR: ran = sched::RoundRobin::run(queue, metrics, sched::Quantum(3)); break;
+            case SCHEDULE_SRTF: ran = sched::ShortestRemainingTimeFirst::run(queue, metrics); break;
+            default: break;
+        }
+        ASSERT_TRUE(ran);
+        EXPECT_EQ(expected.total_run_time, metrics.first.result().total_run_time) << schedule_policy_name(policy);
+        EXPECT_EQ(expected.average_waiting_time, metrics.first.result().average_waiting_time) << schedule_policy_name(policy);
+        EXPECT_EQ(expected.average_turnaround_time, metrics.first.result().average_turnaround_time) << schedule_policy_name(policy);
+        EXPECT_EQ(stats.context_switches, metrics.second.switches()) << schedule_policy_name(policy);
+        for (const ProcessControlBlock_t &pcb : queue)
+        {
+            EXPECT_EQ(0u, pcb.remaining_burst_time);
+        }
+    }
+
+    // a zero quantum never makes progress, so it is refused like the C engine does
+    dyn::dyn_array<ProcessControlBlock_t> queue;
+    kernel_workload(queue, 10);
+    sched::MeanMetrics metrics;
+    EXPECT_FALSE(sched::RoundRobin::run(queue, metrics, sched::Quantum(0)));
+}
+
+//Checks the timeline collector records the same segments as the C engine
+TEST(sched_kernel, TimelineMatches)
+{
+    dyn::dyn_array<ProcessControlBlock_t> expected_queue;
+    dyn::dyn_array<ProcessControlBlock_t> queue;
+    kernel_workload(expected_queue, 50);
+    kernel_workload(queue, 50);
+
+    ScheduleConfig_t config;
+    schedule_config_init(&config, SCHEDULE_SRTF);
+    config.timeline = timeline_create();
+    ScheduleResult_t r = {0, 0, 0};
+    ASSERT_EQ(true, schedule_run(expected_queue.get(), &r, &config));
+
+    sched::TimelineMetrics recorder(timeline_create());
+    Timeline_t *timeline = recorder.timeline();
+    ASSERT_TRUE(sched::ShortestRemainingTimeFirst::run(queue, recorder));
+
+    ASSERT_EQ(timeline_size(config.timeline), timeline_size(timeline));
+    for (size_t i = 0; i < timeline_size(timeline); ++i)
+    {
+        const TimelineSegment_t *a = timeline_at(config.timeline, i);
+        const TimelineSegment_t *b = timeline_at(timeline, i);
+        EXPECT_EQ(a->pid, b->pid);
+        EXPECT_EQ(a->start, b->start);
+        EXPECT_EQ(a->length, b->length);
+    }
+    timeline_destroy(config.timeline);
+    timeline_destroy(timeline);
+
+    dyn::dyn_array<ProcessControlBlock_t> empty;
+    sched::MeanMetrics metrics;
+    EXPECT_FALSE(sched::FirstComeFirstServe::run(empty, metrics));
+}
+
+
+//Parallel busy period tests
+
+
+// Bursty PCBs: clumps that keep the CPU busy for a while, separated by idle gaps
+static void busy_period_workload(dyn::dyn_array<ProcessControlBlock_t> &queue, size_t count)
+{
+    uint32_t seed = 777;
+    uint32_t arrival = 0;
+    for (size_t i = 0; i < count; ++i)
+    {
+        seed = seed * 1103515245 + 12345;
+        arrival += (seed >> 16) % 16 == 0 ? 40 : (seed >> 20) % 3;
+        queue.push_back(ProcessControlBlock_t{1 + (seed >> 8) % 5, (seed >> 4) % 4, arrival, false});
+    }
+}
+
+//Checks every policy gives the serial results, stats and timeline when split into busy periods
+TEST(schedule_run_parallel, MatchesSerialRun)
+{
+    const SchedulePolicy_t policies[] = {SCHEDULE_FCFS, SCHEDULE_SJF, SCHEDULE_PRIORITY, SCHEDULE_RR, SCHEDULE_SRTF};
+    for (SchedulePolicy_t policy : policies)
+    {
+        dyn::dyn_array<ProcessControlBlock_t> expected_queue;
+        dyn::dyn_array<ProcessControlBlock_t> queue;
+        busy_period_workload(expected_queue, 5000);
+        busy_period_workload(queue, 5000);
+
+        ScheduleConfig_t config;
+        ScheduleStats_t expected_stats;
+        schedule_config_init(&config, policy);
+        config.quantum = 2;
+        config.stats = &expected_stats;
+        config.timeline = timeline_create();
+        ScheduleResult_t expected = {0, 0, 0};
+        ASSERT_TRUE(schedule_run(expected_queue.get(), &expected, &config));
+        Timeline_t *expected_timeline = config.timeline;
+
+        ScheduleStats_t stats;
+        config.stats = &stats;
+        config.timeline = timeline_create();
+        ScheduleResult_t result = {0, 0, 0};
+        ASSERT_TRUE(schedule_run_parallel(queue.get(), &result, &config, 4));
+
+        EXPECT_EQ(expected.total_run_time, result.total_run_time) << schedule_policy_name(policy);
+        EXPECT_EQ(expected.average_waiting_time, result.average_waiting_time) << schedule_policy_name(policy);
+        EXPECT_EQ(expected.average_turnaround_time, result.average_turnaround_time) << schedule_policy_name(policy);
+        EXPECT_EQ(expected_stats.context_switches, stats.context_switches) << schedule_policy_name(policy);
+        EXPECT_EQ(expected_stats.cpu_busy, stats.cpu_busy) << schedule_policy_name(policy);
+        ASSERT_EQ(timeline_size(expected_timeline), timeline_size(config.timeline)) << schedule_policy_name(policy);
+        for (size_t i = 0; i < timeline_size(expected_timeline); ++i)
+        {
+            const TimelineSegment_t *a = timeline_at(expected_timeline, i);
+            const TimelineSegment_t *b = timeline_at(config.timeline, i);
+            EXPECT_EQ(a->pid, b->pid);
+            EXPECT_EQ(a->start, b->start);
+            EXPECT_EQ(a->length, b->length);
+        }
+        timeline_destroy(expected_timeline);
+        timeline_destroy(config.timeline);
+    }
+}
+
+//Checks runs with switch costs fall back to the serial engine, and bad input is rejected
+TEST(schedule_run_parallel, CostsRunSerially)
+{
+    dyn::dyn_array<ProcessControlBlock_t> expected_queue;
+    dyn::dyn_array<ProcessControlBlock_t> queue;
+    busy_period_workload(expected_queue, 500);
+    busy_period_workload(queue, 500);
+
+    ScheduleConfig_t config;
+    schedule_config_init(&config, SCHEDULE_SRTF);
+    config.costs.switch_cost = 2;
+    config.costs.refill_max = 3;
+    ScheduleResult_t expected = {0, 0, 0};
+    ScheduleResult_t result = {0, 0, 0};
+    ASSERT_TRUE(schedule_run(expected_queue.get(), &expected, &config));
+    ASSERT_TRUE(schedule_run_parallel(queue.get(), &result, &config, 0));
+    EXPECT_EQ(expected.total_run_time, result.total_run_time);
+    EXPECT_EQ(expected.average_waiting_time, result.average_waiting_time);
+
+    dyn::dyn_array<ProcessControlBlock_t> empty;
+    schedule_config_init(&config, SCHEDULE_RR);
+    EXPECT_FALSE(schedule_run_parallel(empty.get(), &result, &config, 2));
+    config.quantum = 0;
+    EXPECT_FALSE(schedule_run_parallel(queue.get(), &result, &config, 2));
+    EXPECT_FALSE(schedule_run_parallel(NULL, &result, NULL, 2));
+}
+
+
+//SIMD argmin tests
+
+
+//Checks every kernel this CPU runs finds the same first minimum as a plain loop
+TEST(simd_argmin, MatchesScalarLoop)
+{
+    uint32_t seed = 99;
+    for (size_t count = 1; count < 300; count += 7)
+    {
+        std::vector<uint32_t> keys(count);
+        for (uint32_t &key : keys)
+        {
+            seed = seed * 1103515245 + 12345;
+            // few distinct values so there are plenty of ties, some above INT32_MAX
+            key = (seed >> 16) % 4 == 0 ? 0x80000000u + (seed >> 8) % 3 : 5 + (seed >> 8) % 6;
+        }
+        size_t expected = 0;
+        for (size_t i = 1; i < count; ++i)
+        {
+            expected = keys[i] < keys[expected] ? i : expected;
+        }
+        for (int level = SIMD_ARGMIN_SCALAR; level <= simd_argmin_best_level(); ++level)
+        {
+            EXPECT_EQ(expected, simd_argmin_u32_level((SimdArgminLevel_t)level, keys.data(), count)) << level;
+        }
+        EXPECT_EQ(expected, simd_argmin_u32(keys.data(), count));
+    }
+}
+
+// A burst of 3000 arrivals builds a deep backlog, then a trickle lets it drain
+static void backlog_workload(dyn::dyn_array<ProcessControlBlock_t> &queue)
+{
+    uint32_t seed = 4242;
+    for (uint32_t i = 0; i < 4000; ++i)
+    {
+        seed = seed * 1103515245 + 12345;
+        const uint32_t arrival = i < 3000 ? i / 100 : 30 + (i - 3000) * 20;
+        queue.push_back(ProcessControlBlock_t{1 + (seed >> 8) % 7, (seed >> 4) % 6, arrival, false});
+    }
+}
+
+//Checks ready queues big enough to switch to the heap and back still match the kernel's scan
+TEST(simd_argmin, HeapModeMatchesKernel)
+{
+    const SchedulePolicy_t policies[] = {SCHEDULE_SJF, SCHEDULE_PRIORITY, SCHEDULE_SRTF};
+    for (SchedulePolicy_t policy : policies)
+    {
+        dyn::dyn_array<ProcessControlBlock_t> expected_queue;
+        dyn::dyn_array<ProcessControlBlock_t> queue;
+        backlog_workload(expected_queue);
+        backlog_workload(queue);
+
+        ScheduleConfig_t config;
+        schedule_config_init(&config, policy);
+        ScheduleResult_t expected = {0, 0, 0};
+        ASSERT_TRUE(schedule_run(expected_queue.get(), &expected, &config));
+
+        sched::MeanMetrics metrics;
+        bool ran = false;
+        switch (policy)
+        {
+            case SCHEDULE_SJF: ran = sched::ShortestJobFirst::run(queue, metrics); break;
+            case SCHEDULE_PRIORITY: ran = sched::Priority::run(queue, metrics); break;
+            default: ran = sched::ShortestRemainingTimeFirst::run(queue, metrics); break;
+        }
+        ASSERT_TRUE(ran);
+        EXPECT_EQ(expected.total_run_time, metrics.result().total_run_time) << schedule_policy_name(policy);
+        EXPECT_EQ(expected.average_waiting_time, metrics.result().average_waiting_time) << schedule_policy_name(policy);
+        EXPECT_EQ(expected.average_turnaround_time, metrics.result().average_turnaround_time) << schedule_policy_name(policy);
+    }
+}
+
+
+//Realtime tests
+
+
+// A long job that is not urgent followed by two short ones with tight deadlines
+static void deadline_workload(dyn::dyn_array<ProcessControlBlock_t> &queue, dyn::dyn_array<PcbDeadline_t> &deadlines)
+{
+    queue.push_back(ProcessControlBlock_t{10, 0, 0, false});
+    queue.push_back(ProcessControlBlock_t{2, 0, 1, false});
+    queue.push_back(ProcessControlBlock_t{3, 0, 2, false});
+    deadlines.push_back(PcbDeadline_t{100, 0});
+    deadlines.push_back(PcbDeadline_t{3, 0});
+    deadlines.push_back(PcbDeadline_t{10, 0});
+}
+
+//Checks EDF meets the deadlines FCFS misses, and the lateness FCFS reports
+TEST(realtime, EarliestDeadlineFirst)
+{
+    ScheduleConfig_t config;
+    ScheduleDeadlineStats_t stats;
+    ScheduleResult_t result = {0, 0, 0};
+    dyn::dyn_array<ProcessControlBlock_t> queue;
+    dyn::dyn_array<PcbDeadline_t> deadlines;
+    deadline_workload(queue, deadlines);
+    schedule_config_init(&config, SCHEDULE_EDF);
+    config.deadlines = deadlines.get();
+    config.deadline_stats = &stats;
+    ASSERT_TRUE(schedule_run(queue.get(), &result, &config));
+    EXPECT_EQ(3u, stats.jobs);
+    EXPECT_EQ(0u, stats.misses);
+    EXPECT_EQ(3u, stats.lateness[0]);
+    EXPECT_EQ(15u, result.total_run_time);
+
+    dyn::dyn_array<ProcessControlBlock_t> fcfs_queue;
+    dyn::dyn_array<PcbDeadline_t> fcfs_deadlines;
+    deadline_workload(fcfs_queue, fcfs_deadlines);
+    schedule_config_init(&config, SCHEDULE_FCFS);
+    config.deadlines = fcfs_deadlines.get();
+    config.deadline_stats = &stats;
+    ASSERT_TRUE(schedule_run(fcfs_queue.get(), &result, &config));
+    // the short jobs finish at 12 and 15, 8 and 3 ticks late
+    EXPECT_EQ(2u, stats.misses);
+    EXPECT_EQ(8u, stats.max_lateness);
+    EXPECT_EQ(11u, stats.total_lateness);
+    EXPECT_EQ(1u, stats.lateness[0]);
+    EXPECT_EQ(1u, stats.lateness[2]);
+    EXPECT_EQ(1u, stats.lateness[4]);
+
+    dyn::dyn_array<PcbDeadline_t> short_table;
+    short_table.push_back(PcbDeadline_t{1, 0});
+    config.deadlines = short_table.get();
+    EXPECT_FALSE(schedule_run(fcfs_queue.get(), &result, &config));
+}
+
+//Checks admission control turns away the PCB that would overload the CPU and admits once load expires
+TEST(realtime, AdmissionControl)
+{
+    ScheduleConfig_t config;
+    ScheduleDeadlineStats_t stats;
+    ScheduleResult_t result = {0, 0, 0};
+    dyn::dyn_array<ProcessControlBlock_t> queue;
+    dyn::dyn_array<PcbDeadline_t> deadlines;
+    deadline_workload(queue, deadlines);
+    // density 5/6 only fits after the second PCB's deadline has passed
+    queue.push_back(ProcessControlBlock_t{5, 0, 5, false});
+    deadlines.push_back(PcbDeadline_t{6, 0});
+    schedule_config_init(&config, SCHEDULE_EDF);
+    config.deadlines = deadlines.get();
+    config.deadline_stats = &stats;
+    config.admission = true;
+    ASSERT_TRUE(schedule_run(queue.get(), &result, &config));
+    EXPECT_EQ(1u, stats.rejected);
+    EXPECT_EQ(3u, stats.jobs);
+    EXPECT_EQ(0u, stats.misses);
+    EXPECT_EQ(17u, result.total_run_time);
+    EXPECT_FLOAT_EQ(8.0f, result.average_turnaround_time);
+    EXPECT_FLOAT_EQ(7.0f / 3, result.average_waiting_time);
+}
+
+//Checks the utilisation and demand bound tests on known task sets
+TEST(realtime, SchedulabilityTests)
+{
+    double utilisation = 0;
+    bool schedulable = false;
+    dyn::dyn_array<RealtimeTask_t> implicit;
+    implicit.push_back(RealtimeTask_t{1, 0, 4});
+    implicit.push_back(RealtimeTask_t{2, 0, 6});
+    implicit.push_back(RealtimeTask_t{1, 0, 8});
+    EXPECT_TRUE(realtime_utilisation_test(implicit.get(), &utilisation));
+    EXPECT_NEAR(0.25 + 1.0 / 3 + 0.125, utilisation, 1e-9);
+    ASSERT_TRUE(realtime_demand_bound_test(implicit.get(), &schedulable));
+    EXPECT_TRUE(schedulable);
+
+    // a full CPU with implicit deadlines is still schedulable
+    dyn::dyn_array<RealtimeTask_t> full;
+    full.push_back(RealtimeTask_t{1, 0, 2});
+    full.push_back(RealtimeTask_t{1, 0, 2});
+    ASSERT_TRUE(realtime_demand_bound_test(full.get(), &schedulable));
+    EXPECT_TRUE(schedulable);
+
+    // utilisation 1 passes, but 5 ticks are due by t = 4
+    dyn::dyn_array<RealtimeTask_t> constrained;
+    constrained.push_back(RealtimeTask_t{2, 3, 4});
+    constrained.push_back(RealtimeTask_t{3, 4, 6});
+    EXPECT_TRUE(realtime_utilisation_test(constrained.get(), NULL));
+    ASSERT_TRUE(realtime_demand_bound_test(constrained.get(), &schedulable));
+    EXPECT_FALSE(schedulable);
+
+    dyn::dyn_array<RealtimeTask_t> relaxed;
+    relaxed.push_back(RealtimeTask_t{1, 2, 4});
+    relaxed.push_back(RealtimeTask_t{2, 5, 6});
+    ASSERT_TRUE(realtime_demand_bound_test(relaxed.get(), &schedulable));
+    EXPECT_TRUE(schedulable);
+
+    dyn::dyn_array<RealtimeTask_t> overloaded;
+    overloaded.push_back(RealtimeTask_t{3, 0, 2});
+    EXPECT_FALSE(realtime_utilisation_test(overloaded.get(), NULL));
+    ASSERT_TRUE(realtime_demand_bound_test(overloaded.get(), &schedulable));
+    EXPECT_FALSE(schedulable);
+
+    dyn::dyn_array<RealtimeTask_t> invalid;
+    invalid.push_back(RealtimeTask_t{1, 0, 0});
+    EXPECT_FALSE(realtime_utilisation_test(invalid.get(), NULL));
+    EXPECT_FALSE(realtime_demand_bound_test(invalid.get(), &schedulable));
+}
+
+//Checks periodic PCBs without a deadline are due by their period and make up the task set
+TEST(realtime, PeriodicPcbs)
+{
+    ScheduleConfig_t config;
+    ScheduleDeadlineStats_t stats;
+    ScheduleResult_t result = {0, 0, 0};
+    dyn::dyn_array<ProcessControlBlock_t> queue;
+    dyn::dyn_array<PcbDeadline_t> deadlines;
+    queue.push_back(ProcessControlBlock_t{5, 0, 0, false});
+    queue.push_back(ProcessControlBlock_t{2, 0, 0, false});
+    queue.push_back(ProcessControlBlock_t{3, 0, 1, false});
+    deadlines.push_back(PcbDeadline_t{0, 0});
+    deadlines.push_back(PcbDeadline_t{0, 4});
+    deadlines.push_back(PcbDeadline_t{12, 6});
+
+    dyn_array_t *tasks = realtime_periodic_tasks(queue.get(), deadlines.get());
+    ASSERT_NE(nullptr, tasks);
+    ASSERT_EQ(2u, dyn_array_size(tasks));
+    const RealtimeTask_t *first = (const RealtimeTask_t *) dyn_array_at(tasks, 0);
+    EXPECT_EQ(2u, first->wcet);
+    EXPECT_EQ(4u, first->period);
+    double utilisation = 0;
+    bool schedulable = false;
+    EXPECT_TRUE(realtime_utilisation_test(tasks, &utilisation));
+    EXPECT_NEAR(1.0, utilisation, 1e-9);
+    ASSERT_TRUE(realtime_demand_bound_test(tasks, &schedulable));
+    EXPECT_TRUE(schedulable);
+    dyn_array_destroy(tasks);
+
+    // the periodic PCB waits behind the long one and finishes at 7, 3 ticks past its period
+    schedule_config_init(&config, SCHEDULE_FCFS);
+    config.deadlines = deadlines.get();
+    config.deadline_stats = &stats;
+    ASSERT_TRUE(schedule_run(queue.get(), &result, &config));
+    EXPECT_EQ(2u, stats.jobs);
+    EXPECT_EQ(1u, stats.misses);
+    EXPECT_EQ(3u, stats.max_lateness);
+
+    dyn::dyn_array<PcbDeadline_t> short_table;
+    short_table.push_back(PcbDeadline_t{0, 4});
+    EXPECT_EQ(nullptr, realtime_periodic_tasks(queue.get(), short_table.get()));
+}
+
+
+//Proportional share tests
+
+
+// Counts the ticks each of the first pids ran for in the first ticks of a timeline
+static std::vector<uint64_t> ticks_before(const Timeline_t *timeline, size_t pids, uint64_t ticks)
+{
+    std::vector<uint64_t> ran(pids, 0);
+    for (size_t i = 0; i < timeline_size(timeline); ++i)
+    {
+        const TimelineSegment_t *segment = timeline_at(timeline, i);
+        if (segment->start < ticks)
+        {
+            ran[segment->pid] += std::min<uint64_t>(segment->length, ticks - segment->start);
+        }
+    }
+    return ran;
+}
+
+//Checks stride hands out the CPU in exact proportion to tickets and lottery comes close
+TEST(proportional_share, StrideAndLotteryFollowTickets)
+{
+    const SchedulePolicy_t policies[] = {SCHEDULE_STRIDE, SCHEDULE_LOTTERY};
+    for (SchedulePolicy_t policy : policies)
+    {
+        dyn::dyn_array<ProcessControlBlock_t> queue;
+        queue.push_back(ProcessControlBlock_t{3000, 3, 0, false});
+        queue.push_back(ProcessControlBlock_t{3000, 2, 0, false});
+        queue.push_back(ProcessControlBlock_t{3000, 1, 0, false});
+        Timeline_t *timeline = timeline_create();
+        dyn_array_t *shares = dyn_array_create(0, sizeof(ScheduleShare_t), NULL);
+        ScheduleConfig_t config;
+        schedule_config_init(&config, policy);
+        config.timeline = timeline;
+        config.shares = shares;
+        config.seed = 7;
+        ScheduleResult_t result = {0, 0, 0};
+        ASSERT_TRUE(schedule_run(queue.get(), &result, &config));
+        EXPECT_EQ(9000u, result.total_run_time);
+
+        // while all three are runnable they split the CPU 3:2:1
+        const std::vector<uint64_t> ran = ticks_before(timeline, 3, 3000);
+        const uint64_t slack = policy == SCHEDULE_STRIDE ? 1 : 100;
+        EXPECT_NEAR(1500.0, ran[0], slack) << schedule_policy_name(policy);
+        EXPECT_NEAR(1000.0, ran[1], slack) << schedule_policy_name(policy);
+        EXPECT_NEAR(500.0, ran[2], slack) << schedule_policy_name(policy);
+
+        ASSERT_EQ(3u, dyn_array_size(shares));
+        for (size_t t = 0; t < 3; ++t)
+        {
+            EXPECT_EQ(3000u, ((ScheduleShare_t *) dyn_array_at(shares, t))->received);
+        }
+        EXPECT_LT(schedule_share_error(shares), policy == SCHEDULE_STRIDE ? 0.001 : 0.05);
+        timeline_destroy(timeline);
+        dyn_array_destroy(shares);
+    }
+
+    // stride refuses tickets past the cap, where passes would round too coarsely
+    dyn::dyn_array<ProcessControlBlock_t> heavy;
+    heavy.push_back(ProcessControlBlock_t{10, SCHEDULE_TICKETS_MAX, 0, false});
+    heavy.push_back(ProcessControlBlock_t{10, SCHEDULE_TICKETS_MAX + 1, 0, false});
+    ScheduleConfig_t config;
+    schedule_config_init(&config, SCHEDULE_STRIDE);
+    ScheduleResult_t result = {0, 0, 0};
+    EXPECT_FALSE(schedule_run(heavy.get(), &result, &config));
+    heavy.at(1).priority = SCHEDULE_TICKETS_MAX;
+    EXPECT_TRUE(schedule_run(heavy.get(), &result, &config));
+    EXPECT_EQ(20u, result.total_run_time);
+}
+
+//Checks tenants pool their PCBs' tickets and a big lottery run completes every PCB
+TEST(proportional_share, TenantsAndLargeLottery)
+{
+    // tenant 0 holds one PCB of 4 tickets, tenant 1 four PCBs of 1 ticket
+    dyn::dyn_array<ProcessControlBlock_t> queue;
+    dyn::dyn_array<uint32_t> tenants;
+    queue.push_back(ProcessControlBlock_t{400, 4, 0, false});
+    tenants.push_back(0);
+    for (int i = 0; i < 4; ++i)
+    {
+        queue.push_back(ProcessControlBlock_t{100, 1, 0, false});
+        tenants.push_back(1);
+    }
+    dyn_array_t *shares = dyn_array_create(0, sizeof(ScheduleShare_t), NULL);
+    ScheduleConfig_t config;
+    schedule_config_init(&config, SCHEDULE_STRIDE);
+    config.tenants = tenants.get();
+    config.shares = shares;
+    ScheduleResult_t result = {0, 0, 0};
+    ASSERT_TRUE(schedule_run(queue.get(), &result, &config));
+    ASSERT_EQ(2u, dyn_array_size(shares));
+    const ScheduleShare_t *pooled = (const ScheduleShare_t *) dyn_array_at(shares, 1);
+    EXPECT_EQ(4u, pooled->pcbs);
+    EXPECT_EQ(4u, pooled->tickets);
+    EXPECT_EQ(400u, pooled->received);
+    EXPECT_NEAR(400.0, pooled->entitled, 5.0);
+    EXPECT_LT(schedule_share_error(shares), 0.01);
+
+    dyn::dyn_array<ProcessControlBlock_t> big;
+    uint64_t total = 0;
+    uint32_t seed = 5;
+    for (uint32_t i = 0; i < 20000; ++i)
+    {
+        seed = seed * 1103515245 + 12345;
+        const uint32_t burst = 1 + (seed >> 8) % 20;
+        big.push_back(ProcessControlBlock_t{burst, (seed >> 4) % 10, i / 4, false});
+        total += burst;
+    }
+    schedule_config_init(&config, SCHEDULE_LOTTERY);
+    config.quantum = 2;
+    config.shares = shares;
+    ASSERT_TRUE(schedule_run(big.get(), &result, &config));
+    EXPECT_EQ(total, result.total_run_time);
+    ASSERT_EQ(20000u, dyn_array_size(shares));
+    for (size_t i = 0; i < big.size(); ++i)
+    {
+        EXPECT_EQ(0u, big.at(i).remaining_burst_time);
+    }
+    config.quantum = 0;
+    EXPECT_FALSE(schedule_run(big.get(), &result, &config));
+    dyn_array_destroy(shares);
+}
+
+
+//Group scheduling tests
+
+
+//Checks paths intern their ancestors and the tree and map files load
+TEST(group_tree, PathsAndFiles)
+{
+    GroupTree_t *tree = group_tree_create(GROUP_RR);
+    ASSERT_NE(nullptr, tree);
+    uint32_t service, team, found;
+    ASSERT_TRUE(group_tree_add(tree, "search/frontend", 3, GROUP_RR, &service));
+    ASSERT_TRUE(group_tree_find(tree, "search", &team));
+    EXPECT_EQ(3u, group_tree_size(tree));
+    EXPECT_EQ(team, group_tree_node(tree, service)->parent);
+    EXPECT_EQ(2u, group_tree_node(tree, service)->depth);
+    EXPECT_EQ(3u, group_tree_node(tree, service)->weight);
+    EXPECT_EQ(GROUP_FAIR, group_tree_node(tree, team)->policy);
+    EXPECT_TRUE(group_tree_find(tree, "/search//frontend/", &found));
+    EXPECT_EQ(service, found);
+    EXPECT_FALSE(group_tree_find(tree, "search/backend", &found));
+    EXPECT_TRUE(group_tree_find(tree, "/", &found));
+    EXPECT_EQ(0u, found);
+    EXPECT_EQ(nullptr, group_tree_node(tree, 3));
+    group_tree_destroy(tree);
+
+    FILE *file = fopen("groups.txt", "w");
+    ASSERT_NE(nullptr, file);
+    fputs("# team shares\n/ 1 rr\nads 2\nsearch 6 fair\nsearch/frontend 1 rr\n", file);
+    fclose(file);
+    file = fopen("group_map.txt", "w");
+    ASSERT_NE(nullptr, file);
+    fputs("ads\nsearch/frontend\nsearch/backend\n", file);
+    fclose(file);
+    tree = group_tree_load("groups.txt");
+    ASSERT_NE(nullptr, tree);
+    EXPECT_EQ(GROUP_RR, group_tree_node(tree, 0)->policy);
+    dyn_array_t *map = group_tree_load_map(tree, "group_map.txt");
+    ASSERT_NE(nullptr, map);
+    ASSERT_EQ(3u, dyn_array_size(map));
+    ASSERT_TRUE(group_tree_find(tree, "search/backend", &found));
+    EXPECT_EQ(found, *(uint32_t *) dyn_array_at(map, 2));
+    EXPECT_EQ(6u, group_tree_node(tree, group_tree_node(tree, found)->parent)->weight);
+    dyn_array_destroy(map);
+    group_tree_destroy(tree);
+
+    file = fopen("groups.txt", "w");
+    ASSERT_NE(nullptr, file);
+    fputs("ads 2 lottery\n", file);
+    fclose(file);
+    EXPECT_EQ(nullptr, group_tree_load("groups.txt"));
+    remove("groups.txt");
+    remove("group_map.txt");
+}
+
+//Checks weights split the CPU down the tree, and a lone round robin root is plain round robin
+TEST(group_tree, SchedulesHierarchy)
+{
+    // a:3 against b:1 at the root, b splits evenly between x (two PCBs, round robin) and y
+    GroupTree_t *tree = group_tree_create(GROUP_FAIR);
+    uint32_t a, x, y;
+    ASSERT_TRUE(group_tree_add(tree, "a", 3, GROUP_FAIR, &a));
+    ASSERT_TRUE(group_tree_add(tree, "b/x", 1, GROUP_RR, &x));
+    ASSERT_TRUE(group_tree_add(tree, "b/y", 1, GROUP_FAIR, &y));
+    dyn::dyn_array<ProcessControlBlock_t> queue;
+    dyn::dyn_array<uint32_t> group_of;
+    const uint32_t leaves[] = {a, x, x, y};
+    for (uint32_t leaf : leaves)
+    {
+        queue.push_back(ProcessControlBlock_t{10000, 1, 0, false});
+        group_of.push_back(leaf);
+    }
+    Timeline_t *timeline = timeline_create();
+    ScheduleConfig_t config;
+    schedule_config_init(&config, SCHEDULE_GROUP);
+    config.groups = tree;
+    config.group_of = group_of.get();
+    config.timeline = timeline;
+    ScheduleResult_t result = {0, 0, 0};
+    ASSERT_TRUE(schedule_run(queue.get(), &result, &config));
+    EXPECT_EQ(40000u, result.total_run_time);
+    const std::vector<uint64_t> ran = ticks_before(timeline, 4, 4000);
+    EXPECT_NEAR(3000.0, ran[0], 2);
+    EXPECT_NEAR(250.0, ran[1], 2);
+    EXPECT_NEAR(250.0, ran[2], 2);
+    EXPECT_NEAR(500.0, ran[3], 2);
+    timeline_destroy(timeline);
+    group_tree_destroy(tree);
+
+    dyn::dyn_array<ProcessControlBlock_t> expected_queue;
+    dyn::dyn_array<ProcessControlBlock_t> flat_queue;
+    kernel_workload(expected_queue, 300);
+    kernel_workload(flat_queue, 300);
+    dyn::dyn_array<uint32_t> roots;
+    for (size_t i = 0; i < flat_queue.size(); ++i)
+    {
+        roots.push_back(0);
+    }
+    ScheduleStats_t expected_stats, stats;
+    ScheduleResult_t expected = {0, 0, 0};
+    schedule_config_init(&config, SCHEDULE_RR);
+    config.quantum = 3;
+    config.stats = &expected_stats;
+    ASSERT_TRUE(schedule_run(expected_queue.get(), &expected, &config));
+    tree = group_tree_create(GROUP_RR);
+    schedule_config_init(&config, SCHEDULE_GROUP);
+    config.quantum = 3;
+    config.stats = &stats;
+    config.groups = tree;
+    config.group_of = roots.get();
+    ASSERT_TRUE(schedule_run(flat_queue.get(), &result, &config));
+    EXPECT_EQ(expected.total_run_time, result.total_run_time);
+    EXPECT_EQ(expected.average_waiting_time, result.average_waiting_time);
+    EXPECT_EQ(expected.average_turnaround_time, result.average_turnaround_time);
+    EXPECT_EQ(expected_stats.context_switches, stats.context_switches);
+    config.groups = NULL;
+    EXPECT_FALSE(schedule_run(flat_queue.get(), &result, &config));
+    group_tree_destroy(tree);
+}
+
+
+//Topology tests
+
+
+//Checks distances on a uniform machine and a topology file with its own costs
+TEST(topology, DistancesAndFiles)
+{
+    // 2 sockets * 2 cores * 2 threads: CPU ids run thread, then core, then socket
+    Topology_t *topology = topology_create_uniform(2, 2, 2);
+    ASSERT_NE(nullptr, topology);
+    EXPECT_EQ(8u, topology_cpus(topology));
+    EXPECT_EQ(2u, topology_sockets(topology));
+    EXPECT_EQ(TOPOLOGY_SAME, topology_distance(topology, 3, 3));
+    EXPECT_EQ(TOPOLOGY_SMT, topology_distance(topology, 2, 3));
+    EXPECT_EQ(TOPOLOGY_CACHE, topology_distance(topology, 0, 3));
+    EXPECT_EQ(TOPOLOGY_REMOTE, topology_distance(topology, 1, 4));
+    EXPECT_EQ(1u, topology_cpu(topology, 7)->socket);
+    EXPECT_EQ(3u, topology_cpu(topology, 7)->core);
+    EXPECT_EQ(1u, topology_cpu(topology, 7)->thread);
+    EXPECT_EQ(nullptr, topology_cpu(topology, 8));
+    EXPECT_EQ(nullptr, topology_create_uniform(0, 2, 2));
+    topology_destroy(topology);
+
+    // sparse ids, core ids reused across sockets, two last level caches on socket 7
+    FILE *file = fopen("topology.txt", "w");
+    ASSERT_NE(nullptr, file);
+    fputs("# two sockets\ncpu 7 0 100\ncpu 7 4 200\ncpu 9 0 300\ncpu 7 0 100\n"
+          "migrate 0 2 8 40\nremote 50\n", file);
+    fclose(file);
+    topology = topology_load("topology.txt");
+    ASSERT_NE(nullptr, topology);
+    EXPECT_EQ(4u, topology_cpus(topology));
+    EXPECT_EQ(2u, topology_sockets(topology));
+    EXPECT_EQ(TOPOLOGY_SMT, topology_distance(topology, 0, 3));
+    EXPECT_EQ(TOPOLOGY_SOCKET, topology_distance(topology, 0, 1));
+    EXPECT_EQ(TOPOLOGY_REMOTE, topology_distance(topology, 0, 2));
+    EXPECT_EQ(1u, topology_cpu(topology, 3)->thread);
+    EXPECT_EQ(40u, topology_costs(topology)->migrate[TOPOLOGY_REMOTE]);
+    EXPECT_EQ(50u, topology_costs(topology)->remote_percent);
+    EXPECT_EQ(25u, topology_costs(topology)->smt_percent);
+    topology_destroy(topology);
+
+    file = fopen("topology.txt", "w");
+    ASSERT_NE(nullptr, file);
+    fputs("cpu 0 0\n", file);
+    fclose(file);
+    EXPECT_EQ(nullptr, topology_load("topology.txt"));
+    remove("topology.txt");
+}
+
+//Checks one CPU matches the single CPU engine, and placement and stealing use every CPU
+TEST(topology, MultiCpuRun)
+{
+    Topology_t *topology = topology_create_uniform(1, 1, 1);
+    const SchedulePolicy_t policies[] = {SCHEDULE_FCFS, SCHEDULE_SJF, SCHEDULE_PRIORITY};
+    for (SchedulePolicy_t policy : policies)
+    {
+        dyn::dyn_array<ProcessControlBlock_t> expected_queue;
+        dyn::dyn_array<ProcessControlBlock_t> queue;
+        kernel_workload(expected_queue, 300);
+        kernel_workload(queue, 300);
+        ScheduleConfig_t config;
+        schedule_config_init(&config, policy);
+        ScheduleResult_t expected = {0, 0, 0};
+        ScheduleResult_t result = {0, 0, 0};
+        ASSERT_TRUE(schedule_run(expected_queue.get(), &expected, &config));
+        config.topology = topology;
+        ASSERT_TRUE(schedule_run(queue.get(), &result, &config));
+        EXPECT_EQ(expected.total_run_time, result.total_run_time);
+        EXPECT_EQ(expected.average_waiting_time, result.average_waiting_time);
+        EXPECT_EQ(expected.average_turnaround_time, result.average_turnaround_time);
+    }
+    topology_destroy(topology);
+
+    // eight equal PCBs at once on 2 sockets * 2 cores * 2 threads, free of locality costs
+    topology = topology_create_uniform(2, 2, 2);
+    TopologyCosts_t costs;
+    topology_costs_init(&costs);
+    costs.smt_percent = 0;
+    costs.remote_percent = 0;
+    topology_set_costs(topology, &costs);
+    ScheduleConfig_t config;
+    ScheduleStats_t stats;
+    schedule_config_init(&config, SCHEDULE_FCFS);
+    config.topology = topology;
+    config.stats = &stats;
+    ScheduleResult_t result = {0, 0, 0};
+    dyn::dyn_array<ProcessControlBlock_t> queue;
+    for (int i = 0; i < 8; ++i)
+    {
+        queue.push_back(ProcessControlBlock_t{10, 0, 0, false});
+    }
+    ASSERT_TRUE(schedule_run(queue.get(), &result, &config));
+    EXPECT_EQ(10u, result.total_run_time);
+    EXPECT_EQ(80u, stats.cpu_busy);
+    EXPECT_EQ(0u, stats.migrations);
+
+    // packing doubles up SMT siblings, which slows them down
+    costs.smt_percent = 50;
+    topology_set_costs(topology, &costs);
+    config.placement = SCHEDULE_PLACE_PACK;
+    queue.clear();
+    for (int i = 0; i < 4; ++i)
+    {
+        queue.push_back(ProcessControlBlock_t{10, 0, 0, false});
+    }
+    ASSERT_TRUE(schedule_run(queue.get(), &result, &config));
+    EXPECT_EQ(15u, result.total_run_time);
+    EXPECT_EQ(10u, stats.locality_overhead);
+    config.placement = SCHEDULE_PLACE_SPREAD;
+    queue.clear();
+    for (int i = 0; i < 4; ++i)
+    {
+        queue.push_back(ProcessControlBlock_t{10, 0, 0, false});
+    }
+    ASSERT_TRUE(schedule_run(queue.get(), &result, &config));
+    EXPECT_EQ(10u, result.total_run_time);
+    EXPECT_EQ(0u, stats.locality_overhead);
+    topology_destroy(topology);
+
+    // one long PCB holds CPU 0 while short ones queue behind it; CPU 1 only helps by stealing
+    topology = topology_create_uniform(1, 2, 1);
+    const uint32_t bursts[] = {100, 1, 10, 10, 10};
+    const SchedulePolicy_t stealers[] = {SCHEDULE_FCFS, SCHEDULE_RR};
+    for (SchedulePolicy_t policy : stealers)
+    {
+        ScheduleResult_t alone = {0, 0, 0};
+        for (ScheduleBalance_t balance : {SCHEDULE_BALANCE_NONE, SCHEDULE_BALANCE_STEAL})
+        {
+            schedule_config_init(&config, policy);
+            config.quantum = 5;
+            config.topology = topology;
+            config.stats = &stats;
+            config.balance = balance;
+            queue.clear();
+            for (uint32_t burst : bursts)
+            {
+                queue.push_back(ProcessControlBlock_t{burst, 0, 0, false});
+            }
+            ASSERT_TRUE(schedule_run(queue.get(), balance == SCHEDULE_BALANCE_NONE ? &alone : &result, &config));
+            EXPECT_EQ(131u, stats.cpu_busy);
+        }
+        EXPECT_GT(alone.total_run_time, result.total_run_time);
+        EXPECT_GE(result.total_run_time, 100u);
+    }
+    // round robin slices queue again where they ran, so stolen ones move
+    EXPECT_LT(0u, stats.migrations);
+    EXPECT_EQ(stats.migrations * topology_costs(topology)->migrate[TOPOLOGY_CACHE], stats.migration_overhead);
+    topology_destroy(topology);
+    topology = topology_create_uniform(2, 2, 2);
+
+    // with remote memory slowing it down, keeping tenants on their socket beats stealing across
+    costs.smt_percent = 0;
+    costs.remote_percent = 100;
+    topology_set_costs(topology, &costs);
+    config.topology = topology;
+    ScheduleResult_t local = {0, 0, 0};
+    ScheduleStats_t local_stats;
+    dyn::dyn_array<uint32_t> tenants;
+    queue.clear();
+    for (int i = 0; i < 8; ++i)
+    {
+        queue.push_back(ProcessControlBlock_t{10, 0, 0, false});
+        tenants.push_back(0);
+    }
+    config.tenants = tenants.get();
+    config.placement = SCHEDULE_PLACE_AFFINITY;
+    config.balance = SCHEDULE_BALANCE_SOCKET;
+    config.stats = &local_stats;
+    ASSERT_TRUE(schedule_run(queue.get(), &local, &config));
+    EXPECT_EQ(0u, local_stats.locality_overhead);
+    queue.clear();
+    for (int i = 0; i < 8; ++i)
+    {
+        queue.push_back(ProcessControlBlock_t{10, 0, 0, false});
+    }
+    config.placement = SCHEDULE_PLACE_SPREAD;
+    config.balance = SCHEDULE_BALANCE_STEAL;
+    config.stats = &stats;
+    ASSERT_TRUE(schedule_run(queue.get(), &result, &config));
+    EXPECT_LT(0u, stats.locality_overhead);
+    EXPECT_GT(stats.cpu_busy, local_stats.cpu_busy);
+
+    config.quantum = 0;
+    EXPECT_FALSE(schedule_run(queue.get(), &result, &config));
+    topology_destroy(topology);
+}
+
+
+//Heterogeneous core tests
+
+
+// Writes text to a file, for the fake sysfs trees below
+static void write_text(const std::string &path, const char *text)
+{
+    FILE *file = fopen(path.c_str(), "w");
+    ASSERT_NE(nullptr, file);
+    fputs(text, file);
+    fclose(file);
+}
+
+//Checks speeds from files and cpu_capacity group CPUs into classes, and a fast CPU runs bursts faster
+TEST(core_speed, ClassesAndSpeeds)
+{
+    FILE *file = fopen("topology.txt", "w");
+    ASSERT_NE(nullptr, file);
+    fputs("cpu 0 0 0 2000\ncpu 0 1 0\ncpu 0 2 0\ncpu 0 3 0 500\nspeed 2 2 2000\n", file);
+    fclose(file);
+    Topology_t *topology = topology_load("topology.txt");
+    ASSERT_NE(nullptr, topology);
+    EXPECT_EQ(3u, topology_classes(topology));
+    EXPECT_EQ(2u, topology_cpu(topology, 0)->speed_class);
+    EXPECT_EQ(1u, topology_cpu(topology, 1)->speed_class);
+    EXPECT_EQ(2000u, topology_cpu(topology, 2)->speed);
+    EXPECT_EQ(0u, topology_cpu(topology, 3)->speed_class);
+    EXPECT_TRUE(topology_set_speed(topology, 3, 1000));
+    EXPECT_EQ(2u, topology_classes(topology));
+    EXPECT_EQ(1u, topology_cpu(topology, 0)->speed_class);
+    EXPECT_FALSE(topology_set_speed(topology, 3, 0));
+    EXPECT_FALSE(topology_set_speed(topology, 4, 1000));
+    topology_destroy(topology);
+    write_text("topology.txt", "uniform 1 2 1\nspeed 1 2 2000\n");
+    EXPECT_EQ(nullptr, topology_load("topology.txt"));
+    remove("topology.txt");
+
+    // an asymmetric machine as the kernel describes it: one big core, one half as fast, and
+    // one that reports no capacity, taken to be a big core
+    const char *capacities[] = {"512\n", "1024\n", NULL};
+    mkdir("fake_cpu", 0755);
+    for (int cpu = 0; cpu < 3; ++cpu)
+    {
+        const std::string dir = "fake_cpu/cpu" + std::to_string(cpu);
+        mkdir(dir.c_str(), 0755);
+        mkdir((dir + "/topology").c_str(), 0755);
+        write_text(dir + "/topology/physical_package_id", "0\n");
+        write_text(dir + "/topology/core_id", (std::to_string(cpu) + "\n").c_str());
+        if (capacities[cpu])
+        {
+            write_text(dir + "/cpu_capacity", capacities[cpu]);
+        }
+    }
+    topology = topology_detect("fake_cpu");
+    for (int cpu = 0; cpu < 3; ++cpu)
+    {
+        const std::string dir = "fake_cpu/cpu" + std::to_string(cpu);
+        remove((dir + "/topology/physical_package_id").c_str());
+        remove((dir + "/topology/core_id").c_str());
+        remove((dir + "/cpu_capacity").c_str());
+        rmdir((dir + "/topology").c_str());
+        rmdir(dir.c_str());
+    }
+    rmdir("fake_cpu");
+    ASSERT_NE(nullptr, topology);
+    EXPECT_EQ(3u, topology_cpus(topology));
+    EXPECT_EQ(500u, topology_cpu(topology, 0)->speed);
+    EXPECT_EQ(1000u, topology_cpu(topology, 1)->speed);
+    EXPECT_EQ(1000u, topology_cpu(topology, 2)->speed);
+    EXPECT_EQ(TOPOLOGY_CACHE, topology_distance(topology, 0, 1));
+    topology_destroy(topology);
+
+    // one CPU twice as fast as the reference halves every burst; round robin quanta stay in ticks
+    topology = topology_create_uniform(1, 1, 1);
+    ASSERT_TRUE(topology_set_speed(topology, 0, 2000));
+    const SchedulePolicy_t policies[] = {SCHEDULE_FCFS, SCHEDULE_RR};
+    for (SchedulePolicy_t policy : policies)
+    {
+        dyn::dyn_array<ProcessControlBlock_t> queue;
+        queue.push_back(ProcessControlBlock_t{10, 0, 0, false});
+        queue.push_back(ProcessControlBlock_t{7, 0, 0, false});
+        Timeline_t *timeline = timeline_create();
+        ScheduleConfig_t config;
+        schedule_config_init(&config, policy);
+        config.quantum = 2;
+        config.topology = topology;
+        config.timeline = timeline;
+        ScheduleResult_t result = {0, 0, 0};
+        ASSERT_TRUE(schedule_run(queue.get(), &result, &config));
+        EXPECT_EQ(9u, result.total_run_time);
+        EXPECT_LE(0.0f, result.average_waiting_time);
+        for (size_t i = 0; i < timeline_size(timeline); ++i)
+        {
+            EXPECT_GE(policy == SCHEDULE_RR ? 2u : 5u, timeline_at(timeline, i)->length);
+        }
+        timeline_destroy(timeline);
+    }
+    topology_destroy(topology);
+}
+
+//Checks speed-aware placement and stealing put long PCBs on the fast core, with per class results
+TEST(core_speed, PlacementAndClasses)
+{
+    // CPU 0 is a reference core, CPU 1 twice as fast
+    Topology_t *topology = topology_create_uniform(1, 2, 1);
+    ASSERT_TRUE(topology_set_speed(topology, 1, 2000));
+    ScheduleConfig_t config;
+    ScheduleResult_t result = {0, 0, 0};
+    schedule_config_init(&config, SCHEDULE_SJF);
+    config.topology = topology;
+    for (SchedulePlacement_t placement : {SCHEDULE_PLACE_SPREAD, SCHEDULE_PLACE_SPEED})
+    {
+        dyn::dyn_array<ProcessControlBlock_t> queue;
+        queue.push_back(ProcessControlBlock_t{40, 0, 0, false});
+        queue.push_back(ProcessControlBlock_t{10, 0, 0, false});
+        config.placement = placement;
+        ASSERT_TRUE(schedule_run(queue.get(), &result, &config));
+        // spreading leaves the long PCB on the slow core
+        EXPECT_EQ(placement == SCHEDULE_PLACE_SPEED ? 20u : 40u, result.total_run_time);
+    }
+
+    // spread queues 20, 30 and 4 on CPU 0; the fast CPU runs out of work first and steals the
+    // 30, not the least urgent 4, then the 4 while CPU 0 is still on the 20
+    dyn::dyn_array<ScheduleCoreClass_t> classes;
+    schedule_config_init(&config, SCHEDULE_FCFS);
+    config.topology = topology;
+    config.balance = SCHEDULE_BALANCE_STEAL;
+    config.core_classes = classes.get();
+    dyn::dyn_array<ProcessControlBlock_t> queue;
+    const uint32_t bursts[] = {20, 2, 30, 2, 4, 2};
+    for (uint32_t burst : bursts)
+    {
+        queue.push_back(ProcessControlBlock_t{burst, 0, 0, false});
+    }
+    ASSERT_TRUE(schedule_run(queue.get(), &result, &config));
+    EXPECT_EQ(20u, result.total_run_time);
+    ASSERT_EQ(2u, classes.size());
+    EXPECT_EQ(1000u, classes[0].speed);
+    EXPECT_EQ(1u, classes[0].cpus);
+    EXPECT_EQ(20u, classes[0].work);
+    EXPECT_EQ(20u, classes[0].busy);
+    EXPECT_EQ(1u, classes[0].finished);
+    EXPECT_EQ(2000u, classes[1].speed);
+    EXPECT_EQ(40u, classes[1].work);
+    EXPECT_EQ(20u, classes[1].busy);
+    EXPECT_EQ(5u, classes[1].slices);
+    EXPECT_EQ(5u, classes[1].finished);
+    EXPECT_EQ(1u + 2 + 3 + 18 + 20, classes[1].turnaround);
+    topology_destroy(topology);
+}
+
+
+//Auto-tuner tests
+
+
+//Checks a grid search replays every candidate, ranks them and finds the Pareto front on any thread count
+TEST(autotune, GridSearch)
+{
+    dyn::dyn_array<ProcessControlBlock_t> trace;
+    kernel_workload(trace, 300);
+    ScheduleConfig_t base;
+    schedule_config_init(&base, SCHEDULE_FCFS);
+    const SchedulePolicy_t policies[] = {SCHEDULE_FCFS, SCHEDULE_SJF, SCHEDULE_RR};
+    AutotuneConfig_t config;
+    autotune_config_init(&config, &base);
+    config.policies = policies;
+    config.policy_count = 3;
+    config.quantum_max = 6;
+    config.threads = 1;
+    dyn_array_t *serial = autotune_run(trace.get(), &config);
+    config.threads = 4;
+    dyn_array_t *results = autotune_run(trace.get(), &config);
+    ASSERT_NE(nullptr, serial);
+    ASSERT_NE(nullptr, results);
+    // RR with quanta 1, 2, 4 and 6
+    ASSERT_EQ(6u, dyn_array_size(results));
+    ASSERT_EQ(0, memcmp(dyn_array_export(serial), dyn_array_export(results), 6 * sizeof(AutotuneResult_t)));
+    EXPECT_FALSE(trace[0].started);
+
+    size_t front = 0;
+    for (size_t i = 0; i < 6; ++i)
+    {
+        const AutotuneResult_t *result = (const AutotuneResult_t *) dyn_array_at(results, i);
+        EXPECT_EQ(300u, result->pcbs);
+        EXPECT_EQ(result->params.policy == SCHEDULE_RR, result->params.quantum != 0);
+        const AutotuneResult_t *previous = (const AutotuneResult_t *) dyn_array_at(results, i ? i - 1 : 0);
+        EXPECT_FALSE(autotune_better(AUTOTUNE_MEAN_WAIT, result, previous));
+        front += result->pareto;
+        // every candidate off the front has one on it that is no worse anywhere
+        bool dominated = result->pareto;
+        for (size_t j = 0; !dominated && j < 6; ++j)
+        {
+            const AutotuneResult_t *other = (const AutotuneResult_t *) dyn_array_at(results, j);
+            dominated = other->pareto && other->mean_wait <= result->mean_wait
+                        && other->p99_turnaround <= result->p99_turnaround && other->throughput >= result->throughput;
+        }
+        EXPECT_TRUE(dominated);
+
+        // the reported waiting time is the one schedule_run gives
+        dyn::dyn_array<ProcessControlBlock_t> queue;
+        kernel_workload(queue, 300);
+        ScheduleConfig_t run;
+        schedule_config_init(&run, result->params.policy);
+        run.quantum = result->params.quantum;
+        ScheduleResult_t expected = {0, 0, 0};
+        ASSERT_TRUE(schedule_run(queue.get(), &expected, &run));
+        EXPECT_EQ(expected.average_waiting_time, result->mean_wait);
+        EXPECT_EQ(300.0 / expected.total_run_time, result->throughput);
+    }
+    EXPECT_LE(1u, front);
+    // shortest job first waits least of all
+    EXPECT_EQ(SCHEDULE_SJF, ((const AutotuneResult_t *) dyn_array_front(results))->params.policy);
+    dyn_array_destroy(serial);
+    dyn_array_destroy(results);
+
+    config.quantum_min = 0;
+    EXPECT_EQ(nullptr, autotune_run(trace.get(), &config));
+    config.quantum_min = 1;
+    base.policy = SCHEDULE_GROUP;
+    const SchedulePolicy_t group[] = {SCHEDULE_GROUP};
+    config.policies = group;
+    config.policy_count = 1;
+    EXPECT_EQ(nullptr, autotune_run(trace.get(), &config));
+}
+
+//Checks successive halving prunes random draws on growing prefixes of the trace down to the finalists
+TEST(autotune, SuccessiveHalving)
+{
+    dyn::dyn_array<ProcessControlBlock_t> trace;
+    kernel_workload(trace, 800);
+    ScheduleConfig_t base;
+    schedule_config_init(&base, SCHEDULE_RR);
+    const SchedulePolicy_t policies[] = {SCHEDULE_RR, SCHEDULE_STRIDE};
+    AutotuneConfig_t config;
+    autotune_config_init(&config, &base);
+    config.policies = policies;
+    config.policy_count = 2;
+    config.quantum_max = 32;
+    config.search = AUTOTUNE_HALVING;
+    config.objective = AUTOTUNE_P99_TURNAROUND;
+    config.candidates = 16;
+    config.min_pcbs = 50;
+    config.finalists = 2;
+    dyn_array_t *results = autotune_run(trace.get(), &config);
+    ASSERT_NE(nullptr, results);
+    ASSERT_EQ(16u, dyn_array_size(results));
+    // 16 run on 50 PCBs, 8 on 100, 4 on 200 and the last 2 on the whole trace
+    const size_t expected[] = {800, 800, 200, 200, 100, 100, 100, 100, 50, 50, 50, 50, 50, 50, 50, 50};
+    for (size_t i = 0; i < 16; ++i)
+    {
+        const AutotuneResult_t *result = (const AutotuneResult_t *) dyn_array_at(results, i);
+        EXPECT_EQ(expected[i], result->pcbs);
+        EXPECT_EQ(i < 2 || result->pareto, result->pareto);
+        EXPECT_LE(1u, result->params.quantum);
+        EXPECT_GE(32u, result->params.quantum);
+    }
+    const AutotuneResult_t *best = (const AutotuneResult_t *) dyn_array_at(results, 0);
+    EXPECT_LE(best->p99_turnaround, ((const AutotuneResult_t *) dyn_array_at(results, 1))->p99_turnaround);
+    dyn_array_destroy(results);
+
+    config.candidates = 0;
+    config.search = AUTOTUNE_RANDOM;
+    EXPECT_EQ(nullptr, autotune_run(trace.get(), &config));
+}
+
+
+//Result cache tests
+
+
+// Path of a key's entry in a cache directory
+static std::string cache_entry(const char *dir, ResultKey_t key)
+{
+    char name[40];
+    snprintf(name, sizeof(name), "%016llx%016llx.res", (unsigned long long) key.high, (unsigned long long) key.low);
+    return std::string(dir) + "/" + name;
+}
+
+static ResultKey_t text_key(const char *text)
+{
+    ResultHasher_t hasher;
+    result_hasher_init(&hasher);
+    result_hasher_update(&hasher, text, strlen(text));
+    return result_hasher_final(&hasher);
+}
+
+//Checks keys follow content however it is fed, and entries round trip while a damaged one misses
+TEST(result_cache, StoreAndLookUp)
+{
+    ResultHasher_t split;
+    result_hasher_init(&split);
+    result_hasher_update(&split, "a stream of ", 12);
+    result_hasher_update(&split, "bytes", 5);
+    const ResultKey_t whole = text_key("a stream of bytes");
+    EXPECT_EQ(whole.high, result_hasher_final(&split).high);
+    EXPECT_EQ(whole.low, result_hasher_final(&split).low);
+    EXPECT_NE(whole.low, text_key("a stream of bytez").low);
+    // the length counts too, so trailing zero bytes are not lost in the padding
+    ResultHasher_t padded;
+    result_hasher_init(&padded);
+    result_hasher_update(&padded, "ab\0", 3);
+    EXPECT_NE(text_key("ab").low, result_hasher_final(&padded).low);
+
+    write_text("cache_input.txt", "one");
+    ResultHasher_t first, second;
+    result_hasher_init(&first);
+    result_hasher_init(&second);
+    EXPECT_TRUE(result_hasher_file(&first, "cache_input.txt"));
+    write_text("cache_input.txt", "two");
+    EXPECT_TRUE(result_hasher_file(&second, "cache_input.txt"));
+    EXPECT_NE(result_hasher_final(&first).low, result_hasher_final(&second).low);
+    EXPECT_FALSE(result_hasher_file(&second, "cache_missing.txt"));
+    remove("cache_input.txt");
+
+    ResultCache_t *cache = result_cache_open("cache_test", 1 << 20);
+    ASSERT_NE(nullptr, cache);
+    const char payload[] = "turnaround 12.5 waiting 3";
+    dyn_array_t *found = dyn_array_create(0, sizeof(uint8_t), NULL);
+    EXPECT_FALSE(result_cache_get(cache, whole, found));
+    ASSERT_TRUE(result_cache_put(cache, whole, payload, sizeof(payload)));
+    ASSERT_TRUE(result_cache_get(cache, whole, found));
+    ASSERT_EQ(sizeof(payload), dyn_array_size(found));
+    EXPECT_EQ(0, memcmp(payload, dyn_array_export(found), sizeof(payload)));
+    EXPECT_FALSE(result_cache_get(cache, text_key("another run"), found));
+    EXPECT_TRUE(result_cache_put(cache, text_key("empty"), NULL, 0));
+    EXPECT_TRUE(result_cache_get(cache, text_key("empty"), found));
+    EXPECT_EQ(0u, dyn_array_size(found));
+
+    // a flipped payload byte fails the checksum, and the entry is dropped
+    const std::string path = cache_entry("cache_test", whole);
+    FILE *file = fopen(path.c_str(), "r+b");
+    ASSERT_NE(nullptr, file);
+    fseek(file, -2, SEEK_END);
+    fputc('X', file);
+    fclose(file);
+    EXPECT_FALSE(result_cache_get(cache, whole, found));
+    struct stat info;
+    EXPECT_NE(0, stat(path.c_str(), &info));
+    result_cache_close(cache);
+    remove(cache_entry("cache_test", text_key("empty")).c_str());
+    EXPECT_EQ(0, rmdir("cache_test"));
+    dyn_array_destroy(found);
+}
+
+//Checks a file's digest is reused from its sidecar until its size, mtime or inode changes
+TEST(result_cache, MemoizedFileDigest)
+{
+    const struct timespec early[2] = {{1000, 0}, {1000, 0}};
+    const struct timespec late[2] = {{2000, 0}, {2000, 0}};
+    ResultHasher_t plain[3], memo[4];
+    for (ResultHasher_t &hasher : plain)
+    {
+        result_hasher_init(&hasher);
+    }
+    for (ResultHasher_t &hasher : memo)
+    {
+        result_hasher_init(&hasher);
+    }
+
+    write_text("digest_input.bin", "one");
+    ASSERT_EQ(0, utimensat(AT_FDCWD, "digest_input.bin", early, 0));
+    EXPECT_TRUE(result_hasher_file(&plain[0], "digest_input.bin"));
+    EXPECT_TRUE(result_hasher_file_memo(&memo[0], "digest_input.bin"));
+    EXPECT_EQ(result_hasher_final(&plain[0]).low, result_hasher_final(&memo[0]).low);
+    struct stat info;
+    EXPECT_EQ(0, stat("digest_input.bin.digest", &info));
+
+    // same size, mtime and inode: the stored digest is used without reading the file
+    write_text("digest_input.bin", "two");
+    ASSERT_EQ(0, utimensat(AT_FDCWD, "digest_input.bin", early, 0));
+    EXPECT_TRUE(result_hasher_file_memo(&memo[1], "digest_input.bin"));
+    EXPECT_EQ(result_hasher_final(&plain[0]).low, result_hasher_final(&memo[1]).low);
+
+    // a new mtime or size is hashed again
+    ASSERT_EQ(0, utimensat(AT_FDCWD, "digest_input.bin", late, 0));
+    EXPECT_TRUE(result_hasher_file(&plain[1], "digest_input.bin"));
+    EXPECT_TRUE(result_hasher_file_memo(&memo[2], "digest_input.bin"));
+    EXPECT_EQ(result_hasher_final(&plain[1]).low, result_hasher_final(&memo[2]).low);
+    write_text("digest_input.bin", "three");
+    ASSERT_EQ(0, utimensat(AT_FDCWD, "digest_input.bin", late, 0));
+    EXPECT_TRUE(result_hasher_file(&plain[2], "digest_input.bin"));
+    EXPECT_TRUE(result_hasher_file_memo(&memo[3], "digest_input.bin"));
+    EXPECT_EQ(result_hasher_final(&plain[2]).low, result_hasher_final(&memo[3]).low);
+    EXPECT_NE(result_hasher_final(&plain[1]).low, result_hasher_final(&plain[2]).low);
+
+    EXPECT_FALSE(result_hasher_file_memo(&memo[3], "digest_missing.bin"));
+    remove("digest_input.bin");
+    remove("digest_input.bin.digest");
+}
+
+//Checks the cache stays within its size by dropping the least recently used entries
+TEST(result_cache, LeastRecentlyUsedEviction)
+{
+    // every entry is a 40 byte header and 100 bytes of payload, three fit
+    ResultCache_t *cache = result_cache_open("cache_lru", 3 * 140);
+    ASSERT_NE(nullptr, cache);
+    char payload[100];
+    memset(payload, 7, sizeof(payload));
+    const ResultKey_t keys[] = {text_key("k0"), text_key("k1"), text_key("k2"), text_key("k3")};
+    for (int k = 0; k < 3; ++k)
+    {
+        ASSERT_TRUE(result_cache_put(cache, keys[k], payload, sizeof(payload)));
+        // older entries were last used longer ago
+        const struct timespec times[2] = {{1000 + k, 0}, {1000 + k, 0}};
+        ASSERT_EQ(0, utimensat(AT_FDCWD, cache_entry("cache_lru", keys[k]).c_str(), times, 0));
+    }
+    EXPECT_EQ(3u * 140, result_cache_bytes(cache));
+
+    // using k0 makes k1 the oldest, so storing k3 evicts k1
+    dyn_array_t *found = dyn_array_create(0, sizeof(uint8_t), NULL);
+    EXPECT_TRUE(result_cache_get(cache, keys[0], found));
+    ASSERT_TRUE(result_cache_put(cache, keys[3], payload, sizeof(payload)));
+    EXPECT_EQ(3u * 140, result_cache_bytes(cache));
+    EXPECT_FALSE(result_cache_get(cache, keys[1], found));
+    for (int k : {0, 2, 3})
+    {
+        EXPECT_TRUE(result_cache_get(cache, keys[k], found));
+    }
+
+    // an entry bigger than the whole cache is not stored
+    char big[512] = {0};
+    EXPECT_FALSE(result_cache_put(cache, text_key("big"), big, sizeof(big)));
+    EXPECT_EQ(3u * 140, result_cache_bytes(cache));
+    result_cache_close(cache);
+    for (const ResultKey_t &key : keys)
+    {
+        remove(cache_entry("cache_lru", key).c_str());
+    }
+    EXPECT_EQ(0, rmdir("cache_lru"));
+    dyn_array_destroy(found);
+}
+
+
+//Scheduling daemon tests
+
+
+static void *daemon_serve(void *arg)
+{
+    sched_daemon_serve((SchedDaemon_t *)arg);
+    return NULL;
+}
+
+// Runs a query's policy over PCBs loaded here, the way analysis does without the daemon
+static ScheduleResult_t local_run(dyn_array_t *queue, const SchedQuery_t *query)
+{
+    ScheduleConfig_t config;
+    schedule_config_init(&config, (SchedulePolicy_t)query->policy);
+    if (query->quantum)
+    {
+        config.quantum = query->quantum;
+    }
+    config.costs = query->costs;
+    ScheduleResult_t result = {0, 0, 0};
+    EXPECT_TRUE(schedule_run(queue, &result, &config));
+    dyn_array_destroy(queue);
+    return result;
+}
+
+//Checks daemon answers match local runs of the same window, and bad queries get their status
+TEST(sched_daemon, QueriesMatchLocalRuns)
+{
+    std::vector<ProcessControlBlock_t> pcbs;
+    for (uint32_t i = 0; i < 600; ++i)
+    {
+        pcbs.push_back(ProcessControlBlock_t{1 + i % 13, i % 4, (i * 37) % 600, false});
+    }
+    write_shard("daemon_trace.bin", pcbs);
+    SchedDaemon_t *daemon = sched_daemon_create("daemon_test.sock", 2);
+    ASSERT_NE(nullptr, daemon);
+    EXPECT_TRUE(sched_daemon_pin(daemon, "daemon_trace.bin"));
+    EXPECT_FALSE(sched_daemon_pin(daemon, "daemon_missing.bin"));
+    pthread_t server;
+    ASSERT_EQ(0, pthread_create(&server, NULL, daemon_serve, daemon));
+
+    SchedClient_t *client = sched_client_open("daemon_test.sock");
+    ASSERT_NE(nullptr, client);
+    SchedQuery_t query;
+    SchedAnswer_t answer;
+    sched_query_init(&query, SCHEDULE_SJF);
+    query.costs.switch_cost = 2;
+    ASSERT_TRUE(sched_client_query(client, "daemon_trace.bin", &query, &answer));
+    ASSERT_EQ((uint32_t)SCHED_DAEMON_OK, answer.status);
+    ScheduleResult_t expected = local_run(load_process_control_blocks("daemon_trace.bin"), &query);
+    EXPECT_EQ(expected.average_waiting_time, answer.result.average_waiting_time);
+    EXPECT_EQ(expected.total_run_time, answer.result.total_run_time);
+    EXPECT_EQ(600u, answer.pcbs);
+    EXPECT_EQ(13u, answer.longest_burst);
+    EXPECT_LT(0u, answer.stats.switch_overhead);
+
+    // the file is not in arrival order, the window is
+    sched_query_init(&query, SCHEDULE_RR);
+    query.quantum = 3;
+    query.windowed = 1;
+    query.arrival_start = 100;
+    query.arrival_end = 299;
+    query.first_pcb = 20;
+    query.pcb_count = 150;
+    ASSERT_TRUE(sched_client_query(client, "daemon_trace.bin", &query, &answer));
+    ASSERT_EQ((uint32_t)SCHED_DAEMON_OK, answer.status);
+    TraceWindow_t window = {100, 299, 20, 150};
+    const char *paths[] = {"daemon_trace.bin"};
+    expected = local_run(trace_merge_load(paths, 1, &window), &query);
+    EXPECT_EQ(expected.average_turnaround_time, answer.result.average_turnaround_time);
+    EXPECT_EQ(expected.total_run_time, answer.result.total_run_time);
+    EXPECT_EQ(150u, answer.pcbs);
+    EXPECT_EQ(269u, answer.last_arrival);
+
+    query.arrival_start = 300;
+    EXPECT_TRUE(sched_client_query(client, "daemon_trace.bin", &query, &answer));
+    EXPECT_EQ((uint32_t)SCHED_DAEMON_BAD_QUERY, answer.status);
+    query.policy = 99;
+    EXPECT_TRUE(sched_client_query(client, "daemon_trace.bin", &query, &answer));
+    EXPECT_EQ((uint32_t)SCHED_DAEMON_BAD_QUERY, answer.status);
+    sched_query_init(&query, SCHEDULE_GROUP);
+    EXPECT_TRUE(sched_client_query(client, "daemon_trace.bin", &query, &answer));
+    EXPECT_EQ((uint32_t)SCHED_DAEMON_RUN_FAILED, answer.status);
+    EXPECT_TRUE(sched_client_query(client, "daemon_missing.bin", &query, &answer));
+    EXPECT_EQ((uint32_t)SCHED_DAEMON_NO_TRACE, answer.status);
+    sched_client_close(client);
+
+    sched_daemon_stop(daemon);
+    pthread_join(server, NULL);
+    sched_daemon_destroy(daemon);
+    struct stat info;
+    EXPECT_NE(0, stat("daemon_test.sock", &info));
+    EXPECT_EQ(nullptr, sched_client_open("daemon_test.sock"));
+    remove("daemon_trace.bin");
+    remove("daemon_trace.bin.idx");
+}
+
+typedef struct
+{
+    const char *trace;
+    uint64_t run_time;      // what every query has to answer
+    size_t failures;
+}
+DaemonClient;
+
+static void *daemon_ask(void *arg)
+{
+    DaemonClient *asker = (DaemonClient *)arg;
+    SchedClient_t *client = sched_client_open("daemon_load.sock");
+    SchedQuery_t query;
+    sched_query_init(&query, SCHEDULE_FCFS);
+    for (int i = 0; i < 200; ++i)
+    {
+        SchedAnswer_t answer;
+        if (!client || !sched_client_query(client, asker->trace, &query, &answer)
+            || answer.status != SCHED_DAEMON_OK || answer.result.total_run_time != asker->run_time)
+        {
+            ++asker->failures;
+        }
+    }
+    sched_client_close(client);
+    return NULL;
+}
+
+//Checks clients are answered concurrently, and a trace replaced or cut short on disk is read again
+TEST(sched_daemon, ConcurrentClientsAndReload)
+{
+    std::vector<ProcessControlBlock_t> pcbs;
+    for (uint32_t i = 0; i < 100; ++i)
+    {
+        pcbs.push_back(ProcessControlBlock_t{2, 0, i, false});
+    }
+    write_shard("daemon_load.bin", pcbs);
+    SchedDaemon_t *daemon = sched_daemon_create("daemon_load.sock", 3);
+    ASSERT_NE(nullptr, daemon);
+    pthread_t server;
+    ASSERT_EQ(0, pthread_create(&server, NULL, daemon_serve, daemon));
+
+    // an idle connection holds no worker
+    SchedClient_t *idle = sched_client_open("daemon_load.sock");
+    ASSERT_NE(nullptr, idle);
+    pthread_t threads[6];
+    DaemonClient askers[6];
+    for (size_t t = 0; t < 6; ++t)
+    {
+        askers[t] = DaemonClient{"daemon_load.bin", 200, 0};
+        pthread_create(&threads[t], NULL, daemon_ask, &askers[t]);
+    }
+    for (size_t t = 0; t < 6; ++t)
+    {
+        pthread_join(threads[t], NULL);
+        EXPECT_EQ(0u, askers[t].failures);
+    }
+
+    // written next to it and renamed over it, as a capture tool would
+    pcbs.resize(50);
+    write_shard("daemon_load.tmp", pcbs);
+    ASSERT_EQ(0, rename("daemon_load.tmp", "daemon_load.bin"));
+    askers[0] = DaemonClient{"daemon_load.bin", 100, 0};
+    daemon_ask(&askers[0]);
+    EXPECT_EQ(0u, askers[0].failures);
+
+    // cut short in place, which the daemon's own copy of the trace survives
+    ASSERT_EQ(0, truncate("daemon_load.bin", 20 * sizeof(ProcessControlBlock_t)));
+    askers[0] = DaemonClient{"daemon_load.bin", 40, 0};
+    daemon_ask(&askers[0]);
+    EXPECT_EQ(0u, askers[0].failures);
+
+    sched_daemon_stop(daemon);
+    pthread_join(server, NULL);
+    sched_daemon_destroy(daemon);
+    SchedQuery_t query;
+    sched_query_init(&query, SCHEDULE_FCFS);
+    SchedAnswer_t answer;
+    EXPECT_FALSE(sched_client_query(idle, "daemon_load.bin", &query, &answer));
+    sched_client_close(idle);
+    remove("daemon_load.bin");
+}